@@ -0,0 +1,66 @@
+program array_temporaries_01
+implicit none
+real :: a(10), b(10), s
+integer :: i, j, k, n
+
+a = 1.0
+b = 2.0
+n = 10
+
+! The extent of the temporaries does not change in the loop
+s = 0.0
+do i = 1, 100
+    s = s + sum(twice(a(1:n)) + b(1:n))
+end do
+print *, s
+if (abs(s - 4000.0) > 1e-4) error stop
+
+! The extent changes in every iteration
+s = 0.0
+do i = 1, 10
+    s = s + sum(twice(a(1:i)) + b(1:i))
+end do
+print *, s
+if (abs(s - 220.0) > 1e-4) error stop
+
+! Only invariant in the inner loop
+s = 0.0
+do j = 1, 10
+    do i = 1, 5
+        s = s + sum(twice(a(1:j)) * b(1:j))
+    end do
+end do
+print *, s
+if (abs(s - 1100.0) > 1e-4) error stop
+
+! The loop does not execute
+s = 0.0
+do i = 1, 0
+    s = s + sum(twice(a(1:n)) + b(1:n))
+end do
+print *, s
+if (abs(s) > 1e-4) error stop
+
+! `k` is modified through host association
+s = 0.0
+k = 1
+do i = 1, 4
+    s = s + sum(twice(a(1:k)) + b(1:k))
+    call increment_k()
+end do
+print *, s
+if (abs(s - 40.0) > 1e-4) error stop
+
+contains
+
+    function twice(x) result(r)
+    real, intent(in) :: x(:)
+    real :: r(size(x))
+    r = 2*x
+    end function
+
+    subroutine increment_k()
+    k = k + 1
+    end subroutine
+
+end program
@@ -0,0 +1,33 @@
+program expr_21
+! Expressions that need more registers than the x86 backend has available
+! for temporaries, and function calls in the middle of expressions
+implicit none
+integer :: a, b, c, x
+a = 2
+b = 3
+c = 5
+
+x = ((a+b)*(b+c)) + ((c-a)*(a+c)) - ((a*b)-(b*c))*((c+b)-(a*a))
+if (x /= 97) error stop
+
+x = (((a+1)*(b+2))-((c+3)*(a+4))) * (((b+5)-(c+6))+((a+7)*(b+8)))
+if (x /= -3168) error stop
+
+x = ((((a+b)+(b+c))+((c+a)+(a+b)))+(((b+c)+(c+a))+((a+b)+(b+c)))) / 2
+if (x /= 26) error stop
+
+x = f(a) + (b * f(c + f(b))) - f(f(a) * (c - f(1)))
+if (x /= 59) error stop
+
+x = (a + b) * f((a + b) * (b + c)) + (b + c) * f(a * c)
+if (x /= 573) error stop
+print *, x
+
+contains
+
+    integer function f(n) result(r)
+    integer, intent(in) :: n
+    r = 2*n + 1
+    end function
+
+end program
@@ -0,0 +1,41 @@
+program file_31
+  ! List-directed reads of numeric arrays from a formatted file
+  implicit none
+  integer :: u
+  integer(4) :: a(5)
+  integer(8) :: b(3)
+  real(4) :: x(4)
+  real(8) :: y(4)
+  integer :: tail
+
+  open(newunit=u, file='file_31_data.txt', status='replace', action='write')
+  write(u, '(a)') '1 -2, 3'
+  write(u, '(a)') '   2147483647 -2147483648'
+  write(u, '(a)') '9223372036854775807 -9223372036854775807 0'
+  write(u, '(a)') '0.1 -2.5e3 1e-5 3.0'
+  write(u, '(a)') '0.1, 1.5d2 -1.0e-300 123456789.123456789'
+  write(u, '(a)') '42'
+  close(u)
+
+  open(newunit=u, file='file_31_data.txt', status='old', action='read')
+  read(u, *) a
+  read(u, *) b
+  read(u, *) x
+  read(u, *) y
+  read(u, *) tail
+  close(u, status='delete')
+
+  print *, a
+  print *, b
+  print *, x
+  print *, y
+  print *, tail
+
+  if (any(a /= [1, -2, 3, 2147483647, -2147483647 - 1])) error stop
+  if (b(1) /= 9223372036854775807_8) error stop
+  if (b(2) /= -9223372036854775807_8) error stop
+  if (b(3) /= 0) error stop
+  if (any(x /= [0.1, -2.5e3, 1e-5, 3.0])) error stop
+  if (any(y /= [0.1d0, 1.5d2, -1.0d-300, 123456789.123456789d0])) error stop
+  if (tail /= 42) error stop
+end program
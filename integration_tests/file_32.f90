@@ -0,0 +1,62 @@
+program file_32
+    ! Many open units with write-heavy loops: exercises unit lookup on every
+    ! write and the reuse of unit table slots after close
+    implicit none
+    integer, parameter :: nunits = 500, nsteps = 20
+    integer :: i, step, u, ios, val, total
+    character(len=32) :: fname
+
+    do i = 1, nunits
+        u = unit_number(i)
+        write(fname, '(a,i0,a)') 'file_32_', i, '.txt'
+        open(unit=u, file=trim(fname), status='replace', action='write')
+    end do
+
+    do step = 1, nsteps
+        do i = 1, nunits
+            write(unit_number(i), *) step * i
+        end do
+    end do
+
+    ! Close every other unit and reopen it under a different unit number
+    do i = 1, nunits, 2
+        close(unit_number(i))
+    end do
+    do i = 1, nunits, 2
+        u = unit_number(i) + 1
+        write(fname, '(a,i0,a)') 'file_32_', i, '.txt'
+        open(unit=u, file=trim(fname), status='old', action='read')
+    end do
+    do i = 2, nunits, 2
+        close(unit_number(i))
+    end do
+
+    total = 0
+    do i = 1, nunits, 2
+        u = unit_number(i) + 1
+        do step = 1, nsteps
+            read(u, *, iostat=ios) val
+            if (ios /= 0) error stop
+            if (val /= step * i) error stop
+            total = total + 1
+        end do
+        close(u, status='delete')
+    end do
+
+    do i = 2, nunits, 2
+        write(fname, '(a,i0,a)') 'file_32_', i, '.txt'
+        open(unit=unit_number(i), file=trim(fname), status='old')
+        close(unit_number(i), status='delete')
+    end do
+
+    print *, total
+    if (total /= (nunits / 2) * nsteps) error stop
+
+contains
+
+    integer function unit_number(i) result(u)
+        integer, intent(in) :: i
+        u = 1000 + 37 * i
+    end function
+
+end program
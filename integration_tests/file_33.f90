@@ -0,0 +1,58 @@
+program file_33
+    ! Formatted records written to a file, and the truncation of the file
+    ! when a record is written after repositioning the unit
+    implicit none
+    integer :: i, j, n, ios
+    real(8) :: x
+
+    open(unit=10, file='file_33.txt', status='replace')
+    do i = 1, 2000
+        write(10, '(I6, 1X, F12.4)') i, i * 0.5d0
+    end do
+    write(10, *) 2001, 1000.5d0
+
+    rewind(10)
+    n = 0
+    do
+        read(10, *, iostat=ios) j, x
+        if (ios /= 0) exit
+        n = n + 1
+        if (j /= n) error stop
+        if (abs(x - n * 0.5d0) > 1d-9) error stop
+    end do
+    print *, n
+    if (n /= 2001) error stop
+
+    ! Writing after a read makes the new record the last one of the file
+    rewind(10)
+    read(10, *) j, x
+    read(10, *) j, x
+    write(10, '(I6, 1X, F12.4)') 99, 7.25d0
+    rewind(10)
+    n = 0
+    do
+        read(10, *, iostat=ios) j, x
+        if (ios /= 0) exit
+        n = n + 1
+    end do
+    print *, n, j, x
+    if (n /= 3) error stop
+    if (j /= 99) error stop
+    if (abs(x - 7.25d0) > 1d-9) error stop
+
+    ! Same after a rewind, and later records are appended again
+    rewind(10)
+    write(10, '(I6, 1X, F12.4)') 1, 1.5d0
+    write(10, '(I6, 1X, F12.4)') 2, 2.5d0
+    rewind(10)
+    n = 0
+    do
+        read(10, *, iostat=ios) j, x
+        if (ios /= 0) exit
+        n = n + 1
+    end do
+    print *, n, j, x
+    if (n /= 2) error stop
+    if (j /= 2) error stop
+    close(10, status='delete')
+end program file_33
@@ -0,0 +1,33 @@
+program format_25
+    ! Constant format strings are parsed at compile time; check that the
+    ! precompiled formats (repeat counts, nested groups, literals and format
+    ! reversion) still produce the same output
+    implicit none
+    character(len=100) :: s
+    character(len=*), parameter :: FMT = '(A, 2(I3, 1X), F6.2)'
+    integer :: i
+    real(8) :: x(3)
+
+    x = [1.5d0, -2.25d0, 10.125d0]
+
+    write(s, '(3F8.3)') x
+    print *, trim(s)
+    if (s /= '   1.500  -2.250  10.125') error stop
+
+    write(s, FMT) 'ab', 1, 22, x(2)
+    print *, trim(s)
+    if (s /= 'ab  1  22  -2.25') error stop
+
+    write(s, '("x=", I0, " y=", 2(F5.1, ","), A)') 7, x(1), x(2), 'end'
+    print *, trim(s)
+    if (s /= 'x=7 y=  1.5, -2.2,end' .and. s /= 'x=7 y=  1.5, -2.3,end') error stop
+
+    do i = 1, 3
+        write(s, '(I2, 2(1X, I3))') i, 10*i, 100*i
+        print *, trim(s)
+        if (i == 3 .and. s /= ' 3  30 300') error stop
+    end do
+
+    print '(2(I4))', 1, 2, 3, 4, 5
+    print '(I3, (2F6.2))', 1, x, x(1)
+end program
@@ -0,0 +1,59 @@
+module instrument_01_mod
+implicit none
+contains
+
+    recursive integer function fib(n) result(r)
+    integer, intent(in) :: n
+    if (n < 2) then
+        r = n
+        return
+    end if
+    r = fib(n - 1) + fib(n - 2)
+    end function
+
+    integer function first_multiple(a, m) result(r)
+    integer, intent(in) :: a(:), m
+    integer :: i
+    r = 0
+    do i = 1, size(a)
+        if (mod(a(i), m) == 0) then
+            r = i
+            return
+        end if
+    end do
+    end function
+
+end module
+
+program instrument_01
+use instrument_01_mod
+implicit none
+integer :: a(100), i, j, s
+
+do i = 1, size(a)
+    a(i) = 3*i + 1
+end do
+
+s = 0
+outer: do i = 1, 10
+    do j = 1, 10
+        if (j > i) exit
+        s = s + a(j)
+    end do
+end do outer
+print *, s
+if (s /= 715) error stop
+
+print *, fib(15)
+if (fib(15) /= 610) error stop
+
+print *, first_multiple(a, 7)
+if (first_multiple(a, 7) /= 2) error stop
+if (first_multiple(a, 1000) /= 0) error stop
+
+i = 0
+do while (i < 5)
+    i = i + 1
+end do
+if (i /= 5) error stop
+end program
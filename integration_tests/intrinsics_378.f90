@@ -0,0 +1,42 @@
+program intrinsics_378
+    ! random_seed(get=...) and random_seed(put=...) save and restore the
+    ! state of random_number
+    implicit none
+    integer :: n, i
+    integer, allocatable :: seed(:)
+    real(8) :: x(1000), y(1000)
+    real(4) :: a(50, 40)
+    real(8) :: mean
+
+    call random_seed(size=n)
+    print *, n
+    if (n < 1) error stop
+    allocate(seed(n))
+
+    call random_seed(get=seed)
+    call random_number(x)
+    call random_seed(put=seed)
+    call random_number(y)
+    if (any(x /= y)) error stop
+
+    ! A different seed gives a different sequence
+    seed = [(37 * i + 11, i = 1, n)]
+    call random_seed(put=seed)
+    call random_number(x)
+    call random_number(y)
+    if (all(x == y)) error stop
+    call random_seed(put=seed)
+    call random_number(y)
+    if (any(x /= y)) error stop
+
+    if (minval(x) < 0.0d0 .or. maxval(x) >= 1.0d0) error stop
+    mean = sum(x) / size(x)
+    print *, mean
+    if (abs(mean - 0.5d0) > 0.05d0) error stop
+
+    call random_number(a)
+    if (minval(a) < 0.0 .or. maxval(a) >= 1.0) error stop
+    mean = sum(real(a, 8)) / size(a)
+    print *, mean
+    if (abs(mean - 0.5d0) > 0.05d0) error stop
+end program
@@ -0,0 +1,98 @@
+program matmul_03
+    ! matmul, dot_product, sum and transpose of contiguous arrays, which
+    ! go through the runtime kernels, and of array sections, which do not
+    implicit none
+    integer, parameter :: m = 37, n = 53, k = 29
+    real(8) :: a(m, k), b(k, n), c(m, n), r(m, n), v(k), w(m), u(n)
+    real(8) :: big(2*m, 2*k), at(k, m), s
+    real(4) :: as(m, k), bs(k, n), cs(m, n)
+    complex(8) :: za(m, k), zb(k, n), zc(m, n), zr(m, n), zv(k), zs
+    complex(4) :: ca(m, k), cb(k, n), cc(m, n), cr(m, n)
+    integer :: i, j, l
+
+    do j = 1, k
+        do i = 1, m
+            a(i, j) = modulo(i * 7 + j * 3, 11) - 5.0d0
+            za(i, j) = cmplx(a(i, j), modulo(i + 2 * j, 5) - 2, kind=8)
+        end do
+    end do
+    do j = 1, n
+        do i = 1, k
+            b(i, j) = modulo(i * 5 + j, 13) - 6.0d0
+            zb(i, j) = cmplx(modulo(i + j, 3) - 1, b(i, j), kind=8)
+        end do
+    end do
+    do i = 1, k
+        v(i) = i - 15
+        zv(i) = cmplx(i, -i, kind=8)
+    end do
+    as = real(a, 4)
+    bs = real(b, 4)
+    ca = za
+    cb = zb
+
+    r = 0
+    zr = 0
+    do j = 1, n
+        do l = 1, k
+            do i = 1, m
+                r(i, j) = r(i, j) + a(i, l) * b(l, j)
+                zr(i, j) = zr(i, j) + za(i, l) * zb(l, j)
+            end do
+        end do
+    end do
+
+    c = matmul(a, b)
+    if (maxval(abs(c - r)) > 1d-10) error stop
+    cs = matmul(as, bs)
+    if (maxval(abs(cs - r)) > 1e-3) error stop
+    zc = matmul(za, zb)
+    if (maxval(abs(zc - zr)) > 1d-10) error stop
+    cc = matmul(ca, cb)
+    cr = zr
+    if (maxval(abs(cc - cr)) > 1e-3) error stop
+
+    w = matmul(a, v)
+    do i = 1, m
+        if (abs(w(i) - sum(a(i, :) * v)) > 1d-10) error stop
+    end do
+    u = matmul(v, b)
+    do j = 1, n
+        if (abs(u(j) - sum(v * b(:, j))) > 1d-10) error stop
+    end do
+
+    ! Strided operands
+    big = 0
+    big(1:2*m:2, 1:2*k:2) = a
+    c = matmul(big(1:2*m:2, 1:2*k:2), b)
+    if (maxval(abs(c - r)) > 1d-10) error stop
+
+    s = dot_product(v, a(1, :))
+    if (abs(s - sum(v * a(1, :))) > 1d-10) error stop
+    s = dot_product(a(:, 2), a(:, 3))
+    if (abs(s - sum(a(:, 2) * a(:, 3))) > 1d-10) error stop
+    zs = dot_product(zv, za(2, :))
+    if (abs(zs - sum(conjg(zv) * za(2, :))) > 1d-10) error stop
+
+    s = 0
+    zs = 0
+    do j = 1, k
+        do i = 1, m
+            s = s + a(i, j)
+            zs = zs + za(i, j)
+        end do
+    end do
+    if (abs(sum(a) - s) > 1d-10) error stop
+    if (abs(sum(za) - zs) > 1d-10) error stop
+    if (abs(sum(as) - s) > 1e-3) error stop
+
+    at = transpose(a)
+    do j = 1, k
+        do i = 1, m
+            if (at(j, i) /= a(i, j)) error stop
+        end do
+    end do
+    if (any(transpose(za) /= reshape([((za(i, j), j = 1, k), i = 1, m)], [k, m]))) error stop
+
+    print *, sum(c), sum(abs(zc)), s
+end program matmul_03
@@ -0,0 +1,74 @@
+program openmp_44
+    use omp_lib
+    implicit none
+    integer, parameter :: n = 1000
+    integer :: i, j, chunk, hits(n), owner(n)
+    real(8) :: s
+
+    call omp_set_num_threads(4)
+    do i = 1, n
+        hits(i) = 0
+    end do
+    chunk = 7
+
+    !$omp parallel do schedule(dynamic, chunk) shared(hits, owner)
+    do i = 1, n
+        hits(i) = hits(i) + 1
+        owner(i) = omp_get_thread_num()
+    end do
+    !$omp end parallel do
+    do i = 1, n
+        if (hits(i) /= 1) error stop
+    end do
+    do i = 1, n
+        if (owner(i) < 0 .or. owner(i) > 3) error stop
+    end do
+
+    !$omp parallel do schedule(guided) shared(hits)
+    do i = 1, n
+        hits(i) = hits(i) + 1
+    end do
+    !$omp end parallel do
+    do i = 1, n
+        if (hits(i) /= 2) error stop
+    end do
+
+    ! Every block of 10 iterations is handed to one thread
+    !$omp parallel do schedule(static, 10) shared(owner)
+    do i = 1, n
+        owner(i) = omp_get_thread_num()
+    end do
+    !$omp end parallel do
+    do i = 1, n
+        if (owner(i) /= owner(i - modulo(i - 1, 10))) error stop
+    end do
+
+    !$omp parallel do schedule(runtime) shared(hits)
+    do i = 1, n
+        hits(i) = hits(i) + 1
+    end do
+    !$omp end parallel do
+    do i = 1, n
+        if (hits(i) /= 3) error stop
+    end do
+
+    !$omp parallel do collapse(2) schedule(dynamic, 3) shared(hits)
+    do i = 1, 10
+        do j = 1, 100
+            hits((i - 1) * 100 + j) = hits((i - 1) * 100 + j) + 1
+        end do
+    end do
+    !$omp end parallel do
+    do i = 1, n
+        if (hits(i) /= 4) error stop
+    end do
+
+    s = 0
+    !$omp parallel do schedule(dynamic, 16) reduction(+:s)
+    do i = 1, n
+        s = s + i
+    end do
+    !$omp end parallel do
+    print *, s
+    if (abs(s - 500500.0d0) > 1d-8) error stop
+end program openmp_44
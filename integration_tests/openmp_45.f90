@@ -0,0 +1,58 @@
+program openmp_45
+    use omp_lib
+    implicit none
+    integer, parameter :: n = 1003
+    integer :: i, j
+    real :: x(n), y(n), z(n), m(8, n)
+    real(8) :: s
+
+    call omp_set_num_threads(4)
+    do i = 1, n
+        x(i) = i
+        y(i) = 2 * i
+    end do
+
+    !$omp simd
+    do i = 1, n
+        z(i) = x(i) + 2 * y(i)
+    end do
+    !$omp end simd
+    do i = 1, n
+        if (z(i) /= 5 * i) error stop
+    end do
+
+    ! Only the innermost loop is vectorized
+    do j = 1, 8
+        !$omp simd simdlen(8)
+        do i = 1, n
+            m(j, i) = j * x(i)
+        end do
+    end do
+    if (m(8, n) /= 8 * n) error stop
+
+    s = 0
+    !$omp simd reduction(+:s)
+    do i = 1, n
+        s = s + x(i)
+    end do
+    if (abs(s - n * (n + 1) / 2) > 1d-8) error stop
+
+    !$omp parallel do simd schedule(static) shared(x, y, z)
+    do i = 1, n
+        z(i) = 3 * x(i) - y(i)
+    end do
+    !$omp end parallel do simd
+    do i = 1, n
+        if (z(i) /= i) error stop
+    end do
+
+    !$omp parallel do simd schedule(dynamic, 64) shared(x, z)
+    do i = 1, n
+        z(i) = z(i) + x(i)
+    end do
+    !$omp end parallel do simd
+    do i = 1, n
+        if (z(i) /= 2 * i) error stop
+    end do
+    print *, sum(z), s
+end program openmp_45
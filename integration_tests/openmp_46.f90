@@ -0,0 +1,61 @@
+module openmp_46_fib
+    use omp_lib
+    implicit none
+contains
+    recursive integer function fib(n) result(r)
+        integer, intent(in) :: n
+        integer :: x, y
+        if (n < 20) then
+            r = fib_serial(n)
+            return
+        end if
+        !$omp task shared(x)
+        x = fib(n - 1)
+        !$omp end task
+        !$omp task shared(y)
+        y = fib(n - 2)
+        !$omp end task
+        !$omp taskwait
+        r = x + y
+    end function
+
+    recursive integer function fib_serial(n) result(r)
+        integer, intent(in) :: n
+        if (n < 2) then
+            r = n
+        else
+            r = fib_serial(n - 1) + fib_serial(n - 2)
+        end if
+    end function
+end module
+
+program openmp_46
+    ! task and taskwait: recursive Fibonacci
+    use omp_lib
+    use openmp_46_fib
+    implicit none
+    integer :: f
+    real(8) :: t0, t_serial, t_parallel
+
+    call omp_set_num_threads(4)
+
+    ! Outside of a parallel region the tasks are run right away
+    t0 = omp_get_wtime()
+    f = fib(30)
+    t_serial = omp_get_wtime() - t0
+    if (f /= 832040) error stop
+
+    f = 0
+    t0 = omp_get_wtime()
+    !$omp parallel
+    !$omp single
+    f = fib(30)
+    !$omp end single
+    !$omp end parallel
+    t_parallel = omp_get_wtime() - t0
+    if (f /= 832040) error stop
+
+    ! The timings depend on the machine, only print them
+    print *, "fib(30) =", f
+    print *, "speedup:", t_serial / max(t_parallel, 1d-9)
+end program
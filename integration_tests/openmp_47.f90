@@ -0,0 +1,62 @@
+program openmp_47
+    ! task depend and the capture of firstprivate variables
+    use omp_lib
+    implicit none
+    integer, parameter :: n = 10
+    integer :: a, b, c, i, k
+    integer :: v(n)
+
+    call omp_set_num_threads(4)
+    a = 0
+    b = 0
+    c = 0
+    !$omp parallel
+    !$omp single
+    !$omp task depend(out: a) shared(a)
+    a = 1
+    !$omp end task
+    !$omp task depend(in: a) depend(out: b) shared(a, b)
+    b = a + 1
+    !$omp end task
+    !$omp task depend(inout: b) shared(b)
+    b = b * 10
+    !$omp end task
+    !$omp task depend(in: a, b) shared(a, b, c)
+    c = a + b
+    !$omp end task
+    !$omp end single
+    !$omp end parallel
+    print *, a, b, c
+    if (a /= 1 .or. b /= 20 .or. c /= 21) error stop
+
+    ! Every task gets the values of i and k from the time it was created
+    v = 0
+    !$omp parallel
+    !$omp single
+    do i = 1, n
+        k = i * i
+        !$omp task firstprivate(i, k) shared(v)
+        v(i) = k + i
+        !$omp end task
+    end do
+    !$omp taskwait
+    !$omp end single
+    !$omp end parallel
+    print *, v
+    do i = 1, n
+        if (v(i) /= i * i + i) error stop
+    end do
+
+    ! master and single without tasks
+    a = 0
+    b = 0
+    !$omp parallel shared(a, b)
+    !$omp master
+    a = a + 1
+    !$omp end master
+    !$omp single
+    b = b + 1
+    !$omp end single
+    !$omp end parallel
+    if (a /= 1 .or. b /= 1) error stop
+end program
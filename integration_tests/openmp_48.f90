@@ -0,0 +1,64 @@
+program openmp_48
+    ! taskloop
+    use omp_lib
+    implicit none
+    integer, parameter :: n = 100000
+    integer :: i, j
+    real(8) :: x(n), y(0:n-1), s
+    real(8) :: t0, t_serial, t_parallel
+
+    call omp_set_num_threads(4)
+
+    t0 = omp_get_wtime()
+    do i = 1, n
+        x(i) = work(i)
+    end do
+    t_serial = omp_get_wtime() - t0
+    s = sum(x)
+
+    x = 0
+    t0 = omp_get_wtime()
+    !$omp parallel
+    !$omp single
+    !$omp taskloop grainsize(1000) shared(x)
+    do i = 1, n
+        x(i) = work(i)
+    end do
+    !$omp end single
+    !$omp end parallel
+    t_parallel = omp_get_wtime() - t0
+    if (abs(sum(x) - s) > 1d-6 * abs(s)) error stop
+
+    ! A loop with a stride and lower bounds other than 1
+    y = -1
+    !$omp parallel
+    !$omp single
+    !$omp taskloop num_tasks(7)
+    do j = n - 1, 0, -3
+        y(j) = j
+    end do
+    !$omp end single
+    !$omp end parallel
+    do j = 0, n - 1
+        if (modulo(n - 1 - j, 3) == 0) then
+            if (y(j) /= j) error stop
+        else
+            if (y(j) /= -1) error stop
+        end if
+    end do
+
+    ! The timings depend on the machine, only print them
+    print *, "sum =", s
+    print *, "speedup:", t_serial / max(t_parallel, 1d-9)
+
+contains
+
+    real(8) function work(k) result(r)
+        integer, intent(in) :: k
+        integer :: l
+        r = 0
+        do l = 1, 200
+            r = r + sin(real(k + l, 8))
+        end do
+    end function
+end program
@@ -0,0 +1,93 @@
+module stack_arrays_01_mod
+implicit none
+
+integer, allocatable :: kept(:)
+
+contains
+
+real function sum_squares(n) result(s)
+integer, intent(in) :: n
+real, allocatable :: x(:)
+integer :: i
+allocate(x(n))
+do i = 1, n
+    x(i) = real(i)
+end do
+s = sum(x*x)
+deallocate(x)
+end function
+
+integer function automatic_sum(n) result(s)
+integer, intent(in) :: n
+integer :: a(n)
+integer :: i
+do i = 1, n
+    a(i) = i
+end do
+s = sum(a)
+end function
+
+! `y` is handed over with move_alloc
+subroutine keep(n)
+integer, intent(in) :: n
+integer, allocatable :: y(:)
+integer :: i
+allocate(y(n))
+do i = 1, n
+    y(i) = 2*i
+end do
+call move_alloc(y, kept)
+end subroutine
+
+! `w` starts small and grows by reallocation
+integer function grow(n) result(s)
+integer, intent(in) :: n
+integer, allocatable :: w(:)
+integer :: i
+allocate(w(1))
+w(1) = 1
+do i = 2, n
+    w = [w, i]
+end do
+s = sum(w)
+end function
+
+recursive integer function depth_sum(n) result(s)
+integer, intent(in) :: n
+integer, allocatable :: v(:)
+allocate(v(3))
+v = n
+if (n > 0) then
+    s = depth_sum(n - 1) + sum(v)
+else
+    s = sum(v)
+end if
+end function
+
+end module
+
+program stack_arrays_01
+use stack_arrays_01_mod
+implicit none
+integer :: n
+
+do n = 1, 40
+    if (abs(sum_squares(n) - real(n*(n + 1)*(2*n + 1)/6)) > 1e-3) error stop
+    if (automatic_sum(n) /= n*(n + 1)/2) error stop
+end do
+print *, sum_squares(10), sum_squares(1000)
+print *, automatic_sum(10), automatic_sum(1000)
+
+call keep(5)
+if (sum(kept) /= 30) error stop
+call keep(100)
+if (sum(kept) /= 10100) error stop
+print *, size(kept), sum(kept)
+
+if (grow(10) /= 55) error stop
+if (grow(100) /= 5050) error stop
+print *, grow(100)
+
+if (depth_sum(20) /= 630) error stop
+print *, depth_sum(20)
+end program
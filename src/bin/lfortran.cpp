@@ -58,6 +58,7 @@
 
 #include <bin/lfortran_accessor.h>
 #include <bin/lfortran_command_line_parser.h>
+#include <bin/lfortran_compile_server.h>
 #include <bin/lsp_cli.h>
 
 #ifdef WITH_LSP
@@ -171,7 +172,9 @@ void print_time_report(const std::vector<std::string>& vector_of_time_report) {
     for (const auto& entry : vector_of_time_report) {
         // check if `Allocator usage of last chunk (MB)` or `Allocator chunks` is present
         if (entry.find("Allocator usage of last chunk (MB)") != std::string::npos ||
-            entry.find("Allocator chunks") != std::string::npos) {
+            entry.find("Allocator chunks") != std::string::npos ||
+            entry.find("Modfile cache hits") != std::string::npos ||
+            entry.find("Modfile cache lookups") != std::string::npos) {
             print_one_component(entry);
         }
     }
@@ -184,7 +187,9 @@ void print_time_report(const std::vector<std::string>& vector_of_time_report) {
 
     for (const auto& entry : vector_of_time_report) {
         if (entry.find("Allocator usage of last chunk (MB)") == std::string::npos &&
-            entry.find("Allocator chunks") == std::string::npos) {
+            entry.find("Allocator chunks") == std::string::npos &&
+            entry.find("Modfile cache hits") == std::string::npos &&
+            entry.find("Modfile cache lookups") == std::string::npos) {
             print_one_component(entry);
         }
     }
@@ -942,7 +947,8 @@ int save_mod_files(const LCompilers::ASR::TranslationUnit_t &u,
             LCompilers::diag::Diagnostics diagnostics;
             LCOMPILERS_ASSERT(LCompilers::asr_verify(*tu, true, diagnostics));
 
-            std::string modfile_binary = LCompilers::save_modfile(*tu, lm);
+            std::string modfile_binary = LCompilers::save_modfile(*tu, lm,
+                compiler_options.po.compress_modfiles);
 
             m->m_symtab->parent = orig_symtab;
 
@@ -950,11 +956,16 @@ int save_mod_files(const LCompilers::ASR::TranslationUnit_t &u,
 
 	    std::filesystem::path filename { std::string(m->m_name) + ".mod" };
             std::filesystem::path fullpath = compiler_options.po.mod_files_dir / filename;
+            // Modfiles are memory mapped when loaded, so the file is
+            // replaced instead of being overwritten in place
+            std::filesystem::path tmppath = fullpath;
+            tmppath += "." + LCompilers::get_unique_ID();
             {
                 std::ofstream out;
-		out.open(fullpath, std::ofstream::out | std::ofstream::binary);
+		out.open(tmppath, std::ofstream::out | std::ofstream::binary);
                 out << modfile_binary;
             }
+            std::filesystem::rename(tmppath, fullpath);
         }
     }
     return 0;
@@ -1068,19 +1079,88 @@ int emit_asm(const std::string &infile, CompilerOptions &compiler_options)
     }
 }
 
+std::string get_linker(const std::string &linker, const std::string &linker_path)
+{
+    std::string CC{""};
+    if (!linker_path.empty()) {
+        CC = linker_path;
+    } else if (char *env_path = std::getenv("LFORTRAN_LINKER_PATH")) {
+        CC = env_path;
+    }
+
+    if (!CC.empty() && CC.back() != '/') {
+        // TODO: Fix the path usage for Windows
+        CC += "/";
+    }
+
+    if (!linker.empty()) {
+        CC += linker;
+    } else if (char *env_linker = std::getenv("LFORTRAN_LINKER")) {
+        CC += env_linker;
+    } else {
+        // TODO: Add support for msvc linker for Windows
+        // TODO: Add support for lld linker
+        // Default linker to be used
+        CC += "clang";
+    }
+    return CC;
+}
+
+#ifdef HAVE_LFORTRAN_LLVM
+/*
+    Compiles `m` into `outfile` using `compiler_options.codegen_threads`
+    threads: the module is split into partitions which are compiled to
+    separate object files in parallel and then combined into `outfile`
+    using a relocatable link.
+*/
+int save_object_file_parallel(LCompilers::LLVMEvaluator &e, llvm::Module &m,
+        const std::string &outfile, CompilerOptions &compiler_options,
+        const std::string &linker, const std::string &linker_path)
+{
+    std::vector<std::string> parts;
+    for (size_t i = 0; i < compiler_options.codegen_threads; i++) {
+        parts.push_back(outfile + ".part" + std::to_string(i) + ".o");
+    }
+    e.save_object_files(m, parts);
+
+    std::string CC = get_linker(linker, linker_path);
+    std::string cmd = CC;
+    if (compiler_options.target != "" &&
+            CC.find("clang") != std::string::npos) {
+        cmd += " -target " + compiler_options.target;
+    }
+    cmd += " -r -nostdlib -o " + outfile;
+    for (auto &part: parts) {
+        cmd += " " + part;
+    }
+    int err = system(cmd.c_str());
+    for (auto &part: parts) {
+        std::filesystem::remove(part);
+    }
+    if (err) {
+        std::cerr << "The command '" + cmd + "' failed." << std::endl;
+        return 10;
+    }
+    return 0;
+}
+#endif
+
 int compile_src_to_object_file(const std::string &infile,
         const std::string &outfile,
         bool time_report,
         bool assembly,
         CompilerOptions &compiler_options,
         LCompilers::PassManager& lpm,
-        bool arg_c = false)
+        bool arg_c = false,
+        const std::string &linker = "",
+        const std::string &linker_path = "")
 {
     int time_file_read=0;
     int time_src_to_asr=0;
     int time_save_mod=0;
     int time_opt=0;
     int time_llvm_to_bin=0;
+    std::vector<std::string> llvm_pass_times;
 
     auto t1 = std::chrono::high_resolution_clock::now();
     std::string input = read_file_ok(infile);
@@ -1162,8 +1242,11 @@ int compile_src_to_object_file(const std::string &infile,
         return 1;
 #endif
     }
+    compiler_options.po.location_manager = &lm;
     LCompilers::Result<std::unique_ptr<LCompilers::LLVMModule>>
-        res = fe.get_llvm3(*asr, lpm, diagnostics, infile, &time_opt);
+        res = fe.get_llvm3(*asr, lpm, diagnostics, infile, &time_opt,
+            &llvm_pass_times);
+    compiler_options.po.location_manager = nullptr;
     std::cerr << diagnostics.render(lm, compiler_options);
     if (res.ok) {
         m = std::move(res.result);
@@ -1177,7 +1260,16 @@ int compile_src_to_object_file(const std::string &infile,
         e.save_asm_file(*(m->m_m), outfile);
     } else {
         t1 = std::chrono::high_resolution_clock::now();
-        e.save_object_file(*(m->m_m), outfile);
+#ifndef _WIN32
+        if (compiler_options.codegen_threads > 1) {
+            int err = save_object_file_parallel(e, *(m->m_m), outfile,
+                compiler_options, linker, linker_path);
+            if (err) return err;
+        } else
+#endif
+        {
+            e.save_object_file(*(m->m_m), outfile);
+        }
         t2 = std::chrono::high_resolution_clock::now();
         time_llvm_to_bin = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
     }
@@ -1215,6 +1307,14 @@ int compile_src_to_object_file(const std::string &infile,
         compiler_options.po.vector_of_time_report.push_back(message);
         message = "Allocator chunks: " + std::to_string(fe.get_al().num_chunks());
         compiler_options.po.vector_of_time_report.push_back(message);
+        LCompilers::ModfileCache::Stats modfile_stats
+            = LCompilers::ModfileCache::get_instance().get_stats();
+        message = "Modfile cache hits: " + std::to_string(modfile_stats.hits);
+        compiler_options.po.vector_of_time_report.push_back(message);
+        message = "Modfile cache lookups: " + std::to_string(modfile_stats.lookups);
+        compiler_options.po.vector_of_time_report.push_back(message);
+        message = "Modfile cache (time saved): " + std::to_string(modfile_stats.time_saved_us / 1000) + "." + std::to_string(modfile_stats.time_saved_us % 1000) + " ms";
+        compiler_options.po.vector_of_time_report.push_back(message);
         message = "File reading: " + std::to_string(time_file_read / 1000) + "." + std::to_string(time_file_read % 1000) + " ms";
         compiler_options.po.vector_of_time_report.push_back(message);
         message = "Src -> ASR:  " + std::to_string(time_src_to_asr / 1000) + "." + std::to_string(time_src_to_asr % 1000) + " ms";
@@ -1228,6 +1328,9 @@ int compile_src_to_object_file(const std::string &infile,
         compiler_options.po.vector_of_time_report.push_back(message);
         message = "LLVM opt:    " + std::to_string(time_opt / 1000) + "." + std::to_string(time_opt % 1000) + " ms";
         compiler_options.po.vector_of_time_report.push_back(message);
+        for (auto &it: llvm_pass_times) {
+            compiler_options.po.vector_of_time_report.push_back(it);
+        }
         message = "LLVM -> BIN: " + std::to_string(time_llvm_to_bin / 1000) + "." + std::to_string(time_llvm_to_bin % 1000) + " ms";
         compiler_options.po.vector_of_time_report.push_back(message);
     }
@@ -1878,33 +1981,11 @@ int link_executable(const std::vector<std::string> &infiles,
             compile_cmd += runtime_library_dir + "/" + runtime_lib;
             compile_cmd +=  extra_linker_flags;
         } else {
-            std::string CC{""};
+            std::string CC = get_linker(linker, linker_path);
             std::string base_path = "\"" + runtime_library_dir + "\"";
             std::string options;
             std::string runtime_lib = "lfortran_runtime";
 
-            if (!linker_path.empty()) {
-                CC = linker_path;
-            } else if (char *env_path = std::getenv("LFORTRAN_LINKER_PATH")) {
-                CC = env_path;
-            }
-
-            if (!CC.empty() && CC.back() != '/') {
-                // TODO: Fix the path usage for Windows
-                CC += "/";
-            }
-
-            if (!linker.empty()) {
-                CC += linker;
-            } else if (char *env_linker = std::getenv("LFORTRAN_LINKER")) {
-                CC += env_linker;
-            } else {
-                // TODO: Add support for msvc linker for Windows
-                // TODO: Add support for lld linker
-                // Default linker to be used
-                CC += "clang";
-            }
-
             if (compiler_options.target != "" &&
                     CC.find("clang" ) != std::string::npos) {
                 options = " -target " + compiler_options.target;
@@ -1940,6 +2021,17 @@ int link_executable(const std::vector<std::string> &infiles,
                 compile_cmd += extra_linker_flags;
             }
             compile_cmd += " -l" + runtime_lib + " -lm";
+            if (!compiler_options.blas_lib.empty()) {
+                // The runtime only refers to ?gemm_ weakly, so the library
+                // must be kept even though nothing else uses it
+                if (compiler_options.platform == LCompilers::Platform::macOS_Intel
+                        || compiler_options.platform == LCompilers::Platform::macOS_ARM) {
+                    compile_cmd += " -l" + compiler_options.blas_lib;
+                } else {
+                    compile_cmd += " -Wl,--push-state,--no-as-needed -l"
+                        + compiler_options.blas_lib + " -Wl,--pop-state";
+                }
+            }
             if (compiler_options.openmp) {
                 std::string openmp_shared_library = compiler_options.openmp_lib_dir;
                 std::string omp_cmd =  " -L" + openmp_shared_library + " -Wl,-rpath," + openmp_shared_library + " -lomp";
@@ -2151,6 +2243,18 @@ int emit_c_preprocessor(const std::string &infile, CompilerOptions &compiler_opt
     return 0;
 }
 
+// Parses all modfiles in `dir` into the ModfileCache
+void preload_modfiles(const std::string &dir) {
+    std::error_code ec;
+    std::vector<std::filesystem::path> dirs = {dir};
+    for (auto &entry : std::filesystem::directory_iterator(dir, ec)) {
+        if (entry.path().extension() == ".mod") {
+            LCompilers::ModfileCache::get_instance().find(dirs,
+                entry.path().filename().string());
+        }
+    }
+}
+
 } // anonymous namespace
 
 #ifdef HAVE_BUILD_TO_WASM
@@ -2269,6 +2373,8 @@ EMSCRIPTEN_KEEPALIVE char* emit_wasm_from_source(char *input) {
 
 #endif
 
+int run_main_app(int argc, char *argv[]);
+
 int main_app(int argc, char *argv[]) {
     int dirname_length;
     auto start_time = std::chrono::high_resolution_clock::now();
@@ -2306,6 +2412,21 @@ int main_app(int argc, char *argv[]) {
     lcli::LFortranCommandLineOpts &opts = parser.opts;
     CompilerOptions &compiler_options = opts.compiler_options;
 
+    if (opts.compile_server) {
+        // Everything done here is inherited by the jobs forked from the
+        // server. Nothing that is per compilation (like the unique ID) may be
+        // initialized before this point.
+#ifdef HAVE_LFORTRAN_LLVM
+        LCompilers::LLVMEvaluator::initialize_targets();
+#endif
+        preload_modfiles(compiler_options.po.runtime_library_dir);
+        std::string socket_path = opts.server_socket.empty()
+            ? LCompilers::CompileServer::default_socket_path()
+            : opts.server_socket;
+        return LCompilers::CompileServer::serve(socket_path, opts.server_jobs,
+            run_main_app);
+    }
+
     lcompilers_commandline_options = "";
     for (int i=0; i<argc; i++) {
         std::string option = std::string(argv[i]);
@@ -2385,6 +2506,7 @@ int main_app(int argc, char *argv[]) {
 
     if (opts.arg_backend == "llvm") {
         backend = Backend::llvm;
+        compiler_options.po.array_kernels = true;
         lfortran_pass_manager.passes_to_skip_with_llvm.push_back("print_arr");
         lfortran_pass_manager.passes_to_skip_with_llvm.push_back("print_struct_type");
     } else if (opts.arg_backend == "c") {
@@ -2569,7 +2691,8 @@ int main_app(int argc, char *argv[]) {
         if (backend == Backend::llvm) {
 #ifdef HAVE_LFORTRAN_LLVM
             return compile_src_to_object_file(opts.arg_file, outfile, compiler_options.time_report, false,
-                compiler_options, lfortran_pass_manager, opts.arg_c);
+                compiler_options, lfortran_pass_manager, opts.arg_c,
+                opts.linker, opts.linker_path);
 #else
             std::cerr << "The -c option requires the LLVM backend to be enabled. Recompile with `WITH_LLVM=yes`." << std::endl;
             return 1;
@@ -2614,7 +2737,8 @@ int main_app(int argc, char *argv[]) {
             if (backend == Backend::llvm) {
 #ifdef HAVE_LFORTRAN_LLVM
                 err = compile_src_to_object_file(arg_file, tmp_o, compiler_options.time_report, false,
-                    compiler_options, lfortran_pass_manager);
+                    compiler_options, lfortran_pass_manager, false,
+                    opts.linker, opts.linker_path);
 #else
                 std::cerr << "Compiling Fortran files to object files requires the LLVM backend to be enabled. Recompile with `WITH_LLVM=yes`." << std::endl;
                 return 1;
@@ -2678,12 +2802,8 @@ int main_app(int argc, char *argv[]) {
     }
 }
 
-int main(int argc, char *argv[])
+int run_main_app(int argc, char *argv[])
 {
-    LCompilers::initialize();
-#if defined(HAVE_LFORTRAN_STACKTRACE)
-    LCompilers::print_stack_on_segfault();
-#endif
     try {
         return main_app(argc, argv);
     } catch(const LCompilers::LCompilersException &e) {
@@ -2706,3 +2826,16 @@ int main(int argc, char *argv[])
     }
     return 0;
 }
+
+int main(int argc, char *argv[])
+{
+    int exit_code;
+    if (LCompilers::CompileServer::run_client(argc, argv, exit_code)) {
+        return exit_code;
+    }
+    LCompilers::initialize();
+#if defined(HAVE_LFORTRAN_STACKTRACE)
+    LCompilers::print_stack_on_segfault();
+#endif
+    return run_main_app(argc, argv);
+}
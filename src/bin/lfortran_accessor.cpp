@@ -1,4 +1,5 @@
 #include <cstdint>
+#include <functional>
 
 #include <libasr/asr.h>
 #include <libasr/asr_lookup_name.h>
@@ -19,22 +20,10 @@ namespace LCompilers::LLanguageServer {
         const std::string &text,
         CompilerOptions &compiler_options
     ) -> std::vector<LCompilers::error_highlight> {
-        std::unique_lock<std::mutex> lock(mutex);
-        LCompilers::FortranEvaluator fe(compiler_options);
-
-        LCompilers::LocationManager lm;
-        {
-                LCompilers::LocationManager::FileLocations fl;
-                fl.in_filename = filename;
-                lm.files.push_back(fl);
-                lm.file_ends.push_back(text.size());
-        }
-
-        LCompilers::diag::Diagnostics diagnostics;
-        {
-                LCompilers::Result<LCompilers::ASR::TranslationUnit_t*> result =
-                    fe.get_asr2(text, lm, diagnostics);
-        }
+        std::shared_ptr<CompiledDocument> document =
+            compile(filename, text, compiler_options);
+        LCompilers::LocationManager &lm = document->lm;
+        LCompilers::diag::Diagnostics &diagnostics = document->diagnostics;
 
         std::vector<LCompilers::error_highlight> diag_lists;
         diag_lists.reserve(diagnostics.diagnostics.size());
@@ -74,22 +63,14 @@ namespace LCompilers::LLanguageServer {
         const std::string &text,
         CompilerOptions &compiler_options
     ) -> std::vector<LCompilers::document_symbols> {
-        std::unique_lock<std::mutex> lock(mutex);
-        LCompilers::FortranEvaluator fe(compiler_options);
+        std::shared_ptr<CompiledDocument> document =
+            compile(filename, text, compiler_options);
+        LCompilers::FortranEvaluator &fe = *document->fe;
+        LCompilers::LocationManager &lm = document->lm;
         std::vector<LCompilers::document_symbols> symbol_lists;
-
-        LCompilers::LocationManager lm;
         {
-            LCompilers::LocationManager::FileLocations fl;
-            fl.in_filename = filename;
-            lm.files.push_back(fl);
-            lm.file_ends.push_back(text.size());
-        }
-        {
-            LCompilers::diag::Diagnostics diagnostics;
-            LCompilers::Result<LCompilers::ASR::TranslationUnit_t*>
-                x = fe.get_asr2(text, lm, diagnostics);
-            if (x.ok) {
+            LCompilers::ASR::TranslationUnit_t *x = document->asr;
+            if (x) {
                 // populate_symbol_lists(x.result, lm, symbol_lists);
                 uint16_t l = std::stoi(compiler_options.line);
                 uint16_t c = std::stoi(compiler_options.column);
@@ -101,7 +82,7 @@ namespace LCompilers::LLanguageServer {
                 }
                 uint64_t output_pos = lm.input_to_output_pos(input_pos, false);
                 LCompilers::ASR::asr_t* asr =
-                    fe.handle_lookup_name(x.result, output_pos);
+                    fe.handle_lookup_name(x, output_pos);
                 if (ASR::is_a<ASR::symbol_t>(*asr)) {
                     ASR::symbol_t* s = ASR::down_cast<ASR::symbol_t>(asr);
                     std::string symbol_name = ASRUtils::symbol_name( s );
@@ -132,22 +113,14 @@ namespace LCompilers::LLanguageServer {
         const std::string &text,
         CompilerOptions &compiler_options
     ) -> std::vector<std::pair<LCompilers::document_symbols, std::string>> {
-        std::unique_lock<std::mutex> lock(mutex);
-        LCompilers::FortranEvaluator fe(compiler_options);
+        std::shared_ptr<CompiledDocument> document =
+            compile(filename, text, compiler_options);
+        LCompilers::FortranEvaluator &fe = *document->fe;
+        LCompilers::LocationManager &lm = document->lm;
         std::vector<std::pair<LCompilers::document_symbols, std::string>> symbol_lists;
-
-        LCompilers::LocationManager lm;
         {
-            LCompilers::LocationManager::FileLocations fl;
-            fl.in_filename = filename;
-            lm.files.push_back(fl);
-            lm.file_ends.push_back(text.size());
-        }
-        {
-            LCompilers::diag::Diagnostics diagnostics;
-            LCompilers::Result<LCompilers::ASR::TranslationUnit_t*>
-                x = fe.get_asr2(text, lm, diagnostics);
-            if (x.ok) {
+            LCompilers::ASR::TranslationUnit_t *x = document->asr;
+            if (x) {
                 // populate_symbol_lists(x.result, lm, symbol_lists);
                 uint16_t l = std::stoi(compiler_options.line);
                 uint16_t c = std::stoi(compiler_options.column);
@@ -159,7 +132,7 @@ namespace LCompilers::LLanguageServer {
                 }
                 uint64_t output_pos = lm.input_to_output_pos(input_pos, false);
                 LCompilers::ASR::asr_t* asr =
-                    fe.handle_lookup_name(x.result, output_pos);
+                    fe.handle_lookup_name(x, output_pos);
                 if (ASR::is_a<ASR::symbol_t>(*asr)) {
                     std::pair<LCompilers::document_symbols, std::string> &pair =
                         symbol_lists.emplace_back();
@@ -195,34 +168,26 @@ namespace LCompilers::LLanguageServer {
         const std::string &text,
         CompilerOptions &compiler_options
     ) -> std::vector<LCompilers::document_symbols> {
-        std::unique_lock<std::mutex> lock(mutex);
-        LCompilers::FortranEvaluator fe(compiler_options);
+        std::shared_ptr<CompiledDocument> document =
+            compile(filename, text, compiler_options);
+        LCompilers::FortranEvaluator &fe = *document->fe;
+        LCompilers::LocationManager &lm = document->lm;
         std::vector<LCompilers::document_symbols> symbol_lists;
-
-        LCompilers::LocationManager lm;
-        {
-            LCompilers::LocationManager::FileLocations fl;
-            fl.in_filename = filename;
-            lm.files.push_back(fl);
-            lm.file_ends.push_back(text.size());
-        }
         {
-            LCompilers::diag::Diagnostics diagnostics;
-            LCompilers::Result<LCompilers::ASR::TranslationUnit_t*>
-                x = fe.get_asr2(text, lm, diagnostics);
-            if (x.ok) {
+            LCompilers::ASR::TranslationUnit_t *x = document->asr;
+            if (x) {
                 // populate_symbol_lists(x.result, lm, symbol_lists);
                 uint16_t l = std::stoi(compiler_options.line);
                 uint16_t c = std::stoi(compiler_options.column);
                 uint64_t input_pos = lm.linecol_to_pos(l, c);
                 uint64_t output_pos = lm.input_to_output_pos(input_pos, false);
-                LCompilers::ASR::asr_t* asr = fe.handle_lookup_name(x.result, output_pos);
+                LCompilers::ASR::asr_t* asr = fe.handle_lookup_name(x, output_pos);
                 LCompilers::document_symbols loc;
                 if (ASR::is_a<ASR::symbol_t>(*asr)) {
                     ASR::symbol_t* s = ASR::down_cast<ASR::symbol_t>(asr);
                     std::string symbol_name = ASRUtils::symbol_name( s );
                     LCompilers::LFortran::OccurenceCollector occ(symbol_name, symbol_lists, lm);
-                    occ.visit_TranslationUnit(*x.result);
+                    occ.visit_TranslationUnit(*x);
                 }
             }
         }
@@ -238,8 +203,8 @@ namespace LCompilers::LLanguageServer {
         int indent,
         bool indent_unit
     ) -> LCompilers::Result<std::string> {
-        std::unique_lock<std::mutex> lock(mutex);
-        LCompilers::FortranEvaluator fe(compiler_options);
+        CompilerOptions options = compiler_options;
+        LCompilers::FortranEvaluator fe(options);
         LCompilers::LocationManager lm;
         LCompilers::diag::Diagnostics diagnostics;
         {
@@ -269,27 +234,137 @@ namespace LCompilers::LLanguageServer {
         const std::string &text,
         CompilerOptions &compiler_options
     ) -> std::vector<LCompilers::document_symbols> {
-        std::unique_lock<std::mutex> lock(mutex);
-        LCompilers::FortranEvaluator fe(compiler_options);
+        std::shared_ptr<CompiledDocument> document =
+            compile(filename, text, compiler_options);
+        LCompilers::LocationManager &lm = document->lm;
         std::vector<LCompilers::document_symbols> symbol_lists;
+        {
+            LCompilers::ASR::TranslationUnit_t *x = document->asr;
+            if (x) {
+              populateSymbolLists(x, lm, symbol_lists, -1);
+            }
+        }
 
-        LCompilers::LocationManager lm;
+        return symbol_lists;
+    }
+
+    auto LFortranAccessor::invalidate(const std::string &filename) -> void {
+        std::unique_lock<std::shared_mutex> lock(documentsMutex);
+        documentsByFilename.erase(filename);
+    }
+
+    auto LFortranAccessor::invalidateAll() -> void {
+        std::unique_lock<std::shared_mutex> lock(documentsMutex);
+        documentsByFilename.clear();
+    }
+
+    auto LFortranAccessor::compile(
+        const std::string &filename,
+        const std::string &text,
+        const CompilerOptions &compiler_options
+    ) -> std::shared_ptr<CompiledDocument> {
+        {
+            std::shared_lock<std::shared_mutex> lock(documentsMutex);
+            auto iter = documentsByFilename.find(filename);
+            if (iter != documentsByFilename.end()) {
+                std::shared_ptr<CompiledDocument> document = iter->second;
+                lock.unlock();
+                if (isUpToDate(*document, text)) {
+                    return document;
+                }
+            }
+        }
+
+        std::shared_ptr<CompiledDocument> document =
+            std::make_shared<CompiledDocument>();
+        document->text = text;
+        document->compiler_options = compiler_options;
+        document->fe = std::make_unique<LCompilers::FortranEvaluator>(
+            document->compiler_options);
         {
             LCompilers::LocationManager::FileLocations fl;
             fl.in_filename = filename;
-            lm.files.push_back(fl);
-            lm.file_ends.push_back(text.size());
+            document->lm.files.push_back(fl);
+            document->lm.file_ends.push_back(text.size());
         }
-        {
-            LCompilers::diag::Diagnostics diagnostics;
+        LCompilers::Result<LCompilers::LFortran::AST::TranslationUnit_t*>
+            ast = document->fe->get_ast2(text, document->lm, document->diagnostics);
+        if (ast.ok) {
+            document->ast = ast.result;
             LCompilers::Result<LCompilers::ASR::TranslationUnit_t*>
-                x = fe.get_asr2(text, lm, diagnostics);
-            if (x.ok) {
-              populateSymbolLists(x.result, lm, symbol_lists, -1);
+                asr = document->fe->get_asr3(*ast.result,
+                    document->diagnostics, document->lm);
+            if (asr.ok) {
+                document->asr = asr.result;
+                collectDependencies(*document);
             }
         }
 
-        return symbol_lists;
+        std::unique_lock<std::shared_mutex> lock(documentsMutex);
+        documentsByFilename[filename] = document;
+        return document;
+    }
+
+    auto LFortranAccessor::isUpToDate(
+        CompiledDocument &document,
+        const std::string &text
+    ) -> bool {
+        if (document.text != text) {
+            return false;
+        }
+        std::unique_lock<std::mutex> lock(document.dependencies_mutex);
+        for (ModfileDependency &dependency : document.dependencies) {
+            std::error_code ec;
+            std::filesystem::file_time_type mtime =
+                std::filesystem::last_write_time(dependency.path, ec);
+            if (ec) return false;
+            std::uintmax_t size = std::filesystem::file_size(dependency.path, ec);
+            if (ec) return false;
+            if (mtime == dependency.mtime && size == dependency.size) {
+                continue;
+            }
+            // The file was touched, only recompile if its content changed
+            std::string modfile;
+            if (!LCompilers::read_file(dependency.path.string(), modfile)
+                    || std::hash<std::string>{}(modfile) != dependency.hash) {
+                return false;
+            }
+            dependency.mtime = mtime;
+            dependency.size = size;
+        }
+        return true;
+    }
+
+    auto LFortranAccessor::collectDependencies(
+        CompiledDocument &document
+    ) -> void {
+        // Search the modfiles in the same order as find_and_load_module()
+        const LCompilers::PassOptions &po = document.compiler_options.po;
+        std::vector<std::filesystem::path> mod_files_dirs;
+        mod_files_dirs.push_back(po.runtime_library_dir);
+        mod_files_dirs.push_back(po.mod_files_dir);
+        mod_files_dirs.insert(mod_files_dirs.end(),
+            po.include_dirs.begin(), po.include_dirs.end());
+        for (auto &a : document.asr->m_symtab->get_scope()) {
+            if (!ASR::is_a<ASR::Module_t>(*a.second)) continue;
+            ASR::Module_t *m = ASR::down_cast<ASR::Module_t>(a.second);
+            if (!m->m_loaded_from_mod) continue;
+            std::filesystem::path filename{std::string(m->m_name) + ".mod"};
+            for (auto &dir : mod_files_dirs) {
+                std::filesystem::path path = dir / filename;
+                std::string modfile;
+                if (LCompilers::read_file(path.string(), modfile)) {
+                    std::error_code ec;
+                    ModfileDependency &dependency =
+                        document.dependencies.emplace_back();
+                    dependency.path = path;
+                    dependency.mtime = std::filesystem::last_write_time(path, ec);
+                    dependency.size = modfile.size();
+                    dependency.hash = std::hash<std::string>{}(modfile);
+                    break;
+                }
+            }
+        }
     }
 
 } // namespace LCompilers::LLanguageServer
@@ -1,20 +1,64 @@
 #pragma once
 
+#include <cstddef>
+#include <filesystem>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include <libasr/diagnostics.h>
 #include <libasr/exception.h>
+#include <libasr/location.h>
 #include <libasr/lsp_interface.h>
 #include <libasr/utils.h>
 
+#include <lfortran/fortran_evaluator.h>
+
 namespace LCompilers::LLanguageServer {
 
     inline bool is_id_chr(unsigned char c) {
         return std::isalnum(c) || (c == '_');
     }
 
+    // A .mod file that was loaded while compiling a document, along with
+    // enough information to tell whether it changed since.
+    struct ModfileDependency {
+        std::filesystem::path path;
+        std::filesystem::file_time_type mtime;
+        std::uintmax_t size;
+        std::size_t hash;
+    };
+
+    // The result of compiling one version of a document. The AST and ASR
+    // live in the Allocator of `fe`, so they stay valid as long as this
+    // object does. It is never modified once it has been cached, so any
+    // number of read-only requests may use it concurrently.
+    struct CompiledDocument {
+        std::string text;
+        CompilerOptions compiler_options;
+        std::unique_ptr<LCompilers::FortranEvaluator> fe;
+        LCompilers::LocationManager lm;
+        LCompilers::diag::Diagnostics diagnostics;
+        LCompilers::LFortran::AST::TranslationUnit_t *ast = nullptr;
+        LCompilers::ASR::TranslationUnit_t *asr = nullptr;
+        std::vector<ModfileDependency> dependencies;
+        // Serializes the revalidation of `dependencies`
+        std::mutex dependencies_mutex;
+    };
+
+    // LFortranAccessor is reentrant: every compilation builds its own
+    // FortranEvaluator (with its own Allocator), LocationManager and copy of
+    // the CompilerOptions, since semantics may update the options while
+    // compiling. Requests for different documents may therefore be served
+    // concurrently by the parallel language server.
+    //
+    // The compiled document is cached per file and reused by all read-only
+    // requests until the text of the document or one of the .mod files it
+    // depends on changes.
     class LFortranAccessor {
     public:
         auto showErrors(
@@ -93,8 +137,35 @@ namespace LCompilers::LLanguageServer {
             int indent,
             bool indent_unit
         ) -> LCompilers::Result<std::string>;
+
+        // Drops the cached compilation of `filename`, e.g. when the document
+        // is closed.
+        auto invalidate(const std::string &filename) -> void;
+
+        // Drops all cached compilations, e.g. when the compiler options have
+        // changed.
+        auto invalidateAll() -> void;
     private:
-        std::mutex mutex;
+        std::unordered_map<
+            std::string,
+            std::shared_ptr<CompiledDocument>
+        > documentsByFilename;
+        std::shared_mutex documentsMutex;
+
+        // Returns the cached compilation of `text` or compiles it, if the
+        // cache is missing or out of date.
+        auto compile(
+            const std::string &filename,
+            const std::string &text,
+            const CompilerOptions &compiler_options
+        ) -> std::shared_ptr<CompiledDocument>;
+
+        auto isUpToDate(
+            CompiledDocument &document,
+            const std::string &text
+        ) -> bool;
+
+        auto collectDependencies(CompiledDocument &document) -> void;
     };
 
 } // namespace LCompilers::LLanguageServer
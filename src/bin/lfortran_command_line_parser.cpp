@@ -48,8 +48,8 @@ namespace LCompilers::CommandLineInterface {
         app.add_option("-D", compiler_options.c_preprocessor_defines, "Define <macro>=<value> (or 1 if <value> omitted)")->allow_extra_args(false);
         app.add_flag("--version", opts.arg_version, "Display compiler version information");
         app.add_option("-W", opts.linker_flags, "Linker flags")->allow_extra_args(false);
-        app.add_option("-f", opts.f_flags, "All `-f*` flags (only -fPIC & -fdefault-integer-8 supported for now)")->allow_extra_args(false);
-        app.add_option("-O", opts.O_flags, "Optimization level (ignored for now)")->allow_extra_args(false);
+        app.add_option("-f", opts.f_flags, "All `-f*` flags (only -fPIC, -fdefault-integer-8, -fassociative-math & -ffast-math supported for now)")->allow_extra_args(false);
+        app.add_option("-O", opts.O_flags, "Optimization level (0, 1, 2, 3, s, z)")->allow_extra_args(false);
 
         // LFortran specific options
         app.add_flag("--cpp", opts.cpp, "Enable C preprocessing");
@@ -95,6 +95,8 @@ namespace LCompilers::CommandLineInterface {
         app.add_option("--backend", opts.arg_backend, "Select a backend (llvm, c, cpp, x86, wasm, fortran, mlir)")->capture_default_str();
         app.add_flag("--openmp", compiler_options.openmp, "Enable openmp");
         app.add_flag("--openmp-lib-dir", compiler_options.openmp_lib_dir, "Pass path to openmp library")->capture_default_str();
+        app.add_option("--blas", compiler_options.blas_lib, "Link with the given BLAS library (e.g. openblas) and use it for matmul");
+        app.add_option("--instrument", opts.instrument, "Time `functions` and/or `loops` (comma separated); the program writes lfortran_profile.txt and lfortran_profile.folded at exit");
         app.add_flag("--lookup-name", compiler_options.lookup_name, "Lookup a name specified by --line & --column in the ASR");
         app.add_flag("--rename-symbol", compiler_options.rename_symbol, "Returns list of locations where symbol specified by --line & --column appears in the ASR");
         app.add_option("--line", compiler_options.line, "Line number for --lookup-name")->capture_default_str();
@@ -105,8 +107,14 @@ namespace LCompilers::CommandLineInterface {
         app.add_flag("--rtlib", compiler_options.rtlib, "Include the full runtime library in the LLVM output");
         app.add_flag("--use-loop-variable-after-loop", compiler_options.po.use_loop_variable_after_loop, "Allow using loop variable after the loop");
         app.add_flag("--fast", compiler_options.po.fast, "Best performance (disable strict standard compliance)");
+        app.add_option("--llvm-passes", compiler_options.llvm_passes, "Run this LLVM pass pipeline (in the `opt -passes=` syntax) instead of the one selected by -O");
+        app.add_option("--codegen-threads", compiler_options.codegen_threads, "Split the LLVM module into this many partitions and compile them to object code in parallel")->capture_default_str();
         app.add_flag("--linker", opts.linker, "Specify the linker to be used, available options: clang or gcc")->capture_default_str();
         app.add_flag("--linker-path", opts.linker_path, "Use the linker from this path")->capture_default_str();
+        app.add_flag("--server", opts.compile_server, "Run a compile server that compiles the `-c` jobs forwarded by `--client`");
+        app.add_flag("--client", opts.compile_client, "Forward this `-c` job to the compile server (compile locally if none is running)");
+        app.add_option("--server-socket", opts.server_socket, "Unix socket of the compile server (default: $XDG_RUNTIME_DIR/lfortran-server.sock)");
+        app.add_option("--server-jobs", opts.server_jobs, "Number of jobs the compile server runs at the same time (0: number of hardware threads)")->capture_default_str();
         app.add_option("--target", compiler_options.target, "Generate code for the given target")->capture_default_str();
         app.add_flag("--print-targets", opts.print_targets, "Print the registered targets");
         app.add_flag("--implicit-typing", compiler_options.implicit_typing, "Allow implicit typing");
@@ -119,6 +127,9 @@ namespace LCompilers::CommandLineInterface {
         app.add_flag("--dump-all-passes-fortran", compiler_options.po.dump_fortran, "Apply all passes and dump the ASR after each pass into fortran file");
         app.add_flag("--cumulative", compiler_options.po.pass_cumulative, "Apply all the passes cumulatively till the given pass");
         app.add_flag("--realloc-lhs", compiler_options.po.realloc_lhs, "Reallocate left hand side automatically");
+        app.add_flag("--lazy-modfiles", compiler_options.po.lazy_modfiles, "Only load the symbols of a module that `use, only` imports (and the symbols they need)");
+        app.add_flag("--compress-modfiles", compiler_options.po.compress_modfiles, "Compress the modfiles that are written (smaller files, slower to load)");
+        app.add_option("--pass-threads", compiler_options.po.pass_threads, "Number of threads used to apply function-local ASR passes")->capture_default_str();
         app.add_flag("--module-mangling", compiler_options.po.module_name_mangling, "Mangles the module name");
         app.add_flag("--intrinsic-module-mangling", compiler_options.po.intrinsic_module_name_mangling, "Mangles only intrinsic module name");
         app.add_flag("--global-mangling", compiler_options.po.global_symbols_mangling, "Mangles all the global symbols");
@@ -130,6 +141,8 @@ namespace LCompilers::CommandLineInterface {
         app.add_flag("--legacy-array-sections", compiler_options.legacy_array_sections, "Enables passing array items as sections if required");
         app.add_flag("--ignore-pragma", compiler_options.ignore_pragma, "Ignores all the pragmas");
         app.add_flag("--stack-arrays", compiler_options.stack_arrays, "Allocate memory for arrays on stack");
+        app.add_option("--max-stack-array-size", compiler_options.max_stack_array_size, "Largest size in bytes of local array data placed on the stack when the array does not escape its procedure (default: 1024 with --fast, 0 otherwise)");
+        app.add_flag("--no-alias-metadata", compiler_options.no_alias_metadata, "Do not tell LLVM that dummy arguments do not alias (noalias, alias scopes)");
         app.add_flag("--wasm-html", compiler_options.wasm_html, "Generate HTML file using emscripten for LLVM->WASM");
         app.add_option("--emcc-embed", compiler_options.emcc_embed, "Embed a given file/directory using emscripten for LLVM->WASM");
         app.add_flag("--mlir-gpu-offloading", compiler_options.po.enable_gpu_offloading, "Enables gpu offloading using MLIR backend");
@@ -222,6 +235,8 @@ namespace LCompilers::CommandLineInterface {
                 // We do this by default, so we ignore for now
             } else if (f_flag == "default-integer-8") {
                 compiler_options.po.default_integer_kind = 8;
+            } else if (f_flag == "associative-math" || f_flag == "fast-math") {
+                compiler_options.po.associative_math = true;
             } else {
                 throw lc::LCompilersException(
                     "The flag `-f" + f_flag + "` is not supported"
@@ -229,6 +244,35 @@ namespace LCompilers::CommandLineInterface {
             }
         }
 
+        if (!opts.instrument.empty()) {
+            for (auto &region : string_split(opts.instrument, ",")) {
+                if (region == "functions") {
+                    compiler_options.po.instrument_functions = true;
+                } else if (region == "loops") {
+                    compiler_options.po.instrument_loops = true;
+                } else {
+                    throw lc::LCompilersException(
+                        "The option `--instrument=" + opts.instrument
+                        + "` is not supported, use `functions`, `loops` or "
+                        "`functions,loops`"
+                    );
+                }
+            }
+        }
+
+        if (opts.O_flags.size() > 0) {
+            // Like GCC and Clang, the last -O option wins
+            std::string O_flag = opts.O_flags.back();
+            if (O_flag == "0" || O_flag == "1" || O_flag == "2" ||
+                    O_flag == "3" || O_flag == "s" || O_flag == "z") {
+                compiler_options.opt_level = O_flag;
+            } else {
+                throw lc::LCompilersException(
+                    "The flag `-O" + O_flag + "` is not supported"
+                );
+            }
+        }
+
         // if it's the only file, then we use that file
         // to set the compiler_options
         if (opts.arg_files.size() > 0) {
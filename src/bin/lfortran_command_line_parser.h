@@ -52,10 +52,15 @@ namespace LCompilers::CommandLineInterface {
         bool static_link = false;
         bool shared_link = false;
         std::string skip_pass;
+        std::string instrument;
         std::string arg_backend = "llvm";
         std::string arg_kernel_f;
         std::string linker{""};
         std::string linker_path{""};
+        bool compile_server = false;
+        bool compile_client = false;
+        std::string server_socket;
+        size_t server_jobs = 0;
         bool print_targets = false;
         bool fixed_form_infer = false;
         bool cpp = false;
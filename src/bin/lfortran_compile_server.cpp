@@ -0,0 +1,428 @@
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+#include <bin/lfortran_compile_server.h>
+
+#ifndef _WIN32
+extern char **environ;
+#endif
+
+namespace LCompilers::CompileServer {
+
+#ifndef _WIN32
+
+namespace {
+
+    // A request is a 32-bit length followed by the encoded job (see
+    // encode_request()). The client's stdin, stdout and stderr are passed
+    // along with the length as SCM_RIGHTS ancillary data. The reply is the
+    // 32-bit exit code of the job.
+    const std::string request_magic = "LFS1";
+    const uint32_t max_request_size = 64*1024*1024;
+
+    struct Request {
+        std::string cwd;
+        std::vector<std::string> args;
+        std::vector<std::string> env;
+    };
+
+    void put_u32(std::string &s, uint32_t x) {
+        s.append((const char*)&x, sizeof(x));
+    }
+
+    void put_string(std::string &s, const std::string &x) {
+        put_u32(s, x.size());
+        s += x;
+    }
+
+    std::string encode_request(const Request &r) {
+        std::string s = request_magic;
+        put_string(s, r.cwd);
+        put_u32(s, r.args.size());
+        for (auto &arg : r.args) put_string(s, arg);
+        put_u32(s, r.env.size());
+        for (auto &var : r.env) put_string(s, var);
+        return s;
+    }
+
+    class RequestDecoder {
+        const std::string &s;
+        size_t pos = 0;
+    public:
+        RequestDecoder(const std::string &s) : s(s) {}
+
+        bool get_u32(uint32_t &x) {
+            if (s.size() - pos < sizeof(x)) return false;
+            std::memcpy(&x, s.data() + pos, sizeof(x));
+            pos += sizeof(x);
+            return true;
+        }
+
+        bool get_string(std::string &x) {
+            uint32_t n;
+            if (!get_u32(n) || s.size() - pos < n) return false;
+            x = s.substr(pos, n);
+            pos += n;
+            return true;
+        }
+
+        bool get_strings(std::vector<std::string> &x) {
+            uint32_t n;
+            if (!get_u32(n)) return false;
+            x.resize(n);
+            for (auto &item : x) {
+                if (!get_string(item)) return false;
+            }
+            return true;
+        }
+
+        bool decode(Request &r) {
+            if (s.compare(0, request_magic.size(), request_magic) != 0) {
+                return false;
+            }
+            pos = request_magic.size();
+            return get_string(r.cwd) && get_strings(r.args)
+                && get_strings(r.env) && pos == s.size();
+        }
+    };
+
+    bool write_all(int fd, const char *data, size_t n) {
+        while (n > 0) {
+            ssize_t k = write(fd, data, n);
+            if (k < 0 && errno == EINTR) continue;
+            if (k <= 0) return false;
+            data += k;
+            n -= k;
+        }
+        return true;
+    }
+
+    bool read_all(int fd, char *data, size_t n) {
+        while (n > 0) {
+            ssize_t k = read(fd, data, n);
+            if (k < 0 && errno == EINTR) continue;
+            if (k <= 0) return false;
+            data += k;
+            n -= k;
+        }
+        return true;
+    }
+
+    bool make_address(const std::string &path, sockaddr_un &addr) {
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path)) return false;
+        std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+        return true;
+    }
+
+    int connect_to(const std::string &path) {
+        sockaddr_un addr;
+        if (!make_address(path, addr)) return -1;
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+            close(fd);
+            return -1;
+        }
+        return fd;
+    }
+
+    bool send_request(int fd, const std::string &body) {
+        uint32_t n = body.size();
+        int fds[3] = {STDIN_FILENO, STDOUT_FILENO, STDERR_FILENO};
+        iovec iov;
+        iov.iov_base = &n;
+        iov.iov_len = sizeof(n);
+        char control[CMSG_SPACE(sizeof(fds))];
+        std::memset(control, 0, sizeof(control));
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+        cmsg->cmsg_level = SOL_SOCKET;
+        cmsg->cmsg_type = SCM_RIGHTS;
+        cmsg->cmsg_len = CMSG_LEN(sizeof(fds));
+        std::memcpy(CMSG_DATA(cmsg), fds, sizeof(fds));
+        ssize_t k;
+        do {
+            k = sendmsg(fd, &msg, 0);
+        } while (k < 0 && errno == EINTR);
+        if (k != (ssize_t)sizeof(n)) return false;
+        return write_all(fd, body.data(), body.size());
+    }
+
+    bool receive_request(int fd, Request &r, int fds[3]) {
+        uint32_t n = 0;
+        iovec iov;
+        iov.iov_base = &n;
+        iov.iov_len = sizeof(n);
+        char control[CMSG_SPACE(3*sizeof(int))];
+        msghdr msg;
+        std::memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+        ssize_t k;
+        do {
+            k = recvmsg(fd, &msg, 0);
+        } while (k < 0 && errno == EINTR);
+        if (k <= 0) return false;
+        if (k < (ssize_t)sizeof(n)
+                && !read_all(fd, (char*)&n + k, sizeof(n) - k)) {
+            return false;
+        }
+        bool have_fds = false;
+        for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != nullptr;
+                cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+            if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS
+                    && cmsg->cmsg_len == CMSG_LEN(3*sizeof(int))) {
+                std::memcpy(fds, CMSG_DATA(cmsg), 3*sizeof(int));
+                have_fds = true;
+            }
+        }
+        if (!have_fds || n > max_request_size) return false;
+        std::string body(n, '\0');
+        if (!read_all(fd, &body[0], n)) return false;
+        return RequestDecoder(body).decode(r);
+    }
+
+    volatile sig_atomic_t stop_requested = 0;
+
+    void request_stop(int /*signum*/) {
+        stop_requested = 1;
+    }
+
+    // Runs one job in a forked worker and never returns
+    [[noreturn]] void run_worker(int conn, const Job &job) {
+        std::signal(SIGINT, SIG_DFL);
+        std::signal(SIGTERM, SIG_DFL);
+        std::signal(SIGPIPE, SIG_DFL);
+
+        Request r;
+        int fds[3] = {-1, -1, -1};
+        if (!receive_request(conn, r, fds)) _exit(1);
+        for (int i = 0; i < 3; i++) {
+            dup2(fds[i], i);
+            if (fds[i] > 2) close(fds[i]);
+        }
+
+        int32_t code = 1;
+        if (chdir(r.cwd.c_str()) != 0) {
+            std::cerr << "error: cannot change to the directory '" << r.cwd
+                << "': " << std::strerror(errno) << std::endl;
+        } else {
+            std::vector<char*> envp;
+            for (auto &var : r.env) envp.push_back(&var[0]);
+            envp.push_back(nullptr);
+            environ = envp.data();
+
+            std::vector<char*> argv;
+            for (auto &arg : r.args) argv.push_back(&arg[0]);
+            argv.push_back(nullptr);
+            code = job(r.args.size(), argv.data());
+        }
+
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        write_all(conn, (const char*)&code, sizeof(code));
+        _exit(code);
+    }
+
+} // anonymous namespace
+
+std::string default_socket_path() {
+    const char *runtime_dir = std::getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && runtime_dir[0] != '\0') {
+        return std::string(runtime_dir) + "/lfortran-server.sock";
+    }
+    return "/tmp/lfortran-server-" + std::to_string(getuid()) + ".sock";
+}
+
+int serve(const std::string &socket_path, size_t jobs, const Job &job) {
+    if (jobs == 0) {
+        jobs = std::max(1u, std::thread::hardware_concurrency());
+    }
+    sockaddr_un addr;
+    if (!make_address(socket_path, addr)) {
+        std::cerr << "error: the socket path '" << socket_path
+            << "' is too long" << std::endl;
+        return 1;
+    }
+    // Do not take over the socket of a running server, but replace a stale
+    // one left behind by a server that did not shut down cleanly
+    int probe = connect_to(socket_path);
+    if (probe >= 0) {
+        close(probe);
+        std::cerr << "error: a compile server is already listening on '"
+            << socket_path << "'" << std::endl;
+        return 1;
+    }
+    unlink(socket_path.c_str());
+
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener < 0) {
+        std::perror("socket");
+        return 1;
+    }
+    // Only the user running the server may connect to it
+    mode_t old_mask = umask(0077);
+    int err = bind(listener, (sockaddr*)&addr, sizeof(addr));
+    umask(old_mask);
+    if (err != 0 || listen(listener, SOMAXCONN) != 0) {
+        std::perror(socket_path.c_str());
+        close(listener);
+        return 1;
+    }
+
+    struct sigaction action;
+    std::memset(&action, 0, sizeof(action));
+    action.sa_handler = request_stop;
+    sigemptyset(&action.sa_mask);
+    // No SA_RESTART, so that a signal interrupts accept() and waitpid()
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+    std::signal(SIGPIPE, SIG_IGN);
+
+    std::cout << "LFortran compile server listening on " << socket_path
+        << " (" << jobs << " jobs)" << std::endl;
+
+    size_t running = 0;
+    while (!stop_requested) {
+        // Reap finished workers, and wait for one if all of them are busy
+        while (running > 0) {
+            int status;
+            pid_t pid = waitpid(-1, &status, running >= jobs ? 0 : WNOHANG);
+            if (pid > 0) {
+                running--;
+            } else if (pid < 0 && errno == EINTR && !stop_requested) {
+                continue;
+            } else {
+                if (pid < 0 && errno == ECHILD) running = 0;
+                break;
+            }
+        }
+        if (stop_requested) break;
+
+        int conn = accept(listener, nullptr, nullptr);
+        if (conn < 0) {
+            if (errno == EINTR || errno == ECONNABORTED) continue;
+            std::perror("accept");
+            break;
+        }
+        std::cout.flush();
+        std::cerr.flush();
+        std::fflush(nullptr);
+        pid_t pid = fork();
+        if (pid == 0) {
+            close(listener);
+            run_worker(conn, job);
+        }
+        close(conn);
+        if (pid < 0) {
+            std::perror("fork");
+            continue;
+        }
+        running++;
+    }
+
+    close(listener);
+    unlink(socket_path.c_str());
+    while (running > 0) {
+        if (waitpid(-1, nullptr, 0) > 0) {
+            running--;
+        } else if (errno != EINTR) {
+            break;
+        }
+    }
+    return 0;
+}
+
+bool run_client(int argc, char *argv[], int &exit_code) {
+    bool client = false;
+    bool compile_only = false;
+    std::string socket_path;
+    Request r;
+    for (int i = 0; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--client") {
+            client = true;
+        } else if (arg == "--server-socket" && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (arg.rfind("--server-socket=", 0) == 0) {
+            socket_path = arg.substr(std::strlen("--server-socket="));
+        } else {
+            if (arg == "-c") compile_only = true;
+            r.args.push_back(arg);
+        }
+    }
+    if (!client || !compile_only) return false;
+    if (socket_path.empty()) socket_path = default_socket_path();
+
+    int fd = connect_to(socket_path);
+    if (fd < 0) return false;
+    std::error_code ec;
+    r.cwd = std::filesystem::current_path(ec).string();
+    for (char **var = environ; *var != nullptr; var++) {
+        r.env.push_back(*var);
+    }
+    if (ec || !send_request(fd, encode_request(r))) {
+        // The job has not started, so it can still be compiled locally
+        close(fd);
+        return false;
+    }
+    int32_t code;
+    if (!read_all(fd, (char*)&code, sizeof(code))) {
+        std::cerr << "error: the compile server job terminated abnormally"
+            << std::endl;
+        code = 1;
+    }
+    close(fd);
+    exit_code = code;
+    return true;
+}
+
+#else
+
+std::string default_socket_path() {
+    return "";
+}
+
+int serve(const std::string &/*socket_path*/, size_t /*jobs*/,
+        const Job &/*job*/) {
+    std::cerr << "The compile server is not supported on Windows yet."
+        << std::endl;
+    return 1;
+}
+
+bool run_client(int /*argc*/, char */*argv*/[], int &/*exit_code*/) {
+    return false;
+}
+
+#endif // _WIN32
+
+} // namespace LCompilers::CompileServer
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+
+namespace LCompilers::CompileServer {
+
+    /*
+       A compile server for build systems: `lfortran --server` keeps a warm
+       process around (LLVM targets registered, intrinsic modfiles parsed and
+       held in the ModfileCache) and listens on a local Unix socket.
+       `lfortran --client ... -c file.f90` forwards its command line, working
+       directory, environment and standard streams to the server and returns
+       the exit code of the job.
+
+       Every job runs in a worker forked from the warm server process, so it
+       sees exactly the state a standalone `lfortran` would see (the compiler
+       still relies on process wide state such as the working directory and
+       the unique ID used for mangling), and writes its diagnostics straight
+       to the client's stdout and stderr. At most `jobs` workers run at the
+       same time.
+    */
+
+    // The command line of one job: runs the compiler and returns its exit code
+    using Job = std::function<int(int argc, char *argv[])>;
+
+    // `$XDG_RUNTIME_DIR/lfortran-server.sock`, or a per-user socket in /tmp
+    std::string default_socket_path();
+
+    // Serves jobs on `socket_path` until interrupted. If `jobs` is 0, the
+    // number of hardware threads is used.
+    int serve(const std::string &socket_path, size_t jobs, const Job &job);
+
+    // If `argv` contains `--client` and is a `-c` job, forwards it to the
+    // compile server, stores the job's exit code in `exit_code` and returns
+    // true. Returns false if the job should be run locally instead, either
+    // because it is not a client `-c` job or no server is listening.
+    bool run_client(int argc, char *argv[], int &exit_code);
+
+} // namespace LCompilers::CompileServer
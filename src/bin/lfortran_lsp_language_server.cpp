@@ -149,6 +149,8 @@ namespace LCompilers::LanguageServerProtocol {
             optionsByUri.clear();
             logger.debug() << "Invalidated compiler options cache." << std::endl;
         }
+        lfortran.invalidateAll();
+        logger.debug() << "Invalidated compiled document cache." << std::endl;
     }
 
     auto LFortranLspLanguageServer::getLFortranConfig(
@@ -1253,6 +1255,8 @@ namespace LCompilers::LanguageServerProtocol {
         const NotificationMessage &/*notification*/,
         DeleteFilesParams &/*params*/
     ) -> void {
+        // A deleted file may be a modfile that cached documents depend on
+        lfortran.invalidateAll();
         auto readLock = LSP_READ_LOCK(documentMutex, "documents");
         for (auto &[uri, document] : documentsByUri) {
             validate(document);
@@ -1309,6 +1313,7 @@ namespace LCompilers::LanguageServerProtocol {
                 highlightsByDocumentId.erase(iter);
             }
         }
+        lfortran.invalidate(document->path().string());
         BaseLspLanguageServer::receiveTextDocument_didClose(notification, params);
     }
 
@@ -1317,6 +1322,9 @@ namespace LCompilers::LanguageServerProtocol {
         const NotificationMessage &/*notification*/,
         DidChangeWatchedFilesParams &/*params*/
     ) -> void {
+        // Documents that failed to compile may have been missing a modfile
+        // that now exists, so they must be recompiled as well.
+        lfortran.invalidateAll();
         auto readLock = LSP_READ_LOCK(documentMutex, "documents");
         for (auto &[uri, document] : documentsByUri) {
             validate(document);
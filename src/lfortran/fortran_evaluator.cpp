@@ -333,8 +333,10 @@ Result<std::unique_ptr<LLVMModule>> FortranEvaluator::get_llvm2(
     if (!asr.ok) {
         return asr.error;
     }
+    compiler_options.po.location_manager = &lm;
     Result<std::unique_ptr<LLVMModule>> res = get_llvm3(*asr.result, pass_manager,
         diagnostics, lm.files.back().in_filename, nullptr);
+    compiler_options.po.location_manager = nullptr;
     if (res.ok) {
 #ifdef HAVE_LFORTRAN_LLVM
         std::unique_ptr<LLVMModule> m = std::move(res.result);
@@ -349,8 +351,10 @@ Result<std::unique_ptr<LLVMModule>> FortranEvaluator::get_llvm2(
 }
 
 /*
-    time_opt: keeps track of time taken by using `--fast` flag
-        i.e. time taken by optimizations, and used when
+    time_opt: keeps track of time taken by the LLVM optimization pipeline
+        (selected by `-O`, `--fast` or `--llvm-passes`), and used when
+        `--time-report` flag is used
+    llvm_pass_times: receives the time taken by each LLVM pass when
         `--time-report` flag is used
 */
 Result<std::unique_ptr<LLVMModule>> FortranEvaluator::get_llvm3(
@@ -362,7 +366,8 @@ Result<std::unique_ptr<LLVMModule>> FortranEvaluator::get_llvm3(
     diag::Diagnostics &/*diagnostics*/
 #endif
 , [[maybe_unused]] const std::string &infile,
-  [[maybe_unused]] int* time_opt=nullptr)
+  [[maybe_unused]] int* time_opt,
+  [[maybe_unused]] std::vector<std::string>* llvm_pass_times)
 {
 #ifdef HAVE_LFORTRAN_LLVM
     eval_count++;
@@ -398,9 +403,14 @@ Result<std::unique_ptr<LLVMModule>> FortranEvaluator::get_llvm3(
         return res.error;
     }
 
-    if (compiler_options.po.fast) {
+    std::string opt_level = compiler_options.opt_level;
+    if (opt_level.empty()) {
+        opt_level = compiler_options.po.fast ? "3" : "0";
+    }
+    if (opt_level != "0" || !compiler_options.llvm_passes.empty()) {
         auto t1 = std::chrono::high_resolution_clock::now();
-        e->opt(*m->m_m);
+        e->opt(*m->m_m, opt_level, compiler_options.llvm_passes,
+            compiler_options.po.time_report ? llvm_pass_times : nullptr);
         auto t2 = std::chrono::high_resolution_clock::now();
         if (compiler_options.po.time_report && time_opt) {
             *time_opt = std::chrono::duration_cast<std::chrono::microseconds>(t2 - t1).count();
@@ -86,7 +86,7 @@ public:
     Result<std::unique_ptr<LLVMModule>> get_llvm3(ASR::TranslationUnit_t &asr,
         LCompilers::PassManager& pass_manager,
         diag::Diagnostics &diagnostics, const std::string &infile,
-        int* time_opt);
+        int* time_opt, std::vector<std::string>* llvm_pass_times=nullptr);
     Result<std::string> get_asm(const std::string &code,
         LocationManager &lm,
         LCompilers::PassManager& pass_manager,
@@ -289,8 +289,6 @@ const std::vector<std::string> declarators{
             "class"
         };
 
-std::vector<std::string> lines{};
-
 std::vector<std::string> io_names{"open", "read", "write", "format", "close", "print"};
 
 void FixedFormTokenizer::set_string(const std::string &str)
@@ -319,6 +317,8 @@ struct FixedFormRecursiveDescent {
     std::vector<Location> locations;
     // Stack of do labels
     std::vector<int64_t> do_labels;
+    // Labels and lines consumed so far
+    std::vector<std::string> lines;
 
     FixedFormRecursiveDescent(diag::Diagnostics &diag,
         Allocator &m_a) : diag{diag}, m_a{m_a} {
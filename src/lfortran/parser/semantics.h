@@ -1825,6 +1825,7 @@ static inline ast_t* OMP_PRAGMA2(Allocator &al,
     Vec<expr_t *> m_clauses; m_clauses.reserve(al, 1);
     for (; i < omp_stmt.size(); i++) {
         if (omp_stmt[i] == "do" ||
+            omp_stmt[i] == "simd" ||
             omp_stmt[i] == "sections" ||
             omp_stmt[i] == "workshare" ) {
             construct_name += " " + omp_stmt[i];
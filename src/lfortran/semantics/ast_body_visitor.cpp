@@ -37,6 +37,21 @@ public:
     std::vector<ASR::symbol_t*> do_loop_variables;
     std::map<ASR::asr_t*, std::pair<const AST::stmt_t*,int64_t>> print_statements;
     std::vector<ASR::DoConcurrentLoop_t *> omp_constructs;
+    // pragma_nesting_level outside of each pending `!$omp simd`
+    std::vector<int> simd_pragma_nesting_levels;
+    // `!$omp parallel`, `single`, `master`, `task` and `taskloop` regions
+    // that are still open. Their statements are the ones appended to
+    // `body` from `start` on.
+    struct OMPRegionStart {
+        ASR::OMPRegion_t *region;
+        Vec<ASR::stmt_t*> *body;
+        size_t start;
+        int loop_nesting;
+        // The DoConcurrentLoop of `!$omp parallel` is still on
+        // omp_constructs, waiting for an `!$omp do` loop
+        bool construct_pending;
+    };
+    std::vector<OMPRegionStart> omp_regions;
 
     BodyVisitor(Allocator &al, ASR::asr_t *unit, diag::Diagnostics &diagnostics,
         CompilerOptions &compiler_options,
@@ -151,6 +166,20 @@ public:
             }
             // To avoid last statement to be entered twice once we exit this node
             tmp = nullptr;
+            if (!omp_regions.empty() && omp_regions.back().body == &body
+                    && omp_regions.back().region->m_region == ASR::omp_region_typeType::OMPTaskloop
+                    && AST::is_a<AST::DoLoop_t>(*m_body[i])) {
+                // `!$omp taskloop` ends with its loop
+                body.push_back(al, close_omp_region(m_body[i]->base.loc));
+            }
+        }
+        if (!omp_regions.empty() && omp_regions.back().body == &body) {
+            diag.add(Diagnostic(
+                "The OpenMP region is not closed in this block",
+                Level::Error, Stage::Semantic, {
+                    Label("",{omp_regions.back().region->base.base.loc})
+                }));
+            throw SemanticAbort();
         }
         current_body = current_body_copy;
     }
@@ -4340,7 +4369,7 @@ public:
         body.reserve(al, x.n_body);
         transform_stmts(body, x.n_body, x.m_body);
         tmp = ASR::make_WhileLoop_t(al, x.base.base.loc, x.m_stmt_name, test, body.p,
-                body.size(), nullptr, 0);
+                body.size(), nullptr, 0, false);
         all_loops_blocks_nesting -= 1;
     }
 
@@ -4448,6 +4477,12 @@ public:
                 do_concurrent->m_head = do_concurrent_head.p;
                 do_concurrent->n_head = do_concurrent_head.size();
                 tmp = (ASR::asr_t*) do_concurrent;
+                if (do_concurrent->m_schedule == ASR::schedule_typeType::ScheduleSequential) {
+                    // `!$omp simd` only applies to this loop
+                    omp_constructs.pop_back();
+                    pragma_nesting_level = simd_pragma_nesting_levels.back();
+                    simd_pragma_nesting_levels.pop_back();
+                }
             } else if (openmp_collapse == true && !omp_constructs.empty() && collapse_value > loop_nesting - static_cast<int>(omp_constructs.size()) - pragma_nesting_level) {
                 collapse_value--;
                 do_loop_heads_for_collapse.push_back(al, head);
@@ -4476,7 +4511,7 @@ public:
                 = ASRUtils::TYPE(ASR::make_Logical_t(al, x.base.base.loc, compiler_options.po.default_integer_kind));
             ASR::expr_t* cond = ASRUtils::EXPR(
                 ASR::make_LogicalConstant_t(al, x.base.base.loc, true, cond_type));
-            tmp = ASR::make_WhileLoop_t(al, x.base.base.loc, x.m_stmt_name, cond, body.p, body.size(), nullptr, 0);
+            tmp = ASR::make_WhileLoop_t(al, x.base.base.loc, x.m_stmt_name, cond, body.p, body.size(), nullptr, 0, false);
         }
         loop_nesting -= 1;
         all_loops_blocks_nesting -= 1;
@@ -4589,8 +4624,8 @@ public:
                 }
             }
         }
-        tmp = ASR::make_DoConcurrentLoop_t(al, x.base.base.loc, heads.p, heads.n, shared_expr.p, shared_expr.n, local_expr.p, local_expr.n, reductions.p, reductions.n, body.p,
-                body.size());
+        tmp = ASR::make_DoConcurrentLoop_t(al, x.base.base.loc, heads.p, heads.n, shared_expr.p, shared_expr.n, local_expr.p, local_expr.n, reductions.p, reductions.n,
+                ASR::schedule_typeType::ScheduleDefault, nullptr, false, body.p, body.size());
         all_loops_blocks_nesting -= 1;
     }
 
@@ -4873,6 +4908,187 @@ public:
 
     }
 
+    // Returns the variable named in an OpenMP clause
+    ASR::expr_t* omp_clause_variable(std::string s, const Location &loc) {
+        s.erase(0, s.find_first_not_of(" "));
+        s.erase(s.find_last_not_of(" ") + 1);
+        ASR::symbol_t *sym = current_scope->get_symbol(s);
+        if (!sym) {
+            diag.add(Diagnostic(
+                "The clause variable `"+ s
+                +"` is not declared",
+                Level::Error, Stage::Semantic, {
+                    Label("",{loc})
+                }));
+            throw SemanticAbort();
+        }
+        if (!ASR::is_a<ASR::Variable_t>(*sym)) {
+            diag.add(Diagnostic(
+                "Only a variable is supported"
+                " in the clause for now",
+                Level::Error, Stage::Semantic, {
+                    Label("",{loc})
+                }));
+            throw SemanticAbort();
+        }
+        return ASRUtils::EXPR(ASR::make_Var_t(al, loc, sym));
+    }
+
+    // Returns the integer constant or variable given as `what` in an
+    // OpenMP clause
+    ASR::expr_t* omp_clause_integer(std::string s, const Location &loc, const std::string &what) {
+        s.erase(0, s.find_first_not_of(" "));
+        s.erase(s.find_last_not_of(" ") + 1);
+        ASR::symbol_t *sym = current_scope->resolve_symbol(s);
+        if (!s.empty() && s.find_first_not_of("0123456789") == std::string::npos) {
+            return ASRUtils::EXPR(ASR::make_IntegerConstant_t(al, loc, std::stoi(s),
+                ASRUtils::TYPE(ASR::make_Integer_t(al, loc, compiler_options.po.default_integer_kind))));
+        } else if (sym && ASR::is_a<ASR::Variable_t>(*sym)
+                && ASRUtils::is_integer(*ASRUtils::symbol_type(sym))) {
+            return ASRUtils::EXPR(ASR::make_Var_t(al, loc, sym));
+        }
+        diag.add(Diagnostic(
+            "Only an integer constant or variable is"
+            " supported as " + what + " for now",
+            Level::Error, Stage::Semantic, {
+                Label("",{loc})
+            }));
+        throw SemanticAbort();
+    }
+
+    // Creates the (still empty) region of an `!$omp single`, `master`,
+    // `task`, `taskwait` or `taskloop` directive
+    ASR::OMPRegion_t* create_omp_region(const AST::Pragma_t &x,
+            ASR::omp_region_typeType region_type, const std::set<std::string> &supported_clauses) {
+        Location loc = x.base.base.loc;
+        Vec<ASR::expr_t*> m_shared, m_private, m_firstprivate;
+        m_shared.reserve(al, 1); m_private.reserve(al, 1); m_firstprivate.reserve(al, 1);
+        Vec<ASR::omp_depend_t> m_depend; m_depend.reserve(al, 1);
+        ASR::expr_t *grainsize = nullptr, *num_tasks = nullptr;
+        for (size_t i = 0; i < x.n_clauses; i++) {
+            std::string clause = AST::down_cast<AST::String_t>(
+                x.m_clauses[i])->m_s;
+            std::string clause_name = clause.substr(0, clause.find('('));
+            clause_name.erase(clause_name.find_last_not_of(" ") + 1);
+            if (supported_clauses.find(clause_name) == supported_clauses.end()) {
+                diag.add(Diagnostic(
+                    "The clause "+ clause_name
+                    +" is not supported yet",
+                    Level::Error, Stage::Semantic, {
+                        Label("",{loc})
+                    }));
+                throw SemanticAbort();
+            }
+            if (clause.find('(') == std::string::npos) {
+                // `nowait` and `untied` do not change the result
+                continue;
+            }
+            std::string list = clause.substr(clause.find('(') + 1);
+            list = list.substr(0, list.rfind(')'));
+            if (clause_name == "grainsize") {
+                grainsize = omp_clause_integer(list, loc, "the grainsize");
+            } else if (clause_name == "num_tasks") {
+                num_tasks = omp_clause_integer(list, loc, "the number of tasks");
+            } else if (clause_name == "depend") {
+                std::string kind = list.substr(0, list.find(':'));
+                kind.erase(0, kind.find_first_not_of(" "));
+                kind.erase(kind.find_last_not_of(" ") + 1);
+                ASR::omp_depend_typeType depend_type;
+                if (kind == "in") {
+                    depend_type = ASR::omp_depend_typeType::DependIn;
+                } else if (kind == "out") {
+                    depend_type = ASR::omp_depend_typeType::DependOut;
+                } else if (kind == "inout") {
+                    depend_type = ASR::omp_depend_typeType::DependInOut;
+                } else {
+                    diag.add(Diagnostic(
+                        "The dependence type "+ kind
+                        +" is not supported yet",
+                        Level::Error, Stage::Semantic, {
+                            Label("",{loc})
+                        }));
+                    throw SemanticAbort();
+                }
+                for (auto &s: LCompilers::string_split(list.substr(list.find(':') + 1), ",", false)) {
+                    ASR::omp_depend_t dep; dep.loc = loc; dep.m_kind = depend_type;
+                    dep.m_arg = omp_clause_variable(s, loc);
+                    m_depend.push_back(al, dep);
+                }
+            } else {
+                for (auto &s: LCompilers::string_split(list, ",", false)) {
+                    ASR::expr_t *v = omp_clause_variable(s, loc);
+                    if (clause_name == "shared") {
+                        m_shared.push_back(al, v);
+                    } else if (clause_name == "private") {
+                        m_private.push_back(al, v);
+                    } else {
+                        m_firstprivate.push_back(al, v);
+                    }
+                }
+            }
+        }
+        return ASR::down_cast2<ASR::OMPRegion_t>(ASR::make_OMPRegion_t(al, loc,
+            region_type, m_shared.p, m_shared.n, m_private.p, m_private.n,
+            m_firstprivate.p, m_firstprivate.n, m_depend.p, m_depend.n, nullptr,
+            grainsize, num_tasks, nullptr, 0));
+    }
+
+    // Moves the statements of the innermost open region into it
+    ASR::stmt_t* close_omp_region(const Location &loc) {
+        OMPRegionStart start = omp_regions.back();
+        omp_regions.pop_back();
+        Vec<ASR::stmt_t*> body; body.reserve(al, start.body->size() - start.start);
+        for (size_t i = start.start; i < start.body->size(); i++) {
+            body.push_back(al, (*start.body)[i]);
+        }
+        start.body->n = start.start;
+        ASR::OMPRegion_t *region = start.region;
+        region->m_body = body.p; region->n_body = body.size();
+        if (region->m_region == ASR::omp_region_typeType::OMPTaskloop
+                && (body.size() != 1 || !ASR::is_a<ASR::DoLoop_t>(*body[0])
+                    || !ASR::down_cast<ASR::DoLoop_t>(body[0])->m_head.m_v)) {
+            diag.add(Diagnostic(
+                "`!$omp taskloop` must be followed by a counted do loop",
+                Level::Error, Stage::Semantic, {
+                    Label("",{loc})
+                }));
+            throw SemanticAbort();
+        }
+        return &region->base;
+    }
+
+    void end_omp_parallel(const Location &loc) {
+        if (omp_regions.empty() || omp_regions.back().region->m_region != ASR::omp_region_typeType::OMPParallel
+                || omp_regions.back().body != current_body) {
+            diag.add(Diagnostic(
+                "`!$omp end parallel` does not close an `!$omp parallel`"
+                " region of the same block",
+                Level::Error, Stage::Semantic, {
+                    Label("",{loc})
+                }));
+            throw SemanticAbort();
+        }
+        if (omp_regions.back().construct_pending) {
+            ASR::DoConcurrentLoop_t *do_concurrent = omp_constructs.back();
+            omp_constructs.pop_back();
+            if (do_concurrent->m_head[0].m_v) {
+                // An `!$omp do` loop took the construct, the other
+                // statements stay on the current thread
+                omp_regions.pop_back();
+                return;
+            }
+            if (do_concurrent->n_reduction > 0) {
+                diag.add(Diagnostic(
+                    "The reduction clause is only supported on parallel loops for now",
+                    Level::Error, Stage::Semantic, {
+                        Label("",{do_concurrent->base.base.loc})
+                    }));
+                throw SemanticAbort();
+            }
+        }
+        tmp = (ASR::asr_t*) close_omp_region(loc);
+    }
+
     void visit_Pragma(const AST::Pragma_t &x) {
         if ( !compiler_options.openmp ) {
             return;
@@ -4880,7 +5096,17 @@ public:
         Location loc = x.base.base.loc;
         if (x.m_type == AST::OMPPragma) {
             if (x.m_end) {
-                if (LCompilers::startswith(x.m_construct_name, "parallel")) {
+                std::string name = to_lower(x.m_construct_name);
+                if (name == "parallel") {
+                    end_omp_parallel(loc);
+                    if (collapse_value > 0) {
+                        collapse_value = 0;
+                    }
+                    if (openmp_collapse) {
+                        openmp_collapse = false;
+                    }
+                    return;
+                } else if (LCompilers::startswith(x.m_construct_name, "parallel")) {
                     omp_constructs.pop_back();
                     if (collapse_value > 0) {
                         collapse_value = 0;
@@ -4889,18 +5115,38 @@ public:
                         openmp_collapse = false;
                     }
                     return;
+                } else if (name == "simd" || name == "taskloop") {
+                    // The construct ended with its loop
+                    return;
+                } else if (name == "single" || name == "master" || name == "task") {
+                    ASR::omp_region_typeType region = name == "single" ? ASR::omp_region_typeType::OMPSingle
+                        : name == "master" ? ASR::omp_region_typeType::OMPMaster : ASR::omp_region_typeType::OMPTask;
+                    if (omp_regions.empty() || omp_regions.back().region->m_region != region
+                            || omp_regions.back().body != current_body) {
+                        diag.add(Diagnostic(
+                            "`!$omp end " + name + "` does not close an `!$omp "
+                            + name + "` region of the same block",
+                            Level::Error, Stage::Semantic, {
+                                Label("",{loc})
+                            }));
+                        throw SemanticAbort();
+                    }
+                    tmp = (ASR::asr_t*) close_omp_region(loc);
+                    return;
                 }
             }
 
             if ( LCompilers::startswith(x.m_construct_name, "parallel") ) {
                 pragma_nesting_level = loop_nesting;
                 std::string name = x.m_construct_name;
+                bool simd = false;
                 if (name != "parallel") {
                     name = name.substr(9);
-                    if (name != "do") {
+                    simd = (name == "do simd");
+                    if (name != "do" && !simd) {
                         diag.add(Diagnostic(
-                            "Only `parallel do` combined construct"
-                            " is supported for now",
+                            "Only `parallel do` and `parallel do simd`"
+                            " combined constructs are supported for now",
                             Level::Error, Stage::Semantic, {
                                 Label("",{loc})
                             }));
@@ -4908,13 +5154,18 @@ public:
                     }
                 }
 
-                Vec<ASR::expr_t *> m_local, m_shared; Vec<ASR::reduction_expr_t> m_reduction;
-                m_local.reserve(al, 1); m_shared.reserve(al, 1); m_reduction.reserve(al, 1);
+                Vec<ASR::expr_t *> m_local, m_shared, m_firstprivate; Vec<ASR::reduction_expr_t> m_reduction;
+                m_local.reserve(al, 1); m_shared.reserve(al, 1); m_firstprivate.reserve(al, 1); m_reduction.reserve(al, 1);
+                ASR::schedule_typeType schedule = ASR::schedule_typeType::ScheduleDefault;
+                ASR::expr_t *chunk = nullptr, *num_threads = nullptr;
                 for (size_t i = 0; i < x.n_clauses; i++) {
                     std::string clause = AST::down_cast<AST::String_t>(
                         x.m_clauses[i])->m_s;
                     std::string clause_name = clause.substr(0, clause.find('('));
-                    if (clause_name != "private" && clause_name != "shared" && clause_name != "reduction" && clause_name != "collapse") {
+                    bool region_clause = name == "parallel" && (clause_name == "firstprivate"
+                        || clause_name == "num_threads");
+                    if (clause_name != "private" && clause_name != "shared" && clause_name != "reduction"
+                            && clause_name != "collapse" && clause_name != "schedule" && !region_clause) {
                         diag.add(Diagnostic(
                             "The clause "+ clause_name
                             +" is not supported yet",
@@ -4932,6 +5183,40 @@ public:
                         do_loop_heads_for_collapse.reserve(al, collapse_value);do_loop_bodies_for_collapse={};
                         continue;
                     }
+                    if (clause_name == "schedule") {
+                        // schedule([modifier:] kind[, chunk_size])
+                        std::vector<std::string> args = LCompilers::string_split(list, ",", false);
+                        std::string kind = args[0].substr(args[0].find(':') + 1);
+                        kind.erase(0, kind.find_first_not_of(" "));
+                        kind.erase(kind.find_last_not_of(" ") + 1);
+                        if ( kind == "static" ) {
+                            schedule = ASR::schedule_typeType::ScheduleStatic;
+                        } else if ( kind == "dynamic" ) {
+                            schedule = ASR::schedule_typeType::ScheduleDynamic;
+                        } else if ( kind == "guided" ) {
+                            schedule = ASR::schedule_typeType::ScheduleGuided;
+                        } else if ( kind == "auto" ) {
+                            schedule = ASR::schedule_typeType::ScheduleAuto;
+                        } else if ( kind == "runtime" ) {
+                            schedule = ASR::schedule_typeType::ScheduleRuntime;
+                        } else {
+                            diag.add(Diagnostic(
+                                "The schedule kind "+ kind
+                                +" is not supported yet",
+                                Level::Error, Stage::Semantic, {
+                                    Label("",{loc})
+                                }));
+                            throw SemanticAbort();
+                        }
+                        if (args.size() > 1) {
+                            chunk = omp_clause_integer(args[1], loc, "the chunk size");
+                        }
+                        continue;
+                    }
+                    if (clause_name == "num_threads") {
+                        num_threads = omp_clause_integer(list, loc, "the number of threads");
+                        continue;
+                    }
                     if (clause_name == "reduction") {
                         std::string reduction_op = list.substr(0, list.find(':'));
                         if ( reduction_op == "+" ) {
@@ -4956,35 +5241,16 @@ public:
                         list = list.substr(list.find(':')+1);
                     }
                     for (auto &s: LCompilers::string_split(list, ",", false)) {
-                        s.erase(0, s.find_first_not_of(" "));
-                        ASR::symbol_t *sym = current_scope->get_symbol(s);
-                        if (sym) {
-                            if (!ASR::is_a<ASR::Variable_t>(*sym)) {
-                                diag.add(Diagnostic(
-                                    "Only a variable is supported"
-                                    " in the clause for now",
-                                    Level::Error, Stage::Semantic, {
-                                        Label("",{loc})
-                                    }));
-                                throw SemanticAbort();
-                            }
-                            ASR::expr_t *v = ASRUtils::EXPR(ASR::make_Var_t(al, loc, sym));
-                            if (clause_name == "private") {
-                                m_local.push_back(al, v);
-                            } else if (clause_name == "reduction") {
-                                ASR::reduction_expr_t re; re.loc = loc; re.m_arg = v; re.m_op = op;
-                                m_reduction.push_back(al, re);
-                            } else {
-                                m_shared.push_back(al, v);
-                            }
+                        ASR::expr_t *v = omp_clause_variable(s, loc);
+                        if (clause_name == "private") {
+                            m_local.push_back(al, v);
+                        } else if (clause_name == "firstprivate") {
+                            m_firstprivate.push_back(al, v);
+                        } else if (clause_name == "reduction") {
+                            ASR::reduction_expr_t re; re.loc = loc; re.m_arg = v; re.m_op = op;
+                            m_reduction.push_back(al, re);
                         } else {
-                            diag.add(Diagnostic(
-                                "The clause variable `"+ s
-                                +"` is not declared",
-                                Level::Error, Stage::Semantic, {
-                                    Label("",{loc})
-                                }));
-                            throw SemanticAbort();
+                            m_shared.push_back(al, v);
                         }
                     }
                 }
@@ -4994,10 +5260,87 @@ public:
                 heads.push_back(al, head);
                 omp_constructs.push_back(ASR::down_cast2<ASR::DoConcurrentLoop_t>(
                 ASR::make_DoConcurrentLoop_t(al,loc, heads.p, heads.n, m_shared.p,
-                m_shared.n, m_local.p, m_local.n, m_reduction.p, m_reduction.n, nullptr, 0)));
+                m_shared.n, m_local.p, m_local.n, m_reduction.p, m_reduction.n,
+                schedule, chunk, simd, nullptr, 0)));
+                if (name == "parallel") {
+                    // Without an `!$omp do` loop the statements up to
+                    // `!$omp end parallel` become a parallel region
+                    ASR::OMPRegion_t *region = ASR::down_cast2<ASR::OMPRegion_t>(
+                        ASR::make_OMPRegion_t(al, loc, ASR::omp_region_typeType::OMPParallel,
+                        m_shared.p, m_shared.n, m_local.p, m_local.n, m_firstprivate.p,
+                        m_firstprivate.n, nullptr, 0, num_threads, nullptr, nullptr, nullptr, 0));
+                    omp_regions.push_back({region, current_body, current_body->size(),
+                        loop_nesting, true});
+                }
 
             } else if ( to_lower(x.m_construct_name) == "do" ) {
-                // pass
+                if (!omp_regions.empty() && omp_regions.back().region->m_region == ASR::omp_region_typeType::OMPParallel
+                        && !omp_regions.back().construct_pending) {
+                    diag.add(Diagnostic(
+                        "`!$omp do` in a parallel region that also contains"
+                        " other OpenMP constructs is not supported yet",
+                        Level::Error, Stage::Semantic, {
+                            Label("",{loc})
+                        }));
+                    throw SemanticAbort();
+                }
+            } else if ( to_lower(x.m_construct_name) == "simd" ) {
+                // The loop stays on the current thread, so private and
+                // reduction variables need no copies and the hints are
+                // left to the vectorizer
+                for (size_t i = 0; i < x.n_clauses; i++) {
+                    std::string clause = AST::down_cast<AST::String_t>(
+                        x.m_clauses[i])->m_s;
+                    std::string clause_name = clause.substr(0, clause.find('('));
+                    if (clause_name != "private" && clause_name != "reduction"
+                            && clause_name != "simdlen" && clause_name != "safelen") {
+                        diag.add(Diagnostic(
+                            "The clause "+ clause_name
+                            +" is not supported yet",
+                            Level::Error, Stage::Semantic, {
+                                Label("",{loc})
+                            }));
+                        throw SemanticAbort();
+                    }
+                }
+                simd_pragma_nesting_levels.push_back(pragma_nesting_level);
+                pragma_nesting_level = loop_nesting;
+                Vec<ASR::do_loop_head_t> heads;
+                heads.reserve(al,1);
+                ASR::do_loop_head_t head{};
+                heads.push_back(al, head);
+                omp_constructs.push_back(ASR::down_cast2<ASR::DoConcurrentLoop_t>(
+                ASR::make_DoConcurrentLoop_t(al, loc, heads.p, heads.n, nullptr, 0,
+                nullptr, 0, nullptr, 0, ASR::schedule_typeType::ScheduleSequential,
+                nullptr, true, nullptr, 0)));
+            } else if ( to_lower(x.m_construct_name) == "taskwait" ) {
+                tmp = (ASR::asr_t*) create_omp_region(x, ASR::omp_region_typeType::OMPTaskwait, {});
+            } else if ( to_lower(x.m_construct_name) == "single"
+                    || to_lower(x.m_construct_name) == "master"
+                    || to_lower(x.m_construct_name) == "task"
+                    || to_lower(x.m_construct_name) == "taskloop" ) {
+                std::string name = to_lower(x.m_construct_name);
+                ASR::OMPRegion_t *region;
+                if (name == "single") {
+                    region = create_omp_region(x, ASR::omp_region_typeType::OMPSingle, {"nowait"});
+                } else if (name == "master") {
+                    region = create_omp_region(x, ASR::omp_region_typeType::OMPMaster, {});
+                } else if (name == "task") {
+                    region = create_omp_region(x, ASR::omp_region_typeType::OMPTask,
+                        {"shared", "private", "firstprivate", "depend", "untied"});
+                } else {
+                    region = create_omp_region(x, ASR::omp_region_typeType::OMPTaskloop,
+                        {"shared", "private", "firstprivate", "grainsize", "num_tasks", "untied"});
+                }
+                if (!omp_regions.empty() && omp_regions.back().construct_pending
+                        && omp_regions.back().loop_nesting == loop_nesting) {
+                    // The enclosing `!$omp parallel` is a region, not the
+                    // start of an `!$omp do` loop
+                    omp_constructs.pop_back();
+                    omp_regions.back().construct_pending = false;
+                }
+                omp_regions.push_back({region, current_body, current_body->size(),
+                    loop_nesting, false});
             } else {
                 diag.add(Diagnostic(
                     "The construct "+ std::string(x.m_construct_name)
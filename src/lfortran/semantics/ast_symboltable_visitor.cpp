@@ -8,6 +8,7 @@
 #include <libasr/asr.h>
 #include <libasr/asr_utils.h>
 #include <libasr/asr_verify.h>
+#include <libasr/modfile.h>
 #include <libasr/exception.h>
 #include <lfortran/semantics/asr_implicit_cast_rules.h>
 #include <lfortran/semantics/ast_common_visitor.h>
@@ -3042,6 +3043,47 @@ public:
         }
     }
 
+    // The names in the module of the symbols imported by `use mod, only: ...`.
+    // Returns false if they cannot all be determined.
+    bool use_only_names(const AST::Use_t &x, std::vector<std::string> &names) {
+        for (size_t i = 0; i < x.n_symbols; i++) {
+            switch (x.m_symbols[i]->type) {
+                case AST::use_symbolType::UseSymbol: {
+                    names.push_back(to_lower(AST::down_cast<AST::UseSymbol_t>(
+                        x.m_symbols[i])->m_remote_sym));
+                    break;
+                }
+                case AST::use_symbolType::UseAssignment: {
+                    names.push_back("~assign");
+                    break;
+                }
+                case AST::use_symbolType::IntrinsicOperator: {
+                    names.push_back(intrinsic2str[AST::down_cast<AST::IntrinsicOperator_t>(
+                        x.m_symbols[i])->m_op]);
+                    break;
+                }
+                case AST::use_symbolType::DefinedOperator: {
+                    names.push_back(AST::down_cast<AST::DefinedOperator_t>(
+                        x.m_symbols[i])->m_opName);
+                    break;
+                }
+                case AST::use_symbolType::UseWrite: {
+                    names.push_back("~write_" + std::string(
+                        AST::down_cast<AST::UseWrite_t>(x.m_symbols[i])->m_id));
+                    break;
+                }
+                case AST::use_symbolType::UseRead: {
+                    names.push_back("~read_" + std::string(
+                        AST::down_cast<AST::UseRead_t>(x.m_symbols[i])->m_id));
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return true;
+    }
+
     void visit_Use(const AST::Use_t &x) {
         std::string msym = to_lower(x.m_module);
         if (msym == "ieee_arithmetic") {
@@ -3051,8 +3093,14 @@ public:
         char *msym_cc = msym_c.c_str(al);
         current_module_dependencies.push_back(al, msym_cc);
 
+        // With an only-list, only the imported symbols of the module and the
+        // symbols they need are loaded, the rest is loaded when needed
+        std::vector<std::string> only;
+        bool load_only = compiler_options.po.lazy_modfiles
+            && x.m_only_present && x.n_symbols > 0 && use_only_names(x, only);
         ASR::symbol_t *t = current_scope->resolve_symbol(msym);
-        if (!t) {
+        if (!t || (ASR::is_a<ASR::Module_t>(*t)
+                && is_lazily_loaded(*ASR::down_cast<ASR::Module_t>(t)))) {
             SymbolTable *tu_symtab = current_scope;
             while (tu_symtab->parent != nullptr) {
                 tu_symtab = tu_symtab->parent;
@@ -3064,7 +3112,8 @@ public:
                         msg, diag::Level::Error, diag::Stage::Semantic, {
                             diag::Label("", {loc})}));
                     throw SemanticAbort();
-            }, lm, compiler_options.generate_object_code));
+            }, lm, compiler_options.generate_object_code,
+                load_only ? &only : nullptr));
         }
         if (!ASR::is_a<ASR::Module_t>(*t)) {
             diag.add(diag::Diagnostic(
@@ -3,6 +3,8 @@
 #include <sstream>
 
 #include <iostream>
+#include <chrono>
+#include <thread>
 
 #include <lfortran/fortran_evaluator.h>
 #include <libasr/codegen/evaluator.h>
@@ -11,8 +13,10 @@
 #include <libasr/asr.h>
 #include <lfortran/parser/parser.h>
 #include <lfortran/semantics/ast_to_asr.h>
+#include <libasr/asr_utils.h>
 #include <libasr/asr_verify.h>
 #include <libasr/utils.h>
+#include <libasr/pass/pass_manager.h>
 
 namespace LCompilers::LFortran {
 
@@ -147,5 +151,217 @@ end program
     }
 }
 
+TEST_CASE("Parallel get_asr2") {
+    // Each document is compiled by its own FortranEvaluator, Allocator and
+    // LocationManager, exactly like the language server does for every
+    // request, so independent documents can be compiled concurrently.
+    auto make_src = [](int n) {
+        std::string src = "module mod_" + std::to_string(n) + "\n"
+            "implicit none\n"
+            "contains\n";
+        for (int i = 0; i < 50; i++) {
+            std::string f = "f" + std::to_string(i);
+            src += "integer function " + f + "(x) result(r)\n"
+                "integer, intent(in) :: x\n"
+                "integer :: i\n"
+                "r = 0\n"
+                "do i = 1, x\n"
+                "    r = r + i*" + std::to_string(i) + "\n"
+                "end do\n"
+                "end function\n";
+        }
+        src += "end module\n";
+        return src;
+    };
+    auto compile = [](const std::string &src) {
+        CompilerOptions compiler_options;
+        LCompilers::LocationManager lm;
+        {
+            LCompilers::LocationManager::FileLocations fl;
+            fl.in_filename = "input.f90";
+            lm.files.push_back(fl);
+            lm.file_ends.push_back(src.size());
+        }
+        LCompilers::diag::Diagnostics diagnostics;
+        FortranEvaluator e(compiler_options);
+        LCompilers::Result<LCompilers::ASR::TranslationUnit_t*>
+            r = e.get_asr2(src, lm, diagnostics);
+        return r.ok && asr_verify(*r.result, true, diagnostics)
+            && r.result->m_symtab->get_scope().size() == 1;
+    };
+
+    const int n_threads = 8;
+    const int n_repeat = 4;
+    std::vector<std::string> sources;
+    for (int i = 0; i < n_threads; i++) sources.push_back(make_src(i));
+
+    auto t1 = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < n_threads; i++) {
+        for (int j = 0; j < n_repeat; j++) CHECK(compile(sources[i]));
+    }
+    auto t2 = std::chrono::high_resolution_clock::now();
+
+    std::vector<int> ok(n_threads, 0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < n_threads; i++) {
+        threads.emplace_back([&, i]() {
+            bool all_ok = true;
+            for (int j = 0; j < n_repeat; j++) all_ok &= compile(sources[i]);
+            ok[i] = all_ok;
+        });
+    }
+    for (auto &t : threads) t.join();
+    auto t3 = std::chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < n_threads; i++) CHECK(ok[i]);
+    double serial = std::chrono::duration<double, std::milli>(t2 - t1).count();
+    double parallel = std::chrono::duration<double, std::milli>(t3 - t2).count();
+    MESSAGE("get_asr2 of " << n_threads << " documents: serial " << serial
+        << " ms, parallel " << parallel << " ms, speedup "
+        << serial / parallel << "x on "
+        << std::thread::hardware_concurrency() << " hardware threads");
+}
+
+TEST_CASE("Parallel function-local passes") {
+    std::string src = "module mod_passes\n"
+        "implicit none\n"
+        "contains\n";
+    for (int i = 0; i < 40; i++) {
+        std::string n = std::to_string(i);
+        src += "subroutine f" + n + "(x, a)\n"
+            "integer, intent(inout) :: x\n"
+            "real, intent(inout) :: a(10)\n"
+            "integer :: i\n"
+            "do i = 1, x\n"
+            "    select case (mod(i, 3))\n"
+            "    case (0)\n"
+            "        x = x + " + n + "\n"
+            "    case default\n"
+            "        x = x - 1\n"
+            "    end select\n"
+            "end do\n"
+            "where (a > 0.0) a = 0.0\n"
+            "end subroutine\n";
+    }
+    src += "end module\n";
+
+    auto apply = [&](size_t pass_threads) {
+        CompilerOptions compiler_options;
+        compiler_options.po.pass_threads = pass_threads;
+        LCompilers::LocationManager lm;
+        {
+            LCompilers::LocationManager::FileLocations fl;
+            fl.in_filename = "input.f90";
+            lm.files.push_back(fl);
+            lm.file_ends.push_back(src.size());
+        }
+        LCompilers::diag::Diagnostics diagnostics;
+        FortranEvaluator e(compiler_options);
+        LCompilers::Result<LCompilers::ASR::TranslationUnit_t*>
+            r = e.get_asr2(src, lm, diagnostics);
+        REQUIRE(r.ok);
+        Allocator al(64*1024);
+        LCompilers::PassManager lpm;
+        std::string passes = "where,do_loops,select_case", skip;
+        lpm.parse_pass_arg(passes, skip);
+        lpm.apply_passes(al, r.result, compiler_options.po, diagnostics);
+        CHECK(asr_verify(*r.result, true, diagnostics));
+        LCompilers::Result<std::string> code = LCompilers::asr_to_fortran(
+            *r.result, diagnostics, false, 4);
+        REQUIRE(code.ok);
+        return code.result;
+    };
+
+    std::string serial = apply(1);
+    CHECK(serial.find("do i =") == std::string::npos);
+    CHECK(serial.find("select case") == std::string::npos);
+    CHECK(apply(4) == serial);
+}
+
+TEST_CASE("SymbolTable") {
+    Allocator al(1024);
+    SymbolTable global(nullptr), local(&global);
+    ASR::symbol_t *a = (ASR::symbol_t*)al.allocate<int64_t>();
+    ASR::symbol_t *b = (ASR::symbol_t*)al.allocate<int64_t>();
+    for (int i = 0; i < 1000; i++) {
+        global.add_symbol("g" + std::to_string(i), a);
+    }
+    local.add_symbol("x", b);
+    local.add_symbol("g7", b);
+    CHECK(local.resolve_symbol("g7") == b);
+    CHECK(local.resolve_symbol("g8") == a);
+    CHECK(local.resolve_symbol("y") == nullptr);
+    CHECK(local.get_symbol("g8") == nullptr);
+
+    local.erase_symbol("g7");
+    CHECK(local.resolve_symbol("g7") == a);
+    for (int i = 0; i < 1000; i += 2) {
+        global.erase_symbol("g" + std::to_string(i));
+    }
+    global.overwrite_symbol("g9", b);
+    global.add_or_overwrite_symbol("g10", b);
+    global.add_or_overwrite_symbol("g11", b);
+    CHECK(global.get_scope().size() == 501);
+    for (int i = 0; i < 1000; i++) {
+        ASR::symbol_t *s = global.get_symbol("g" + std::to_string(i));
+        if (i % 2 == 0 && i != 10) {
+            CHECK(s == nullptr);
+        } else {
+            CHECK(s == (i == 9 || i == 10 || i == 11 ? b : a));
+        }
+    }
+
+    // Iteration stays sorted by name, independent of the insertion order
+    std::string prev;
+    for (auto &item : global.get_scope()) {
+        CHECK(prev < item.first);
+        prev = item.first;
+    }
+    CHECK(global.get_unique_name("g1", false) == "g12");
+}
+
+TEST_CASE("get_asr2 of a module with 50000 symbols") {
+    const int n_symbols = 50000;
+    std::string src = "module mod_symbols\n"
+        "implicit none\n";
+    for (int i = 0; i < n_symbols; i += 100) {
+        src += "integer :: v" + std::to_string(i);
+        for (int j = i + 1; j < i + 100; j++) {
+            src += ", v" + std::to_string(j);
+        }
+        src += "\n";
+    }
+    src += "contains\n"
+        "integer function f() result(r)\n"
+        "r = 0\n";
+    for (int i = 0; i < n_symbols; i += 7) {
+        src += "r = r + v" + std::to_string(i) + "\n";
+    }
+    src += "end function\n"
+        "end module\n";
+
+    CompilerOptions compiler_options;
+    LCompilers::LocationManager lm;
+    {
+        LCompilers::LocationManager::FileLocations fl;
+        fl.in_filename = "input.f90";
+        lm.files.push_back(fl);
+        lm.file_ends.push_back(src.size());
+    }
+    LCompilers::diag::Diagnostics diagnostics;
+    FortranEvaluator e(compiler_options);
+    auto t1 = std::chrono::high_resolution_clock::now();
+    LCompilers::Result<LCompilers::ASR::TranslationUnit_t*>
+        r = e.get_asr2(src, lm, diagnostics);
+    auto t2 = std::chrono::high_resolution_clock::now();
+    REQUIRE(r.ok);
+    ASR::symbol_t *m = r.result->m_symtab->get_symbol("mod_symbols");
+    REQUIRE(m);
+    // n_symbols variables and the function `f`
+    CHECK(ASRUtils::symbol_symtab(m)->get_scope().size() == n_symbols + 1);
+    MESSAGE("get_asr2 of a module with " << n_symbols << " symbols: "
+        << std::chrono::duration<double, std::milli>(t2 - t1).count()
+        << " ms");
+}
 
 } // namespace LCompilers::LFortran
@@ -1,4 +1,7 @@
 #include <tests/doctest.h>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
 
 #include <libasr/bwriter.h>
@@ -331,6 +334,263 @@ end module
 
 }
 
+TEST_CASE("Modfile cache") {
+    Allocator al(4*1024);
+    std::string src = R"""(
+module modfile_cache_a
+implicit none
+integer :: x = 5
+end module
+)""";
+    LCompilers::LFortran::AST::TranslationUnit_t* ast0;
+    LCompilers::diag::Diagnostics diagnostics;
+    LCompilers::CompilerOptions compiler_options;
+    ast0 = TRY(LCompilers::LFortran::parse(al, src, diagnostics, compiler_options));
+    LCompilers::LocationManager lm;
+    {
+        LCompilers::LocationManager::FileLocations fl;
+        fl.in_filename = "modfile_cache_a.f90";
+        lm.files.push_back(fl);
+        lm.file_ends.push_back(src.size());
+        lm.init_simple(src);
+    }
+    LCompilers::ASR::TranslationUnit_t* asr = TRY(LCompilers::LFortran::ast_to_asr(al, *ast0,
+        diagnostics, nullptr, false, compiler_options, lm));
+
+    std::filesystem::path dir = std::filesystem::temp_directory_path()
+        / "lfortran_test_modfile_cache";
+    std::filesystem::create_directories(dir);
+    std::string modfile = LCompilers::save_modfile(*asr, lm);
+    {
+        std::ofstream out((dir / "modfile_cache_a.mod").string(), std::ios::binary);
+        out << modfile;
+    }
+
+    LCompilers::ModfileCache cache;
+    std::vector<std::filesystem::path> dirs = {dir / "missing", dir};
+    auto m1 = cache.find(dirs, "modfile_cache_a.mod");
+    REQUIRE(m1 != nullptr);
+    CHECK(cache.get_stats().lookups == 1);
+    CHECK(cache.get_stats().hits == 0);
+    CHECK(cache.find(dirs, "modfile_cache_b.mod") == nullptr);
+
+    // Unchanged (mtime, size): served without reading the file
+    auto m2 = cache.find(dirs, "modfile_cache_a.mod");
+    CHECK(m2 == m1);
+    CHECK(cache.get_stats().hits == 1);
+
+    // Rewritten with the same content: served by the content hash
+    {
+        std::ofstream out((dir / "modfile_cache_a.mod").string(), std::ios::binary);
+        out << modfile;
+    }
+    std::filesystem::last_write_time(dir / "modfile_cache_a.mod",
+        std::filesystem::last_write_time(dir / "modfile_cache_a.mod")
+        + std::chrono::seconds(1));
+    auto m3 = cache.find(dirs, "modfile_cache_a.mod");
+    CHECK(m3 == m1);
+    CHECK(cache.get_stats().lookups == 3);
+    CHECK(cache.get_stats().hits == 2);
+
+    LCompilers::SymbolTable symtab(nullptr);
+    LCompilers::ASR::TranslationUnit_t *asr2 = LCompilers::load_modfile(al,
+            *m3, true, symtab, lm);
+    fix_external_symbols(*asr2, symtab);
+    CHECK(LCompilers::asr_verify(*asr2, true, diagnostics));
+    CHECK(LCompilers::pickle(*asr) == LCompilers::pickle(*asr2));
+
+    std::filesystem::remove_all(dir);
+}
+
+TEST_CASE("Lazy modfile loading") {
+    Allocator al(4*1024);
+    std::string src = R"""(
+module modfile_lazy_a
+implicit none
+type :: point
+    real :: x, y
+end type
+integer, parameter :: n = 3
+contains
+    real function norm2p(p)
+    type(point), intent(in) :: p
+    norm2p = sqrt(p%x**2 + p%y**2)
+    end function
+    real function twice_norm(p)
+    type(point), intent(in) :: p
+    twice_norm = 2*norm2p(p)
+    end function
+    integer function unrelated()
+    unrelated = n
+    end function
+end module
+)""";
+    LCompilers::LFortran::AST::TranslationUnit_t* ast0;
+    LCompilers::diag::Diagnostics diagnostics;
+    LCompilers::CompilerOptions compiler_options;
+    ast0 = TRY(LCompilers::LFortran::parse(al, src, diagnostics, compiler_options));
+    LCompilers::LocationManager lm;
+    {
+        LCompilers::LocationManager::FileLocations fl;
+        fl.in_filename = "modfile_lazy_a.f90";
+        lm.files.push_back(fl);
+        lm.file_ends.push_back(src.size());
+        lm.init_simple(src);
+    }
+    LCompilers::ASR::TranslationUnit_t* asr = TRY(LCompilers::LFortran::ast_to_asr(al, *ast0,
+        diagnostics, nullptr, false, compiler_options, lm));
+    std::shared_ptr<const LCompilers::ParsedModfile> m
+        = std::make_shared<const LCompilers::ParsedModfile>(
+            LCompilers::parse_modfile(LCompilers::save_modfile(*asr, lm)));
+    REQUIRE(m->symbol_index.count("twice_norm") == 1);
+    REQUIRE(m->symbol_index.count("unrelated") == 1);
+
+    // Only the requested symbol and the symbols it refers to are loaded
+    LCompilers::SymbolTable symtab(nullptr);
+    LCompilers::ASR::TranslationUnit_t *asr2 = LCompilers::load_modfile_lazily(
+        al, m, {"twice_norm"}, symtab, lm);
+    LCompilers::ASR::Module_t *mod = LCompilers::ASRUtils::extract_module(*asr2);
+    CHECK(mod->m_symtab->get_symbol("twice_norm") != nullptr);
+    CHECK(mod->m_symtab->get_symbol("norm2p") != nullptr);
+    CHECK(mod->m_symtab->get_symbol("point") != nullptr);
+    CHECK(mod->m_symtab->get_symbol("unrelated") == nullptr);
+    CHECK(mod->m_symtab->get_symbol("n") == nullptr);
+    CHECK(LCompilers::is_lazily_loaded(*mod));
+    fix_external_symbols(*asr2, symtab);
+    CHECK(LCompilers::asr_verify(*asr2, true, diagnostics));
+
+    // The rest is loaded on demand
+    CHECK(LCompilers::load_lazy_symbols(al, *mod, nullptr));
+    CHECK(mod->m_symtab->get_symbol("unrelated") != nullptr);
+    CHECK(mod->m_symtab->get_symbol("n") != nullptr);
+    CHECK(!LCompilers::is_lazily_loaded(*mod));
+    CHECK(!LCompilers::load_lazy_symbols(al, *mod, nullptr));
+    CHECK(mod->m_symtab->get_scope().size() == m->symbols.size());
+    fix_external_symbols(*asr2, symtab);
+    CHECK(LCompilers::asr_verify(*asr2, true, diagnostics));
+
+    // A name that is not in the index loads the whole module
+    LCompilers::SymbolTable symtab2(nullptr);
+    LCompilers::ASR::TranslationUnit_t *asr3 = LCompilers::load_modfile_lazily(
+        al, m, {"missing"}, symtab2, lm);
+    mod = LCompilers::ASRUtils::extract_module(*asr3);
+    CHECK(!LCompilers::is_lazily_loaded(*mod));
+    CHECK(mod->m_symtab->get_scope().size() == m->symbols.size());
+}
+
+TEST_CASE("BinaryWriter and BinaryReader") {
+    LCompilers::BinaryWriter w;
+    std::vector<uint64_t> ints = {0, 1, 127, 128, 300, 16383, 16384,
+        4294967295U, 4294967296U, 18446744073709551615U};
+    for (uint64_t i : ints) {
+        w.write_int64(i);
+    }
+    w.write_string("name");
+    w.write_string(std::string(1000, 'x'));
+    w.write_string("other");
+    w.write_string("name");
+    w.write_string(std::string(1000, 'x'));
+    w.write_string("");
+    w.write_float64(-1.5e300);
+    int32_t data[3] = {-1, 2, 3};
+    w.write_void(data, sizeof(data));
+    w.write_int8(255);
+    std::string s = w.get_str();
+    // Small integers take a single byte, the repeated short string a
+    // single byte too
+    CHECK(s.size() == 1+1+1+2+2+2+3+5+5+10 + 5+1002+6+1+1002+1 + 8+12+1);
+
+    LCompilers::BinaryReader r(s);
+    for (uint64_t i : ints) {
+        CHECK(r.read_int64() == i);
+    }
+    CHECK(r.read_string() == "name");
+    CHECK(r.read_string() == std::string(1000, 'x'));
+    CHECK(r.read_string() == "other");
+    CHECK(r.read_string() == "name");
+    CHECK(r.read_string() == std::string(1000, 'x'));
+    CHECK(r.read_string() == "");
+    CHECK(r.read_float64() == -1.5e300);
+    int32_t *data2 = (int32_t*)r.read_void(sizeof(data));
+    CHECK(data2[0] == -1);
+    CHECK(data2[2] == 3);
+    delete[] (char*)data2;
+    CHECK(r.read_int8() == 255);
+    CHECK(r.get_pos() == s.size());
+    CHECK_THROWS_AS(r.read_int8(), LCompilers::LCompilersException);
+}
+
+TEST_CASE("Modfile size and round trip") {
+    Allocator al(4*1024);
+    std::string src = "module modfile_size_a\n"
+        "implicit none\n"
+        "type :: point\n"
+        "    real :: x, y\n"
+        "end type\n";
+    for (int i = 0; i < 500; i++) {
+        src += "integer, parameter :: c" + std::to_string(i) + " = "
+            + std::to_string(i * 1000) + "\n";
+    }
+    src += "contains\n";
+    for (int i = 0; i < 200; i++) {
+        std::string n = std::to_string(i);
+        src += "real function f" + n + "(p, a) result(r)\n"
+            "type(point), intent(in) :: p\n"
+            "real, intent(in) :: a(:)\n"
+            "integer :: i\n"
+            "r = p%x * c" + n + "\n"
+            "do i = 1, size(a)\n"
+            "    r = r + a(i) * p%y\n"
+            "end do\n"
+            "end function\n";
+    }
+    src += "end module\n";
+    LCompilers::LFortran::AST::TranslationUnit_t* ast0;
+    LCompilers::diag::Diagnostics diagnostics;
+    LCompilers::CompilerOptions compiler_options;
+    ast0 = TRY(LCompilers::LFortran::parse(al, src, diagnostics, compiler_options));
+    LCompilers::LocationManager lm;
+    {
+        LCompilers::LocationManager::FileLocations fl;
+        fl.in_filename = "modfile_size_a.f90";
+        lm.files.push_back(fl);
+        lm.file_ends.push_back(src.size());
+        lm.init_simple(src);
+    }
+    LCompilers::ASR::TranslationUnit_t* asr = TRY(LCompilers::LFortran::ast_to_asr(al, *ast0,
+        diagnostics, nullptr, false, compiler_options, lm));
+    std::string asr_orig = LCompilers::pickle(*asr);
+
+    const int n_repeat = 10;
+    for (bool compress : {false, true}) {
+#ifndef HAVE_ZLIB
+        if (compress) break;
+#endif
+        std::string modfile;
+        auto t1 = std::chrono::high_resolution_clock::now();
+        for (int i = 0; i < n_repeat; i++) {
+            modfile = LCompilers::save_modfile(*asr, lm, compress);
+        }
+        auto t2 = std::chrono::high_resolution_clock::now();
+        LCompilers::ASR::TranslationUnit_t *asr2 = nullptr;
+        for (int i = 0; i < n_repeat; i++) {
+            LCompilers::LocationManager lm2 = lm;
+            LCompilers::SymbolTable symtab(nullptr);
+            asr2 = LCompilers::load_modfile(al, modfile, true, symtab, lm2);
+            fix_external_symbols(*asr2, symtab);
+        }
+        auto t3 = std::chrono::high_resolution_clock::now();
+        CHECK(LCompilers::asr_verify(*asr2, true, diagnostics));
+        CHECK(LCompilers::pickle(*asr2) == asr_orig);
+        MESSAGE("modfile" << (compress ? " (compressed)" : "") << ": "
+            << modfile.size() << " bytes, save "
+            << std::chrono::duration<double, std::milli>(t2 - t1).count() / n_repeat
+            << " ms, load "
+            << std::chrono::duration<double, std::milli>(t3 - t2).count() / n_repeat
+            << " ms");
+    }
+}
+
 TEST_CASE("Topological sorting mod_int") {
     std::map<std::string, std::vector<std::string>> deps;
     // 1 depends on 2
@@ -112,6 +112,18 @@ public:
         //return new T(std::forward<Args>(args)...);
     }
 
+    // Takes over all memory blocks of `other`, so that everything allocated
+    // by `other` stays alive as long as this allocator does. `other` must not
+    // be used for allocations afterwards.
+    void adopt(Allocator &other) {
+        LCOMPILERS_ASSERT(&other != this);
+        blocks.insert(blocks.end(), other.blocks.begin(), other.blocks.end());
+        other.blocks.clear();
+        other.start = nullptr;
+        other.current_pos = 0;
+        other.size = 0;
+    }
+
     size_t size_current() {
         return current_pos - (size_t)start;
     }
@@ -1,3 +1,4 @@
+#include <atomic>
 #include <iomanip>
 #include <sstream>
 
@@ -19,17 +20,65 @@ std::string hexify(T i)
     return buf.str();
 }
 
-unsigned int symbol_table_counter = 0;
+// Atomic so that independent compilations (e.g. in the language server) can
+// create symbol tables from several threads and still get unique IDs.
+std::atomic<unsigned int> symbol_table_counter = 0;
 
 SymbolTable::SymbolTable(SymbolTable *parent) : parent{parent} {
-    symbol_table_counter++;
-    counter = symbol_table_counter;
+    counter = ++symbol_table_counter;
 }
 
 void SymbolTable::reset_global_counter() {
     symbol_table_counter = 0;
 }
 
+void SymbolTable::index_insert(scope_t::value_type *entry, size_t hash) {
+    // Keep the load factor at most 1/2, so that probe sequences stay short
+    if (2 * scope.size() > index.size()) {
+        std::vector<IndexSlot> old_index(std::max<size_t>(8, 2 * index.size()),
+            IndexSlot{0, nullptr});
+        old_index.swap(index);
+        size_t mask = index.size() - 1;
+        for (auto &slot : old_index) {
+            if (slot.entry == nullptr) continue;
+            size_t i = slot.hash & mask;
+            while (index[i].entry) i = (i + 1) & mask;
+            index[i] = slot;
+        }
+    }
+    size_t mask = index.size() - 1;
+    size_t i = hash & mask;
+    while (index[i].entry) i = (i + 1) & mask;
+    index[i] = IndexSlot{hash, entry};
+}
+
+void SymbolTable::index_erase(const std::string &name, size_t hash) {
+    size_t mask = index.size() - 1;
+    size_t i = hash & mask;
+    while (!(index[i].entry && index[i].hash == hash
+            && index[i].entry->first == name)) {
+        i = (i + 1) & mask;
+    }
+    // Backward shift deletion: move later entries of the probe sequence into
+    // the hole, so that no tombstones are needed
+    size_t j = i;
+    while (true) {
+        index[i].entry = nullptr;
+        while (true) {
+            j = (j + 1) & mask;
+            if (index[j].entry == nullptr) return;
+            size_t home = index[j].hash & mask;
+            // The entry at `j` can move to `i` only if its home slot is not
+            // cyclically in (i, j]
+            if (i <= j ? (home <= i || home > j) : (home <= i && home > j)) {
+                break;
+            }
+        }
+        index[i] = index[j];
+        i = j;
+    }
+}
+
 void SymbolTable::mark_all_variables_external(Allocator &al) {
     for (auto &a : scope) {
         switch (a.second->type) {
@@ -66,8 +115,8 @@ ASR::symbol_t *SymbolTable::find_scoped_symbol(const std::string &name,
     const SymbolTable *s = this;
     for(size_t i=0; i < n_scope_names; i++) {
         std::string scope_name = m_scope_names[i];
-        if (s->scope.find(scope_name) != scope.end()) {
-            ASR::symbol_t *sym = s->scope.at(scope_name);
+        ASR::symbol_t *sym = s->get_symbol(scope_name);
+        if (sym) {
             s = ASRUtils::symbol_symtab(sym);
             if (s == nullptr) {
                 // The m_scope_names[i] found in the appropriate symbol table,
@@ -80,9 +129,8 @@ ASR::symbol_t *SymbolTable::find_scoped_symbol(const std::string &name,
             return nullptr;
         }
     }
-    if (s->scope.find(name) != scope.end()) {
-        ASR::symbol_t *sym = s->scope.at(name);
-        LCOMPILERS_ASSERT(sym)
+    ASR::symbol_t *sym = s->get_symbol(name);
+    if (sym) {
         return sym;
     } else {
         // The `name` not found in the appropriate symbol table
@@ -96,7 +144,7 @@ std::string SymbolTable::get_unique_name(const std::string &name, bool use_uniqu
         unique_name += "_" + lcompilers_unique_ID;
     }
     int counter = 1;
-    while (scope.find(unique_name) != scope.end()) {
+    while (get_symbol(unique_name)) {
         unique_name = name + std::to_string(counter);
         counter++;
     }
@@ -1,7 +1,9 @@
 #ifndef LFORTRAN_SEMANTICS_ASR_SCOPES_H
 #define LFORTRAN_SEMANTICS_ASR_SCOPES_H
 
+#include <functional>
 #include <map>
+#include <vector>
 
 #include <libasr/alloc.h>
 #include <libasr/containers.h>
@@ -17,7 +19,36 @@ namespace ASR {
 
 struct SymbolTable {
     private:
-    std::map<std::string, ASR::symbol_t*> scope;
+    // `scope` owns the symbols and defines the (sorted, deterministic) order
+    // in which they are iterated, printed and serialized. Lookups by name go
+    // through `index` instead: an open addressing hash table (linear probing,
+    // power of two capacity) pointing to the entries of `scope`, whose nodes
+    // are never moved by std::map.
+    typedef std::map<std::string, ASR::symbol_t*> scope_t;
+    struct IndexSlot {
+        size_t hash;
+        scope_t::value_type *entry; // nullptr if the slot is empty
+    };
+    scope_t scope;
+    std::vector<IndexSlot> index;
+
+    static size_t hash_name(const std::string &name) {
+        return std::hash<std::string>{}(name);
+    }
+
+    scope_t::value_type* index_find(const std::string &name, size_t hash) const {
+        if (index.empty()) return nullptr;
+        size_t mask = index.size() - 1;
+        for (size_t i = hash & mask; index[i].entry; i = (i + 1) & mask) {
+            if (index[i].hash == hash && index[i].entry->first == name) {
+                return index[i].entry;
+            }
+        }
+        return nullptr;
+    }
+
+    void index_insert(scope_t::value_type *entry, size_t hash);
+    void index_erase(const std::string &name, size_t hash);
 
     public:
     SymbolTable *parent;
@@ -29,6 +60,9 @@ struct SymbolTable {
     unsigned int counter;
 
     SymbolTable(SymbolTable *parent);
+    // `index` points into `scope`, so a copy would point into the original
+    SymbolTable(const SymbolTable&) = delete;
+    SymbolTable& operator=(const SymbolTable&) = delete;
 
     // Determines a stable hash based on the content of the symbol table
     uint32_t get_hash_uint32(); // Returns the hash as an integer
@@ -40,14 +74,13 @@ struct SymbolTable {
     // Resolves the symbol `name` recursively in current and parent scopes.
     // Returns `nullptr` if symbol not found.
     ASR::symbol_t* resolve_symbol(const std::string &name) {
-        if (scope.find(name) == scope.end()) {
-            if (parent) {
-                return parent->resolve_symbol(name);
-            } else {
-                return nullptr;
-            }
+        // The name is hashed once for the whole chain of scopes
+        size_t hash = hash_name(name);
+        for (SymbolTable *s = this; s; s = s->parent) {
+            scope_t::value_type *entry = s->index_find(name, hash);
+            if (entry) return entry->second;
         }
-        return scope[name];
+        return nullptr;
     }
 
     SymbolTable* get_global_scope() {
@@ -65,37 +98,45 @@ struct SymbolTable {
     // Obtains the symbol `name` from the current symbol table
     // Returns `nullptr` if symbol not found.
     ASR::symbol_t* get_symbol(const std::string &name) const {
-        //auto it = scope.find(to_lower(name));
-        auto it = scope.find(name);
-        if (it == scope.end()) {
+        scope_t::value_type *entry = index_find(name, hash_name(name));
+        if (entry == nullptr) {
             return nullptr;
         } else {
-            return it->second;
+            return entry->second;
         }
     }
 
     void erase_symbol(const std::string &name) {
-        //auto it = scope.find(to_lower(name));
-        LCOMPILERS_ASSERT(scope.find(name) != scope.end())
+        size_t hash = hash_name(name);
+        LCOMPILERS_ASSERT(index_find(name, hash) != nullptr)
+        index_erase(name, hash);
         scope.erase(name);
     }
 
     // Add a new symbol that did not exist before
     void add_symbol(const std::string &name, ASR::symbol_t* symbol) {
-        LCOMPILERS_ASSERT(scope.find(name) == scope.end())
-        scope[name] = symbol;
+        size_t hash = hash_name(name);
+        LCOMPILERS_ASSERT(index_find(name, hash) == nullptr)
+        index_insert(&*scope.emplace(name, symbol).first, hash);
     }
 
     // Overwrite an existing symbol
     void overwrite_symbol(const std::string &name, ASR::symbol_t* symbol) {
-        LCOMPILERS_ASSERT(scope.find(name) != scope.end())
-        scope[name] = symbol;
+        scope_t::value_type *entry = index_find(name, hash_name(name));
+        LCOMPILERS_ASSERT(entry != nullptr)
+        entry->second = symbol;
     }
 
     // Use as the last resort, prefer to always either add a new symbol
     // or overwrite an existing one, not both
     void add_or_overwrite_symbol(const std::string &name, ASR::symbol_t* symbol) {
-        scope[name] = symbol;
+        size_t hash = hash_name(name);
+        scope_t::value_type *entry = index_find(name, hash);
+        if (entry) {
+            entry->second = symbol;
+        } else {
+            index_insert(&*scope.emplace(name, symbol).first, hash);
+        }
     }
 
     // Marks all variables as external
@@ -291,6 +291,16 @@ ASR::Module_t* extract_module(const ASR::TranslationUnit_t &m) {
     throw LCompilersException("ICE: Module not found");
 }
 
+// Loads the modules that the modules in `symtab` depend on and resolves
+// their external symbols
+static void fix_loaded_modules(Allocator &al, SymbolTable *symtab,
+                            const Location &loc,
+                            LCompilers::PassOptions& pass_options,
+                            bool run_verify,
+                            const std::function<void (const std::string &, const Location &)> err,
+                            LCompilers::LocationManager &lm,
+                            bool generate_object_code);
+
 ASR::Module_t* load_module(Allocator &al, SymbolTable *symtab,
                             const std::string &module_name,
                             const Location &loc, bool intrinsic,
@@ -298,19 +308,28 @@ ASR::Module_t* load_module(Allocator &al, SymbolTable *symtab,
                             bool run_verify,
                             const std::function<void (const std::string &, const Location &)> err,
                             LCompilers::LocationManager &lm,
-                            bool generate_object_code) {
+                            bool generate_object_code,
+                            const std::vector<std::string> *only) {
     LCOMPILERS_ASSERT(symtab);
     if (symtab->get_symbol(module_name) != nullptr) {
         ASR::symbol_t *m = symtab->get_symbol(module_name);
         if (ASR::is_a<ASR::Module_t>(*m)) {
-            return ASR::down_cast<ASR::Module_t>(m);
+            ASR::Module_t *mod = ASR::down_cast<ASR::Module_t>(m);
+            if (load_lazy_symbols(al, *mod, only)) {
+                if ( generate_object_code && !startswith(mod->m_name, "lfortran_intrinsic") ) {
+                    mod->m_symtab->mark_all_variables_external(al);
+                }
+                fix_loaded_modules(al, symtab, loc, pass_options, run_verify,
+                    err, lm, generate_object_code);
+            }
+            return mod;
         } else {
             err("The symbol '" + module_name + "' is not a module", loc);
         }
     }
     LCOMPILERS_ASSERT(symtab->parent == nullptr);
     ASR::TranslationUnit_t *mod1 = find_and_load_module(al, module_name,
-            *symtab, intrinsic, pass_options, lm);
+            *symtab, intrinsic, pass_options, lm, only);
     if (mod1 == nullptr && !intrinsic) {
         // Module not found as a regular module. Try intrinsic module
         if (module_name == "iso_c_binding"
@@ -333,6 +352,18 @@ ASR::Module_t* load_module(Allocator &al, SymbolTable *symtab,
     }
     LCOMPILERS_ASSERT(symtab->resolve_symbol(module_name));
 
+    fix_loaded_modules(al, symtab, loc, pass_options, run_verify, err, lm,
+        generate_object_code);
+    return mod2;
+}
+
+static void fix_loaded_modules(Allocator &al, SymbolTable *symtab,
+                            const Location &loc,
+                            LCompilers::PassOptions& pass_options,
+                            bool run_verify,
+                            const std::function<void (const std::string &, const Location &)> err,
+                            LCompilers::LocationManager &lm,
+                            bool generate_object_code) {
     // Create a temporary TranslationUnit just for fixing the symbols
     ASR::asr_t *orig_asr_owner = symtab->asr_owner;
     ASR::TranslationUnit_t *tu
@@ -405,8 +436,6 @@ ASR::Module_t* load_module(Allocator &al, SymbolTable *symtab,
 #endif
     }
     symtab->asr_owner = orig_asr_owner;
-
-    return mod2;
 }
 
 ASR::asr_t* make_Assignment_t_util(Allocator &al, const Location &a_loc,
@@ -463,7 +492,8 @@ void set_intrinsic(ASR::TranslationUnit_t* trans_unit) {
 ASR::TranslationUnit_t* find_and_load_module(Allocator &al, const std::string &msym,
                                                 SymbolTable &symtab, bool intrinsic,
                                                 LCompilers::PassOptions& pass_options,
-                                                LCompilers::LocationManager &lm) {
+                                                LCompilers::LocationManager &lm,
+                                                const std::vector<std::string> *only) {
     std::filesystem::path runtime_library_dir { pass_options.runtime_library_dir };
     std::filesystem::path filename {msym + ".mod"};
     std::vector<std::filesystem::path> mod_files_dirs;
@@ -474,16 +504,19 @@ ASR::TranslationUnit_t* find_and_load_module(Allocator &al, const std::string &m
                           pass_options.include_dirs.begin(),
                           pass_options.include_dirs.end());
 
-    for (auto path : mod_files_dirs) {
-        std::string modfile;
-        std::filesystem::path full_path = path / filename;
-        if (read_file(full_path.string(), modfile)) {
-            ASR::TranslationUnit_t *asr = load_modfile(al, modfile, false, symtab, lm);
-            if (intrinsic) {
-                set_intrinsic(asr);
-            }
-            return asr;
+    std::shared_ptr<const ParsedModfile> modfile
+        = ModfileCache::get_instance().find(mod_files_dirs, filename.string());
+    if (modfile) {
+        ASR::TranslationUnit_t *asr;
+        if (only && !intrinsic) {
+            asr = load_modfile_lazily(al, modfile, *only, symtab, lm);
+        } else {
+            asr = load_modfile(al, *modfile, false, symtab, lm);
+        }
+        if (intrinsic) {
+            set_intrinsic(asr);
         }
+        return asr;
     }
     return nullptr;
 }
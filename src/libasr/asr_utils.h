@@ -1,9 +1,11 @@
 #ifndef LFORTRAN_ASR_UTILS_H
 #define LFORTRAN_ASR_UTILS_H
 
+#include <atomic>
 #include <functional>
 #include <map>
 #include <limits>
+#include <mutex>
 
 #include <libasr/assert.h>
 #include <libasr/asr.h>
@@ -2305,12 +2307,16 @@ ASR::Module_t* load_module(Allocator &al, SymbolTable *symtab,
                             bool run_verify,
                             const std::function<void (const std::string &, const Location &)> err,
                             LCompilers::LocationManager &lm,
-                            bool generate_object_code = false);
+                            bool generate_object_code = false,
+                            const std::vector<std::string> *only = nullptr);
 
+// If `only` is given, the symbols of the module that are not in it (nor
+// needed by them) are only loaded once another load_module() call needs them
 ASR::TranslationUnit_t* find_and_load_module(Allocator &al, const std::string &msym,
                                                 SymbolTable &symtab, bool intrinsic,
                                                 LCompilers::PassOptions& pass_options,
-                                                LCompilers::LocationManager &lm);
+                                                LCompilers::LocationManager &lm,
+                                                const std::vector<std::string> *only = nullptr);
 
 void set_intrinsic(ASR::TranslationUnit_t* trans_unit);
 
@@ -4495,6 +4501,17 @@ class ExprStmtWithScopeDuplicator: public ASR::BaseExprStmtDuplicator<ExprStmtWi
         return ASR::make_Var_t(al, x->base.base.loc, m_v);
     }
 
+    ASR::asr_t* duplicate_SubroutineCall(ASR::SubroutineCall_t* x) {
+        ASR::asr_t* call = BaseExprStmtDuplicator::duplicate_SubroutineCall(x);
+        // A procedure declared in the duplicated scope (e.g. an interface)
+        ASR::symbol_t* m_name = current_scope->get_symbol(ASRUtils::symbol_name(x->m_name));
+        if (m_name != nullptr && ASRUtils::symbol_parent_symtab(x->m_name)
+                != ASRUtils::symbol_parent_symtab(m_name)) {
+            ASR::down_cast<ASR::SubroutineCall_t>(ASR::down_cast<ASR::stmt_t>(call))->m_name = m_name;
+        }
+        return call;
+    }
+
 };
 
 class FixScopedTypeVisitor: public ASR::BaseExprReplacer<FixScopedTypeVisitor> {
@@ -4987,12 +5004,14 @@ static inline bool present(Vec<ASR::symbol_t*> &v, const ASR::symbol_t* name) {
 // Singleton LabelGenerator so that it generates
 // unique labels for different statements, from
 // wherever it is called (be it ASR passes, be it
-// AST to ASR transition, etc).
+// AST to ASR transition, etc). It is safe to use
+// from several compilations running in parallel.
 class LabelGenerator {
     private:
 
         static LabelGenerator *label_generator;
-        uint64_t unique_label;
+        std::atomic<uint64_t> unique_label;
+        std::mutex node2label_mutex;
         std::map<ASR::asr_t*, uint64_t> node2label;
 
         // Private constructor so that more than
@@ -5005,23 +5024,25 @@ class LabelGenerator {
     public:
 
         static LabelGenerator *get_instance() {
-            if (!label_generator) {
+            static std::once_flag created;
+            std::call_once(created, []() {
                 label_generator = new LabelGenerator;
-            }
+            });
             return label_generator;
         }
 
         int get_unique_label() {
-            unique_label += 1;
-            return unique_label;
+            return ++unique_label;
         }
 
         void add_node_with_unique_label(ASR::asr_t* node, uint64_t label) {
+            std::lock_guard<std::mutex> lock(node2label_mutex);
             LCOMPILERS_ASSERT( node2label.find(node) == node2label.end() );
             node2label[node] = label;
         }
 
         bool verify(ASR::asr_t* node) {
+            std::lock_guard<std::mutex> lock(node2label_mutex);
             return node2label.find(node) != node2label.end();
         }
 };
@@ -1318,6 +1318,30 @@ public:
         BaseWalkVisitor<VerifyVisitor>::visit_DoConcurrentLoop(x);
     }
 
+    void visit_OMPRegion(const OMPRegion_t &x) {
+        for ( size_t i = 0; i < x.n_shared; i++ ) {
+            require(ASR::is_a<ASR::Var_t>(*x.m_shared[i]),
+                "OMPRegion::m_shared must be a Var");
+        }
+        for ( size_t i = 0; i < x.n_private; i++ ) {
+            require(ASR::is_a<ASR::Var_t>(*x.m_private[i]),
+                "OMPRegion::m_private must be a Var");
+        }
+        for ( size_t i = 0; i < x.n_firstprivate; i++ ) {
+            require(ASR::is_a<ASR::Var_t>(*x.m_firstprivate[i]),
+                "OMPRegion::m_firstprivate must be a Var");
+        }
+        for ( size_t i = 0; i < x.n_depend; i++ ) {
+            require(ASR::is_a<ASR::Var_t>(*x.m_depend[i].m_arg),
+                "OMPRegion::m_depend must be a Var");
+        }
+        if (x.m_region == ASR::omp_region_typeType::OMPTaskloop) {
+            require(x.n_body == 1 && ASR::is_a<ASR::DoLoop_t>(*x.m_body[0]),
+                "The body of a taskloop OMPRegion must be a DoLoop");
+        }
+        BaseWalkVisitor<VerifyVisitor>::visit_OMPRegion(x);
+    }
+
 };
 
 
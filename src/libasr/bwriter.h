@@ -1,8 +1,11 @@
 #ifndef LFORTRAN_BWRITER_H
 #define LFORTRAN_BWRITER_H
 
+#include <cstring>
 #include <sstream>
 #include <iomanip>
+#include <unordered_map>
+#include <vector>
 
 #include <libasr/asr_utils.h>
 #include <libasr/exception.h>
@@ -120,41 +123,76 @@ static inline void* string_to_void(const char *s) {
 
 // BinaryReader / BinaryWriter encapsulate access to the file by providing
 // primitives that other classes just use.
+//
+// Integers are written as unsigned LEB128 varints (7 bits per byte, the high
+// bit set on all but the last byte), floats as 8 bytes. A string is written
+// as a varint header followed by its bytes; short strings that were already
+// written are instead written as a reference to their first occurrence
+// within the same stream:
+//
+//     (length << 1)     followed by `length` bytes
+//     (index << 1) | 1  the `index`-th short string of the stream
+//
+// A stream that is read starting in the middle (such as a symbol of a
+// modfile) must have been written by its own BinaryWriter, and the reader's
+// string table must be reset with reset_strings() before reading it.
+
+// Strings up to this length are shared through the string table
+const size_t bwriter_max_shared_string_size = 256;
+
 class BinaryWriter
 {
 private:
     std::string s;
+    std::unordered_map<std::string, uint64_t> strings;
 public:
     std::string get_str() {
         return s;
     }
 
     void write_int8(uint8_t i) {
-        char c=i;
-        s.append(std::string(&c, 1));
+        s.push_back(i);
+    }
+
+    void write_varint(uint64_t i) {
+        char bytes[10];
+        size_t n = 0;
+        while (i >= 0x80) {
+            bytes[n++] = (i & 0x7F) | 0x80;
+            i >>= 7;
+        }
+        bytes[n++] = i;
+        s.append(bytes, n);
     }
 
     void write_int16(uint16_t i) {
-        s.append(uint16_to_string(i));
+        write_varint(i);
     }
 
     void write_int32(uint32_t i) {
-        s.append(uint32_to_string(i));
+        write_varint(i);
     }
 
     void write_int64(uint64_t i) {
-        s.append(uint64_to_string(i));
+        write_varint(i);
     }
 
     void write_string(const std::string &t) {
-        write_int64(t.size());
+        if (t.size() <= bwriter_max_shared_string_size) {
+            auto r = strings.emplace(t, strings.size());
+            if (!r.second) {
+                write_varint((r.first->second << 1) | 1);
+                return;
+            }
+        }
+        write_varint(((uint64_t)t.size()) << 1);
         s.append(t);
     }
 
     void write_float64(double d) {
-        void *p = &d;
-        uint64_t *ip = (uint64_t*)p;
-        write_int64(*ip);
+        uint64_t i;
+        memcpy(&i, &d, sizeof(i));
+        s.append(uint64_to_string(i));
     }
 
     void write_uintptr(uintptr_t i) {
@@ -162,10 +200,7 @@ public:
     }
 
     void write_void(void *p, int64_t n_data) {
-        for (int64_t i = 0; i < n_data; i++) {
-            uint8_t* p_i8 = (uint8_t*)p;
-            write_int8(p_i8[i]);
-        }
+        s.append((const char*)p, n_data);
     }
 
 };
@@ -173,13 +208,64 @@ public:
 class BinaryReader
 {
 private:
-    std::string s;
+    // Owns the data if the reader was constructed from a string
+    std::string buffer;
+    const char *s;
+    size_t size;
     size_t pos;
+    // The (position, length) of the short strings read so far
+    std::vector<std::pair<size_t, size_t>> strings;
+
+    // Reads the header of a string written by write_string(). Returns the
+    // position of its first byte and stores its length in `n`.
+    size_t read_string_pos(size_t &n) {
+        uint64_t header = read_varint();
+        if (header & 1) {
+            header >>= 1;
+            if (header >= strings.size()) {
+                throw LCompilersException("read_string: Invalid string reference.");
+            }
+            n = strings[header].second;
+            return strings[header].first;
+        }
+        n = header >> 1;
+        if (n > size - pos) {
+            throw LCompilersException("read_string: String is too short for deserialization.");
+        }
+        size_t start = pos;
+        if (n <= bwriter_max_shared_string_size) {
+            strings.push_back({start, n});
+        }
+        pos += n;
+        return start;
+    }
 public:
-    BinaryReader(const std::string &s) : s{s}, pos{0} {}
+    BinaryReader(const std::string &s) : buffer{s}, s{buffer.data()},
+        size{buffer.size()}, pos{0} {}
+
+    // Reads the `size` bytes at `data` in place. The data must outlive the
+    // reader.
+    BinaryReader(const char *data, size_t size) : s{data}, size{size}, pos{0} {}
+
+    BinaryReader(const BinaryReader &) = delete;
+    BinaryReader& operator=(const BinaryReader &) = delete;
+
+    size_t get_pos() const {
+        return pos;
+    }
+
+    void set_pos(size_t p) {
+        pos = p;
+    }
+
+    // Forgets the strings read so far, before reading a stream that was
+    // written by its own BinaryWriter
+    void reset_strings() {
+        strings.clear();
+    }
 
     uint8_t read_int8() {
-        if (pos+1 > s.size()) {
+        if (pos+1 > size) {
             throw LCompilersException("read_int8: String is too short for deserialization.");
         }
         uint8_t n = s[pos];
@@ -187,62 +273,67 @@ public:
         return n;
     }
 
-    uint16_t read_int16() {
-        if (pos+2 > s.size()) {
-            throw LCompilersException("read_int16: String is too short for deserialization.");
+    uint64_t read_varint() {
+        // Most integers (enums, counts, small locations) fit in one byte
+        if (pos < size && (s[pos] & 0x80) == 0) {
+            return (uint8_t)s[pos++];
         }
-        uint16_t n = string_to_uint16(&s[pos]);
-        pos += 2;
-        return n;
+        uint64_t n = 0;
+        for (unsigned shift = 0; shift < 64; shift += 7) {
+            if (pos >= size) {
+                throw LCompilersException("read_varint: String is too short for deserialization.");
+            }
+            uint8_t b = s[pos++];
+            n |= ((uint64_t)(b & 0x7F)) << shift;
+            if ((b & 0x80) == 0) {
+                return n;
+            }
+        }
+        throw LCompilersException("read_varint: Integer is too long.");
+    }
+
+    uint16_t read_int16() {
+        return read_varint();
     }
 
     uint32_t read_int32() {
-        if (pos+4 > s.size()) {
-            throw LCompilersException("read_int32: String is too short for deserialization.");
-        }
-        uint32_t n = string_to_uint32(&s[pos]);
-        pos += 4;
-        return n;
+        return read_varint();
     }
 
     uint64_t read_int64() {
-        if (pos+8 > s.size()) {
-            throw LCompilersException("read_int64: String is too short for deserialization.");
-        }
-        uint64_t n = string_to_uint64(&s[pos]);
-        pos += 8;
-        return n;
+        return read_varint();
     }
 
     std::string read_string() {
-        size_t n = read_int64();
-        if (pos+n > s.size()) {
-            throw LCompilersException("read_string: String is too short for deserialization.");
-        }
-        std::string r = std::string(&s[pos], n);
-        pos += n;
-        return r;
+        size_t n;
+        size_t start = read_string_pos(n);
+        return std::string(&s[start], n);
+    }
+
+    // Skips a string written by write_string(). Returns the position of its
+    // first byte and stores its length in `n`.
+    size_t skip_string(size_t &n) {
+        return read_string_pos(n);
     }
 
     double read_float64() {
-        uint64_t x = read_int64();
-        uint64_t *ip = &x;
-        void *p = ip;
-        double *dp = (double*)p;
-        return *dp;
+        if (pos+8 > size) {
+            throw LCompilersException("read_float64: String is too short for deserialization.");
+        }
+        uint64_t x = string_to_uint64(&s[pos]);
+        pos += 8;
+        double d;
+        memcpy(&d, &x, sizeof(d));
+        return d;
     }
 
     void* read_void(int64_t n_data) {
-        void *p = new char[n_data];
-
-        for (int64_t i = 0; i < n_data; i++) {
-            uint8_t x = read_int8();
-            uint8_t *ip = &x;
-            void *p_i = (void*)((uintptr_t)p + i);
-            uint8_t *p_i_8 = (uint8_t*)p_i;
-            *p_i_8 = *ip;
+        if ((size_t)n_data > size - pos) {
+            throw LCompilersException("read_void: String is too short for deserialization.");
         }
-
+        void *p = new char[n_data];
+        memcpy(p, &s[pos], n_data);
+        pos += n_data;
         return p;
     }
 };
@@ -309,10 +400,33 @@ public:
 class TextReader
 {
 private:
-    std::string s;
+    // Owns the data if the reader was constructed from a string
+    std::string buffer;
+    const char *s;
+    size_t size;
     size_t pos;
 public:
-    TextReader(const std::string &s) : s{s}, pos{0} {}
+    TextReader(const std::string &s) : buffer{s}, s{buffer.data()},
+        size{buffer.size()}, pos{0} {}
+
+    // Reads the `size` bytes at `data` in place. The data must outlive the
+    // reader.
+    TextReader(const char *data, size_t size) : s{data}, size{size}, pos{0} {}
+
+    TextReader(const TextReader &) = delete;
+    TextReader& operator=(const TextReader &) = delete;
+
+    size_t get_pos() const {
+        return pos;
+    }
+
+    void set_pos(size_t p) {
+        pos = p;
+    }
+
+    // Strings are always written in full in the text format
+    void reset_strings() {
+    }
 
     uint8_t read_int8() {
         uint64_t n = read_int64();
@@ -349,7 +463,7 @@ public:
                 throw LCompilersException("read_int64: Expected integer, got `" + tmp + "`");
             }
             pos++;
-            if (pos >= s.size()) {
+            if (pos >= size) {
                 throw LCompilersException("read_int64: String is too short for deserialization.");
             }
         }
@@ -363,7 +477,7 @@ public:
         while (s[pos] != ' ') {
             tmp += s[pos];
             pos++;
-            if (pos >= s.size()) {
+            if (pos >= size) {
                 throw LCompilersException("read_float64: String is too short for deserialization.");
             }
         }
@@ -374,7 +488,7 @@ public:
 
     std::string read_string() {
         size_t n = read_int64();
-        if (pos+n > s.size()) {
+        if (pos+n > size) {
             throw LCompilersException("read_string: String is too short for deserialization.");
         }
         std::string r = std::string(&s[pos], n);
@@ -386,6 +500,22 @@ public:
         return r;
     }
 
+    // Skips a string written by write_string(). Returns the position of its
+    // first character and stores its length in `n`.
+    size_t skip_string(size_t &n) {
+        n = read_int64();
+        if (pos+n >= size) {
+            throw LCompilersException("skip_string: String is too short for deserialization.");
+        }
+        size_t start = pos;
+        pos += n;
+        if (s[pos] != ' ') {
+            throw LCompilersException("skip_string: Space expected.");
+        }
+        pos ++;
+        return start;
+    }
+
     void* read_void(int64_t n_data) {
         void *p = new char[n_data];
 
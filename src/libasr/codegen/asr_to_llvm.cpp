@@ -19,6 +19,8 @@
 #include <llvm/IR/Intrinsics.h>
 #include <llvm/IR/LegacyPassManager.h>
 #include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/MDBuilder.h>
+#include <llvm/IR/Operator.h>
 #include <llvm/IR/Module.h>
 #include <llvm/IR/Type.h>
 #include <llvm/Support/Casting.h>
@@ -43,12 +45,21 @@
 #include <libasr/containers.h>
 #include <libasr/codegen/asr_to_llvm.h>
 #include <libasr/pass/pass_manager.h>
+#include <libasr/pass/escape_analysis.h>
 #include <libasr/exception.h>
 #include <libasr/asr_utils.h>
 #include <libasr/codegen/llvm_utils.h>
 #include <libasr/codegen/llvm_array_utils.h>
 #include <libasr/pass/intrinsic_function_registry.h>
 
+extern "C" {
+
+// From the runtime library (lfortran_intrinsics.c)
+char* _lcompilers_precompile_format(const char* format, int64_t* n_values,
+    int64_t* item_start, int64_t* size);
+
+}
+
 namespace LCompilers {
 
 using ASR::is_a;
@@ -190,6 +201,11 @@ public:
     std::unique_ptr<LLVMSetInterface> set_api_sc;
     std::unique_ptr<LLVMArrUtils::Descriptor> arr_descr;
     std::vector<llvm::Value*> heap_arrays;
+    // Local allocatable arrays of the procedure being generated that may
+    // keep their data on the stack (see `get_stack_array_size`)
+    std::set<ASR::symbol_t*> stack_promotable_arrays;
+    llvm::Function* stack_promotion_fn;
+    int64_t stack_promotion_budget;
     std::map<llvm::Value*, llvm::Value*> strings_to_be_allocated; // (array, size)
     Vec<llvm::Value*> strings_to_be_deallocated;
     struct to_be_allocated_array{ // struct to hold details for the initializing pointer_to_array_type later inside main function.
@@ -231,7 +247,9 @@ public:
     set_api_sc(std::make_unique<LLVMSetSeparateChaining>(context, llvm_utils.get(), builder.get())),
     arr_descr(LLVMArrUtils::Descriptor::get_descriptor(context,
               builder.get(), llvm_utils.get(),
-              LLVMArrUtils::DESCR_TYPE::_SimpleCMODescriptor, compiler_options_, heap_arrays))
+              LLVMArrUtils::DESCR_TYPE::_SimpleCMODescriptor, compiler_options_, heap_arrays)),
+    stack_promotion_fn(nullptr),
+    stack_promotion_budget(0)
     {
         llvm_utils->tuple_api = tuple_api.get();
         llvm_utils->list_api = list_api.get();
@@ -274,7 +292,8 @@ public:
     }
 
     template <typename Cond, typename Body>
-    void create_loop(char *name, Cond condition, Body loop_body) {
+    void create_loop(char *name, Cond condition, Body loop_body,
+            bool vectorize=false) {
 
         std::string loop_name;
         if (name) {
@@ -296,6 +315,8 @@ public:
         loop_or_block_end.push_back(loopend);
         loop_or_block_end_names.push_back(loopend_name);
 
+        llvm::BasicBlock *preheader = builder->GetInsertBlock();
+
         // head
         start_new_block(loophead); {
             llvm::Value* cond = condition();
@@ -308,6 +329,26 @@ public:
             builder->CreateBr(loophead);
         }
 
+        if (vectorize) {
+            // Same as `#pragma clang loop vectorize(enable)`: the loop
+            // vectorizer skips its cost model (it still checks that the
+            // loop can be vectorized). The loop ID has to be on every
+            // latch, which includes the `cycle` statements.
+            llvm::TempMDTuple temp = llvm::MDNode::getTemporary(context, {});
+            llvm::Metadata *enable[] = {
+                llvm::MDString::get(context, "llvm.loop.vectorize.enable"),
+                llvm::ConstantAsMetadata::get(llvm::ConstantInt::getTrue(context))
+            };
+            llvm::Metadata *ops[] = {temp.get(), llvm::MDNode::get(context, enable)};
+            llvm::MDNode *loop_id = llvm::MDNode::getDistinct(context, ops);
+            loop_id->replaceOperandWith(0, loop_id);
+            for (llvm::BasicBlock *pred: llvm::predecessors(loophead)) {
+                if (pred != preheader) {
+                    pred->getTerminator()->setMetadata(llvm::LLVMContext::MD_loop, loop_id);
+                }
+            }
+        }
+
         // end
         loop_head.pop_back();
         loop_head_names.pop_back();
@@ -425,6 +466,44 @@ public:
         return is_ok;
     }
 
+    int64_t get_max_stack_array_size() {
+        if( compiler_options.max_stack_array_size >= 0 ) {
+            return compiler_options.max_stack_array_size;
+        }
+        return compiler_options.po.fast ? 1024 : 0;
+    }
+
+    /*
+        Finds the arrays of procedure `x` that do not outlive it. Must be
+        called once the builder is inside the LLVM function of `x`. Each
+        procedure may place at most 16 arrays worth of data on the stack.
+    */
+    void start_stack_promotion(ASR::symbol_t* x) {
+        stack_promotable_arrays.clear();
+        stack_promotion_fn = builder->GetInsertBlock()->getParent();
+        stack_promotion_budget = 16 * get_max_stack_array_size();
+        if( stack_promotion_budget > 0 ) {
+            find_non_escaping_arrays(x, stack_promotable_arrays);
+        }
+    }
+
+    /*
+        Returns how many bytes of data the allocation of `sym` being
+        generated may take from the stack (0 if it must use the heap only).
+        Allocations inside functions outlined from the procedure (e.g. by
+        OpenMP) always use the heap.
+    */
+    int64_t get_stack_array_size(ASR::symbol_t* sym) {
+        int64_t size = get_max_stack_array_size();
+        if( size <= 0 || stack_promotion_budget < size ||
+            builder->GetInsertBlock()->getParent() != stack_promotion_fn ||
+            stack_promotable_arrays.find(sym) == stack_promotable_arrays.end() ) {
+            return 0;
+        }
+        stack_promotion_budget -= size;
+        return size;
+    }
+
     void fill_array_details(llvm::Value* arr, llvm::Type* llvm_data_type,
                             ASR::dimension_t* m_dims, int n_dims, bool is_data_only=false,
                             bool reserve_data_memory=true) {
@@ -454,9 +533,10 @@ public:
                 if( !compiler_options.stack_arrays ) {
                     llvm::DataLayout data_layout(module->getDataLayout());
                     uint64_t size = data_layout.getTypeAllocSize(llvm_data_type);
-                    prod = builder->CreateMul(prod,
-                        llvm::ConstantInt::get(context, llvm::APInt(32, size)));
-                    llvm::Value* arr_first_i8 = LLVMArrUtils::lfortran_malloc(
+                    prod = builder->CreateMul(
+                        builder->CreateSExt(prod, llvm::Type::getInt64Ty(context)),
+                        llvm::ConstantInt::get(context, llvm::APInt(64, size)));
+                    llvm::Value* arr_first_i8 = LLVMArrUtils::lfortran_pool_malloc(
                         context, *module, *builder, prod);
                     heap_arrays.push_back(arr_first_i8);
                     arr_first = builder->CreateBitCast(
@@ -479,7 +559,7 @@ public:
     */
     inline void fill_malloc_array_details(llvm::Value* arr, llvm::Type* arr_type, llvm::Type* llvm_data_type,
                                           ASR::dimension_t* m_dims, int n_dims,
-                                          bool realloc=false) {
+                                          bool realloc=false, int64_t stack_size=0) {
         std::vector<std::pair<llvm::Value*, llvm::Value*>> llvm_dims;
         int ptr_loads_copy = ptr_loads;
         ptr_loads = 2;
@@ -493,7 +573,7 @@ public:
         }
         ptr_loads = ptr_loads_copy;
         arr_descr->fill_malloc_array_details(arr, arr_type, llvm_data_type,
-            n_dims, llvm_dims, module.get(), realloc);
+            n_dims, llvm_dims, module.get(), realloc, stack_size);
     }
 
     /*
@@ -1028,7 +1108,7 @@ public:
                           ASR::is_a<ASR::Logical_t>(*curr_arg_m_a_type)) {
                     llvm::Value* malloc_size = SizeOfTypeUtil(curr_arg_m_a_type, llvm_utils->getIntType(4),
                     ASRUtils::TYPE(ASR::make_Integer_t(al, x.base.base.loc, 4)));
-                    llvm::Value* malloc_ptr = LLVMArrUtils::lfortran_malloc(
+                    llvm::Value* malloc_ptr = LLVM::lfortran_malloc(
                         context, *module, *builder, malloc_size);
                     builder->CreateMemSet(malloc_ptr, llvm::ConstantInt::get(context, llvm::APInt(8, 0)), malloc_size, llvm::MaybeAlign());
                     llvm::Type* llvm_arg_type = llvm_utils->get_type_from_ttype_t_util(curr_arg_m_a_type, module.get());
@@ -1059,7 +1139,7 @@ public:
                             llvm::Value* null_array_ptr = llvm::ConstantPointerNull::get(type->getPointerTo());
                             llvm::Value* size_of_array_struct = llvm_utils->CreateGEP2(type, null_array_ptr, idx_vec);
                             llvm::Value* size_of_array_struct_casted = builder->CreatePtrToInt(size_of_array_struct, llvm::Type::getInt32Ty(context)); //cast to int32
-                            llvm::Value* struct_ptr = LLVMArrUtils::lfortran_malloc(
+                            llvm::Value* struct_ptr = LLVM::lfortran_malloc(
                                 context, *module, *builder, size_of_array_struct_casted);
                             ptr_ = builder->CreateBitCast(struct_ptr, type->getPointerTo());
 #if LLVM_VERSION_MAJOR > 16
@@ -1076,7 +1156,13 @@ public:
                         LLVM::CreateStore(*builder, ptr_, x_arr);
                     },
                     []() {});
-                fill_malloc_array_details(x_arr, type, llvm_data_type, curr_arg.m_dims, curr_arg.n_dims, realloc);
+                int64_t stack_size = 0;
+                if( !realloc && ASR::is_a<ASR::Var_t>(*tmp_expr) ) {
+                    stack_size = get_stack_array_size(ASRUtils::symbol_get_past_external(
+                        ASR::down_cast<ASR::Var_t>(tmp_expr)->m_v));
+                }
+                fill_malloc_array_details(x_arr, type, llvm_data_type, curr_arg.m_dims,
+                    curr_arg.n_dims, realloc, stack_size);
                 if( ASR::is_a<ASR::StructType_t>(*ASRUtils::extract_type(ASRUtils::expr_type(tmp_expr)))) {
                     llvm::Value* x_arr_ = llvm_utils->CreateLoad(x_arr);
 #if LLVM_VERSION_MAJOR > 16
@@ -1175,12 +1261,11 @@ public:
         }
     }
 
-    inline void call_lfortran_free(llvm::Function* fn, llvm::Type* llvm_data_type) {
+    // Array data is allocated by the pool allocator, see
+    // `SimpleCMODescriptor::fill_malloc_array_details`
+    inline void call_lfortran_free(llvm::Type* llvm_data_type) {
         llvm::Value* arr = llvm_utils->CreateLoad2(llvm_data_type->getPointerTo(), arr_descr->get_pointer_to_data(tmp));
-        llvm::AllocaInst *arg_arr = llvm_utils->CreateAlloca(*builder, character_type);
-        builder->CreateStore(builder->CreateBitCast(arr, character_type), arg_arr);
-        std::vector<llvm::Value*> args = {llvm_utils->CreateLoad(arg_arr)};
-        builder->CreateCall(fn, args);
+        LLVMArrUtils::lfortran_pool_free(context, *module, *builder, arr);
         arr_descr->reset_is_allocated_flag(tmp, llvm_data_type);
     }
 
@@ -1332,7 +1417,7 @@ public:
                     module.get(), abt);
                 llvm::Value *cond = arr_descr->get_is_allocated_flag(tmp, llvm_data_type);
                 llvm_utils->create_if_else(cond, [=]() {
-                    call_lfortran_free(free_fn, llvm_data_type);
+                    call_lfortran_free(llvm_data_type);
                 }, [](){});
             }
         }
@@ -2593,9 +2678,11 @@ public:
             }
             case ASR::array_physical_typeType::FixedSizeArray:
             case ASR::array_physical_typeType::SIMDArray:
+            // Elements of a PointerToDataArray are addressed in column major
+            // order from its data pointer
+            case ASR::array_physical_typeType::PointerToDataArray:
                 tmp = llvm::ConstantInt::get(context, llvm::APInt(1, 1));
                 break;
-            case ASR::array_physical_typeType::PointerToDataArray:
             case ASR::array_physical_typeType::StringArraySinglePointer:
                 tmp = llvm::ConstantInt::get(context, llvm::APInt(1, 0));
                 break;
@@ -3439,6 +3526,7 @@ public:
         visit_procedures(x);
 
         builder->SetInsertPoint(BB);
+        start_stack_promotion((ASR::symbol_t*)&x);
         // Call the `_lpython_call_initial_functions` function to assign command line argument
         // values to `argc` and `argv`, and set the random seed to the system clock.
         {
@@ -3475,7 +3563,7 @@ public:
             this->visit_stmt(*x.m_body[i]);
         }
         for( auto& value: heap_arrays ) {
-            LLVM::lfortran_free(context, *module, *builder, value);
+            LLVMArrUtils::lfortran_pool_free(context, *module, *builder, value);
         }
         call_lcompilers_free_strings();
 
@@ -3988,9 +4076,10 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
             if( !compiler_options.stack_arrays && array_size ) {
                 llvm::DataLayout data_layout(module->getDataLayout());
                 uint64_t size = data_layout.getTypeAllocSize(type);
-                array_size = builder->CreateMul(array_size,
-                    llvm::ConstantInt::get(context, llvm::APInt(32, size)));
-                llvm::Value* ptr_i8 = LLVMArrUtils::lfortran_malloc(
+                array_size = builder->CreateMul(
+                    builder->CreateSExtOrTrunc(array_size, llvm::Type::getInt64Ty(context)),
+                    llvm::ConstantInt::get(context, llvm::APInt(64, size)));
+                llvm::Value* ptr_i8 = LLVMArrUtils::lfortran_pool_malloc(
                     context, *module, *builder, array_size);
                 heap_arrays.push_back(ptr_i8);
                 ptr = builder->CreateBitCast(ptr_i8, type->getPointerTo());
@@ -4461,6 +4550,7 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
         llvm::BasicBlock *BB = llvm::BasicBlock::Create(context,
                 ".entry", F);
         builder->SetInsertPoint(BB);
+        start_stack_promotion((ASR::symbol_t*)&x);
         if (compiler_options.emit_debug_info) debug_emit_loc(x);
         declare_args(x, *F);
         declare_local_vars(x);
@@ -4514,20 +4604,158 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
                 }
             }
             for( auto& value: heap_arrays ) {
-                LLVM::lfortran_free(context, *module, *builder, value);
+                LLVMArrUtils::lfortran_pool_free(context, *module, *builder, value);
             }
             call_lcompilers_free_strings();
             builder->CreateRet(ret_val2);
         } else {
             start_new_block(proc_return);
             for( auto& value: heap_arrays ) {
-                LLVM::lfortran_free(context, *module, *builder, value);
+                LLVMArrUtils::lfortran_pool_free(context, *module, *builder, value);
             }
             call_lcompilers_free_strings();
             builder->CreateRetVoid();
         }
     }
 
+    // Fortran forbids modifying a dummy argument through another one (or
+    // referencing it while it is modified through another one), unless it
+    // is a `pointer` or a `target`. The numeric and logical dummies of `x`
+    // therefore do not alias each other.
+    bool is_noalias_arg(const ASR::Function_t &x, size_t i) {
+        if (!is_a<ASR::Var_t>(*x.m_args[i])) return false;
+        ASR::symbol_t *s = ASRUtils::symbol_get_past_external(
+            ASR::down_cast<ASR::Var_t>(x.m_args[i])->m_v);
+        if (!is_a<ASR::Variable_t>(*s)) return false;
+        ASR::Variable_t *v = ASR::down_cast<ASR::Variable_t>(s);
+        if (!ASRUtils::is_arg_dummy(v->m_intent) || v->m_value_attr ||
+                v->m_target_attr || is_a<ASR::Pointer_t>(*v->m_type) ||
+                is_a<ASR::Allocatable_t>(*v->m_type)) {
+            return false;
+        }
+        ASR::ttype_t *type = ASRUtils::type_get_past_array(v->m_type);
+        return is_a<ASR::Integer_t>(*type) || is_a<ASR::UnsignedInteger_t>(*type) ||
+            is_a<ASR::Real_t>(*type) || is_a<ASR::Complex_t>(*type) ||
+            is_a<ASR::Logical_t>(*type);
+    }
+
+    /*
+     * Passes the aliasing guarantees of the dummy arguments of `x` on to
+     * LLVM: the arguments that point to their data get the `noalias`
+     * attribute, and the loads and stores of `F` get scoped alias metadata,
+     *
+     *  - one scope per argument for the accesses to its data, which for an
+     *    array descriptor is the memory its data pointer (field 0) points to
+     *  - one scope for the accesses to the array descriptors themselves
+     *
+     * and each access is `!noalias` with the other scopes. Stores to one
+     * array then no longer clobber the loads from the other arrays or from
+     * the descriptors, so that loops over them can be vectorized.
+     */
+    void add_alias_info(const ASR::Function_t &x, llvm::Function &F) {
+        if (compiler_options.no_alias_metadata ||
+                ASRUtils::get_FunctionType(x)->m_abi != ASR::abiType::Source) {
+            return;
+        }
+        llvm::MDBuilder md_builder(context);
+        llvm::MDNode *domain = nullptr;
+        std::vector<llvm::MDNode*> scopes;
+        std::map<llvm::Value*, llvm::MDNode*> data_scope, descriptor_data_scope;
+        llvm::MDNode *descriptor_scope = nullptr;
+        for (size_t i = 0; i < x.n_args && i < F.arg_size(); i++) {
+            llvm::Argument *arg = F.getArg(i);
+            if (!arg->getType()->isPointerTy() || !is_noalias_arg(x, i)) continue;
+            if (domain == nullptr) {
+                domain = md_builder.createAnonymousAliasScopeDomain(F.getName());
+            }
+            llvm::MDNode *scope = md_builder.createAnonymousAliasScope(domain,
+                arg->getName());
+            scopes.push_back(scope);
+            ASR::ttype_t *type = ASRUtils::expr_type(x.m_args[i]);
+            if (ASRUtils::is_array(type) && ASRUtils::extract_physical_type(type)
+                    == ASR::array_physical_typeType::DescriptorArray) {
+                if (descriptor_scope == nullptr) {
+                    descriptor_scope = md_builder.createAnonymousAliasScope(
+                        domain, "descriptors");
+                }
+                descriptor_data_scope[arg] = scope;
+            } else {
+                data_scope[arg] = scope;
+                arg->addAttr(llvm::Attribute::NoAlias);
+            }
+        }
+        if (scopes.size() + (descriptor_scope != nullptr) < 2) return;
+        if (descriptor_scope) scopes.push_back(descriptor_scope);
+
+        auto strip = [](llvm::Value *ptr) {
+            while (true) {
+                if (llvm::GEPOperator *gep = llvm::dyn_cast<llvm::GEPOperator>(ptr)) {
+                    ptr = gep->getPointerOperand();
+                } else if (llvm::BitCastOperator *cast = llvm::dyn_cast<llvm::BitCastOperator>(ptr)) {
+                    ptr = cast->getOperand(0);
+                } else {
+                    return ptr;
+                }
+            }
+        };
+        // The scope of the memory `ptr` points into, or nullptr
+        auto scope_of = [&](llvm::Value *ptr) -> llvm::MDNode* {
+            llvm::Value *base = strip(ptr);
+            if (data_scope.find(base) != data_scope.end()) {
+                return data_scope[base];
+            }
+            if (descriptor_data_scope.find(base) != descriptor_data_scope.end()) {
+                return descriptor_scope;
+            }
+            llvm::LoadInst *load = llvm::dyn_cast<llvm::LoadInst>(base);
+            if (load == nullptr) return nullptr;
+            // A pointer loaded from a field of a descriptor: 0 is the data,
+            // 2 the dimension descriptors
+            llvm::GEPOperator *field = llvm::dyn_cast<llvm::GEPOperator>(
+                load->getPointerOperand());
+            if (field == nullptr || field->getNumIndices() != 2 ||
+                    descriptor_data_scope.find(field->getPointerOperand())
+                        == descriptor_data_scope.end()) {
+                return nullptr;
+            }
+            llvm::ConstantInt *index = llvm::dyn_cast<llvm::ConstantInt>(
+                field->getOperand(2));
+            if (index == nullptr) return nullptr;
+            if (index->getZExtValue() == 0) {
+                return descriptor_data_scope[field->getPointerOperand()];
+            } else if (index->getZExtValue() == 2) {
+                return descriptor_scope;
+            }
+            return nullptr;
+        };
+
+        std::map<llvm::MDNode*, llvm::MDNode*> noalias;
+        for (llvm::MDNode *scope : scopes) {
+            std::vector<llvm::Metadata*> others;
+            for (llvm::MDNode *other : scopes) {
+                if (other != scope) others.push_back(other);
+            }
+            noalias[scope] = llvm::MDNode::get(context, others);
+        }
+        for (llvm::BasicBlock &BB : F) {
+            for (llvm::Instruction &I : BB) {
+                llvm::Value *ptr = nullptr;
+                if (llvm::LoadInst *load = llvm::dyn_cast<llvm::LoadInst>(&I)) {
+                    ptr = load->getPointerOperand();
+                } else if (llvm::StoreInst *store = llvm::dyn_cast<llvm::StoreInst>(&I)) {
+                    ptr = store->getPointerOperand();
+                } else {
+                    continue;
+                }
+                llvm::MDNode *scope = scope_of(ptr);
+                if (scope == nullptr) continue;
+                I.setMetadata(llvm::LLVMContext::MD_alias_scope,
+                    llvm::MDNode::get(context, {scope}));
+                I.setMetadata(llvm::LLVMContext::MD_noalias, noalias[scope]);
+            }
+        }
+    }
+
     void generate_function(const ASR::Function_t &x) {
         bool interactive = (ASRUtils::get_FunctionType(x)->m_abi == ASR::abiType::Interactive);
         if (ASRUtils::get_FunctionType(x)->m_deftype == ASR::deftypeType::Implementation ) {
@@ -4550,6 +4778,7 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
                 }
 
                 define_function_exit(x);
+                add_alias_info(x, *builder->GetInsertBlock()->getParent());
             }
         } else if( ASRUtils::get_FunctionType(x)->m_abi == ASR::abiType::Intrinsic &&
                    ASRUtils::get_FunctionType(x)->m_deftype == ASR::deftypeType::Interface ) {
@@ -4755,10 +4984,21 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
             builder->CreateStore(llvm_cptr, fptr_data);
             llvm::Value* prod = llvm::ConstantInt::get(context, llvm::APInt(32, 1));
             ASR::ArrayConstant_t* lower_bounds = nullptr;
-            if( x.m_lower_bounds ) {
-                LCOMPILERS_ASSERT(ASR::is_a<ASR::ArrayConstant_t>(*x.m_lower_bounds));
+            // Lower bounds only known at runtime (the openmp pass passes
+            // them along with the data of shared arrays)
+            llvm::Value* llvm_lower_bounds = nullptr;
+            ASR::ttype_t* asr_lower_bounds_type = nullptr;
+            if( x.m_lower_bounds && ASR::is_a<ASR::ArrayConstant_t>(*x.m_lower_bounds) ) {
                 lower_bounds = ASR::down_cast<ASR::ArrayConstant_t>(x.m_lower_bounds);
                 LCOMPILERS_ASSERT(fptr_rank == ASRUtils::get_fixed_size_of_array(lower_bounds->m_type));
+            } else if( x.m_lower_bounds ) {
+                asr_lower_bounds_type = ASRUtils::expr_type(x.m_lower_bounds);
+                this->visit_expr(*x.m_lower_bounds);
+                llvm_lower_bounds = tmp;
+                if( ASRUtils::extract_physical_type(asr_lower_bounds_type) ==
+                    ASR::array_physical_typeType::DescriptorArray ) {
+                    llvm_lower_bounds = llvm_utils->CreateLoad(arr_descr->get_pointer_to_data(llvm_lower_bounds));
+                }
             }
             for( int i = 0; i < fptr_rank; i++ ) {
                 llvm::Value* curr_dim = llvm::ConstantInt::get(context, llvm::APInt(32, i));
@@ -4775,6 +5015,15 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
                     this->visit_expr_wrapper(ASRUtils::fetch_ArrayConstant_value(al, lower_bounds, i), true);
                     ptr_loads = ptr_loads_copy;
                     new_lb = tmp;
+                } else if( llvm_lower_bounds ) {
+                    if( ASRUtils::extract_physical_type(asr_lower_bounds_type) ==
+                        ASR::array_physical_typeType::FixedSizeArray ) {
+                        new_lb = llvm_utils->CreateLoad2(llvm::Type::getInt32Ty(context),
+                            llvm_utils->create_gep(llvm_lower_bounds, i));
+                    } else {
+                        new_lb = llvm_utils->CreateLoad2(llvm::Type::getInt32Ty(context),
+                            llvm_utils->create_ptr_gep(llvm_lower_bounds, i));
+                    }
                 }
                 llvm::Value* new_ub = nullptr;
                 if( ASRUtils::extract_physical_type(asr_shape_type) == ASR::array_physical_typeType::DescriptorArray ||
@@ -4795,7 +5044,8 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
             ptr_loads = 1 - reduce_loads;
             this->visit_expr(*cptr);
             llvm::Value* llvm_cptr = tmp;
-            if (ASR::is_a<ASR::ArrayItem_t>(*cptr)) {
+            if (ASR::is_a<ASR::ArrayItem_t>(*cptr) ||
+                    ASR::is_a<ASR::StructInstanceMember_t>(*cptr)) {
                 llvm_cptr = llvm_utils->CreateLoad2(ASRUtils::expr_type(cptr), llvm_cptr);
             }
             ptr_loads = 0;
@@ -5768,7 +6018,7 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
             [&]() {
                 llvm::Value* malloc_size = SizeOfTypeUtil(asr_type, llvm_utils->getIntType(4),
                 ASRUtils::TYPE(ASR::make_Integer_t(al, target_expr->base.loc, 4)));
-                llvm::Value* malloc_ptr = LLVMArrUtils::lfortran_malloc(
+                llvm::Value* malloc_ptr = LLVM::lfortran_malloc(
                     context, *module, *builder, malloc_size);
                 builder->CreateMemSet(malloc_ptr, llvm::ConstantInt::get(context, llvm::APInt(8, 0)), malloc_size, llvm::MaybeAlign());
                 builder->CreateStore(builder->CreateBitCast(
@@ -5978,7 +6228,7 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
         llvm::BasicBlock *last_bb = builder->GetInsertBlock();
         llvm::Instruction *block_terminator = last_bb->getTerminator();
         for( auto& value: heap_arrays ) {
-            LLVM::lfortran_free(context, *module, *builder, value);
+            LLVMArrUtils::lfortran_pool_free(context, *module, *builder, value);
         }
         heap_arrays = heap_arrays_copy;
         if (block_terminator == nullptr) {
@@ -6538,7 +6788,7 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
                 this->visit_stmt(*x.m_body[i]);
             }
             call_lcompilers_free_strings();
-        });
+        }, x.m_vectorize);
         strings_to_be_deallocated.reserve(al, n);
         strings_to_be_deallocated.n = n;
         strings_to_be_deallocated.p = strings_to_be_deallocated_copy;
@@ -8969,6 +9219,33 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
             end = builder->CreateGlobalStringPtr("\n");
         }
         size_t n_values = x.n_values; ASR::expr_t **m_values = x.m_values;
+        if (!is_string && x.m_is_formatted && n_values == 1 &&
+                ASR::is_a<ASR::StringFormat_t>(*m_values[0]) &&
+                ASR::down_cast<ASR::StringFormat_t>(m_values[0])->m_kind ==
+                    ASR::string_format_kindType::FormatFortran) {
+            // Format the record straight into the unit's output buffer,
+            // instead of creating the string and writing it afterwards
+            std::vector<llvm::Value *> format_args;
+            llvm::Value* null_str = llvm::ConstantPointerNull::get(
+                llvm::Type::getInt8Ty(context)->getPointerTo());
+            // Same state as `compute_fmt_specifier_and_arg` visits it with
+            ptr_loads = 2;
+            lookup_enum_value_for_nonints = true;
+            bool format_precompiled = get_string_format_args(
+                *ASR::down_cast<ASR::StringFormat_t>(m_values[0]), format_args);
+            lookup_enum_value_for_nonints = false;
+            ptr_loads = ptr_loads_copy;
+            if (format_precompiled) {
+                format_args.insert(format_args.begin(), null_str);
+            } else {
+                format_args.insert(format_args.begin() + 1, {null_str,
+                    llvm::ConstantInt::get(llvm::Type::getInt64Ty(context), 0),
+                    llvm::ConstantInt::get(llvm::Type::getInt64Ty(context), 0)});
+            }
+            format_args.insert(format_args.begin(), {unit, iostat, end});
+            tmp = file_write_formatted(context, *module, *builder, format_args);
+            return;
+        }
         for (size_t i=0; i<n_values; i++) {
             if (i != 0 && !is_string && x.m_is_formatted) {
                 fmt.push_back("%s");
@@ -11147,84 +11424,117 @@ ptr_type[ptr_member] = llvm_utils->get_type_from_ttype_t_util(
         }
     }
 
-    void visit_StringFormat(const ASR::StringFormat_t& x) {
-        // TODO: Handle some things at compile time if possible:
-        //ASR::expr_t* fmt_value = ASRUtils::expr_value(x.m_fmt);
-        // if (fmt_value) ...
-        if (x.m_kind == ASR::string_format_kindType::FormatFortran) {
-            std::vector<llvm::Value *> args;
-            // Push fmt string.
-            if(x.m_fmt == nullptr){ // default formatting
-                llvm::Type* int8Type = builder->getInt8Ty();
-                llvm::PointerType* charPtrType = int8Type->getPointerTo();
-                llvm::Constant* nullCharPtr = llvm::ConstantPointerNull::get(charPtrType);
-                args.push_back(nullCharPtr);
-            } else {
-                visit_expr(*x.m_fmt);
+    // Pushes the arguments of `_lcompilers_string_format_fortran` for `x`, or
+    // of `_lcompilers_string_format_fortran_compiled` if its format string
+    // could be parsed at compile time, in which case it returns true
+    bool get_string_format_args(const ASR::StringFormat_t& x,
+            std::vector<llvm::Value *> &args) {
+        LCOMPILERS_ASSERT(x.m_kind == ASR::string_format_kindType::FormatFortran);
+        // A constant format string is parsed here, once, into the table
+        // of format specifiers that the runtime would otherwise parse
+        // again on every execution
+        char* format_table = nullptr;
+        bool format_precompiled = false;
+        int64_t n_format_values = 0, format_item_start = 0, format_table_size = 0;
+        if (x.m_fmt != nullptr) {
+            ASR::expr_t* fmt_value = ASRUtils::expr_value(x.m_fmt);
+            if (fmt_value && ASR::is_a<ASR::StringConstant_t>(*fmt_value)) {
+                format_table = _lcompilers_precompile_format(
+                    ASR::down_cast<ASR::StringConstant_t>(fmt_value)->m_s,
+                    &n_format_values, &format_item_start, &format_table_size);
+            }
+        }
+        // Push fmt string.
+        if (format_table != nullptr) {
+            format_precompiled = true;
+            args.push_back(builder->CreateGlobalStringPtr(
+                std::string(format_table, format_table_size), "format_table"));
+            args.push_back(llvm::ConstantInt::get(llvm::Type::getInt64Ty(context),
+                n_format_values));
+            args.push_back(llvm::ConstantInt::get(llvm::Type::getInt64Ty(context),
+                format_item_start));
+            free(format_table);
+        } else if(x.m_fmt == nullptr){ // default formatting
+            llvm::Type* int8Type = builder->getInt8Ty();
+            llvm::PointerType* charPtrType = int8Type->getPointerTo();
+            llvm::Constant* nullCharPtr = llvm::ConstantPointerNull::get(charPtrType);
+            args.push_back(nullCharPtr);
+        } else {
+            visit_expr(*x.m_fmt);
+            args.push_back(tmp);
+        }
+        // Push Serialization;
+        llvm::Value* serialization_info = SerializeExprTypes(x.m_args, x.n_args);
+        args.push_back(serialization_info);
+
+        //Push serialization of sizes and n_size
+        size_t ArraySizesCnt = 0;
+        for (size_t i=0; i<x.n_args; i++) {
+            if(ASRUtils::is_array(ASRUtils::expr_type(x.m_args[i]))){
+                ASR::expr_t* ArraySizeExpr = ASRUtils::EXPR
+                    (ASR::make_ArraySize_t(al, x.m_args[i]->base.loc, x.m_args[i],
+                    nullptr, ASRUtils::TYPE(ASR::make_Integer_t(al, x.m_args[i]->base.loc, 8)),
+                    ASRUtils::get_compile_time_array_size(al,
+                        ASRUtils::expr_type(x.m_args[i])))) ;
+                visit_expr(*ArraySizeExpr);
                 args.push_back(tmp);
+                ArraySizesCnt++;
             }
-            // Push Serialization;
-            llvm::Value* serialization_info = SerializeExprTypes(x.m_args, x.n_args);
-            args.push_back(serialization_info);
-
-            //Push serialization of sizes and n_size
-            size_t ArraySizesCnt = 0;
-            for (size_t i=0; i<x.n_args; i++) {
-                if(ASRUtils::is_array(ASRUtils::expr_type(x.m_args[i]))){
-                    ASR::expr_t* ArraySizeExpr = ASRUtils::EXPR
-                        (ASR::make_ArraySize_t(al, x.m_args[i]->base.loc, x.m_args[i],
-                        nullptr, ASRUtils::TYPE(ASR::make_Integer_t(al, x.m_args[i]->base.loc, 8)),
-                        ASRUtils::get_compile_time_array_size(al,
-                            ASRUtils::expr_type(x.m_args[i])))) ;
-                    visit_expr(*ArraySizeExpr);
-                    args.push_back(tmp);
-                    ArraySizesCnt++;
-                }
-            }
-
-            args.insert(args.end()-ArraySizesCnt,
-                llvm::ConstantInt::get(llvm::Type::getInt32Ty(context),
-                    ArraySizesCnt));
-            // Push the args.
-            for (size_t i=0; i<x.n_args; i++) {
-                // Push the args as raw pointers
-                int64_t ptr_load_copy = ptr_loads;
-                ptr_loads = (ASR::is_a<ASR::Var_t>(*x.m_args[i]) && !ASRUtils::is_character(*expr_type(x.m_args[i]))) ? 0 : 1;
-                // Special Hanlding to pass appropriate pointer to the backend.
-                if(ASRUtils::is_array(expr_type(x.m_args[i]))){ // Arrays need a cast to pointerToDataArray physicalType.
-                    ASR::Array_t* arr = ASR::down_cast<ASR::Array_t>(
-                        ASRUtils::type_get_past_allocatable_pointer(
-                            ASRUtils::expr_type(x.m_args[i])));
-                    if(arr->m_physical_type != ASR::array_physical_typeType::PointerToDataArray){
-                        ASR::ttype_t* array_type = ASRUtils::TYPE(
-                                                    ASR::make_Array_t(al, arr->base.base.loc,arr->m_type,
-                                                    arr->m_dims, arr->n_dims,ASR::array_physical_typeType::FixedSizeArray));
-                        ASR::expr_t* array_casted_to_pointer = ASRUtils::EXPR(
-                                                                ASR::make_ArrayPhysicalCast_t(al, arr->base.base.loc,
-                                                                x.m_args[i],arr->m_physical_type,
-                                                                ASR::array_physical_typeType::PointerToDataArray,
-                                                                array_type, nullptr));
-                        this->visit_expr(*array_casted_to_pointer);
-                    } else {
-                        this->visit_expr_wrapper(x.m_args[i], true);
-                    }
+        }
+
+        args.insert(args.end()-ArraySizesCnt,
+            llvm::ConstantInt::get(llvm::Type::getInt32Ty(context),
+                ArraySizesCnt));
+        // Push the args.
+        for (size_t i=0; i<x.n_args; i++) {
+            // Push the args as raw pointers
+            int64_t ptr_load_copy = ptr_loads;
+            ptr_loads = (ASR::is_a<ASR::Var_t>(*x.m_args[i]) && !ASRUtils::is_character(*expr_type(x.m_args[i]))) ? 0 : 1;
+            // Special Hanlding to pass appropriate pointer to the backend.
+            if(ASRUtils::is_array(expr_type(x.m_args[i]))){ // Arrays need a cast to pointerToDataArray physicalType.
+                ASR::Array_t* arr = ASR::down_cast<ASR::Array_t>(
+                    ASRUtils::type_get_past_allocatable_pointer(
+                        ASRUtils::expr_type(x.m_args[i])));
+                if(arr->m_physical_type != ASR::array_physical_typeType::PointerToDataArray){
+                    ASR::ttype_t* array_type = ASRUtils::TYPE(
+                                                ASR::make_Array_t(al, arr->base.base.loc,arr->m_type,
+                                                arr->m_dims, arr->n_dims,ASR::array_physical_typeType::FixedSizeArray));
+                    ASR::expr_t* array_casted_to_pointer = ASRUtils::EXPR(
+                                                            ASR::make_ArrayPhysicalCast_t(al, arr->base.base.loc,
+                                                            x.m_args[i],arr->m_physical_type,
+                                                            ASR::array_physical_typeType::PointerToDataArray,
+                                                            array_type, nullptr));
+                    this->visit_expr(*array_casted_to_pointer);
                 } else {
-                    ptr_loads = ptr_loads + LLVM::is_llvm_pointer(*expr_type(x.m_args[i]));
                     this->visit_expr_wrapper(x.m_args[i], true);
                 }
-                if(!tmp->getType()->isPointerTy() ||
-                    ASR::is_a<ASR::PointerToCPtr_t>(*x.m_args[i]) ||
-                    (ASRUtils::is_character(*expr_type(x.m_args[i])) &&
-                        !ASRUtils::is_array(expr_type(x.m_args[i]))) ){
-                    llvm::Value* tmp_ptr = builder->CreateAlloca
-                        (llvm_utils->get_type_from_ttype_t_util(expr_type(x.m_args[i]), llvm_utils->module));
-                    builder->CreateStore(tmp, tmp_ptr);
-                    tmp = tmp_ptr;
-                }
-                args.push_back(tmp);
-                ptr_loads = ptr_load_copy;
+            } else {
+                ptr_loads = ptr_loads + LLVM::is_llvm_pointer(*expr_type(x.m_args[i]));
+                this->visit_expr_wrapper(x.m_args[i], true);
+            }
+            if(!tmp->getType()->isPointerTy() ||
+                ASR::is_a<ASR::PointerToCPtr_t>(*x.m_args[i]) ||
+                (ASRUtils::is_character(*expr_type(x.m_args[i])) &&
+                    !ASRUtils::is_array(expr_type(x.m_args[i]))) ){
+                llvm::Value* tmp_ptr = builder->CreateAlloca
+                    (llvm_utils->get_type_from_ttype_t_util(expr_type(x.m_args[i]), llvm_utils->module));
+                builder->CreateStore(tmp, tmp_ptr);
+                tmp = tmp_ptr;
+            }
+            args.push_back(tmp);
+            ptr_loads = ptr_load_copy;
+        }
+        return format_precompiled;
+    }
+
+    void visit_StringFormat(const ASR::StringFormat_t& x) {
+        if (x.m_kind == ASR::string_format_kindType::FormatFortran) {
+            std::vector<llvm::Value *> args;
+            if (get_string_format_args(x, args)) {
+                tmp = string_format_fortran_compiled(context, *module, *builder, args);
+            } else {
+                tmp = string_format_fortran(context, *module, *builder, args);
             }
-            tmp = string_format_fortran(context, *module, *builder, args);
         } else {
             throw CodeGenError("Only FormatFortran string formatting implemented so far.");
         }
@@ -241,10 +241,107 @@ public:
 
     void visit_Return(const ASR::Return_t &/*x*/) { }
 
-    // Expressions leave integer values in eax
+    /*
+    Register allocation for expression temporaries
+
+    Expressions are trees, so the live ranges of their temporaries are
+    properly nested and a linear scan over them reduces to handing out
+    registers in LIFO order. Every expression is evaluated into the register
+    `m_dest` chosen by its parent; binary operators evaluate the operand that
+    needs more registers first (Sethi-Ullman numbering) and hold the other
+    one in a register taken from `reg_pool`. Only if the pool is exhausted is
+    a register spilled to the stack for the duration of the operand.
+
+    eax and edx are kept out of the pool: `mul`, `div` and function return
+    values use them as fixed scratch registers. Called functions may clobber
+    any register, so the registers in use are saved around calls.
+    */
+
+    static constexpr X86Reg reg_pool[] = {X86Reg::ecx, X86Reg::ebx,
+        X86Reg::esi, X86Reg::edi};
+    uint8_t m_regs_used = 0; // Bit `1 << r` is set if register `r` is in use
+    X86Reg m_dest = X86Reg::eax;
+
+    struct TempReg {
+        X86Reg reg;
+        bool spilled; // The previous value of `reg` was pushed to the stack
+    };
+
+    // Returns a free register of the pool. If all are in use, a register
+    // other than `m_dest` is saved on the stack and reused.
+    TempReg alloc_reg() {
+        for (X86Reg r : reg_pool) {
+            if (!(m_regs_used & (1 << r))) {
+                m_regs_used |= (1 << r);
+                return {r, false};
+            }
+        }
+        X86Reg r = (m_dest == reg_pool[0]) ? reg_pool[1] : reg_pool[0];
+        m_a.asm_push_r32(r);
+        return {r, true};
+    }
+
+    void free_reg(const TempReg &t) {
+        if (t.spilled) {
+            m_a.asm_pop_r32(t.reg);
+        } else {
+            m_regs_used &= ~(1 << t.reg);
+        }
+    }
+
+    // Evaluates the expression `x` into the register `dest`
+    void visit_expr_into(const ASR::expr_t &x, X86Reg dest) {
+        X86Reg dest_copy = m_dest;
+        m_dest = dest;
+        this->visit_expr(x);
+        m_dest = dest_copy;
+    }
+
+    // Number of registers needed to evaluate `x` without spilling
+    static int reg_need(const ASR::expr_t &x) {
+        switch (x.type) {
+            case ASR::exprType::IntegerBinOp: {
+                const ASR::IntegerBinOp_t &b = (const ASR::IntegerBinOp_t&)x;
+                return reg_need_binop(*b.m_left, *b.m_right);
+            }
+            case ASR::exprType::IntegerCompare: {
+                const ASR::IntegerCompare_t &c = (const ASR::IntegerCompare_t&)x;
+                return reg_need_binop(*c.m_left, *c.m_right);
+            }
+            case ASR::exprType::IntegerUnaryMinus: {
+                return reg_need(*((const ASR::IntegerUnaryMinus_t&)x).m_arg);
+            }
+            default: {
+                return 1;
+            }
+        }
+    }
+
+    static int reg_need_binop(const ASR::expr_t &left, const ASR::expr_t &right) {
+        int l = reg_need(left);
+        int r = reg_need(right);
+        return (l == r) ? l + 1 : std::max(l, r);
+    }
+
+    // Evaluates `left` into `m_dest` and `right` into the returned register,
+    // which must be released with free_reg()
+    TempReg visit_operands(const ASR::expr_t &left, const ASR::expr_t &right) {
+        X86Reg dest = m_dest;
+        TempReg t;
+        if (reg_need(right) > reg_need(left)) {
+            t = alloc_reg();
+            visit_expr_into(right, t.reg);
+            visit_expr_into(left, dest);
+        } else {
+            visit_expr_into(left, dest);
+            t = alloc_reg();
+            visit_expr_into(right, t.reg);
+        }
+        return t;
+    }
 
     void visit_IntegerConstant(const ASR::IntegerConstant_t &x) {
-        m_a.asm_mov_r32_imm32(X86Reg::eax, x.m_n);
+        m_a.asm_mov_r32_imm32(m_dest, x.m_n);
     }
 
     void visit_LogicalConstant(const ASR::LogicalConstant_t &x) {
@@ -254,7 +351,7 @@ public:
         } else {
             val = 0;
         }
-        m_a.asm_mov_r32_imm32(X86Reg::eax, val);
+        m_a.asm_mov_r32_imm32(m_dest, val);
     }
 
     void visit_Var(const ASR::Var_t &x) {
@@ -263,62 +360,84 @@ public:
         LCOMPILERS_ASSERT(x86_symtab.find(h) != x86_symtab.end());
         Sym s = x86_symtab[h];
         X86Reg base = X86Reg::ebp;
-        // mov eax, [ebp-s.stack_offset]
-        m_a.asm_mov_r32_m32(X86Reg::eax, &base, nullptr, 1, -s.stack_offset);
+        // mov dest, [ebp-s.stack_offset]
+        m_a.asm_mov_r32_m32(m_dest, &base, nullptr, 1, -s.stack_offset);
         if (s.pointer) {
-            base = X86Reg::eax;
+            base = m_dest;
             // Dereference a pointer
-            // mov eax, [eax]
-            m_a.asm_mov_r32_m32(X86Reg::eax, &base, nullptr, 1, 0);
+            // mov dest, [dest]
+            m_a.asm_mov_r32_m32(m_dest, &base, nullptr, 1, 0);
         }
     }
 
     void visit_IntegerBinOp(const ASR::IntegerBinOp_t &x) {
-        this->visit_expr(*x.m_right);
-        m_a.asm_push_r32(X86Reg::eax);
-        this->visit_expr(*x.m_left);
-        m_a.asm_pop_r32(X86Reg::ecx);
-        // The left operand is in eax, the right operand is in ecx
-        // Leave the result in eax.
+        X86Reg dest = m_dest;
+        if ((x.m_op == ASR::binopType::Add || x.m_op == ASR::binopType::Sub)
+                && is_a<ASR::IntegerConstant_t>(*x.m_right)) {
+            // The right operand is an immediate, no register needed
+            this->visit_expr(*x.m_left);
+            uint32_t n = down_cast<ASR::IntegerConstant_t>(x.m_right)->m_n;
+            if (x.m_op == ASR::binopType::Add) {
+                m_a.asm_add_r32_imm32(dest, n);
+            } else {
+                m_a.asm_sub_r32_imm32(dest, n);
+            }
+            return;
+        }
+        TempReg right = visit_operands(*x.m_left, *x.m_right);
+        // The left operand is in dest, the right operand is in right.reg
+        // Leave the result in dest.
         switch (x.m_op) {
             case ASR::binopType::Add: {
-                m_a.asm_add_r32_r32(X86Reg::eax, X86Reg::ecx);
+                m_a.asm_add_r32_r32(dest, right.reg);
                 break;
             };
             case ASR::binopType::Sub: {
-                m_a.asm_sub_r32_r32(X86Reg::eax, X86Reg::ecx);
+                m_a.asm_sub_r32_r32(dest, right.reg);
                 break;
             };
             case ASR::binopType::Mul: {
-                m_a.asm_mov_r32_imm32(X86Reg::edx, 0);
-                m_a.asm_mul_r32(X86Reg::ecx);
+                m_a.asm_mov_r32_r32(X86Reg::eax, dest);
+                m_a.asm_mul_r32(right.reg);
+                m_a.asm_mov_r32_r32(dest, X86Reg::eax);
                 break;
             };
             case ASR::binopType::Div: {
+                m_a.asm_mov_r32_r32(X86Reg::eax, dest);
                 m_a.asm_mov_r32_imm32(X86Reg::edx, 0);
-                m_a.asm_div_r32(X86Reg::ecx);
+                m_a.asm_div_r32(right.reg);
+                m_a.asm_mov_r32_r32(dest, X86Reg::eax);
                 break;
             };
             default: {
                 throw CodeGenError("Binary operator '" + ASRUtils::binop_to_str_python(x.m_op) + "' not supported yet");
             }
         }
+        free_reg(right);
     }
 
     void visit_IntegerUnaryMinus(const ASR::IntegerUnaryMinus_t &x) {
         this->visit_expr(*x.m_arg);
-        m_a.asm_neg_r32(X86Reg::eax);
+        m_a.asm_neg_r32(m_dest);
     }
 
     void visit_IntegerCompare(const ASR::IntegerCompare_t &x) {
         std::string id = std::to_string(get_hash((ASR::asr_t*)&x));
-        this->visit_expr(*x.m_right);
-        m_a.asm_push_r32(X86Reg::eax);
-        this->visit_expr(*x.m_left);
-        m_a.asm_pop_r32(X86Reg::ecx);
-        // The left operand is in eax, the right operand is in ecx
-        // Leave the result in eax.
-        m_a.asm_cmp_r32_r32(X86Reg::eax, X86Reg::ecx);
+        X86Reg dest = m_dest;
+        if (is_a<ASR::IntegerConstant_t>(*x.m_right)
+                && down_cast<ASR::IntegerConstant_t>(x.m_right)->m_n >= -128
+                && down_cast<ASR::IntegerConstant_t>(x.m_right)->m_n <= 127) {
+            // Compare with a sign extended 8-bit immediate
+            this->visit_expr(*x.m_left);
+            m_a.asm_cmp_r32_imm8(dest,
+                down_cast<ASR::IntegerConstant_t>(x.m_right)->m_n);
+        } else {
+            TempReg right = visit_operands(*x.m_left, *x.m_right);
+            // The left operand is in dest, the right operand is in right.reg
+            m_a.asm_cmp_r32_r32(dest, right.reg);
+            free_reg(right);
+        }
+        // Leave the result in dest.
         switch (x.m_op) {
             case (ASR::cmpopType::Eq) : {
                 m_a.asm_je_label(".compare1" + id);
@@ -348,16 +467,17 @@ public:
                 throw CodeGenError("Comparison operator not implemented");
             }
         }
-        m_a.asm_mov_r32_imm32(X86Reg::eax, 0);
+        m_a.asm_mov_r32_imm32(dest, 0);
         m_a.asm_jmp_label(".compareend" + id);
         m_a.add_label(".compare1" + id);
-        m_a.asm_mov_r32_imm32(X86Reg::eax, 1);
+        m_a.asm_mov_r32_imm32(dest, 1);
         m_a.add_label(".compareend" + id);
     }
 
     void visit_Assignment(const ASR::Assignment_t &x) {
-        this->visit_expr(*x.m_value);
-        // RHS is in eax
+        TempReg value = alloc_reg();
+        visit_expr_into(*x.m_value, value.reg);
+        // RHS is in value.reg
 
         ASR::Variable_t *v = ASRUtils::EXPR2VAR(x.m_target);
         uint32_t h = get_hash((ASR::asr_t*)v);
@@ -365,15 +485,16 @@ public:
         Sym s = x86_symtab[h];
         X86Reg base = X86Reg::ebp;
         if (s.pointer) {
-            // mov ecx, [ebp-s.stack_offset]
-            m_a.asm_mov_r32_m32(X86Reg::ecx, &base, nullptr, 1, -s.stack_offset);
-            // mov [ecx], eax
-            base = X86Reg::ecx;
-            m_a.asm_mov_m32_r32(&base, nullptr, 1, 0, X86Reg::eax);
+            // mov eax, [ebp-s.stack_offset]
+            m_a.asm_mov_r32_m32(X86Reg::eax, &base, nullptr, 1, -s.stack_offset);
+            // mov [eax], value
+            base = X86Reg::eax;
+            m_a.asm_mov_m32_r32(&base, nullptr, 1, 0, value.reg);
         } else {
-            // mov [ebp-s.stack_offset], eax
-            m_a.asm_mov_m32_r32(&base, nullptr, 1, -s.stack_offset, X86Reg::eax);
+            // mov [ebp-s.stack_offset], value
+            m_a.asm_mov_m32_r32(&base, nullptr, 1, -s.stack_offset, value.reg);
         }
+        free_reg(value);
     }
 
     void visit_Print(const ASR::Print_t &x) {
@@ -392,10 +513,12 @@ public:
             emit_print(m_a, id, msg.size());
             m_global_strings[id] = msg;
         } else {
-            this->visit_expr(*e);
             ASR::ttype_t *t = ASRUtils::expr_type(e);
             if (t->type == ASR::ttypeType::Integer) {
-                m_a.asm_push_r32(X86Reg::eax);
+                TempReg value = alloc_reg();
+                visit_expr_into(*e, value.reg);
+                m_a.asm_push_r32(value.reg);
+                free_reg(value);
                 m_a.asm_call_label("print_int");
                 m_a.asm_add_r32_imm8(X86Reg::esp, 4);
             } else if (t->type == ASR::ttypeType::Real) {
@@ -423,11 +546,17 @@ public:
         m_a.asm_call_label("exit_error_stop");
     }
 
+    // Evaluates the logical `test` and compares it with 1 (true)
+    void emit_test(const ASR::expr_t &test) {
+        TempReg value = alloc_reg();
+        visit_expr_into(test, value.reg);
+        m_a.asm_cmp_r32_imm8(value.reg, 1);
+        free_reg(value);
+    }
+
     void visit_If(const ASR::If_t &x) {
         std::string id = std::to_string(get_hash((ASR::asr_t*)&x));
-        this->visit_expr(*x.m_test);
-        // eax contains the logical value (true=1, false=0) of the if condition
-        m_a.asm_cmp_r32_imm8(X86Reg::eax, 1);
+        emit_test(*x.m_test);
         m_a.asm_je_label(".then" + id);
         m_a.asm_jmp_label(".else" + id);
         m_a.add_label(".then" + id);
@@ -447,9 +576,7 @@ public:
 
         // head
         m_a.add_label(".loop.head" + id);
-        this->visit_expr(*x.m_test);
-        // eax contains the logical value (true=1, false=0) of the while condition
-        m_a.asm_cmp_r32_imm8(X86Reg::eax, 1);
+        emit_test(*x.m_test);
         m_a.asm_je_label(".loop.body" + id);
         m_a.asm_jmp_label(".loop.end" + id);
 
@@ -464,10 +591,12 @@ public:
         m_a.add_label(".loop.end" + id);
     }
 
-    // Push arguments to stack (last argument first)
+    // Push arguments to stack (last argument first), using `m_dest` for
+    // computing their values
     template <typename T, typename T2>
     uint8_t push_call_args(const T &x, const T2 &sub) {
         LCOMPILERS_ASSERT(sub.n_args == x.n_args);
+        X86Reg dest = m_dest;
         // Note: when counting down in a loop, we have to use signed ints
         // for `i`, so that it can become negative and fail the i>=0 condition.
         for (int i=x.n_args-1; i>=0; i--) {
@@ -488,44 +617,63 @@ public:
                 Sym s = x86_symtab[h];
                 X86Reg base = X86Reg::ebp;
                 if (s.pointer) {
-                    if (pass_as_pointer) {
-                        // Copy over the stack variable (already a pointer)
-                        // mov eax, [ebp-s.stack_offset]
-                        m_a.asm_mov_r32_m32(X86Reg::eax, &base, nullptr, 1, -s.stack_offset);
-                    } else {
-                        // Copy and dereference the stack variable
-
-                        // Copy
-                        // mov eax, [ebp-s.stack_offset]
-                        m_a.asm_mov_r32_m32(X86Reg::eax, &base, nullptr, 1, -s.stack_offset);
-
+                    // Copy over the stack variable (already a pointer)
+                    // mov dest, [ebp-s.stack_offset]
+                    m_a.asm_mov_r32_m32(dest, &base, nullptr, 1, -s.stack_offset);
+                    if (!pass_as_pointer) {
                         // Dereference a pointer
-                        // mov eax, [eax]
-                        m_a.asm_mov_r32_m32(X86Reg::eax, &base, nullptr, 1, 0);
+                        // mov dest, [dest]
+                        base = dest;
+                        m_a.asm_mov_r32_m32(dest, &base, nullptr, 1, 0);
                     }
-                    m_a.asm_push_r32(X86Reg::eax);
                 } else {
                     if (pass_as_pointer) {
                         // Get a pointer to the stack variable
-                        // lea eax, [ebp-s.stack_offset]
-                        m_a.asm_lea_r32_m32(X86Reg::eax, &base, nullptr, 1, -s.stack_offset);
+                        // lea dest, [ebp-s.stack_offset]
+                        m_a.asm_lea_r32_m32(dest, &base, nullptr, 1, -s.stack_offset);
                     } else {
                         // Copy over the stack variable
-                        // mov eax, [ebp-s.stack_offset]
-                        m_a.asm_mov_r32_m32(X86Reg::eax, &base, nullptr, 1, -s.stack_offset);
+                        // mov dest, [ebp-s.stack_offset]
+                        m_a.asm_mov_r32_m32(dest, &base, nullptr, 1, -s.stack_offset);
                     }
-                    m_a.asm_push_r32(X86Reg::eax);
                 }
             } else {
                 LCOMPILERS_ASSERT(!pass_as_pointer);
                 this->visit_expr(*(x.m_args[i].m_value));
-                // The value of the argument is in eax, push it onto the stack
-                m_a.asm_push_r32(X86Reg::eax);
             }
+            // The value of the argument is in dest, push it onto the stack
+            m_a.asm_push_r32(dest);
         }
         return x.n_args*4;
     }
 
+    // Calls `fn_label` with the arguments of `x`, the result (if any) is
+    // left in `m_dest`. The callee may clobber all registers, so the ones in
+    // use by the enclosing expression are saved on the stack around the call
+    // and are available for computing the arguments.
+    template <typename T>
+    void emit_call(const T &x, const ASR::Function_t &s,
+            const std::string &fn_label, bool has_result) {
+        uint8_t saved = m_regs_used & ~(1 << m_dest);
+        for (X86Reg r : reg_pool) {
+            if (saved & (1 << r)) m_a.asm_push_r32(r);
+        }
+        m_regs_used &= ~saved;
+        // Push arguments to stack (last argument first)
+        uint8_t arg_offset = push_call_args(x, s);
+        m_a.asm_call_label(fn_label);
+        // Remove arguments from stack
+        m_a.asm_add_r32_imm8(X86Reg::esp, arg_offset);
+        if (has_result) {
+            // The result is in eax
+            m_a.asm_mov_r32_r32(m_dest, X86Reg::eax);
+        }
+        m_regs_used |= saved;
+        for (int i = sizeof(reg_pool)/sizeof(reg_pool[0]) - 1; i >= 0; i--) {
+            if (saved & (1 << reg_pool[i])) m_a.asm_pop_r32(reg_pool[i]);
+        }
+    }
+
     void visit_SubroutineCall(const ASR::SubroutineCall_t &x) {
         ASR::Function_t *s = ASR::down_cast<ASR::Function_t>(
             ASRUtils::symbol_get_past_external(x.m_name));
@@ -536,12 +684,12 @@ public:
                 + std::string(s->m_name) + "'");
         }
         Sym &sym = x86_symtab[h];
-        // Push arguments to stack (last argument first)
-        uint8_t arg_offset = push_call_args(x, *s);
-        // Call the subroutine
-        m_a.asm_call_label(sym.fn_label);
-        // Remove arguments from stack
-        m_a.asm_add_r32_imm8(X86Reg::esp, arg_offset);
+        TempReg t = alloc_reg();
+        X86Reg dest_copy = m_dest;
+        m_dest = t.reg;
+        emit_call(x, *s, sym.fn_label, false);
+        m_dest = dest_copy;
+        free_reg(t);
     }
 
     void visit_FunctionCall(const ASR::FunctionCall_t &x) {
@@ -553,12 +701,7 @@ public:
                 + std::string(s->m_name) + "'");
         }
         Sym &sym = x86_symtab[h];
-        // Push arguments to stack (last argument first)
-        uint8_t arg_offset = push_call_args(x, *s);
-        // Call the function (the result is in eax, we leave it there)
-        m_a.asm_call_label(sym.fn_label);
-        // Remove arguments from stack
-        m_a.asm_add_r32_imm8(X86Reg::esp, arg_offset);
+        emit_call(x, *s, sym.fn_label, true);
     }
 
 };
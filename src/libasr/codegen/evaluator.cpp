@@ -1,5 +1,9 @@
 #include <iostream>
 #include <fstream>
+#include <mutex>
+#include <chrono>
+#include <map>
+#include <thread>
 
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/ADT/STLExtras.h>
@@ -43,6 +47,9 @@
 #include <llvm/Support/FileSystem.h>
 #include <llvm/Support/Path.h>
 #include <llvm/AsmParser/Parser.h>
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#include <llvm/Transforms/Utils/SplitModule.h>
 #include <llvm/Support/SourceMgr.h>
 #include <llvm/ADT/StringRef.h>
 #include <llvm/Target/TargetOptions.h>
@@ -56,6 +63,7 @@
     #include <llvm/Passes/PassBuilder.h>
 #else
 #    include <llvm/Transforms/IPO/PassManagerBuilder.h>
+#    include <llvm/IR/PassTimingInfo.h>
 #endif
 
 #if LLVM_VERSION_MAJOR < 18
@@ -197,33 +205,80 @@ float _lfortran_stan(float x);
 
 }
 
-LLVMEvaluator::LLVMEvaluator(const std::string &t)
+namespace {
+
+    llvm::TargetMachine *create_target_machine(const std::string &target_triple) {
+        std::string Error;
+        const llvm::Target *target = llvm::TargetRegistry::lookupTarget(target_triple, Error);
+        if (!target) {
+            throw LCompilersException(Error);
+        }
+        std::string CPU = "generic";
+        std::string features = "";
+        llvm::TargetOptions opt;
+        RM_OPTIONAL_TYPE<llvm::Reloc::Model> RM = llvm::Reloc::Model::PIC_;
+        return target->createTargetMachine(target_triple, CPU, features, opt, RM);
+    }
+
+    void emit_object_file(llvm::Module &m, llvm::TargetMachine &TM,
+            const std::string &filename) {
+        llvm::legacy::PassManager pass;
+#if LLVM_VERSION_MAJOR < 18
+        llvm::CodeGenFileType ft = llvm::CGFT_ObjectFile;
+#else
+        llvm::CodeGenFileType ft = llvm::CodeGenFileType::ObjectFile;
+#endif
+        std::error_code EC;
+        llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
+        if (EC) {
+            throw std::runtime_error("raw_fd_ostream failed");
+        }
+        if (TM.addPassesToEmitFile(pass, dest, nullptr, ft)) {
+            throw std::runtime_error("TargetMachine can't emit a file of this type");
+        }
+        pass.run(m);
+        dest.flush();
+    }
+
+} // namespace
+
+void LLVMEvaluator::initialize_targets()
 {
-    llvm::InitializeNativeTarget();
-    llvm::InitializeNativeTargetAsmPrinter();
-    llvm::InitializeNativeTargetAsmParser();
+    // Registering the targets mutates LLVM's global TargetRegistry, so do it
+    // once per process, even if several evaluators are created in parallel.
+    static std::once_flag targets_initialized;
+    std::call_once(targets_initialized, []() {
+        llvm::InitializeNativeTarget();
+        llvm::InitializeNativeTargetAsmPrinter();
+        llvm::InitializeNativeTargetAsmParser();
 
 #ifdef HAVE_TARGET_AARCH64
-    LLVMInitializeAArch64Target();
-    LLVMInitializeAArch64TargetInfo();
-    LLVMInitializeAArch64TargetMC();
-    LLVMInitializeAArch64AsmPrinter();
-    LLVMInitializeAArch64AsmParser();
+        LLVMInitializeAArch64Target();
+        LLVMInitializeAArch64TargetInfo();
+        LLVMInitializeAArch64TargetMC();
+        LLVMInitializeAArch64AsmPrinter();
+        LLVMInitializeAArch64AsmParser();
 #endif
 #ifdef HAVE_TARGET_X86
-    LLVMInitializeX86Target();
-    LLVMInitializeX86TargetInfo();
-    LLVMInitializeX86TargetMC();
-    LLVMInitializeX86AsmPrinter();
-    LLVMInitializeX86AsmParser();
+        LLVMInitializeX86Target();
+        LLVMInitializeX86TargetInfo();
+        LLVMInitializeX86TargetMC();
+        LLVMInitializeX86AsmPrinter();
+        LLVMInitializeX86AsmParser();
 #endif
 #ifdef HAVE_TARGET_WASM
-    LLVMInitializeWebAssemblyTarget();
-    LLVMInitializeWebAssemblyTargetInfo();
-    LLVMInitializeWebAssemblyTargetMC();
-    LLVMInitializeWebAssemblyAsmPrinter();
-    LLVMInitializeWebAssemblyAsmParser();
+        LLVMInitializeWebAssemblyTarget();
+        LLVMInitializeWebAssemblyTargetInfo();
+        LLVMInitializeWebAssemblyTargetMC();
+        LLVMInitializeWebAssemblyAsmPrinter();
+        LLVMInitializeWebAssemblyAsmParser();
 #endif
+    });
+}
+
+LLVMEvaluator::LLVMEvaluator(const std::string &t)
+{
+    initialize_targets();
 
     context = std::make_unique<llvm::LLVMContext>();
 
@@ -232,16 +287,7 @@ LLVMEvaluator::LLVMEvaluator(const std::string &t)
     else
         target_triple = LLVMGetDefaultTargetTriple();
 
-    std::string Error;
-    const llvm::Target *target = llvm::TargetRegistry::lookupTarget(target_triple, Error);
-    if (!target) {
-        throw LCompilersException(Error);
-    }
-    std::string CPU = "generic";
-    std::string features = "";
-    llvm::TargetOptions opt;
-    RM_OPTIONAL_TYPE<llvm::Reloc::Model> RM = llvm::Reloc::Model::PIC_;
-    TM = target->createTargetMachine(target_triple, CPU, features, opt, RM);
+    TM = create_target_machine(target_triple);
 
     // For some reason the JIT requires a different TargetMachine
     jit = cantFail(llvm::orc::KaleidoscopeJIT::Create());
@@ -381,23 +427,58 @@ void LLVMEvaluator::save_asm_file(llvm::Module &m, const std::string &filename)
 void LLVMEvaluator::save_object_file(llvm::Module &m, const std::string &filename) {
     m.setTargetTriple(target_triple);
     m.setDataLayout(TM->createDataLayout());
+    emit_object_file(m, *TM, filename);
+}
 
-    llvm::legacy::PassManager pass;
-#if LLVM_VERSION_MAJOR < 18
-    llvm::CodeGenFileType ft = llvm::CGFT_ObjectFile;
-#else
-    llvm::CodeGenFileType ft = llvm::CodeGenFileType::ObjectFile;
-#endif
-    std::error_code EC;
-    llvm::raw_fd_ostream dest(filename, EC, llvm::sys::fs::OF_None);
-    if (EC) {
-        throw std::runtime_error("raw_fd_ostream failed");
+void LLVMEvaluator::save_object_files(llvm::Module &m,
+        const std::vector<std::string> &filenames) {
+    m.setTargetTriple(target_triple);
+    m.setDataLayout(TM->createDataLayout());
+
+    // Each partition is compiled in its own LLVMContext (a context must not
+    // be shared between threads), so the partitions are handed over to the
+    // threads as bitcode. Local symbols are kept in the partition of their
+    // users, so no symbol changes its name, linkage or visibility.
+    std::vector<llvm::SmallString<0>> partitions;
+    llvm::SplitModule(m, filenames.size(),
+        [&](std::unique_ptr<llvm::Module> part) {
+            partitions.emplace_back();
+            llvm::raw_svector_ostream os(partitions.back());
+            llvm::WriteBitcodeToFile(*part, os);
+        }, /* PreserveLocals */ true);
+    LCOMPILERS_ASSERT(partitions.size() == filenames.size());
+
+    std::vector<std::string> errors(partitions.size());
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < partitions.size(); i++) {
+        threads.emplace_back([&, i]() {
+            try {
+                llvm::LLVMContext ctx;
+                llvm::Expected<std::unique_ptr<llvm::Module>> part =
+                    llvm::parseBitcodeFile(llvm::MemoryBufferRef(
+                        llvm::StringRef(partitions[i].data(), partitions[i].size()),
+                        filenames[i]), ctx);
+                if (!part) {
+                    errors[i] = llvm::toString(part.takeError());
+                    return;
+                }
+                std::unique_ptr<llvm::TargetMachine> tm(
+                    create_target_machine(target_triple));
+                emit_object_file(**part, *tm, filenames[i]);
+            } catch (const std::exception &e) {
+                errors[i] = e.what();
+            }
+        });
     }
-    if (TM->addPassesToEmitFile(pass, dest, nullptr, ft)) {
-        throw std::runtime_error("TargetMachine can't emit a file of this type");
+    for (std::thread &t: threads) {
+        t.join();
+    }
+    for (size_t i = 0; i < errors.size(); i++) {
+        if (!errors[i].empty()) {
+            throw LCompilersException("Code generation of '" + filenames[i]
+                + "' failed: " + errors[i]);
+        }
     }
-    pass.run(m);
-    dest.flush();
 }
 
 void LLVMEvaluator::create_empty_object_file(const std::string &filename) {
@@ -406,7 +487,74 @@ void LLVMEvaluator::create_empty_object_file(const std::string &filename) {
     save_object_file(*module, filename);
 }
 
-void LLVMEvaluator::opt(llvm::Module &m) {
+#if LLVM_VERSION_MAJOR >= 17
+namespace {
+
+    llvm::OptimizationLevel get_optimization_level(const std::string &opt_level) {
+        if (opt_level == "0") return llvm::OptimizationLevel::O0;
+        if (opt_level == "1") return llvm::OptimizationLevel::O1;
+        if (opt_level == "2") return llvm::OptimizationLevel::O2;
+        if (opt_level == "3") return llvm::OptimizationLevel::O3;
+        if (opt_level == "s") return llvm::OptimizationLevel::Os;
+        if (opt_level == "z") return llvm::OptimizationLevel::Oz;
+        throw LCompilersException("Unsupported optimization level: -O" + opt_level);
+    }
+
+    // Accumulates the time spent in each LLVM pass. Pass managers and
+    // adaptors also report themselves, so only the time not spent in nested
+    // passes is attributed to a pass.
+    class PassTimer {
+        struct RunningPass {
+            std::chrono::high_resolution_clock::time_point start;
+            double nested_us;
+        };
+        std::vector<RunningPass> running;
+        std::map<std::string, double> total_us;
+
+        void before() {
+            running.push_back({std::chrono::high_resolution_clock::now(), 0});
+        }
+
+        void after(llvm::StringRef pass) {
+            if (running.empty()) return;
+            RunningPass p = running.back();
+            running.pop_back();
+            double us = std::chrono::duration<double, std::micro>(
+                std::chrono::high_resolution_clock::now() - p.start).count();
+            total_us[pass.str()] += us - p.nested_us;
+            if (!running.empty()) running.back().nested_us += us;
+        }
+
+    public:
+        void register_callbacks(llvm::PassInstrumentationCallbacks &PIC) {
+            PIC.registerBeforeNonSkippedPassCallback(
+                [this](llvm::StringRef, const auto &) { before(); });
+            PIC.registerAfterPassCallback(
+                [this](llvm::StringRef pass, const auto &, const auto &) {
+                    after(pass);
+                });
+            PIC.registerAfterPassInvalidatedCallback(
+                [this](llvm::StringRef pass, const auto &) { after(pass); });
+        }
+
+        // Appends one "[LLVM]<pass>: <time> ms" entry per pass, slowest first
+        void report(std::vector<std::string> &pass_times) {
+            std::vector<std::pair<std::string, double>> passes(
+                total_us.begin(), total_us.end());
+            std::stable_sort(passes.begin(), passes.end(),
+                [](const auto &a, const auto &b) { return a.second > b.second; });
+            for (auto &p: passes) {
+                pass_times.push_back("[LLVM]" + p.first + ": "
+                    + std::to_string(p.second / 1000.0) + " ms");
+            }
+        }
+    };
+
+} // namespace
+#endif
+
+void LLVMEvaluator::opt(llvm::Module &m, const std::string &opt_level,
+        const std::string &passes, std::vector<std::string> *pass_times) {
     m.setTargetTriple(target_triple);
     m.setDataLayout(TM->createDataLayout());
 
@@ -415,31 +563,63 @@ void LLVMEvaluator::opt(llvm::Module &m) {
     llvm::FunctionAnalysisManager FAM;
     llvm::CGSCCAnalysisManager CGAM;
     llvm::ModuleAnalysisManager MAM;
-    llvm::PassBuilder PB = llvm::PassBuilder(TM);
+    llvm::PassInstrumentationCallbacks PIC;
+    PassTimer timer;
+    if (pass_times) timer.register_callbacks(PIC);
+    llvm::PassBuilder PB = llvm::PassBuilder(TM, llvm::PipelineTuningOptions(),
+        std::nullopt, &PIC);
     PB.registerModuleAnalyses(MAM);
     PB.registerCGSCCAnalyses(CGAM);
     PB.registerFunctionAnalyses(FAM);
     PB.registerLoopAnalyses(LAM);
     PB.crossRegisterProxies(LAM, FAM, CGAM, MAM);
-    llvm::ModulePassManager MPM = PB.buildPerModuleDefaultPipeline(llvm::OptimizationLevel::O3);
+    llvm::ModulePassManager MPM;
+    if (!passes.empty()) {
+        if (llvm::Error err = PB.parsePassPipeline(MPM, passes)) {
+            throw LCompilersException("Invalid LLVM pass pipeline '" + passes
+                + "': " + llvm::toString(std::move(err)));
+        }
+    } else {
+        llvm::OptimizationLevel level = get_optimization_level(opt_level);
+        if (level == llvm::OptimizationLevel::O0) {
+            MPM = PB.buildO0DefaultPipeline(level);
+        } else {
+            MPM = PB.buildPerModuleDefaultPipeline(level);
+        }
+    }
     MPM.run(m, MAM);
+    if (pass_times) timer.report(*pass_times);
 
 #else
+    if (!passes.empty()) {
+        throw LCompilersException("Custom LLVM pass pipelines require LLVM 17 or newer");
+    }
+    int optLevel, sizeLevel = 0;
+    if (opt_level == "0" || opt_level == "1" || opt_level == "2" || opt_level == "3") {
+        optLevel = opt_level[0] - '0';
+    } else if (opt_level == "s") {
+        optLevel = 2;
+        sizeLevel = 1;
+    } else if (opt_level == "z") {
+        optLevel = 2;
+        sizeLevel = 2;
+    } else {
+        throw LCompilersException("Unsupported optimization level: -O" + opt_level);
+    }
+    if (pass_times) llvm::TimePassesIsEnabled = true;
     llvm::legacy::PassManager mpm;
     mpm.add(new llvm::TargetLibraryInfoWrapperPass(TM->getTargetTriple()));
     mpm.add(llvm::createTargetTransformInfoWrapperPass(TM->getTargetIRAnalysis()));
     llvm::legacy::FunctionPassManager fpm(&m);
     fpm.add(llvm::createTargetTransformInfoWrapperPass(TM->getTargetIRAnalysis()));
-    int optLevel = 3;
-    int sizeLevel = 0;
     llvm::PassManagerBuilder builder;
     builder.OptLevel = optLevel;
     builder.SizeLevel = sizeLevel;
     builder.Inliner = llvm::createFunctionInliningPass(optLevel, sizeLevel,
         false);
-    builder.DisableUnrollLoops = false;
-    builder.LoopVectorize = true;
-    builder.SLPVectorize = true;
+    builder.DisableUnrollLoops = optLevel == 0;
+    builder.LoopVectorize = optLevel > 1 && sizeLevel < 2;
+    builder.SLPVectorize = optLevel > 1 && sizeLevel < 2;
     builder.populateFunctionPassManager(fpm);
     builder.populateModulePassManager(mpm);
     fpm.doInitialization();
@@ -449,6 +629,17 @@ void LLVMEvaluator::opt(llvm::Module &m) {
     fpm.doFinalization();
     mpm.add(llvm::createVerifierPass());
     mpm.run(m);
+    if (pass_times) {
+        // The legacy pass manager can only report its own timing tables
+        std::string report;
+        llvm::raw_string_ostream os(report);
+        llvm::reportAndResetTimings(&os);
+        os.flush();
+        llvm::TimePassesIsEnabled = false;
+        for (const std::string &line: string_split(report, "\n", false)) {
+            if (!line.empty()) pass_times->push_back("[LLVM]" + line);
+        }
+    }
 #endif
 }
 
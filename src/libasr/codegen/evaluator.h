@@ -70,6 +70,8 @@ private:
 public:
     LLVMEvaluator(const std::string &t = "");
     ~LLVMEvaluator();
+    // Registers the LLVM targets; done once per process by the constructor
+    static void initialize_targets();
     std::unique_ptr<llvm::Module> parse_module(const std::string &source, const std::string &filename);
     std::unique_ptr<LLVMModule> parse_module2(const std::string &source, const std::string &filename);
     void add_module(const std::string &source);
@@ -79,8 +81,17 @@ public:
     std::string get_asm(llvm::Module &m);
     void save_asm_file(llvm::Module &m, const std::string &filename);
     void save_object_file(llvm::Module &m, const std::string &filename);
+    // Splits `m` into `filenames.size()` partitions and compiles them into
+    // the corresponding object files in parallel
+    void save_object_files(llvm::Module &m,
+        const std::vector<std::string> &filenames);
     void create_empty_object_file(const std::string &filename);
-    void opt(llvm::Module &m);
+    // Optimizes `m` with the default pipeline of `opt_level` ("0", "1", "2",
+    // "3", "s" or "z"), or with the custom pipeline `passes` if not empty.
+    // If `pass_times` is given, the time spent in each pass is appended.
+    void opt(llvm::Module &m, const std::string &opt_level = "3",
+        const std::string &passes = "",
+        std::vector<std::string> *pass_times = nullptr);
     static std::string module_to_string(llvm::Module &m);
     static void print_version_message();
     static std::string llvm_version();
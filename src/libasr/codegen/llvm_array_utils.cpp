@@ -6,40 +6,117 @@ namespace LCompilers {
 
     namespace LLVMArrUtils {
 
-        llvm::Value* lfortran_malloc(llvm::LLVMContext &context, llvm::Module &module,
+        llvm::Value* lfortran_pool_malloc(llvm::LLVMContext &context, llvm::Module &module,
                 llvm::IRBuilder<> &builder, llvm::Value* arg_size) {
-            std::string func_name = "_lfortran_malloc";
+            std::string func_name = "_lfortran_pool_malloc";
             llvm::Function *fn = module.getFunction(func_name);
             if (!fn) {
                 llvm::FunctionType *function_type = llvm::FunctionType::get(
                         llvm::Type::getInt8Ty(context)->getPointerTo(), {
-                            llvm::Type::getInt32Ty(context)
+                            llvm::Type::getInt64Ty(context)
                         }, false);
                 fn = llvm::Function::Create(function_type,
                         llvm::Function::ExternalLinkage, func_name, module);
+                // Like malloc, every call returns a fresh object
+#if LLVM_VERSION_MAJOR >= 14
+                fn->addRetAttr(llvm::Attribute::NoAlias);
+#else
+                fn->addAttribute(llvm::AttributeList::ReturnIndex, llvm::Attribute::NoAlias);
+#endif
             }
-            std::vector<llvm::Value*> args = {arg_size};
+            std::vector<llvm::Value*> args = {
+                builder.CreateSExtOrTrunc(arg_size, llvm::Type::getInt64Ty(context))};
             return builder.CreateCall(fn, args);
         }
 
-        llvm::Value* lfortran_realloc(llvm::LLVMContext &context, llvm::Module &module,
+        llvm::Value* lfortran_pool_realloc(llvm::LLVMContext &context, llvm::Module &module,
                 llvm::IRBuilder<> &builder, llvm::Value* ptr, llvm::Value* arg_size) {
-            std::string func_name = "_lfortran_realloc";
+            std::string func_name = "_lfortran_pool_realloc";
             llvm::Function *fn = module.getFunction(func_name);
             if (!fn) {
                 llvm::FunctionType *function_type = llvm::FunctionType::get(
                         llvm::Type::getInt8Ty(context)->getPointerTo(), {
                             llvm::Type::getInt8Ty(context)->getPointerTo(),
-                            llvm::Type::getInt32Ty(context)
+                            llvm::Type::getInt64Ty(context)
+                        }, false);
+                fn = llvm::Function::Create(function_type,
+                        llvm::Function::ExternalLinkage, func_name, module);
+            }
+            std::vector<llvm::Value*> args = {
+                builder.CreateBitCast(ptr, llvm::Type::getInt8Ty(context)->getPointerTo()),
+                builder.CreateSExtOrTrunc(arg_size, llvm::Type::getInt64Ty(context))};
+            return builder.CreateCall(fn, args);
+        }
+
+        llvm::Value* lfortran_pool_free(llvm::LLVMContext &context, llvm::Module &module,
+                llvm::IRBuilder<> &builder, llvm::Value* ptr) {
+            std::string func_name = "_lfortran_pool_free";
+            llvm::Function *fn = module.getFunction(func_name);
+            if (!fn) {
+                llvm::FunctionType *function_type = llvm::FunctionType::get(
+                        llvm::Type::getVoidTy(context), {
+                            llvm::Type::getInt8Ty(context)->getPointerTo()
                         }, false);
                 fn = llvm::Function::Create(function_type,
                         llvm::Function::ExternalLinkage, func_name, module);
             }
             std::vector<llvm::Value*> args = {
-                builder.CreateBitCast(ptr, llvm::Type::getInt8Ty(context)->getPointerTo()), arg_size};
+                builder.CreateBitCast(ptr, llvm::Type::getInt8Ty(context)->getPointerTo())};
             return builder.CreateCall(fn, args);
         }
 
+        llvm::Value* lfortran_pool_malloc_or_stack(LLVMUtils* llvm_utils,
+                llvm::LLVMContext &context, llvm::Module &module,
+                llvm::IRBuilder<> &builder, llvm::Value* arg_size,
+                int64_t stack_size) {
+            llvm::Type* i8_ptr = llvm::Type::getInt8Ty(context)->getPointerTo();
+            llvm::Type* i64 = llvm::Type::getInt64Ty(context);
+            arg_size = builder.CreateSExtOrTrunc(arg_size, i64);
+            bool is_constant_size = llvm::isa<llvm::ConstantInt>(arg_size);
+            if( is_constant_size ) {
+                int64_t size = llvm::cast<llvm::ConstantInt>(arg_size)->getSExtValue();
+                if( size > stack_size ) {
+                    return lfortran_pool_malloc(context, module, builder, arg_size);
+                }
+                // Known small size, no runtime check needed
+                stack_size = std::max<int64_t>(size, 1);
+            }
+            if( stack_size <= 0 ) {
+                return lfortran_pool_malloc(context, module, builder, arg_size);
+            }
+            // Round up to keep the 16 byte alignment of the data
+            stack_size = (stack_size + 15) / 16 * 16;
+            // Layout of the runtime lfortran_pool_header:
+            // {i64 size_class (LFORTRAN_POOL_STACK), i64 capacity}
+            const int64_t header_size = 16, pool_stack_class = -2;
+            llvm::AllocaInst* buffer = llvm_utils->CreateAlloca(
+                llvm::ArrayType::get(llvm::Type::getInt8Ty(context),
+                    header_size + stack_size), nullptr, "stack_array_buffer");
+            buffer->setAlignment(llvm::Align(16));
+            auto fill_stack_block = [&]() -> llvm::Value* {
+                llvm::Value* header = builder.CreateBitCast(buffer, i64->getPointerTo());
+                builder.CreateStore(llvm::ConstantInt::get(i64, pool_stack_class), header);
+                builder.CreateStore(llvm::ConstantInt::get(i64, stack_size),
+                    llvm_utils->create_ptr_gep2(i64, header, 1));
+                return llvm_utils->create_ptr_gep2(llvm::Type::getInt8Ty(context),
+                    builder.CreateBitCast(buffer, i8_ptr), header_size);
+            };
+            if( is_constant_size ) {
+                return fill_stack_block();
+            }
+            llvm::Value* data = llvm_utils->CreateAlloca(i8_ptr);
+            llvm_utils->create_if_else(builder.CreateICmpSLE(arg_size,
+                    llvm::ConstantInt::get(i64, stack_size)),
+                [&]() {
+                    builder.CreateStore(fill_stack_block(), data);
+                },
+                [&]() {
+                    builder.CreateStore(lfortran_pool_malloc(
+                        context, module, builder, arg_size), data);
+                });
+            return llvm_utils->CreateLoad2(i8_ptr, data);
+        }
+
         bool compile_time_dimensions_t(ASR::dimension_t* m_dims, int n_dims) {
             if( n_dims <= 0 ) {
                 return false;
@@ -303,11 +380,12 @@ namespace LCompilers {
             if( !co.stack_arrays ) {
                 llvm::DataLayout data_layout(module->getDataLayout());
                 uint64_t size = data_layout.getTypeAllocSize(llvm_data_type);
-                builder->CreateStore(builder->CreateMul(
-                    llvm_utils->CreateLoad(llvm_size),
-                    llvm::ConstantInt::get(context, llvm::APInt(32, size))), llvm_size);
-                llvm::Value* arr_first_i8 = lfortran_malloc(
-                    context, *module, *builder, llvm_utils->CreateLoad(llvm_size));
+                llvm::Value* size_in_bytes = builder->CreateMul(
+                    builder->CreateSExt(llvm_utils->CreateLoad(llvm_size),
+                        llvm::Type::getInt64Ty(context)),
+                    llvm::ConstantInt::get(context, llvm::APInt(64, size)));
+                llvm::Value* arr_first_i8 = lfortran_pool_malloc(
+                    context, *module, *builder, size_in_bytes);
                 heap_arrays.push_back(arr_first_i8);
                 arr_first = builder->CreateBitCast(
                     arr_first_i8, llvm_data_type->getPointerTo());
@@ -351,7 +429,7 @@ namespace LCompilers {
         void SimpleCMODescriptor::fill_malloc_array_details(
             llvm::Value* arr, llvm::Type* arr_type, llvm::Type* llvm_data_type, int n_dims,
             std::vector<std::pair<llvm::Value*, llvm::Value*>>& llvm_dims,
-            llvm::Module* module, bool realloc) {
+            llvm::Module* module, bool realloc, int64_t stack_size) {
             arr = llvm_utils->CreateLoad2(arr_type->getPointerTo(), arr);
 #if LLVM_VERSION_MAJOR > 16
             llvm_utils->ptr_type[arr] = arr_type;
@@ -375,20 +453,28 @@ namespace LCompilers {
                 prod = builder->CreateMul(prod, dim_size);
             }
             llvm::Value* ptr2firstptr = get_pointer_to_data(arr);
-            llvm::AllocaInst *arg_size = llvm_utils->CreateAlloca(*builder, llvm::Type::getInt32Ty(context));
+            llvm::AllocaInst *arg_size = llvm_utils->CreateAlloca(*builder, llvm::Type::getInt64Ty(context));
             llvm::DataLayout data_layout(module->getDataLayout());
             llvm::Type* ptr_type = llvm_data_type->getPointerTo();
             uint64_t size = data_layout.getTypeAllocSize(llvm_data_type);
-            llvm::Value* llvm_size = llvm::ConstantInt::get(context, llvm::APInt(32, size));
-            prod = builder->CreateMul(prod, llvm_size);
+            // The size in bytes is computed in 64 bits, so that arrays
+            // larger than 2 GB can be allocated
+            llvm::Value* llvm_size = llvm::ConstantInt::get(context, llvm::APInt(64, size));
+            prod = builder->CreateMul(
+                builder->CreateSExt(prod, llvm::Type::getInt64Ty(context)), llvm_size);
             builder->CreateStore(prod, arg_size);
             llvm::Value* ptr_as_char_ptr = nullptr;
             if( realloc ) {
-                ptr_as_char_ptr = lfortran_realloc(context, *module,
+                ptr_as_char_ptr = lfortran_pool_realloc(context, *module,
                     *builder, llvm_utils->CreateLoad2(llvm_data_type->getPointerTo(), ptr2firstptr),
                     llvm_utils->CreateLoad(arg_size));
+            } else if( stack_size > 0 ) {
+                // `prod` instead of a load of `arg_size`, so that
+                // a constant size is seen as such
+                ptr_as_char_ptr = lfortran_pool_malloc_or_stack(llvm_utils,
+                    context, *module, *builder, prod, stack_size);
             } else {
-                ptr_as_char_ptr = lfortran_malloc(context, *module,
+                ptr_as_char_ptr = lfortran_pool_malloc(context, *module,
                     *builder, llvm_utils->CreateLoad(arg_size));
             }
             llvm::Value* first_ptr = builder->CreateBitCast(ptr_as_char_ptr, ptr_type);
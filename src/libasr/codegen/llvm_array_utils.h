@@ -22,9 +22,37 @@ namespace LCompilers {
 
     namespace LLVMArrUtils {
 
-        llvm::Value* lfortran_malloc(llvm::LLVMContext &context, llvm::Module &module,
+        /*
+        * Allocation of array data goes through the runtime pool
+        * allocator. Memory obtained from lfortran_pool_malloc and
+        * lfortran_pool_realloc must be released with lfortran_pool_free,
+        * never with LLVM::lfortran_free. The sizes are in bytes and are
+        * extended to 64 bits.
+        */
+        llvm::Value* lfortran_pool_malloc(llvm::LLVMContext &context, llvm::Module &module,
                 llvm::IRBuilder<> &builder, llvm::Value* arg_size);
 
+        llvm::Value* lfortran_pool_realloc(llvm::LLVMContext &context, llvm::Module &module,
+                llvm::IRBuilder<> &builder, llvm::Value* ptr, llvm::Value* arg_size);
+
+        llvm::Value* lfortran_pool_free(llvm::LLVMContext &context, llvm::Module &module,
+                llvm::IRBuilder<> &builder, llvm::Value* ptr);
+
+        /*
+        * Like lfortran_pool_malloc, but requests of at most `stack_size`
+        * bytes are served from a buffer allocated in the entry block of the
+        * current function. The check is done at runtime, larger requests
+        * fall back to the pool. The buffer is preceded by a header that
+        * makes lfortran_pool_free a no-op and lfortran_pool_realloc move
+        * the data to the heap when it grows, so the result can be released
+        * and resized like any other pool block. The caller must ensure
+        * the memory does not outlive the current function.
+        */
+        llvm::Value* lfortran_pool_malloc_or_stack(LLVMUtils* llvm_utils,
+                llvm::LLVMContext &context, llvm::Module &module,
+                llvm::IRBuilder<> &builder, llvm::Value* arg_size,
+                int64_t stack_size);
+
         /*
         * This function checks whether the
         * dimensions are available at compile time.
@@ -145,13 +173,14 @@ namespace LCompilers {
 
                 /*
                 * Fills the elements of the input array descriptor
-                * for allocatable arrays.
+                * for allocatable arrays. Allocations (not reallocations)
+                * of at most `stack_size` bytes are served from the stack.
                 */
                 virtual
                 void fill_malloc_array_details(
                     llvm::Value* arr, llvm::Type *arr_type, llvm::Type* llvm_data_type, int n_dims,
                     std::vector<std::pair<llvm::Value*, llvm::Value*>>& llvm_dims,
-                    llvm::Module* module, bool realloc=false) = 0;
+                    llvm::Module* module, bool realloc=false, int64_t stack_size=0) = 0;
 
                 virtual
                 void fill_dimension_descriptor(llvm::Value* arr, int n_dims) = 0;
@@ -379,7 +408,7 @@ namespace LCompilers {
                 void fill_malloc_array_details(
                     llvm::Value* arr, llvm::Type *arr_type, llvm::Type* llvm_data_type, int n_dims,
                     std::vector<std::pair<llvm::Value*, llvm::Value*>>& llvm_dims,
-                    llvm::Module* module, bool realloc=false);
+                    llvm::Module* module, bool realloc=false, int64_t stack_size=0);
 
                 virtual
                 void fill_dimension_descriptor(llvm::Value* arr, int n_dims);
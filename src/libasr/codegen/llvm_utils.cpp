@@ -19,12 +19,13 @@ namespace LCompilers {
             if (!fn) {
                 llvm::FunctionType *function_type = llvm::FunctionType::get(
                         llvm::Type::getInt8Ty(context)->getPointerTo(), {
-                            llvm::Type::getInt32Ty(context)
+                            llvm::Type::getInt64Ty(context)
                         }, false);
                 fn = llvm::Function::Create(function_type,
                         llvm::Function::ExternalLinkage, func_name, module);
             }
-            std::vector<llvm::Value*> args = {arg_size};
+            std::vector<llvm::Value*> args = {
+                builder.CreateSExtOrTrunc(arg_size, llvm::Type::getInt64Ty(context))};
             return builder.CreateCall(fn, args);
         }
 
@@ -35,13 +36,15 @@ namespace LCompilers {
             if (!fn) {
                 llvm::FunctionType *function_type = llvm::FunctionType::get(
                         llvm::Type::getInt8Ty(context)->getPointerTo(), {
-                            llvm::Type::getInt32Ty(context),
-                            llvm::Type::getInt32Ty(context)
+                            llvm::Type::getInt64Ty(context),
+                            llvm::Type::getInt64Ty(context)
                         }, false);
                 fn = llvm::Function::Create(function_type,
                         llvm::Function::ExternalLinkage, func_name, module);
             }
-            std::vector<llvm::Value*> args = {count, type_size};
+            std::vector<llvm::Value*> args = {
+                builder.CreateSExtOrTrunc(count, llvm::Type::getInt64Ty(context)),
+                builder.CreateSExtOrTrunc(type_size, llvm::Type::getInt64Ty(context))};
             return builder.CreateCall(fn, args);
         }
 
@@ -53,14 +56,14 @@ namespace LCompilers {
                 llvm::FunctionType *function_type = llvm::FunctionType::get(
                         llvm::Type::getInt8Ty(context)->getPointerTo(), {
                             llvm::Type::getInt8Ty(context)->getPointerTo(),
-                            llvm::Type::getInt32Ty(context)
+                            llvm::Type::getInt64Ty(context)
                         }, false);
                 fn = llvm::Function::Create(function_type,
                         llvm::Function::ExternalLinkage, func_name, module);
             }
             std::vector<llvm::Value*> args = {
                 builder.CreateBitCast(ptr, llvm::Type::getInt8Ty(context)->getPointerTo()),
-                arg_size
+                builder.CreateSExtOrTrunc(arg_size, llvm::Type::getInt64Ty(context))
             };
             return builder.CreateCall(fn, args);
         }
@@ -1,4 +1,16 @@
 #include <string>
+#include <string_view>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
 
 #include <libasr/config.h>
 #include <libasr/asr_utils.h>
@@ -10,16 +22,69 @@
 namespace LCompilers {
 
 const std::string lfortran_modfile_type_string = "LCompilers Modfile";
+// Version of the layout of the sections below, within one LFortran version
+const uint32_t lfortran_modfile_format = 3;
+
+// How the sections after the header are stored
+enum class ModfileCompression : uint8_t {
+    None = 0,
+    Zlib = 1,
+};
+
+#ifdef WITH_LFORTRAN_BINARY_MODFILES
+typedef BinaryWriter ModfileWriter;
+typedef BinaryReader ModfileReader;
+#else
+typedef TextWriter ModfileWriter;
+typedef TextReader ModfileReader;
+#endif
 
-inline void save_asr(const ASR::TranslationUnit_t &m, std::string& asr_string, LCompilers::LocationManager lm) {
-    #ifdef WITH_LFORTRAN_BINARY_MODFILES
-    BinaryWriter b;
+static std::string compress_sections(const std::string &s) {
+#ifdef HAVE_ZLIB
+    uLongf n = compressBound(s.size());
+    std::string r(n, '\0');
+    // The fastest level, modfiles are written on every compilation
+    int res = compress2((Bytef*)&r[0], &n, (const Bytef*)s.data(), s.size(),
+        Z_BEST_SPEED);
+    if (res != Z_OK) {
+        throw LCompilersException("ZLIB: compressing the modfile failed ("
+            + std::to_string(res) + ")");
+    }
+    r.resize(n);
+    return r;
 #else
-    TextWriter b;
+    (void)s;
+    throw LCompilersException("Compressed modfiles require LFortran to be built with ZLIB");
 #endif
+}
+
+static std::string uncompress_sections(const char *data, size_t size,
+        size_t uncompressed_size) {
+#ifdef HAVE_ZLIB
+    std::string r(uncompressed_size, '\0');
+    uLongf n = uncompressed_size;
+    int res = uncompress((Bytef*)&r[0], &n, (const Bytef*)data, size);
+    if (res != Z_OK || n != uncompressed_size) {
+        throw LCompilersException("LCompilers Modfile is corrupted, the compressed sections cannot be read");
+    }
+    return r;
+#else
+    (void)data; (void)size; (void)uncompressed_size;
+    throw LCompilersException("The modfile is compressed, but LFortran was built without ZLIB");
+#endif
+}
+
+inline void save_asr(const ASR::TranslationUnit_t &m, std::string& asr_string,
+        LCompilers::LocationManager lm, bool split_module, bool compress) {
     // Header
-    b.write_string(lfortran_modfile_type_string);
-    b.write_string(LFORTRAN_VERSION);
+    ModfileWriter header;
+    header.write_string(lfortran_modfile_type_string);
+    header.write_string(LFORTRAN_VERSION);
+    header.write_int32(lfortran_modfile_format);
+
+    // The sections below are written by their own writer, so that they can
+    // be compressed as a whole
+    ModfileWriter b;
 
     // AST section: Original module source code:
     // Currently empty.
@@ -98,10 +163,54 @@ inline void save_asr(const ASR::TranslationUnit_t &m, std::string& asr_string, L
         b.write_int32(i);
     }
 
-    // Full ASR:
-    b.write_string(serialize(m));
+    // Full ASR, without the symbols of the module if they are split out:
+    std::vector<SerializedSymbol> symbols;
+    uint64_t symtab_id = 0;
+    if (split_module) {
+        b.write_string(serialize_module(m, symbols));
+        symtab_id = ASRUtils::extract_module(m)->m_symtab->counter;
+    } else {
+        b.write_string(serialize(m));
+    }
+
+    // Symbol index: the symbols of the module are serialized one by one, so
+    // that `use mod, only: x` only needs to deserialize `x` and the symbols
+    // it refers to. Positions are relative to the symbols section.
+    std::map<std::string, size_t> index;
+    for (size_t i = 0; i < symbols.size(); i++) {
+        index[symbols[i].name] = i;
+    }
+    b.write_int64(symtab_id);
+    b.write_int64(symbols.size());
+    size_t pos = 0;
+    for (auto &s : symbols) {
+        b.write_string(s.name);
+        b.write_int64(pos);
+        pos += s.asr.size();
+        b.write_int64(s.dependencies.size());
+        for (auto &d : s.dependencies) {
+            b.write_int64(index.at(d));
+        }
+    }
 
-    asr_string = b.get_str();
+    // Symbols section:
+    std::string symbols_asr;
+    symbols_asr.reserve(pos);
+    for (auto &s : symbols) {
+        symbols_asr.append(s.asr);
+    }
+    b.write_string(symbols_asr);
+
+    if (compress) {
+        std::string sections = b.get_str();
+        header.write_int8((uint8_t)ModfileCompression::Zlib);
+        header.write_int64(sections.size());
+        header.write_string(compress_sections(sections));
+        asr_string = header.get_str();
+    } else {
+        header.write_int8((uint8_t)ModfileCompression::None);
+        asr_string = header.get_str() + b.get_str();
+    }
 }
 
 // The save_modfile() and load_modfile() must stay consistent. What is saved
@@ -116,7 +225,8 @@ inline void save_asr(const ASR::TranslationUnit_t &m, std::string& asr_string, L
 
     Comments below show some possible future improvements to the mod format.
 */
-std::string save_modfile(const ASR::TranslationUnit_t &m, LCompilers::LocationManager lm) {
+std::string save_modfile(const ASR::TranslationUnit_t &m,
+        LCompilers::LocationManager lm, bool compress) {
     LCOMPILERS_ASSERT(m.m_symtab->get_scope().size()== 1);
     for (auto &a : m.m_symtab->get_scope()) {
         LCOMPILERS_ASSERT(ASR::is_a<ASR::Module_t>(*a.second));
@@ -124,31 +234,26 @@ std::string save_modfile(const ASR::TranslationUnit_t &m, LCompilers::LocationMa
     }
 
     std::string asr_string;
-    save_asr(m, asr_string, lm);
+    save_asr(m, asr_string, lm, true, compress);
     return asr_string;
 }
 
 std::string save_pycfile(const ASR::TranslationUnit_t &m, LCompilers::LocationManager lm) {
     std::string asr_string;
-    save_asr(m, asr_string, lm);
+    save_asr(m, asr_string, lm, false, false);
     return asr_string;
 }
 
-inline void load_serialised_asr(const std::string &s, std::string& asr_binary,
-                                LCompilers::LocationManager &lm) {
-#ifdef WITH_LFORTRAN_BINARY_MODFILES
-    BinaryReader b(s);
-#else
-    TextReader b(s);
-#endif
-    std::string file_type = b.read_string();
-    if (file_type != lfortran_modfile_type_string) {
-        throw LCompilersException("LCompilers Modfile format not recognized");
-    }
-    std::string version = b.read_string();
-    if (version != LFORTRAN_VERSION) {
-        throw LCompilersException("Incompatible format: LFortran Modfile was generated using version '" + version + "', but current LFortran version is '" + LFORTRAN_VERSION + "'");
-    }
+ParsedModfile parse_modfile(const std::string &s) {
+    return parse_modfile(MappedFile::copy(s));
+}
+
+// Parses the sections of a modfile that follow the header, starting at
+// `pos` in `data`
+static ParsedModfile parse_sections(std::shared_ptr<const MappedFile> data,
+        size_t pos) {
+    ModfileReader b(data->data(), data->size());
+    b.set_pos(pos);
     LCompilers::LocationManager serialized_lm;
     int32_t n_files = b.read_int32();
     std::vector<LCompilers::LocationManager::FileLocations> files;
@@ -207,32 +312,410 @@ inline void load_serialised_asr(const std::string &s, std::string& asr_binary,
         serialized_lm.file_ends.push_back(b.read_int32());
     }
 
-    lm.files.push_back(serialized_lm.files[0]);
-    lm.file_ends.push_back(serialized_lm.file_ends[0] + lm.file_ends.back());
+    ParsedModfile m;
+    m.data = data;
+    m.file = serialized_lm.files[0];
+    m.file_end = serialized_lm.file_ends[0];
+    m.asr_pos = b.skip_string(m.asr_size);
+
+    m.symtab_id = b.read_int64();
+    size_t n_symbols = b.read_int64();
+    for (size_t i = 0; i < n_symbols; i++) {
+        ParsedModfile::Symbol s;
+        s.name = b.read_string();
+        s.pos = b.read_int64();
+        size_t n_dependencies = b.read_int64();
+        for (size_t j = 0; j < n_dependencies; j++) {
+            size_t d = b.read_int64();
+            if (d >= n_symbols) {
+                throw LCompilersException("LCompilers Modfile symbol index is corrupted");
+            }
+            s.dependencies.push_back(d);
+        }
+        m.symbol_index[s.name] = i;
+        m.symbols.push_back(s);
+    }
+    size_t symbols_size;
+    size_t symbols_pos = b.skip_string(symbols_size);
+    for (auto &s : m.symbols) {
+        if (s.pos >= symbols_size) {
+            throw LCompilersException("LCompilers Modfile symbol index is corrupted");
+        }
+        s.pos += symbols_pos;
+    }
+    return m;
+}
 
-    asr_binary = b.read_string();
+ParsedModfile parse_modfile(std::shared_ptr<const MappedFile> data) {
+    ModfileReader b(data->data(), data->size());
+    std::string file_type = b.read_string();
+    if (file_type != lfortran_modfile_type_string) {
+        throw LCompilersException("LCompilers Modfile format not recognized");
+    }
+    std::string version = b.read_string();
+    if (version != LFORTRAN_VERSION) {
+        throw LCompilersException("Incompatible format: LFortran Modfile was generated using version '" + version + "', but current LFortran version is '" + LFORTRAN_VERSION + "'");
+    }
+    uint32_t format = b.read_int32();
+    if (format != lfortran_modfile_format) {
+        throw LCompilersException("Incompatible format: LFortran Modfile has the format " + std::to_string(format) + ", but the current format is " + std::to_string(lfortran_modfile_format));
+    }
+    ModfileCompression compression = (ModfileCompression)b.read_int8();
+    switch (compression) {
+        case ModfileCompression::None: {
+            return parse_sections(data, b.get_pos());
+        }
+        case ModfileCompression::Zlib: {
+            size_t uncompressed_size = b.read_int64();
+            size_t n;
+            size_t pos = b.skip_string(n);
+            // The sections are deserialized in place from the uncompressed
+            // copy
+            return parse_sections(MappedFile::copy(uncompress_sections(
+                data->data() + pos, n, uncompressed_size)), 0);
+        }
+        default: {
+            throw LCompilersException("LCompilers Modfile compression "
+                + std::to_string((int)compression) + " not recognized");
+        }
+    }
 }
 
-ASR::TranslationUnit_t* load_modfile(Allocator &al, const std::string &s,
-        bool load_symtab_id, SymbolTable &symtab, LCompilers::LocationManager &lm) {
-    std::string asr_binary;
-    load_serialised_asr(s, asr_binary, lm);
-    // take offset as last second element of file_ends
-    uint32_t offset = lm.file_ends[lm.file_ends.size()-2];
-    ASR::asr_t *asr = deserialize_asr(al, asr_binary, load_symtab_id, symtab, offset);
+inline void load_serialised_asr(const ParsedModfile &m,
+                                LCompilers::LocationManager &lm) {
+    lm.files.push_back(m.file);
+    lm.file_ends.push_back(m.file_end + lm.file_ends.back());
+}
+
+// Deserializes the TranslationUnit of `m` together with the module symbols
+// `symbols` (indices into `m.symbols`)
+static ASR::TranslationUnit_t* deserialize_modfile(Allocator &al,
+        const ParsedModfile &m, const std::vector<size_t> &symbols,
+        bool load_symtab_id, uint32_t offset) {
+    ASR::asr_t *asr = deserialize_asr(al, m.data->data() + m.asr_pos,
+        m.asr_size, load_symtab_id, offset);
     ASR::TranslationUnit_t *tu = ASR::down_cast2<ASR::TranslationUnit_t>(asr);
+    if (m.symbols.empty()) {
+        return tu;
+    }
+
+    std::vector<size_t> positions;
+    for (size_t i : symbols) {
+        positions.push_back(m.symbols[i].pos);
+    }
+    deserialize_symbols(al, m.data->data(), m.data->size(), positions,
+        m.symtab_id, *ASRUtils::extract_module(*tu), load_symtab_id, offset);
+
+#if defined(WITH_LFORTRAN_ASSERT)
+    diag::Diagnostics diagnostics;
+    if (!asr_verify(*tu, false, diagnostics)) {
+        std::cerr << diagnostics.render2();
+        throw LCompilersException("Verify failed");
+    };
+#endif
     return tu;
 }
 
+static std::vector<size_t> all_symbols(const ParsedModfile &m,
+        const std::vector<bool> &loaded) {
+    std::vector<size_t> symbols;
+    for (size_t i = 0; i < m.symbols.size(); i++) {
+        if (!loaded[i]) {
+            symbols.push_back(i);
+        }
+    }
+    return symbols;
+}
+
+// Collects the symbols `names` and the symbols they refer to, except the
+// ones already loaded, in index order. Returns false if a name is not in the
+// symbol index.
+static bool collect_symbols(const ParsedModfile &m,
+        const std::vector<std::string> &names, const std::vector<bool> &loaded,
+        std::vector<size_t> &symbols) {
+    std::vector<bool> needed(m.symbols.size(), false);
+    std::vector<size_t> stack;
+    for (auto &name : names) {
+        auto it = m.symbol_index.find(name);
+        if (it == m.symbol_index.end()) {
+            return false;
+        }
+        stack.push_back(it->second);
+        // An interface overriding the constructor of a derived type is
+        // imported together with the type
+        it = m.symbol_index.find("~" + name);
+        if (it != m.symbol_index.end()) {
+            stack.push_back(it->second);
+        }
+    }
+    while (!stack.empty()) {
+        size_t i = stack.back();
+        stack.pop_back();
+        if (needed[i] || loaded[i]) continue;
+        needed[i] = true;
+        for (size_t d : m.symbols[i].dependencies) {
+            stack.push_back(d);
+        }
+    }
+    for (size_t i = 0; i < m.symbols.size(); i++) {
+        if (needed[i]) {
+            symbols.push_back(i);
+        }
+    }
+    return true;
+}
+
+ASR::TranslationUnit_t* load_modfile(Allocator &al, const ParsedModfile &m,
+        bool load_symtab_id, SymbolTable &/*symtab*/, LCompilers::LocationManager &lm) {
+    load_serialised_asr(m, lm);
+    // take offset as last second element of file_ends
+    uint32_t offset = lm.file_ends[lm.file_ends.size()-2];
+    return deserialize_modfile(al, m,
+        all_symbols(m, std::vector<bool>(m.symbols.size(), false)),
+        load_symtab_id, offset);
+}
+
+ASR::TranslationUnit_t* load_modfile(Allocator &al, const std::string &s,
+        bool load_symtab_id, SymbolTable &symtab, LCompilers::LocationManager &lm) {
+    return load_modfile(al, parse_modfile(s), load_symtab_id, symtab, lm);
+}
+
 ASR::TranslationUnit_t* load_pycfile(Allocator &al, const std::string &s,
         bool load_symtab_id, LCompilers::LocationManager &lm) {
-    std::string asr_binary;
-    load_serialised_asr(s, asr_binary, lm);
+    ParsedModfile m = parse_modfile(s);
+    load_serialised_asr(m, lm);
     uint32_t offset = 0;
-    ASR::asr_t *asr = deserialize_asr(al, asr_binary, load_symtab_id, offset);
+    return deserialize_modfile(al, m,
+        all_symbols(m, std::vector<bool>(m.symbols.size(), false)),
+        load_symtab_id, offset);
+}
 
-    ASR::TranslationUnit_t *tu = ASR::down_cast2<ASR::TranslationUnit_t>(asr);
+// The modules loaded by load_modfile_lazily() that still have symbols to
+// deserialize, by the counter of their symbol table
+struct LazyModule {
+    std::shared_ptr<const ParsedModfile> modfile;
+    std::vector<bool> loaded;
+    uint32_t offset;
+};
+static std::mutex lazy_modules_mutex;
+static std::unordered_map<unsigned int, LazyModule> lazy_modules;
+
+ASR::TranslationUnit_t* load_modfile_lazily(Allocator &al,
+        const std::shared_ptr<const ParsedModfile> &modfile,
+        const std::vector<std::string> &names, SymbolTable &symtab,
+        LCompilers::LocationManager &lm) {
+    const ParsedModfile &m = *modfile;
+    std::vector<bool> loaded(m.symbols.size(), false);
+    std::vector<size_t> symbols;
+    if (m.symbols.empty() || !collect_symbols(m, names, loaded, symbols)) {
+        return load_modfile(al, m, false, symtab, lm);
+    }
+    load_serialised_asr(m, lm);
+    uint32_t offset = lm.file_ends[lm.file_ends.size()-2];
+    ASR::TranslationUnit_t *tu;
+    try {
+        tu = deserialize_modfile(al, m, symbols, false, offset);
+    } catch (const LCompilersException &) {
+        // The symbols refer to a symbol that is missing in the index
+        return deserialize_modfile(al, m, all_symbols(m, loaded), false, offset);
+    }
+    if (symbols.size() < m.symbols.size()) {
+        for (size_t i : symbols) {
+            loaded[i] = true;
+        }
+        // Symbol table counters are unique within the process, since the
+        // ids saved in the modfile are not loaded
+        std::lock_guard<std::mutex> lock(lazy_modules_mutex);
+        lazy_modules[ASRUtils::extract_module(*tu)->m_symtab->counter]
+            = {modfile, loaded, offset};
+    }
     return tu;
 }
 
+bool is_lazily_loaded(const ASR::Module_t &m) {
+    std::lock_guard<std::mutex> lock(lazy_modules_mutex);
+    return lazy_modules.find(m.m_symtab->counter) != lazy_modules.end();
+}
+
+bool load_lazy_symbols(Allocator &al, ASR::Module_t &mod,
+        const std::vector<std::string> *names) {
+    LazyModule lazy;
+    {
+        std::lock_guard<std::mutex> lock(lazy_modules_mutex);
+        auto it = lazy_modules.find(mod.m_symtab->counter);
+        if (it == lazy_modules.end()) {
+            return false;
+        }
+        lazy = it->second;
+    }
+    const ParsedModfile &m = *lazy.modfile;
+    std::vector<size_t> symbols;
+    if (names == nullptr || !collect_symbols(m, *names, lazy.loaded, symbols)) {
+        symbols = all_symbols(m, lazy.loaded);
+    }
+    if (symbols.empty()) {
+        return false;
+    }
+    std::vector<size_t> positions;
+    for (size_t i : symbols) {
+        positions.push_back(m.symbols[i].pos);
+    }
+    try {
+        deserialize_symbols(al, m.data->data(), m.data->size(), positions,
+            m.symtab_id, mod, false, lazy.offset);
+    } catch (const LCompilersException &) {
+        // The symbols refer to a symbol that is missing in the index. The
+        // symbols deserialized so far are filled in again in place.
+        symbols = all_symbols(m, lazy.loaded);
+        positions.clear();
+        for (size_t i : symbols) {
+            positions.push_back(m.symbols[i].pos);
+        }
+        deserialize_symbols(al, m.data->data(), m.data->size(), positions,
+            m.symtab_id, mod, false, lazy.offset);
+    }
+    for (size_t i : symbols) {
+        lazy.loaded[i] = true;
+    }
+
+    std::lock_guard<std::mutex> lock(lazy_modules_mutex);
+    if (all_symbols(m, lazy.loaded).empty()) {
+        lazy_modules.erase(mod.m_symtab->counter);
+    } else {
+        lazy_modules[mod.m_symtab->counter].loaded = lazy.loaded;
+    }
+    return true;
+}
+
+std::shared_ptr<const MappedFile> MappedFile::map(const std::string &path) {
+    std::shared_ptr<MappedFile> f(new MappedFile());
+#ifdef _WIN32
+    if (!read_file(path, f->buffer)) return nullptr;
+    f->p = f->buffer.data();
+    f->n = f->buffer.size();
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return nullptr;
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        return nullptr;
+    }
+    f->n = st.st_size;
+    if (f->n > 0) {
+        void *p = mmap(nullptr, f->n, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            close(fd);
+            return nullptr;
+        }
+        f->p = (const char*)p;
+        f->mapped = true;
+    }
+    close(fd);
+#endif
+    return f;
+}
+
+std::shared_ptr<const MappedFile> MappedFile::copy(const std::string &s) {
+    std::shared_ptr<MappedFile> f(new MappedFile());
+    f->buffer = s;
+    f->p = f->buffer.data();
+    f->n = f->buffer.size();
+    return f;
+}
+
+MappedFile::~MappedFile() {
+#ifndef _WIN32
+    if (mapped) {
+        munmap((void*)p, n);
+    }
+#endif
+}
+
+ModfileCache& ModfileCache::get_instance() {
+    static ModfileCache cache;
+    return cache;
+}
+
+bool ModfileCache::contains(const std::filesystem::path &dir,
+        const std::string &filename) {
+    // An empty directory means the current one, as in `dir / filename`
+    std::filesystem::path d = dir.empty() ? std::filesystem::path(".") : dir;
+    std::error_code ec;
+    std::filesystem::file_time_type mtime
+        = std::filesystem::last_write_time(d, ec);
+    if (ec) return false;
+    Listing &listing = listings[d.string()];
+    if (listing.filenames.empty() || listing.mtime != mtime) {
+        // Adding or removing a file updates the directory mtime
+        listing.mtime = mtime;
+        listing.filenames.clear();
+        for (auto &f : std::filesystem::directory_iterator(d, ec)) {
+            listing.filenames.insert(f.path().filename().string());
+        }
+    }
+    return listing.filenames.find(filename) != listing.filenames.end();
+}
+
+std::shared_ptr<const ParsedModfile> ModfileCache::find(
+        const std::vector<std::filesystem::path> &dirs,
+        const std::string &filename) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &dir : dirs) {
+        if (!contains(dir, filename)) continue;
+        std::filesystem::path path = dir / filename;
+        std::error_code ec;
+        std::filesystem::file_time_type mtime
+            = std::filesystem::last_write_time(path, ec);
+        if (ec) continue;
+        std::uintmax_t size = std::filesystem::file_size(path, ec);
+        if (ec) continue;
+        stats.lookups++;
+
+        auto entry = entries.find(path.string());
+        if (entry != entries.end() && entry->second.mtime == mtime
+                && entry->second.size == size) {
+            Content &content = contents.at(entry->second.hash);
+            stats.hits++;
+            stats.time_saved_us += content.load_time_us;
+            return content.parsed;
+        }
+
+        auto t1 = std::chrono::high_resolution_clock::now();
+        std::shared_ptr<const MappedFile> modfile = MappedFile::map(path.string());
+        if (!modfile) continue;
+        std::size_t hash = std::hash<std::string_view>{}(
+            std::string_view(modfile->data(), modfile->size()));
+        auto content = contents.find(hash);
+        if (content != contents.end()) {
+            // Same content under a new path or with a new mtime
+            entries[path.string()] = {mtime, size, hash};
+            stats.hits++;
+            stats.time_saved_us += content->second.load_time_us;
+            return content->second.parsed;
+        }
+        std::shared_ptr<const ParsedModfile> parsed
+            = std::make_shared<const ParsedModfile>(parse_modfile(modfile));
+        auto t2 = std::chrono::high_resolution_clock::now();
+        contents[hash] = {parsed, (uint64_t)std::chrono::duration_cast<
+            std::chrono::microseconds>(t2 - t1).count()};
+        entries[path.string()] = {mtime, size, hash};
+        return parsed;
+    }
+    return nullptr;
+}
+
+ModfileCache::Stats ModfileCache::get_stats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
+
+void ModfileCache::clear() {
+    std::lock_guard<std::mutex> lock(mutex);
+    listings.clear();
+    entries.clear();
+    contents.clear();
+    stats = Stats();
+}
+
 } // namespace LCompilers
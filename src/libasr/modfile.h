@@ -1,12 +1,78 @@
 #ifndef LFORTRAN_MODFILE_H
 #define LFORTRAN_MODFILE_H
 
+#include <chrono>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include <libasr/asr.h>
 
 namespace LCompilers {
 
-    // Save a module to a modfile
-    std::string save_modfile(const ASR::TranslationUnit_t &m, LCompilers::LocationManager lm);
+    // The contents of a file, memory mapped where it is supported
+    class MappedFile {
+    public:
+        // Returns nullptr if the file cannot be read
+        static std::shared_ptr<const MappedFile> map(const std::string &path);
+        // Wraps a copy of `s`
+        static std::shared_ptr<const MappedFile> copy(const std::string &s);
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile& operator=(const MappedFile &) = delete;
+        ~MappedFile();
+
+        const char* data() const {
+            return p;
+        }
+
+        size_t size() const {
+            return n;
+        }
+
+    private:
+        MappedFile() = default;
+
+        const char *p = nullptr;
+        size_t n = 0;
+        bool mapped = false;
+        std::string buffer;
+    };
+
+    // A modfile split into its sections. The serialized ASR is not copied,
+    // it is deserialized in place from `data`.
+    struct ParsedModfile {
+        // A symbol of the module, serialized on its own
+        struct Symbol {
+            std::string name;
+            // Position in `data`
+            size_t pos;
+            // The symbols of the module it refers to, as indices into
+            // `symbols`
+            std::vector<size_t> dependencies;
+        };
+
+        std::shared_ptr<const MappedFile> data;
+        LocationManager::FileLocations file;
+        uint32_t file_end;
+        // The serialized TranslationUnit. If `symbols` is not empty, its
+        // module is serialized with an empty symbol table.
+        size_t asr_pos;
+        size_t asr_size;
+        // The symbol index: the id of the symbol table of the module and its
+        // symbols, in the order they must be deserialized in
+        uint64_t symtab_id = 0;
+        std::vector<Symbol> symbols;
+        std::unordered_map<std::string, size_t> symbol_index;
+    };
+
+    // Save a module to a modfile. If `compress` is true, the sections after
+    // the header are compressed (requires ZLIB).
+    std::string save_modfile(const ASR::TranslationUnit_t &m,
+        LCompilers::LocationManager lm, bool compress=false);
 
     std::string save_pycfile(const ASR::TranslationUnit_t &m, LCompilers::LocationManager lm);
 
@@ -14,9 +80,94 @@ namespace LCompilers {
     ASR::TranslationUnit_t* load_modfile(Allocator &al, const std::string &s,
         bool load_symtab_id, SymbolTable &symtab, LCompilers::LocationManager &lm);
 
+    // Split a modfile into its sections, checking the header
+    ParsedModfile parse_modfile(const std::string &s);
+    ParsedModfile parse_modfile(std::shared_ptr<const MappedFile> data);
+
+    // Load a module from an already parsed modfile
+    ASR::TranslationUnit_t* load_modfile(Allocator &al, const ParsedModfile &m,
+        bool load_symtab_id, SymbolTable &symtab, LCompilers::LocationManager &lm);
+
+    // Load a module from an already parsed modfile, but only deserialize the
+    // symbols `names` and the symbols they refer to. The other symbols are
+    // deserialized later by load_lazy_symbols(). Loads all symbols if a name
+    // is not in the symbol index.
+    ASR::TranslationUnit_t* load_modfile_lazily(Allocator &al,
+        const std::shared_ptr<const ParsedModfile> &m,
+        const std::vector<std::string> &names, SymbolTable &symtab,
+        LCompilers::LocationManager &lm);
+
+    // Returns true if some symbols of `m` were not deserialized yet
+    bool is_lazily_loaded(const ASR::Module_t &m);
+
+    // Deserializes the symbols `names` of a module loaded by
+    // load_modfile_lazily() and the symbols they refer to, or all remaining
+    // symbols if `names` is nullptr. Returns true if any symbol was loaded.
+    bool load_lazy_symbols(Allocator &al, ASR::Module_t &m,
+        const std::vector<std::string> *names);
+
     ASR::TranslationUnit_t* load_pycfile(Allocator &al, const std::string &s,
         bool load_symtab_id, LCompilers::LocationManager &lm);
 
+    /*
+       ModfileCache is a process wide cache of parsed modfiles, shared by all
+       compilations in the process (all `use` statements of one compilation
+       unit, several compilation units, or the language server).
+
+       Files are looked up through a cached listing of each search directory,
+       which is refreshed when the modification time of the directory
+       changes. A cached file is reused without reading it as long as its
+       (mtime, size) is unchanged. Otherwise it is mapped again, and its parsed
+       sections are still reused if its content hash is unchanged. The ASR
+       itself is deserialized into the Allocator of each compilation, since
+       compilations modify the modules they load.
+    */
+    class ModfileCache {
+    public:
+        struct Stats {
+            uint64_t lookups = 0;
+            uint64_t hits = 0;
+            // Time spent reading and parsing the modfiles that were loaded
+            // from the cache instead
+            uint64_t time_saved_us = 0;
+        };
+
+        static ModfileCache& get_instance();
+
+        // Returns the parsed modfile `filename` from the first directory of
+        // `dirs` that contains it, or nullptr if none does.
+        std::shared_ptr<const ParsedModfile> find(
+            const std::vector<std::filesystem::path> &dirs,
+            const std::string &filename);
+
+        Stats get_stats();
+        void clear();
+
+    private:
+        struct Listing {
+            std::filesystem::file_time_type mtime;
+            std::unordered_set<std::string> filenames;
+        };
+        struct Entry {
+            std::filesystem::file_time_type mtime;
+            std::uintmax_t size;
+            std::size_t hash;
+        };
+        struct Content {
+            std::shared_ptr<const ParsedModfile> parsed;
+            uint64_t load_time_us;
+        };
+
+        std::mutex mutex;
+        std::unordered_map<std::string, Listing> listings;
+        std::unordered_map<std::string, Entry> entries;
+        std::unordered_map<std::size_t, Content> contents;
+        Stats stats;
+
+        bool contains(const std::filesystem::path &dir,
+            const std::string &filename);
+    };
+
 } // namespace LCompilers
 
 #endif // LFORTRAN_MODFILE_H
@@ -54,11 +54,24 @@ public:
         for (int i = 0; i < static_cast<int>(x.n_body); i++) {
             body.push_back(al,x.m_body[i]);
         }
-        for (int i = static_cast<int>(x.n_head) - 1; i > 0; i--) {
+        int outer = static_cast<int>(x.n_head) - 1;
+        if (x.m_simd) {
+            // Only the innermost loop is vectorized, so it is lowered here
+            // (lowering it in the next sweep would drop the flag)
+            ASR::asr_t* do_loop = ASR::make_DoLoop_t(al, x.base.base.loc, s2c(al, ""), x.m_head[outer], body.p, body.n, nullptr, 0);
+            body = PassUtils::replace_doloop(al, (const ASR::DoLoop_t&)(*do_loop), -1,
+                use_loop_variable_after_loop, true);
+            outer--;
+        }
+        for (int i = outer; i > 0; i--) {
             ASR::asr_t* do_loop = ASR::make_DoLoop_t(al, x.base.base.loc, s2c(al, ""), x.m_head[i], body.p, body.n, nullptr, 0);
             body={};body.reserve(al,1);
             body.push_back(al,ASRUtils::STMT(do_loop));
         }
+        if (outer < 0) {
+            pass_result = body;
+            return;
+        }
         ASR::asr_t* do_loop = ASR::make_DoLoop_t(al, x.base.base.loc, s2c(al, ""), x.m_head[0], body.p, body.n, nullptr, 0);
         const ASR::DoLoop_t &do_loop_ref = (const ASR::DoLoop_t&)(*do_loop);
         pass_result = PassUtils::replace_doloop(al, do_loop_ref, -1, use_loop_variable_after_loop);
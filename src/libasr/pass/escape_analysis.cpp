@@ -0,0 +1,255 @@
+#include <libasr/asr.h>
+#include <libasr/containers.h>
+#include <libasr/exception.h>
+#include <libasr/asr_utils.h>
+#include <libasr/pass/escape_analysis.h>
+#include <libasr/pass/intrinsic_functions.h>
+
+#include <map>
+#include <set>
+
+namespace LCompilers {
+
+using ASR::down_cast;
+using ASR::is_a;
+
+/*
+ * Walks the body of a procedure and records the variables whose data may
+ * outlive it, together with the targets of pointer associations so that
+ * the escape of a pointer can be propagated to what it points to.
+ */
+class EscapeVisitor : public ASR::BaseWalkVisitor<EscapeVisitor>
+{
+public:
+
+    std::set<SymbolTable*> scopes;
+    std::set<ASR::symbol_t*> escaping;
+    std::map<ASR::symbol_t*, std::set<ASR::symbol_t*>> pointees;
+    // Set while visiting an expression that may capture the address of
+    // every variable it mentions (c_loc, move_alloc, constructors)
+    bool escape_all_vars;
+
+    EscapeVisitor(): escape_all_vars(false) {}
+
+    static ASR::symbol_t* get_base_symbol(ASR::expr_t* x) {
+        while( true ) {
+            if( is_a<ASR::ArrayPhysicalCast_t>(*x) ) {
+                x = down_cast<ASR::ArrayPhysicalCast_t>(x)->m_arg;
+            } else if( is_a<ASR::ArrayItem_t>(*x) ) {
+                x = down_cast<ASR::ArrayItem_t>(x)->m_v;
+            } else if( is_a<ASR::ArraySection_t>(*x) ) {
+                x = down_cast<ASR::ArraySection_t>(x)->m_v;
+            } else if( is_a<ASR::StructInstanceMember_t>(*x) ) {
+                x = down_cast<ASR::StructInstanceMember_t>(x)->m_v;
+            } else {
+                break;
+            }
+        }
+        if( !is_a<ASR::Var_t>(*x) ) {
+            return nullptr;
+        }
+        return ASRUtils::symbol_get_past_external(down_cast<ASR::Var_t>(x)->m_v);
+    }
+
+    bool is_local(ASR::symbol_t* sym) {
+        if( !is_a<ASR::Variable_t>(*sym) ) {
+            return false;
+        }
+        ASR::Variable_t* v = down_cast<ASR::Variable_t>(sym);
+        return v->m_intent == ASR::intentType::Local &&
+            v->m_storage == ASR::storage_typeType::Default &&
+            scopes.find(v->m_parent_symtab) != scopes.end();
+    }
+
+    // Whether the callee can keep the whole array passed as argument `i`
+    // (allocatable dummies can be moved from, pointer dummies associated)
+    bool is_safe_actual_argument(ASR::symbol_t* callee, ASR::expr_t* dt, size_t i) {
+        if( dt != nullptr ) {
+            // The passed object shifts the arguments, stay conservative
+            return false;
+        }
+        ASR::symbol_t* f = ASRUtils::symbol_get_past_external(callee);
+        if( f != nullptr && is_a<ASR::Function_t>(*f) ) {
+            ASR::Function_t* func = down_cast<ASR::Function_t>(f);
+            if( i >= func->n_args || !is_a<ASR::Var_t>(*func->m_args[i]) ) {
+                return false;
+            }
+            ASR::symbol_t* dummy = ASRUtils::symbol_get_past_external(
+                down_cast<ASR::Var_t>(func->m_args[i])->m_v);
+            if( !is_a<ASR::Variable_t>(*dummy) ) {
+                return false;
+            }
+            ASR::Variable_t* dummy_var = down_cast<ASR::Variable_t>(dummy);
+            if( ASRUtils::is_pointer(dummy_var->m_type) ) {
+                return false;
+            }
+            return !ASRUtils::is_allocatable(dummy_var->m_type) ||
+                dummy_var->m_intent == ASR::intentType::In;
+        }
+        if( f != nullptr && is_a<ASR::Variable_t>(*f) &&
+                is_a<ASR::FunctionType_t>(*down_cast<ASR::Variable_t>(f)->m_type) ) {
+            ASR::FunctionType_t* func_type = down_cast<ASR::FunctionType_t>(
+                down_cast<ASR::Variable_t>(f)->m_type);
+            if( i >= func_type->n_arg_types ) {
+                return false;
+            }
+            return !ASRUtils::is_pointer(func_type->m_arg_types[i]) &&
+                !ASRUtils::is_allocatable(func_type->m_arg_types[i]);
+        }
+        return false;
+    }
+
+    template <typename T>
+    void visit_call_args(const T& x) {
+        for( size_t i = 0; i < x.n_args; i++ ) {
+            ASR::expr_t* arg = x.m_args[i].m_value;
+            if( arg == nullptr ) {
+                continue;
+            }
+            while( is_a<ASR::ArrayPhysicalCast_t>(*arg) ) {
+                arg = down_cast<ASR::ArrayPhysicalCast_t>(arg)->m_arg;
+            }
+            // Only whole arrays can be passed to allocatable or pointer
+            // dummy arguments
+            if( !is_a<ASR::Var_t>(*arg) ) {
+                continue;
+            }
+            if( !is_safe_actual_argument(x.m_name, x.m_dt, i) ) {
+                escaping.insert(ASRUtils::symbol_get_past_external(
+                    down_cast<ASR::Var_t>(arg)->m_v));
+            }
+        }
+    }
+
+    void visit_SubroutineCall(const ASR::SubroutineCall_t& x) {
+        visit_call_args(x);
+        ASR::BaseWalkVisitor<EscapeVisitor>::visit_SubroutineCall(x);
+    }
+
+    void visit_FunctionCall(const ASR::FunctionCall_t& x) {
+        visit_call_args(x);
+        ASR::BaseWalkVisitor<EscapeVisitor>::visit_FunctionCall(x);
+    }
+
+    void visit_Associate(const ASR::Associate_t& x) {
+        ASR::symbol_t* value = get_base_symbol(x.m_value);
+        if( value != nullptr ) {
+            if( is_a<ASR::Var_t>(*x.m_target) ) {
+                pointees[ASRUtils::symbol_get_past_external(
+                    down_cast<ASR::Var_t>(x.m_target)->m_v)].insert(value);
+            } else {
+                escaping.insert(value);
+            }
+        }
+        ASR::BaseWalkVisitor<EscapeVisitor>::visit_Associate(x);
+    }
+
+    void visit_BlockCall(const ASR::BlockCall_t& x) {
+        ASR::Block_t* block = down_cast<ASR::Block_t>(x.m_m);
+        scopes.insert(block->m_symtab);
+        visit_Block(*block);
+    }
+
+    void visit_Var(const ASR::Var_t& x) {
+        if( escape_all_vars ) {
+            escaping.insert(ASRUtils::symbol_get_past_external(x.m_v));
+        }
+    }
+
+    #define visit_capturing(Node) void visit_##Node(const ASR::Node##_t& x) { \
+            bool escape_all_vars_copy = escape_all_vars; \
+            escape_all_vars = true; \
+            ASR::BaseWalkVisitor<EscapeVisitor>::visit_##Node(x); \
+            escape_all_vars = escape_all_vars_copy; \
+        }
+
+    visit_capturing(GetPointer)
+    visit_capturing(PointerToCPtr)
+    visit_capturing(StructConstructor)
+    visit_capturing(ListConstant)
+    visit_capturing(ListAppend)
+    visit_capturing(ListInsert)
+    visit_capturing(TupleConstant)
+    visit_capturing(DictConstant)
+    visit_capturing(DictInsert)
+    visit_capturing(SetConstant)
+    visit_capturing(SetInsert)
+
+    #undef visit_capturing
+
+    void visit_IntrinsicElementalFunction(const ASR::IntrinsicElementalFunction_t& x) {
+        if( x.m_intrinsic_id == static_cast<int64_t>(
+                ASRUtils::IntrinsicElementalFunctions::MoveAlloc) ) {
+            bool escape_all_vars_copy = escape_all_vars;
+            escape_all_vars = true;
+            ASR::BaseWalkVisitor<EscapeVisitor>::visit_IntrinsicElementalFunction(x);
+            escape_all_vars = escape_all_vars_copy;
+            return ;
+        }
+        ASR::BaseWalkVisitor<EscapeVisitor>::visit_IntrinsicElementalFunction(x);
+    }
+
+    // A pointer that is not a local variable, or that escapes itself,
+    // lets everything it was associated with escape
+    void propagate() {
+        bool changed = true;
+        while( changed ) {
+            changed = false;
+            for( auto& item: pointees ) {
+                if( is_local(item.first) &&
+                    escaping.find(item.first) == escaping.end() ) {
+                    continue;
+                }
+                for( ASR::symbol_t* pointee: item.second ) {
+                    changed = escaping.insert(pointee).second || changed;
+                }
+            }
+        }
+    }
+
+};
+
+static bool is_stack_promotable_type(ASR::ttype_t* type) {
+    if( !ASRUtils::is_allocatable(type) || !ASRUtils::is_array(type) ||
+        ASRUtils::extract_physical_type(type) != ASR::array_physical_typeType::DescriptorArray ) {
+        return false;
+    }
+    ASR::ttype_t* element_type = ASRUtils::extract_type(type);
+    return is_a<ASR::Integer_t>(*element_type) ||
+        is_a<ASR::Real_t>(*element_type) ||
+        is_a<ASR::Complex_t>(*element_type) ||
+        is_a<ASR::Logical_t>(*element_type);
+}
+
+void find_non_escaping_arrays(ASR::symbol_t* x,
+        std::set<ASR::symbol_t*>& non_escaping) {
+    EscapeVisitor v;
+    if( is_a<ASR::Function_t>(*x) ) {
+        ASR::Function_t* func = down_cast<ASR::Function_t>(x);
+        v.scopes.insert(func->m_symtab);
+        for( size_t i = 0; i < func->n_body; i++ ) {
+            v.visit_stmt(*func->m_body[i]);
+        }
+    } else if( is_a<ASR::Program_t>(*x) ) {
+        ASR::Program_t* prog = down_cast<ASR::Program_t>(x);
+        v.scopes.insert(prog->m_symtab);
+        for( size_t i = 0; i < prog->n_body; i++ ) {
+            v.visit_stmt(*prog->m_body[i]);
+        }
+    } else {
+        return ;
+    }
+    v.propagate();
+    for( SymbolTable* scope: v.scopes ) {
+        for( auto& item: scope->get_scope() ) {
+            if( v.is_local(item.second) &&
+                is_stack_promotable_type(
+                    down_cast<ASR::Variable_t>(item.second)->m_type) &&
+                v.escaping.find(item.second) == v.escaping.end() ) {
+                non_escaping.insert(item.second);
+            }
+        }
+    }
+}
+
+} // namespace LCompilers
@@ -0,0 +1,26 @@
+#ifndef LIBASR_PASS_ESCAPE_ANALYSIS_H
+#define LIBASR_PASS_ESCAPE_ANALYSIS_H
+
+#include <libasr/asr.h>
+
+#include <set>
+
+namespace LCompilers {
+
+    /*
+    * Collects the local allocatable arrays of `x` (a Function or a Program,
+    * including the variables of its BLOCK constructs) whose data provably
+    * does not outlive the procedure: they are neither saved nor returned,
+    * never passed to allocatable (unless intent(in)) or pointer dummy
+    * arguments, never moved with move_alloc, their address is never taken
+    * with c_loc and they are only pointer associated with local pointers
+    * that do not escape either.
+    *
+    * The backends use it to place the data of such arrays on the stack.
+    */
+    void find_non_escaping_arrays(ASR::symbol_t* x,
+        std::set<ASR::symbol_t*>& non_escaping);
+
+} // namespace LCompilers
+
+#endif // LIBASR_PASS_ESCAPE_ANALYSIS_H
@@ -0,0 +1,142 @@
+#include <libasr/asr.h>
+#include <libasr/asr_utils.h>
+#include <libasr/pass/function_local_passes.h>
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace LCompilers {
+
+namespace {
+
+    struct PassTask {
+        ASR::symbol_t *sym;
+        size_t cost;
+    };
+
+    // A rough estimate of the amount of work a pass has to do for `sym`,
+    // only used to schedule the largest procedures first.
+    size_t estimate_cost(ASR::symbol_t *sym) {
+        size_t cost = 1;
+        SymbolTable *symtab = nullptr;
+        if (ASR::is_a<ASR::Function_t>(*sym)) {
+            ASR::Function_t *f = ASR::down_cast<ASR::Function_t>(sym);
+            cost += f->n_body;
+            symtab = f->m_symtab;
+        } else if (ASR::is_a<ASR::Program_t>(*sym)) {
+            ASR::Program_t *p = ASR::down_cast<ASR::Program_t>(sym);
+            cost += p->n_body;
+            symtab = p->m_symtab;
+        }
+        if (symtab) {
+            for (auto &item: symtab->get_scope()) {
+                if (ASR::is_a<ASR::Function_t>(*item.second)) {
+                    cost += estimate_cost(item.second);
+                }
+            }
+        }
+        return cost;
+    }
+
+    // Collects the procedures and programs a function-local pass can be
+    // applied to independently. Returns false if `scope` contains symbols
+    // with statements that would not be visited through these tasks.
+    bool collect_tasks(SymbolTable *scope, std::vector<PassTask> &tasks) {
+        for (auto &item: scope->get_scope()) {
+            ASR::symbol_t *sym = item.second;
+            switch (sym->type) {
+                case ASR::symbolType::Function:
+                case ASR::symbolType::Program: {
+                    tasks.push_back({sym, estimate_cost(sym)});
+                    break;
+                }
+                case ASR::symbolType::Module: {
+                    ASR::Module_t *m = ASR::down_cast<ASR::Module_t>(sym);
+                    if (!collect_tasks(m->m_symtab, tasks)) return false;
+                    break;
+                }
+                case ASR::symbolType::Template:
+                case ASR::symbolType::Requirement:
+                case ASR::symbolType::Block:
+                case ASR::symbolType::AssociateBlock: {
+                    return false;
+                }
+                default: {
+                    // Symbols without statements: variables, types, external
+                    // symbols, generic procedures, ...
+                    break;
+                }
+            }
+        }
+        return true;
+    }
+
+} // namespace
+
+void apply_function_local_pass(Allocator &al, ASR::TranslationUnit_t &unit,
+        pass_function pass, const PassOptions &pass_options,
+        size_t n_threads) {
+    std::vector<PassTask> tasks;
+    if (n_threads <= 1 || unit.n_items > 0
+            || !collect_tasks(unit.m_symtab, tasks) || tasks.size() < 2) {
+        pass(al, unit, pass_options);
+        return;
+    }
+    std::stable_sort(tasks.begin(), tasks.end(),
+        [](const PassTask &a, const PassTask &b) { return a.cost > b.cost; });
+
+    size_t n_workers = std::min(n_threads, tasks.size());
+    std::vector<std::unique_ptr<Allocator>> arenas;
+    for (size_t i = 0; i < n_workers; i++) {
+        arenas.push_back(std::make_unique<Allocator>(1024*1024));
+    }
+    std::atomic<size_t> next_task{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    auto worker = [&](Allocator &arena) {
+        size_t i;
+        while (!failed && (i = next_task++) < tasks.size()) {
+            try {
+                ASR::symbol_t *sym = tasks[i].sym;
+                // The temporary translation unit only owns `sym` through its
+                // own scope; `sym` keeps its real parent scope, so name
+                // resolution inside the procedure is unaffected.
+                SymbolTable *view = arena.make_new<SymbolTable>(nullptr);
+                view->add_symbol(ASRUtils::symbol_name(sym), sym);
+                ASR::TranslationUnit_t *tu = ASR::down_cast2<ASR::TranslationUnit_t>(
+                    ASR::make_TranslationUnit_t(arena, unit.base.base.loc,
+                        view, nullptr, 0));
+                view->asr_owner = (ASR::asr_t*) tu;
+                pass(arena, *tu, pass_options);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error) error = std::current_exception();
+                failed = true;
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < n_workers; i++) {
+        threads.emplace_back(worker, std::ref(*arenas[i]));
+    }
+    worker(*arenas[0]);
+    for (std::thread &t: threads) {
+        t.join();
+    }
+    for (auto &arena: arenas) {
+        al.adopt(*arena);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace LCompilers
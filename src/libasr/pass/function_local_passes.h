@@ -0,0 +1,32 @@
+#ifndef LIBASR_PASS_FUNCTION_LOCAL_PASSES_H
+#define LIBASR_PASS_FUNCTION_LOCAL_PASSES_H
+
+#include <libasr/asr.h>
+#include <libasr/utils.h>
+
+namespace LCompilers {
+
+    typedef void (*pass_function)(Allocator&, ASR::TranslationUnit_t&,
+                                  const LCompilers::PassOptions&);
+
+    /*
+    Applies a function-local `pass` to every procedure and program of `unit`
+    using up to `n_threads` threads.
+
+    A pass is function-local if it only rewrites the statements of the
+    procedure being visited and only adds symbols to that procedure's own
+    (or nested) scopes. Each procedure is then handed to the pass on its own,
+    wrapped in a temporary translation unit, and every thread allocates from
+    its own arena which is handed over to `al` once the pass is done.
+
+    Falls back to applying `pass` to the whole `unit` whenever the
+    translation unit cannot be split (a single thread, top level items,
+    templates, ...).
+    */
+    void apply_function_local_pass(Allocator &al, ASR::TranslationUnit_t &unit,
+        pass_function pass, const PassOptions &pass_options,
+        size_t n_threads);
+
+} // namespace LCompilers
+
+#endif // LIBASR_PASS_FUNCTION_LOCAL_PASSES_H
@@ -0,0 +1,438 @@
+#include <libasr/asr.h>
+#include <libasr/containers.h>
+#include <libasr/exception.h>
+#include <libasr/asr_utils.h>
+#include <libasr/pass/hoist_array_temporaries.h>
+#include <libasr/pass/pass_utils.h>
+
+#include <map>
+#include <set>
+
+namespace LCompilers {
+
+using ASR::down_cast;
+using ASR::is_a;
+
+/*
+ * Collects the variables a loop body may modify and, for each variable,
+ * the number of statements in the body that may change its allocation
+ * status.
+ */
+class LoopSideEffectsVisitor : public ASR::BaseWalkVisitor<LoopSideEffectsVisitor>
+{
+public:
+
+    std::set<ASR::symbol_t*> modified;
+    std::map<ASR::symbol_t*, size_t> allocation_changes;
+    // Set when the body contains a construct this analysis does not model
+    bool unknown;
+    bool collect_all_vars;
+
+    LoopSideEffectsVisitor(): unknown(false), collect_all_vars(false) {}
+
+    static ASR::symbol_t* get_base_symbol(ASR::expr_t* x) {
+        while( true ) {
+            if( is_a<ASR::ArrayPhysicalCast_t>(*x) ) {
+                x = down_cast<ASR::ArrayPhysicalCast_t>(x)->m_arg;
+            } else if( is_a<ASR::ArrayItem_t>(*x) ) {
+                x = down_cast<ASR::ArrayItem_t>(x)->m_v;
+            } else if( is_a<ASR::ArraySection_t>(*x) ) {
+                x = down_cast<ASR::ArraySection_t>(x)->m_v;
+            } else if( is_a<ASR::StructInstanceMember_t>(*x) ) {
+                x = down_cast<ASR::StructInstanceMember_t>(x)->m_v;
+            } else {
+                break;
+            }
+        }
+        if( !is_a<ASR::Var_t>(*x) ) {
+            return nullptr;
+        }
+        return ASRUtils::symbol_get_past_external(down_cast<ASR::Var_t>(x)->m_v);
+    }
+
+    void mark_modified(ASR::expr_t* x, bool may_reallocate) {
+        ASR::symbol_t* sym = get_base_symbol(x);
+        if( sym == nullptr ) {
+            return ;
+        }
+        modified.insert(sym);
+        if( may_reallocate ) {
+            allocation_changes[sym] += 1;
+        }
+    }
+
+    void visit_Var(const ASR::Var_t& x) {
+        if( collect_all_vars ) {
+            ASR::symbol_t* sym = ASRUtils::symbol_get_past_external(x.m_v);
+            modified.insert(sym);
+            allocation_changes[sym] += 1;
+        }
+    }
+
+    void visit_Assignment(const ASR::Assignment_t& x) {
+        // Assigning to a whole allocatable may reallocate it
+        mark_modified(x.m_target, is_a<ASR::Var_t>(*x.m_target) &&
+            ASRUtils::is_allocatable(x.m_target));
+        ASR::BaseWalkVisitor<LoopSideEffectsVisitor>::visit_Assignment(x);
+    }
+
+    void visit_Associate(const ASR::Associate_t& x) {
+        mark_modified(x.m_target, true);
+        ASR::BaseWalkVisitor<LoopSideEffectsVisitor>::visit_Associate(x);
+    }
+
+    void visit_DoLoop(const ASR::DoLoop_t& x) {
+        if( x.m_head.m_v ) {
+            mark_modified(x.m_head.m_v, false);
+        }
+        ASR::BaseWalkVisitor<LoopSideEffectsVisitor>::visit_DoLoop(x);
+    }
+
+    template <typename T>
+    void visit_Allocation(const T& x) {
+        for( size_t i = 0; i < x.n_args; i++ ) {
+            mark_modified(x.m_args[i].m_a, true);
+        }
+    }
+
+    void visit_Allocate(const ASR::Allocate_t& x) {
+        visit_Allocation(x);
+        ASR::BaseWalkVisitor<LoopSideEffectsVisitor>::visit_Allocate(x);
+    }
+
+    void visit_ReAlloc(const ASR::ReAlloc_t& x) {
+        visit_Allocation(x);
+        ASR::BaseWalkVisitor<LoopSideEffectsVisitor>::visit_ReAlloc(x);
+    }
+
+    void visit_ExplicitDeallocate(const ASR::ExplicitDeallocate_t& x) {
+        for( size_t i = 0; i < x.n_vars; i++ ) {
+            mark_modified(x.m_vars[i], true);
+        }
+    }
+
+    void visit_ImplicitDeallocate(const ASR::ImplicitDeallocate_t& x) {
+        for( size_t i = 0; i < x.n_vars; i++ ) {
+            mark_modified(x.m_vars[i], true);
+        }
+    }
+
+    void visit_Nullify(const ASR::Nullify_t& x) {
+        for( size_t i = 0; i < x.n_vars; i++ ) {
+            mark_modified(x.m_vars[i], true);
+        }
+    }
+
+    // Every argument not passed to an `intent(in)` dummy is assumed to be
+    // modified by the call
+    void visit_call_args(ASR::symbol_t* callee, ASR::call_arg_t* args, size_t n_args) {
+        ASR::Function_t* fn = nullptr;
+        callee = ASRUtils::symbol_get_past_external(callee);
+        if( is_a<ASR::Function_t>(*callee) ) {
+            fn = down_cast<ASR::Function_t>(callee);
+        }
+        for( size_t i = 0; i < n_args; i++ ) {
+            if( args[i].m_value == nullptr ) {
+                continue;
+            }
+            if( fn && i < fn->n_args && is_a<ASR::Var_t>(*fn->m_args[i]) ) {
+                ASR::symbol_t* dummy = down_cast<ASR::Var_t>(fn->m_args[i])->m_v;
+                if( is_a<ASR::Variable_t>(*dummy) ) {
+                    ASR::Variable_t* v = down_cast<ASR::Variable_t>(dummy);
+                    if( v->m_intent == ASRUtils::intent_in ) {
+                        continue;
+                    }
+                    mark_modified(args[i].m_value,
+                        ASRUtils::is_allocatable(v->m_type) ||
+                        ASRUtils::is_pointer(v->m_type));
+                    continue;
+                }
+            }
+            mark_modified(args[i].m_value, true);
+        }
+    }
+
+    void visit_SubroutineCall(const ASR::SubroutineCall_t& x) {
+        visit_call_args(x.m_name, x.m_args, x.n_args);
+        if( x.m_dt ) {
+            mark_modified(x.m_dt, true);
+        }
+        ASR::BaseWalkVisitor<LoopSideEffectsVisitor>::visit_SubroutineCall(x);
+    }
+
+    void visit_FunctionCall(const ASR::FunctionCall_t& x) {
+        visit_call_args(x.m_name, x.m_args, x.n_args);
+        if( x.m_dt ) {
+            mark_modified(x.m_dt, true);
+        }
+        ASR::BaseWalkVisitor<LoopSideEffectsVisitor>::visit_FunctionCall(x);
+    }
+
+    void visit_IntrinsicImpureSubroutine(const ASR::IntrinsicImpureSubroutine_t& x) {
+        for( size_t i = 0; i < x.n_args; i++ ) {
+            mark_modified(x.m_args[i], true);
+        }
+        ASR::BaseWalkVisitor<LoopSideEffectsVisitor>::visit_IntrinsicImpureSubroutine(x);
+    }
+
+    // Statements that may write to any of the variables they mention
+    #define collect_all_vars_of(Node) void visit_##Node(const ASR::Node##_t& x) { \
+        bool collect_all_vars_copy = collect_all_vars; \
+        collect_all_vars = true; \
+        ASR::BaseWalkVisitor<LoopSideEffectsVisitor>::visit_##Node(x); \
+        collect_all_vars = collect_all_vars_copy; \
+    } \
+
+    collect_all_vars_of(FileOpen)
+    collect_all_vars_of(FileClose)
+    collect_all_vars_of(FileRead)
+    collect_all_vars_of(FileWrite)
+    collect_all_vars_of(FileInquire)
+    collect_all_vars_of(FileBackspace)
+    collect_all_vars_of(FileRewind)
+    collect_all_vars_of(Flush)
+    collect_all_vars_of(CPtrToPointer)
+    collect_all_vars_of(Assign)
+
+    // Constructs with their own scopes or semantics not modelled here
+    #define mark_unknown(Node) void visit_##Node(const ASR::Node##_t& /*x*/) { \
+        unknown = true; \
+    } \
+
+    mark_unknown(BlockCall)
+    mark_unknown(AssociateBlockCall)
+    mark_unknown(DoConcurrentLoop)
+    mark_unknown(OMPRegion)
+    mark_unknown(ForAllSingle)
+    mark_unknown(ForEach)
+    mark_unknown(Where)
+    mark_unknown(SelectType)
+    mark_unknown(ListAppend)
+    mark_unknown(ListInsert)
+    mark_unknown(ListRemove)
+    mark_unknown(ListClear)
+    mark_unknown(SetInsert)
+    mark_unknown(SetRemove)
+    mark_unknown(SetClear)
+    mark_unknown(DictInsert)
+    mark_unknown(DictClear)
+
+};
+
+/*
+ * Moves the allocation of loop invariant array temporaries out of loops.
+ *
+ * The array passes allocate a temporary right before each use,
+ *
+ *     do while (...)
+ *         deallocate(__libasr_created_tmp)
+ *         allocate(__libasr_created_tmp(n))
+ *         ...
+ *     end do
+ *
+ * When the extents only depend on values the loop cannot change, and the
+ * loop does not otherwise (re)allocate the temporary, the pair is moved in
+ * front of the loop and the allocation is reused by all iterations. Nested
+ * loops are processed inside out, so a temporary is lifted as far as its
+ * extents allow. `size` and bounds of temporaries lifted earlier from the
+ * same loop are invariant too.
+ */
+class HoistArrayTemporariesVisitor : public PassUtils::PassVisitor<HoistArrayTemporariesVisitor>
+{
+public:
+
+    HoistArrayTemporariesVisitor(Allocator &al_) : PassVisitor(al_, nullptr)
+    {
+        pass_result.reserve(al, 1);
+    }
+
+    bool is_invariant(ASR::expr_t* x, LoopSideEffectsVisitor& side_effects,
+        std::set<ASR::symbol_t*>& hoisted) {
+        if( x == nullptr || ASRUtils::expr_value(x) != nullptr ) {
+            return true;
+        }
+        switch( x->type ) {
+            case ASR::exprType::IntegerConstant: {
+                return true;
+            }
+            case ASR::exprType::Var: {
+                ASR::symbol_t* sym = down_cast<ASR::Var_t>(x)->m_v;
+                if( !is_a<ASR::Variable_t>(*sym) ) {
+                    return false;
+                }
+                ASR::Variable_t* v = down_cast<ASR::Variable_t>(sym);
+                return v->m_parent_symtab == current_scope &&
+                    (v->m_intent == ASRUtils::intent_local ||
+                     v->m_intent == ASRUtils::intent_in) &&
+                    v->m_storage != ASR::storage_typeType::Save &&
+                    !v->m_target_attr &&
+                    is_a<ASR::Integer_t>(*v->m_type) &&
+                    side_effects.modified.find(sym) == side_effects.modified.end();
+            }
+            case ASR::exprType::IntegerBinOp: {
+                ASR::IntegerBinOp_t* binop = down_cast<ASR::IntegerBinOp_t>(x);
+                if( binop->m_op == ASR::binopType::Div ) {
+                    // Only divisions that cannot trap when evaluated
+                    // ahead of a loop that might not execute at all
+                    int64_t divisor;
+                    if( !ASRUtils::is_value_constant(
+                            ASRUtils::expr_value(binop->m_right), divisor) ||
+                        divisor == 0 ) {
+                        return false;
+                    }
+                } else if( binop->m_op != ASR::binopType::Add &&
+                           binop->m_op != ASR::binopType::Sub &&
+                           binop->m_op != ASR::binopType::Mul ) {
+                    return false;
+                }
+                return is_invariant(binop->m_left, side_effects, hoisted) &&
+                    is_invariant(binop->m_right, side_effects, hoisted);
+            }
+            case ASR::exprType::IntegerUnaryMinus: {
+                return is_invariant(down_cast<ASR::IntegerUnaryMinus_t>(x)->m_arg,
+                    side_effects, hoisted);
+            }
+            case ASR::exprType::Cast: {
+                ASR::Cast_t* cast = down_cast<ASR::Cast_t>(x);
+                return cast->m_kind == ASR::cast_kindType::IntegerToInteger &&
+                    is_invariant(cast->m_arg, side_effects, hoisted);
+            }
+            case ASR::exprType::ArraySize: {
+                ASR::ArraySize_t* array_size = down_cast<ASR::ArraySize_t>(x);
+                return has_invariant_shape(array_size->m_v, hoisted) &&
+                    is_invariant(array_size->m_dim, side_effects, hoisted);
+            }
+            case ASR::exprType::ArrayBound: {
+                ASR::ArrayBound_t* array_bound = down_cast<ASR::ArrayBound_t>(x);
+                return has_invariant_shape(array_bound->m_v, hoisted) &&
+                    is_invariant(array_bound->m_dim, side_effects, hoisted);
+            }
+            default: {
+                return false;
+            }
+        }
+    }
+
+    // The shape of arrays that are neither allocatable nor pointers is fixed
+    bool has_invariant_shape(ASR::expr_t* x, std::set<ASR::symbol_t*>& hoisted) {
+        x = ASRUtils::get_past_array_physical_cast(x);
+        if( !is_a<ASR::Var_t>(*x) ) {
+            return false;
+        }
+        ASR::symbol_t* sym = ASRUtils::symbol_get_past_external(
+            down_cast<ASR::Var_t>(x)->m_v);
+        if( hoisted.find(sym) != hoisted.end() ) {
+            return true;
+        }
+        return is_a<ASR::Variable_t>(*sym) &&
+            !ASRUtils::is_allocatable(ASRUtils::symbol_type(sym)) &&
+            !ASRUtils::is_pointer(ASRUtils::symbol_type(sym));
+    }
+
+    ASR::symbol_t* get_hoistable_temporary(ASR::stmt_t* dealloc_stmt, ASR::stmt_t* alloc_stmt,
+        LoopSideEffectsVisitor& side_effects, std::set<ASR::symbol_t*>& hoisted) {
+        ASR::expr_t* dealloc_var = nullptr;
+        if( is_a<ASR::ExplicitDeallocate_t>(*dealloc_stmt) ) {
+            ASR::ExplicitDeallocate_t* dealloc = down_cast<ASR::ExplicitDeallocate_t>(dealloc_stmt);
+            if( dealloc->n_vars != 1 ) {
+                return nullptr;
+            }
+            dealloc_var = dealloc->m_vars[0];
+        } else if( is_a<ASR::ImplicitDeallocate_t>(*dealloc_stmt) ) {
+            ASR::ImplicitDeallocate_t* dealloc = down_cast<ASR::ImplicitDeallocate_t>(dealloc_stmt);
+            if( dealloc->n_vars != 1 ) {
+                return nullptr;
+            }
+            dealloc_var = dealloc->m_vars[0];
+        } else {
+            return nullptr;
+        }
+        if( !is_a<ASR::Allocate_t>(*alloc_stmt) ) {
+            return nullptr;
+        }
+        ASR::Allocate_t* alloc = down_cast<ASR::Allocate_t>(alloc_stmt);
+        if( alloc->n_args != 1 || alloc->m_stat || alloc->m_errmsg || alloc->m_source ) {
+            return nullptr;
+        }
+        ASR::alloc_arg_t& alloc_arg = alloc->m_args[0];
+        if( alloc_arg.m_len_expr || alloc_arg.m_type ||
+            !is_a<ASR::Var_t>(*alloc_arg.m_a) || !is_a<ASR::Var_t>(*dealloc_var) ) {
+            return nullptr;
+        }
+        ASR::symbol_t* sym = down_cast<ASR::Var_t>(alloc_arg.m_a)->m_v;
+        if( sym != down_cast<ASR::Var_t>(dealloc_var)->m_v ||
+            !is_a<ASR::Variable_t>(*sym) ) {
+            return nullptr;
+        }
+        ASR::Variable_t* v = down_cast<ASR::Variable_t>(sym);
+        if( v->m_parent_symtab != current_scope ||
+            !startswith(std::string(v->m_name), "__libasr_created") ||
+            !ASRUtils::is_allocatable(v->m_type) ||
+            side_effects.allocation_changes[sym] != 2 ) {
+            return nullptr;
+        }
+        for( size_t i = 0; i < alloc_arg.n_dims; i++ ) {
+            if( !is_invariant(alloc_arg.m_dims[i].m_start, side_effects, hoisted) ||
+                !is_invariant(alloc_arg.m_dims[i].m_length, side_effects, hoisted) ) {
+                return nullptr;
+            }
+        }
+        return sym;
+    }
+
+    void hoist_temporaries(ASR::stmt_t**& m_body, size_t& n_body,
+        LoopSideEffectsVisitor& side_effects) {
+        if( side_effects.unknown ) {
+            return ;
+        }
+        std::set<ASR::symbol_t*> hoisted;
+        Vec<ASR::stmt_t*> body;
+        body.reserve(al, n_body);
+        for( size_t i = 0; i < n_body; i++ ) {
+            ASR::symbol_t* temporary = nullptr;
+            if( i + 1 < n_body ) {
+                temporary = get_hoistable_temporary(m_body[i], m_body[i + 1],
+                    side_effects, hoisted);
+            }
+            if( temporary ) {
+                pass_result.push_back(al, m_body[i]);
+                pass_result.push_back(al, m_body[i + 1]);
+                hoisted.insert(temporary);
+                i++;
+            } else {
+                body.push_back(al, m_body[i]);
+            }
+        }
+        if( pass_result.size() > 0 ) {
+            m_body = body.p;
+            n_body = body.size();
+            retain_original_stmt = true;
+        }
+    }
+
+    void visit_DoLoop(const ASR::DoLoop_t& x) {
+        PassUtils::PassVisitor<HoistArrayTemporariesVisitor>::visit_DoLoop(x);
+        ASR::DoLoop_t& xx = const_cast<ASR::DoLoop_t&>(x);
+        LoopSideEffectsVisitor side_effects;
+        side_effects.visit_DoLoop(x);
+        hoist_temporaries(xx.m_body, xx.n_body, side_effects);
+    }
+
+    void visit_WhileLoop(const ASR::WhileLoop_t& x) {
+        PassUtils::PassVisitor<HoistArrayTemporariesVisitor>::visit_WhileLoop(x);
+        ASR::WhileLoop_t& xx = const_cast<ASR::WhileLoop_t&>(x);
+        LoopSideEffectsVisitor side_effects;
+        side_effects.visit_WhileLoop(x);
+        hoist_temporaries(xx.m_body, xx.n_body, side_effects);
+    }
+
+};
+
+void pass_hoist_array_temporaries(Allocator &al, ASR::TranslationUnit_t &unit,
+                                  const LCompilers::PassOptions& /*pass_options*/) {
+    HoistArrayTemporariesVisitor v(al);
+    v.visit_TranslationUnit(unit);
+}
+
+
+} // namespace LCompilers
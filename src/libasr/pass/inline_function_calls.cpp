@@ -6,6 +6,7 @@
 #include <libasr/pass/inline_function_calls.h>
 #include <libasr/pass/pass_utils.h>
 
+#include <algorithm>
 #include <vector>
 #include <map>
 #include <utility>
@@ -39,6 +40,8 @@ class FixSymbolsVisitor: public ASR::BaseWalkVisitor<FixSymbolsVisitor>
 {
 private:
 
+    Allocator& al;
+
     SymbolTable*& current_routine_scope;
     SymbolTable*& current_scope;
 
@@ -46,45 +49,148 @@ private:
 
     std::map<std::string, ASR::symbol_t*>& arg2value;
 
+    // Names of the symbols added to current_scope while inlining
+    // the current function call
+    std::vector<std::string>& new_symbols;
+
 public:
 
-    FixSymbolsVisitor(SymbolTable*& current_routine_scope_, SymbolTable*& current_scope_,
-        bool& fixed_duplicated_expr_stmt, std::map<std::string, ASR::symbol_t*>& arg2value_):
-        current_routine_scope(current_routine_scope_), current_scope(current_scope_),
-        fixed_duplicated_expr_stmt(fixed_duplicated_expr_stmt), arg2value(arg2value_) {}
-
-    // If anything is not local to a function being inlined
-    // then do not inline the function by setting
-    // fixed_duplicated_expr_stmt to false.
-    // To be supported later.
-    #define replace_symbol(sym, symbol_t, m_v)                                  \
-        std::string sym_name = ASRUtils::symbol_name(sym);                      \
-        if( current_routine_scope &&                                            \
-            current_routine_scope->get_symbol(sym_name) == nullptr ) {          \
-            fixed_duplicated_expr_stmt = false;                                 \
-            return ;                                                            \
-        }                                                                       \
-        if( arg2value.find(sym_name) != arg2value.end() ) {                     \
-            LCOMPILERS_ASSERT(ASR::is_a<symbol_t>(*sym))                        \
-            symbol_t *x_var = ASR::down_cast<symbol_t>(arg2value[sym_name]);    \
-            if( current_scope->get_symbol(std::string(x_var->m_name))) {        \
-                m_v = arg2value[sym_name];                                      \
-            }                                                                   \
+    FixSymbolsVisitor(Allocator& al_, SymbolTable*& current_routine_scope_,
+        SymbolTable*& current_scope_, bool& fixed_duplicated_expr_stmt,
+        std::map<std::string, ASR::symbol_t*>& arg2value_,
+        std::vector<std::string>& new_symbols_):
+        al(al_), current_routine_scope(current_routine_scope_), current_scope(current_scope_),
+        fixed_duplicated_expr_stmt(fixed_duplicated_expr_stmt), arg2value(arg2value_),
+        new_symbols(new_symbols_) {}
+
+    // Returns the symbol through which `sym` is accessible from current_scope,
+    // importing it with an ExternalSymbol if `sym` belongs to a module.
+    // This covers the module procedures and module variables used by the
+    // function being inlined, including the host variables of contained
+    // procedures (moved to a module by the nested_vars pass). Returns
+    // nullptr if `sym` cannot be accessed from current_scope.
+    ASR::symbol_t* import_symbol(ASR::symbol_t* sym) {
+        sym = ASRUtils::symbol_get_past_external(sym);
+        std::string sym_name = ASRUtils::symbol_name(sym);
+        ASR::symbol_t* visible_sym = current_scope->resolve_symbol(sym_name);
+        if( visible_sym && ASRUtils::symbol_get_past_external(visible_sym) == sym ) {
+            return visible_sym;
+        }
+        ASR::symbol_t* owner = ASRUtils::get_asr_owner(sym);
+        if( owner == nullptr || !ASR::is_a<ASR::Module_t>(*owner) ) {
+            return nullptr;
         }
+        std::string new_sym_name = current_scope->get_unique_name(sym_name, false);
+        ASR::symbol_t* new_sym = ASR::down_cast<ASR::symbol_t>(ASR::make_ExternalSymbol_t(
+            al, sym->base.loc, current_scope, s2c(al, new_sym_name), sym,
+            ASR::down_cast<ASR::Module_t>(owner)->m_name, nullptr, 0,
+            s2c(al, sym_name), ASR::accessType::Private));
+        current_scope->add_symbol(new_sym_name, new_sym);
+        new_symbols.push_back(new_sym_name);
+        return new_sym;
+    }
+
+    // Maps a symbol used in the body of the function being inlined
+    // to the one to be used in current_scope. The local variables of the
+    // function are replaced with their copies (see arg2value), everything
+    // else is imported. Sets fixed_duplicated_expr_stmt to false if this
+    // isn't possible.
+    ASR::symbol_t* replace_symbol(ASR::symbol_t* sym) {
+        std::string sym_name = ASRUtils::symbol_name(sym);
+        if( current_routine_scope &&
+            current_routine_scope->get_symbol(sym_name) == sym &&
+            !ASR::is_a<ASR::ExternalSymbol_t>(*sym) ) {
+            if( arg2value.find(sym_name) == arg2value.end() ) {
+                fixed_duplicated_expr_stmt = false;
+                return sym;
+            }
+            return arg2value[sym_name];
+        }
+        ASR::symbol_t* new_sym = import_symbol(sym);
+        if( new_sym == nullptr ) {
+            fixed_duplicated_expr_stmt = false;
+            return sym;
+        }
+        return new_sym;
+    }
 
     void visit_Var(const ASR::Var_t& x) {
         ASR::Var_t& xx = const_cast<ASR::Var_t&>(x);
-        ASR::symbol_t *sym = ASRUtils::symbol_get_past_external(xx.m_v);
-        if (ASR::is_a<ASR::Variable_t>(*sym)) {
-            replace_symbol(sym, ASR::Variable_t, xx.m_v);
-        } else {
+        xx.m_v = replace_symbol(xx.m_v);
+    }
+
+    void visit_BlockCall(const ASR::BlockCall_t& x) {
+        ASR::BlockCall_t& xx = const_cast<ASR::BlockCall_t&>(x);
+        xx.m_m = replace_symbol(xx.m_m);
+    }
+
+    template <typename T>
+    void visit_Call(const T& x) {
+        T& xx = const_cast<T&>(x);
+        if( xx.m_dt ) {
             fixed_duplicated_expr_stmt = false;
+            return ;
+        }
+        xx.m_name = replace_symbol(xx.m_name);
+        if( xx.m_original_name ) {
+            // The generic procedure is only informative, drop it
+            // if it isn't accessible from current_scope
+            bool fixed_duplicated_expr_stmt_copy = fixed_duplicated_expr_stmt;
+            xx.m_original_name = replace_symbol(xx.m_original_name);
+            if( !fixed_duplicated_expr_stmt ) {
+                fixed_duplicated_expr_stmt = fixed_duplicated_expr_stmt_copy;
+                xx.m_original_name = nullptr;
+            }
         }
     }
 
+    void visit_FunctionCall(const ASR::FunctionCall_t& x) {
+        visit_Call(x);
+        ASR::BaseWalkVisitor<FixSymbolsVisitor>::visit_FunctionCall(x);
+    }
+
+    void visit_SubroutineCall(const ASR::SubroutineCall_t& x) {
+        visit_Call(x);
+        ASR::BaseWalkVisitor<FixSymbolsVisitor>::visit_SubroutineCall(x);
+    }
+
+};
+
+/*
+ * Measures the size of a function body as the number of statements and
+ * expressions in it. Also records whether the body has labels (GoTo targets
+ * or labelled blocks left by inlining other calls), which would be
+ * duplicated by inlining it more than once.
+ */
+class FunctionSizeVisitor: public ASR::BaseWalkVisitor<FunctionSizeVisitor>
+{
+public:
+
+    int64_t size;
+    bool has_labels;
+
+    FunctionSizeVisitor(): size(0), has_labels(false) {}
+
+    void visit_stmt(const ASR::stmt_t& x) {
+        size += 1;
+        ASR::BaseWalkVisitor<FunctionSizeVisitor>::visit_stmt(x);
+    }
+
+    void visit_expr(const ASR::expr_t& x) {
+        size += 1;
+        ASR::BaseWalkVisitor<FunctionSizeVisitor>::visit_expr(x);
+    }
+
+    void visit_GoTo(const ASR::GoTo_t& /*x*/) {
+        has_labels = true;
+    }
+
+    void visit_GoToTarget(const ASR::GoToTarget_t& /*x*/) {
+        has_labels = true;
+    }
+
     void visit_BlockCall(const ASR::BlockCall_t& x) {
-        ASR::BlockCall_t& xx = const_cast<ASR::BlockCall_t&>(x);
-        replace_symbol(xx.m_m, ASR::Block_t, xx.m_m);
+        has_labels = has_labels || x.m_label != -1;
     }
 
 };
@@ -110,6 +216,11 @@ private:
 
     bool inline_external_symbol_calls;
 
+    // Number of loops enclosing the call being visited
+    size_t& loop_depth;
+    // Number of ASR nodes added to the current routine by inlining
+    int64_t& routine_growth;
+    std::vector<std::string> new_symbols;
 
     ASRUtils::ExprStmtDuplicator node_duplicator;
 
@@ -125,15 +236,29 @@ public:
     FixSymbolsVisitor fix_symbols_visitor;
     bool function_inlined;
 
+    // Cost model: functions with up to `inline_size_limit` ASR nodes are
+    // inlined, each compile time constant argument raises the limit by
+    // `constant_argument_bonus` and each level of call frequency
+    // (see is_inlining_profitable) doubles it, up to `max_frequency_level`
+    // levels. No more than `max_routine_growth` nodes are inlined in a
+    // single routine.
+    static const int64_t inline_size_limit = 40;
+    static const int64_t constant_argument_bonus = 15;
+    static const size_t max_frequency_level = 3;
+    static const int64_t max_routine_growth = 2000;
+
     InlineFunctionCall(Allocator &al_, const std::string& rl_path_,
         bool inline_external_symbol_calls_, bool is_fast_,
         Vec<ASR::stmt_t*>& pass_result_, bool& from_inline_function_call_,
-        std::string& current_routine_): al(al_), rl_path(rl_path_), function_result_var(nullptr),
+        std::string& current_routine_, size_t& loop_depth_, int64_t& routine_growth_):
+        al(al_), rl_path(rl_path_), function_result_var(nullptr),
         from_inline_function_call(from_inline_function_call_), inlining_function(false), fixed_duplicated_expr_stmt(false),
         is_fast(is_fast_), current_routine(current_routine_), inline_external_symbol_calls(inline_external_symbol_calls_),
+        loop_depth(loop_depth_), routine_growth(routine_growth_),
         node_duplicator(al_), current_routine_scope(nullptr), label_generator(ASRUtils::LabelGenerator::get_instance()),
         empty_block(nullptr), return_replacer(al_, 0), pass_result(pass_result_), current_scope(nullptr),
-        fix_symbols_visitor(current_routine_scope, current_scope, fixed_duplicated_expr_stmt, arg2value),
+        fix_symbols_visitor(al_, current_routine_scope, current_scope, fixed_duplicated_expr_stmt,
+            arg2value, new_symbols),
         function_inlined(false) {}
 
     void configure_node_duplicator(bool allow_procedure_calls_) {
@@ -150,12 +275,52 @@ public:
                                 empty_symtab,
                                 s2c(al, empty_block_name), nullptr, 0));
             scope->add_symbol(empty_block_name, empty_block);
+            new_symbols.push_back(empty_block_name);
         }
-        arg2value[empty_block_name] = empty_block;
+        arg2value["~empty_block"] = empty_block;
     }
 
+    // Removes the empty block if it was created for the current function call,
+    // it may be used by the calls inlined before otherwise.
     void remove_empty_block(SymbolTable* scope) {
-        scope->erase_symbol("~empty_block");
+        if( std::find(new_symbols.begin(), new_symbols.end(), "~empty_block") != new_symbols.end() ) {
+            scope->erase_symbol("~empty_block");
+        }
+    }
+
+    // Decides whether inlining `x` is worth the code growth. Functions
+    // marked for inlining are always inlined, with --fast the size of
+    // `func` is compared against a limit which grows with the number of
+    // compile time constant arguments (they simplify the inlined body) and
+    // with how often the call executes: every loop around it adds a level
+    // of frequency, and so does an elemental callee or the implementation
+    // of an elemental intrinsic (`_lcompilers_*`), which runs once per
+    // array element.
+    bool is_inlining_profitable(ASR::FunctionCall_t* x, ASR::Function_t* func,
+            int64_t func_size) {
+        if( ASRUtils::get_FunctionType(func)->m_inline ) {
+            return true;
+        }
+        if( !is_fast ) {
+            return false;
+        }
+        int64_t size_limit = inline_size_limit;
+        for( size_t i = 0; i < x->n_args; i++ ) {
+            if( x->m_args[i].m_value && ASRUtils::expr_value(x->m_args[i].m_value) ) {
+                size_limit += constant_argument_bonus;
+            }
+        }
+        size_t frequency_level = loop_depth;
+        if( ASRUtils::get_FunctionType(func)->m_elemental ||
+            startswith(std::string(func->m_name), "_lcompilers_") ) {
+            frequency_level += 1;
+        }
+        if( frequency_level > max_frequency_level ) {
+            frequency_level = max_frequency_level;
+        }
+        size_limit <<= frequency_level;
+        return func_size <= size_limit &&
+            routine_growth + func_size <= max_routine_growth;
     }
 
     void replace_FunctionCall(ASR::FunctionCall_t* x) {
@@ -164,43 +329,6 @@ public:
         // then return. To ensure that only one function call is inlined
         // at a time.
         if( !from_inline_function_call || inlining_function ) {
-            if( !inlining_function ) {
-                return ;
-            }
-            // TODO: Handle type later
-            if( ASR::is_a<ASR::ExternalSymbol_t>(*x->m_name) ) {
-                ASR::ExternalSymbol_t* called_sym_ext = ASR::down_cast<ASR::ExternalSymbol_t>(x->m_name);
-                ASR::symbol_t* f_sym = ASRUtils::symbol_get_past_external(called_sym_ext->m_external);
-                ASR::Function_t* f = ASR::down_cast<ASR::Function_t>(f_sym);
-
-                // Never inline intrinsic functions
-                if( ASRUtils::is_intrinsic_function2(f) ) {
-                    return ;
-                }
-
-                ASR::symbol_t* called_sym = x->m_name;
-
-                // TODO: Handle later
-                // ASR::symbol_t* called_sym_original = x.m_original_name;
-
-                std::string called_sym_name = std::string(called_sym_ext->m_name);
-                std::string new_sym_name_str = current_scope->get_unique_name(called_sym_name, false);
-                char* new_sym_name = s2c(al, new_sym_name_str);
-                if( current_scope->get_symbol(new_sym_name_str) == nullptr ) {
-                    ASR::Module_t *m = ASR::down_cast2<ASR::Module_t>(f->m_symtab->parent->asr_owner);
-                    char *modname = m->m_name;
-                    ASR::symbol_t* new_sym = ASR::down_cast<ASR::symbol_t>(ASR::make_ExternalSymbol_t(
-                                                al, called_sym->base.loc, current_scope, new_sym_name,
-                                                f_sym, modname, nullptr, 0,
-                                                f->m_name, ASR::accessType::Private));
-                    current_scope->add_symbol(new_sym_name_str, new_sym);
-                }
-                x->m_name = current_scope->get_symbol(new_sym_name_str);
-            }
-
-            for( size_t i = 0; i < x->n_args; i++ ) {
-                fix_symbols_visitor.visit_expr(*x->m_args[i].m_value);
-            }
             return ;
         }
 
@@ -218,6 +346,7 @@ public:
         // Clear up any local variables present in arg2value map
         // due to inlining other function calls
         arg2value.clear();
+        new_symbols.clear();
 
         // Stores the result temporarily to avoid corrupting
         // the actual pass result due to failure of inlining function
@@ -225,7 +354,8 @@ public:
         Vec<ASR::stmt_t*> pass_result_local;
         pass_result_local.reserve(al, 1);
 
-        // Avoid external symbols for now.
+        // Module procedures (possibly loaded from a .mod file) are called
+        // through external symbols.
         ASR::symbol_t* routine = x->m_name;
         if( !ASR::is_a<ASR::Function_t>(*routine) ) {
             if( ASR::is_a<ASR::ExternalSymbol_t>(*routine) &&
@@ -246,44 +376,74 @@ public:
                 // Never Inline BindC Function
                 ASRUtils::get_FunctionType(func)->m_abi == ASR::abiType::BindC || 
                 // Never Inline Interface Function
-                ASRUtils::get_FunctionType(func)->m_deftype == ASR::deftypeType::Interface) {
+                ASRUtils::get_FunctionType(func)->m_deftype == ASR::deftypeType::Interface ||
+                func->m_return_var == nullptr || x->n_args != func->n_args || x->m_dt ) {
             return ;
         }
 
-        if( !is_fast && !ASRUtils::get_FunctionType(func)->m_inline ) {
+        FunctionSizeVisitor size_visitor;
+        for( size_t i = 0; i < func->n_body; i++ ) {
+            size_visitor.visit_stmt(*func->m_body[i]);
+        }
+        if( size_visitor.has_labels ||
+            !is_inlining_profitable(x, func, size_visitor.size) ) {
             return ;
         }
 
         current_routine_scope = func->m_symtab;
 
+        bool success = true;
         ASR::expr_t* return_var = nullptr;
         // The following prepares arg2value map for inlining the
         // current function call. Variables are created in the current
         // scope for the arguments. These local variables are then initialised
         // as well with the argument value.
-        for( size_t i = 0; i < func->n_args + 1; i++ ) {
+        for( size_t i = 0; i < func->n_args + 1 && success; i++ ) {
             ASR::expr_t *func_margs_i = nullptr, *x_m_args_i = nullptr;
             if( i < func->n_args ) {
                 func_margs_i = func->m_args[i];
                 x_m_args_i = x->m_args[i].m_value;
+                if( x_m_args_i == nullptr ) {
+                    success = false;
+                    break;
+                }
             } else {
                 func_margs_i = func->m_return_var;
                 x_m_args_i = nullptr;
             }
             if( !ASR::is_a<ASR::Var_t>(*func_margs_i) ) {
-                arg2value.clear();
-                return ;
+                success = false;
+                break;
             }
             ASR::Var_t* arg_var = ASR::down_cast<ASR::Var_t>(func_margs_i);
             // TODO: Expand to other symbol types, Function, Subroutine, ExternalSymbol
             if( !ASR::is_a<ASR::Variable_t>(*(arg_var->m_v)) ||
                  ASRUtils::is_character(*ASRUtils::symbol_type(arg_var->m_v)) ||
-                 ASRUtils::is_array(ASRUtils::symbol_type(arg_var->m_v)) ) {
-                arg2value.clear();
-                return ;
+                 ASRUtils::is_array(ASRUtils::symbol_type(arg_var->m_v)) ||
+                 ASR::is_a<ASR::StructType_t>(*ASRUtils::symbol_type(arg_var->m_v)) ||
+                 ASR::is_a<ASR::ClassType_t>(*ASRUtils::symbol_type(arg_var->m_v)) ||
+                 ASR::down_cast<ASR::Variable_t>(arg_var->m_v)->m_presence ==
+                    ASR::presenceType::Optional ) {
+                success = false;
+                break;
             }
             ASR::Variable_t* arg_variable = ASR::down_cast<ASR::Variable_t>(arg_var->m_v);
             std::string arg_variable_name = std::string(arg_variable->m_name);
+            if( x_m_args_i && arg_variable->m_intent != ASR::intentType::In ) {
+                // Arguments which may be defined by the function are
+                // associated with the actual variable itself.
+                if( ASR::is_a<ASR::Var_t>(*x_m_args_i) &&
+                    ASR::is_a<ASR::Variable_t>(*ASRUtils::symbol_get_past_external(
+                        ASR::down_cast<ASR::Var_t>(x_m_args_i)->m_v)) ) {
+                    arg2value[arg_variable_name] = ASR::down_cast<ASR::Var_t>(x_m_args_i)->m_v;
+                    continue;
+                }
+                if( ASR::is_a<ASR::ArrayItem_t>(*x_m_args_i) ||
+                    ASR::is_a<ASR::StructInstanceMember_t>(*x_m_args_i) ) {
+                    success = false;
+                    break;
+                }
+            }
             std::string arg_name = current_scope->get_unique_name(arg_variable_name + "_" + std::string(func->m_name), false);
             ASR::stmt_t* assign_stmt = nullptr;
             ASR::expr_t* call_arg_var = nullptr;
@@ -294,13 +454,13 @@ public:
                     ASRUtils::duplicate_type(al, ASRUtils::expr_type(func_margs_i)));
                 return_var = call_arg_var;
             }
+            new_symbols.push_back(arg_name);
             if( assign_stmt ) {
                 pass_result_local.push_back(al, assign_stmt);
             }
             arg2value[arg_variable_name] = ASR::down_cast<ASR::Var_t>(call_arg_var)->m_v;
         }
 
-        bool success = true;
         // Stores the initialisation expression for function's local variables
         // i.e., other than the argument variables.
         std::vector<std::pair<ASR::expr_t*, ASR::symbol_t*>> exprs_to_be_visited;
@@ -309,17 +469,27 @@ public:
         // the ones other than the arguments.
         // exprs_to_be_visited temporarily stores the initialisation expression as well.
         for( auto& itr : func->m_symtab->get_scope() ) {
+            if( !success ) {
+                break;
+            }
             if( startswith(itr.first, "~empty_block") ) {
                 set_empty_block(current_scope, func->base.base.loc);
                 continue;
             }
+            // Symbols used from modules are imported when fixing the body
+            if( ASR::is_a<ASR::ExternalSymbol_t>(*itr.second) ) {
+                continue;
+            }
             if( !ASR::is_a<ASR::Variable_t>(*itr.second) ||
                  ASRUtils::is_character(*ASRUtils::symbol_type(itr.second)) ||
                  ASRUtils::is_array(ASRUtils::symbol_type(itr.second)) ||
                  ASR::is_a<ASR::StructType_t>(*ASRUtils::symbol_type(itr.second)) ||
-                 ASR::is_a<ASR::ClassType_t>(*ASRUtils::symbol_type(itr.second)) ) {
-                arg2value.clear();
-                return ;
+                 ASR::is_a<ASR::ClassType_t>(*ASRUtils::symbol_type(itr.second)) ||
+                 // Saved variables keep their value across calls
+                 ASR::down_cast<ASR::Variable_t>(itr.second)->m_storage ==
+                    ASR::storage_typeType::Save ) {
+                success = false;
+                break;
             }
             ASR::Variable_t* func_var = ASR::down_cast<ASR::Variable_t>(itr.second);
             std::string func_var_name = itr.first;
@@ -345,6 +515,7 @@ public:
                         local_var_type, nullptr, ASR::abiType::Source, ASR::accessType::Public,
                         ASR::presenceType::Required, false);
                 current_scope->add_symbol(local_var_name, local_var);
+                new_symbols.push_back(local_var_name);
                 arg2value[func_var_name] = local_var;
                 if( m_symbolic_value ) {
                     exprs_to_be_visited.push_back(std::make_pair(m_symbolic_value, local_var));
@@ -425,18 +596,18 @@ public:
                 } else {
                     remove_empty_block(current_scope);
                 }
+                routine_growth += size_visitor.size;
             }
             inlining_function = false;
-            current_routine_scope = nullptr;
             function_result_var = return_var;
         }
+        current_routine_scope = nullptr;
 
         if (!success) {
-            // If not successful then delete all the local variables
+            // If not successful then delete all the symbols
             // created for the purpose of inlining the current function call.
-            for( auto& itr : arg2value ) {
-                ASR::Variable_t* auxiliary_var = ASR::down_cast<ASR::Variable_t>(itr.second);
-                current_scope->erase_symbol(std::string(auxiliary_var->m_name));
+            for( auto& new_symbol : new_symbols ) {
+                current_scope->erase_symbol(new_symbol);
             }
             function_result_var = nullptr;
         }
@@ -449,6 +620,7 @@ public:
         // Clear up the arg2value to avoid corruption
         // of any kind.
         arg2value.clear();
+        new_symbols.clear();
     }
 
 };
@@ -461,6 +633,8 @@ private:
 
     bool from_inline_function_call;
     std::string current_routine;
+    size_t loop_depth;
+    int64_t routine_growth;
     Vec<ASR::stmt_t*>* parent_body;
     Vec<ASR::stmt_t*> pass_result;
 
@@ -472,9 +646,10 @@ public:
 
     InlineFunctionCallVisitor(Allocator &al_, const std::string& rl_path_,
         bool inline_external_symbol_calls_, bool is_fast_):
-        al(al_), current_routine(""), parent_body(nullptr),
+        al(al_), current_routine(""), loop_depth(0), routine_growth(0), parent_body(nullptr),
         replacer(al_, rl_path_, inline_external_symbol_calls_, is_fast_,
-                 pass_result, from_inline_function_call, current_routine) {
+                 pass_result, from_inline_function_call, current_routine,
+                 loop_depth, routine_growth) {
         pass_result.reserve(al, 1);
     }
 
@@ -493,10 +668,42 @@ public:
         // which requires to generate a TransformVisitor.
         ASR::Function_t &xx = const_cast<ASR::Function_t&>(x);
         current_routine = std::string(xx.m_name);
+        size_t loop_depth_copy = loop_depth;
+        int64_t routine_growth_copy = routine_growth;
+        loop_depth = 0;
+        routine_growth = 0;
         ASR::CallReplacerOnExpressionsVisitor<InlineFunctionCallVisitor>::visit_Function(x);
+        loop_depth = loop_depth_copy;
+        routine_growth = routine_growth_copy;
         current_routine.clear();
     }
 
+    void visit_Program(const ASR::Program_t &x) {
+        routine_growth = 0;
+        ASR::CallReplacerOnExpressionsVisitor<InlineFunctionCallVisitor>::visit_Program(x);
+    }
+
+    void visit_Module(const ASR::Module_t &x) {
+        // The code for modules loaded from .mod files is not generated,
+        // their procedures are only inlined in the callers
+        if( x.m_loaded_from_mod || x.m_intrinsic ) {
+            return ;
+        }
+        ASR::CallReplacerOnExpressionsVisitor<InlineFunctionCallVisitor>::visit_Module(x);
+    }
+
+    void visit_DoLoop(const ASR::DoLoop_t& x) {
+        loop_depth += 1;
+        ASR::CallReplacerOnExpressionsVisitor<InlineFunctionCallVisitor>::visit_DoLoop(x);
+        loop_depth -= 1;
+    }
+
+    void visit_WhileLoop(const ASR::WhileLoop_t& x) {
+        loop_depth += 1;
+        ASR::CallReplacerOnExpressionsVisitor<InlineFunctionCallVisitor>::visit_WhileLoop(x);
+        loop_depth -= 1;
+    }
+
     void visit_Assignment(const ASR::Assignment_t& x) {
         from_inline_function_call = true;
         ASR::CallReplacerOnExpressionsVisitor<InlineFunctionCallVisitor>::visit_Assignment(x);
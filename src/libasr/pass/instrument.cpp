@@ -0,0 +1,338 @@
+#include <libasr/asr.h>
+#include <libasr/containers.h>
+#include <libasr/exception.h>
+#include <libasr/asr_utils.h>
+#include <libasr/asr_builder.h>
+#include <libasr/location.h>
+#include <libasr/pass/instrument.h>
+#include <libasr/pass/pass_utils.h>
+
+
+namespace LCompilers {
+
+using ASR::down_cast;
+using ASR::is_a;
+
+/*
+This ASR pass times procedures and loop nests for `--instrument`. Each timed
+region gets a saved site variable and is enclosed in calls to the runtime
+library:
+
+    subroutine f(n)
+    integer, save :: __lcompilers_profile_site = 0
+    call _lfortran_profile_enter(__lcompilers_profile_site, &
+        "function" // tab // "f" // tab // "a.f90:1")
+    ...
+    call _lfortran_profile_exit(__lcompilers_profile_site)
+    end subroutine
+
+The runtime numbers each site the first time it is entered and keeps the
+counters per thread. When the program exits it writes the flat profile and
+the collapsed stacks (see `_lfortran_profile_enter`).
+
+With `loops`, the outermost DoLoop or DoConcurrentLoop of each nest is
+timed. The bodies of OpenMP regions and `do concurrent` loops are left
+alone, the openmp pass outlines them into other functions. `exit` leaves
+the loop to the call after it. `return` and `go to` may leave a region
+without its exit call; the runtime closes those regions when it exits an
+enclosing one.
+*/
+class InstrumentVisitor : public ASR::BaseWalkVisitor<InstrumentVisitor>
+{
+private:
+
+    Allocator &al;
+    const PassOptions &pass_options;
+    // The procedure being instrumented
+    SymbolTable *current_scope = nullptr;
+    std::string current_name;
+    ASR::symbol_t *enter_fn = nullptr, *exit_fn = nullptr;
+    ASR::expr_t *procedure_site = nullptr;
+    size_t n_loops = 0;
+
+public:
+
+    InstrumentVisitor(Allocator &al_, const PassOptions &pass_options_) :
+        al(al_), pass_options(pass_options_) {}
+
+    // "file:line" of `loc`, or "" without a LocationManager
+    std::string location(const Location &loc, uint32_t &line) {
+        line = 0;
+        const LocationManager *lm = pass_options.location_manager;
+        if (lm == nullptr || lm->file_ends.empty()) return "";
+        uint32_t column;
+        std::string filename;
+        lm->pos_to_linecol(lm->output_to_input_pos(loc.first, false),
+            line, column, filename);
+        return filename + ":" + std::to_string(line);
+    }
+
+    // Declares `_lfortran_profile_<name>(site[, desc])` in the current scope
+    ASR::symbol_t* declare_runtime_function(const Location &loc,
+            const std::string &name, bool with_desc) {
+        ASRUtils::ASRBuilder b(al, loc);
+        std::string fn_name = current_scope->get_unique_name(
+            "__lcompilers_profile_" + name, false);
+        SymbolTable *fn_symtab = al.make_new<SymbolTable>(current_scope);
+        Vec<ASR::expr_t*> args; args.reserve(al, 2);
+        args.push_back(al, b.Variable(fn_symtab, "site", int32,
+            ASR::intentType::InOut, ASR::abiType::BindC, false));
+        if (with_desc) {
+            args.push_back(al, b.Variable(fn_symtab, "desc", character(-1),
+                ASR::intentType::In, ASR::abiType::BindC, false));
+        }
+        SetChar dep; dep.reserve(al, 1);
+        Vec<ASR::stmt_t*> body; body.reserve(al, 1);
+        ASR::symbol_t *s = make_Function_Without_ReturnVar_t(fn_name, fn_symtab,
+            dep, args, body, ASR::abiType::BindC, ASR::deftypeType::Interface,
+            s2c(al, "_lfortran_profile_" + name));
+        current_scope->add_symbol(fn_name, s);
+        return s;
+    }
+
+    // A new site variable, `integer, save :: site = 0`
+    ASR::expr_t* create_site(const Location &loc) {
+        ASRUtils::ASRBuilder b(al, loc);
+        std::string name = current_scope->get_unique_name(
+            "__lcompilers_profile_site", false);
+        ASR::expr_t *zero = b.i32(0);
+        ASR::symbol_t *sym = down_cast<ASR::symbol_t>(
+            ASRUtils::make_Variable_t_util(al, loc, current_scope,
+            s2c(al, name), nullptr, 0, ASR::intentType::Local, zero, zero,
+            ASR::storage_typeType::Save, int32, nullptr, ASR::abiType::Source,
+            ASR::accessType::Public, ASR::presenceType::Required, false));
+        current_scope->add_symbol(name, sym);
+        return ASRUtils::EXPR(ASR::make_Var_t(al, loc, sym));
+    }
+
+    ASR::stmt_t* enter_call(const Location &loc, ASR::expr_t *site,
+            const std::string &kind, const std::string &frame,
+            const std::string &where) {
+        if (enter_fn == nullptr) {
+            enter_fn = declare_runtime_function(loc, "enter", true);
+        }
+        ASRUtils::ASRBuilder b(al, loc);
+        std::string desc = kind + "\t" + frame + "\t" + where;
+        Vec<ASR::call_arg_t> args; args.reserve(al, 2);
+        ASR::call_arg_t arg;
+        arg.loc = loc;
+        arg.m_value = site;
+        args.push_back(al, arg);
+        arg.m_value = b.StringConstant(desc, character(desc.size()));
+        args.push_back(al, arg);
+        return b.SubroutineCall(enter_fn, args);
+    }
+
+    ASR::stmt_t* exit_call(const Location &loc, ASR::expr_t *site) {
+        if (exit_fn == nullptr) {
+            exit_fn = declare_runtime_function(loc, "exit", false);
+        }
+        ASRUtils::ASRBuilder b(al, loc);
+        Vec<ASR::call_arg_t> args; args.reserve(al, 1);
+        ASR::call_arg_t arg;
+        arg.loc = loc;
+        arg.m_value = site;
+        args.push_back(al, arg);
+        return b.SubroutineCall(exit_fn, args);
+    }
+
+    // Appends the loop `s` to `body`, between the calls that time it. Its
+    // frame is named after the loop's construct name or line.
+    void time_loop(Vec<ASR::stmt_t*> &body, ASR::stmt_t *s, char *name) {
+        const Location &loc = s->base.loc;
+        uint32_t line;
+        std::string where = location(loc, line);
+        n_loops++;
+        std::string frame = current_name + ":" + (name ? std::string(name)
+            : line ? "do@" + std::to_string(line) : "do" + std::to_string(n_loops));
+        ASR::expr_t *site = create_site(loc);
+        body.push_back(al, enter_call(loc, site, "loop", frame, where));
+        body.push_back(al, s);
+        body.push_back(al, exit_call(loc, site));
+    }
+
+    void instrument_stmts(ASR::stmt_t **&m_body, size_t &n_body, bool in_loop) {
+        Vec<ASR::stmt_t*> body;
+        body.reserve(al, n_body + 2);
+        for (size_t i = 0; i < n_body; i++) {
+            ASR::stmt_t *s = m_body[i];
+            switch (s->type) {
+                case ASR::stmtType::Return: {
+                    if (procedure_site) {
+                        body.push_back(al, exit_call(s->base.loc, procedure_site));
+                    }
+                    break;
+                }
+                case ASR::stmtType::DoLoop: {
+                    ASR::DoLoop_t *loop = down_cast<ASR::DoLoop_t>(s);
+                    instrument_stmts(loop->m_body, loop->n_body, true);
+                    instrument_stmts(loop->m_orelse, loop->n_orelse, true);
+                    if (pass_options.instrument_loops && !in_loop) {
+                        time_loop(body, s, loop->m_name);
+                        continue;
+                    }
+                    break;
+                }
+                case ASR::stmtType::DoConcurrentLoop: {
+                    // Timed as a whole, its body runs in an outlined function
+                    if (pass_options.instrument_loops && !in_loop) {
+                        time_loop(body, s, nullptr);
+                        continue;
+                    }
+                    break;
+                }
+                case ASR::stmtType::WhileLoop: {
+                    ASR::WhileLoop_t *loop = down_cast<ASR::WhileLoop_t>(s);
+                    instrument_stmts(loop->m_body, loop->n_body, in_loop);
+                    instrument_stmts(loop->m_orelse, loop->n_orelse, in_loop);
+                    break;
+                }
+                case ASR::stmtType::If: {
+                    ASR::If_t *x = down_cast<ASR::If_t>(s);
+                    instrument_stmts(x->m_body, x->n_body, in_loop);
+                    instrument_stmts(x->m_orelse, x->n_orelse, in_loop);
+                    break;
+                }
+                case ASR::stmtType::Select: {
+                    ASR::Select_t *x = down_cast<ASR::Select_t>(s);
+                    for (size_t j = 0; j < x->n_body; j++) {
+                        if (is_a<ASR::CaseStmt_t>(*x->m_body[j])) {
+                            ASR::CaseStmt_t *c = down_cast<ASR::CaseStmt_t>(x->m_body[j]);
+                            instrument_stmts(c->m_body, c->n_body, in_loop);
+                        } else {
+                            ASR::CaseStmt_Range_t *c = down_cast<ASR::CaseStmt_Range_t>(x->m_body[j]);
+                            instrument_stmts(c->m_body, c->n_body, in_loop);
+                        }
+                    }
+                    instrument_stmts(x->m_default, x->n_default, in_loop);
+                    break;
+                }
+                case ASR::stmtType::SelectType: {
+                    ASR::SelectType_t *x = down_cast<ASR::SelectType_t>(s);
+                    for (size_t j = 0; j < x->n_body; j++) {
+                        ASR::type_stmt_t *t = x->m_body[j];
+                        if (is_a<ASR::TypeStmtName_t>(*t)) {
+                            ASR::TypeStmtName_t *c = down_cast<ASR::TypeStmtName_t>(t);
+                            instrument_stmts(c->m_body, c->n_body, in_loop);
+                        } else if (is_a<ASR::ClassStmt_t>(*t)) {
+                            ASR::ClassStmt_t *c = down_cast<ASR::ClassStmt_t>(t);
+                            instrument_stmts(c->m_body, c->n_body, in_loop);
+                        } else {
+                            ASR::TypeStmtType_t *c = down_cast<ASR::TypeStmtType_t>(t);
+                            instrument_stmts(c->m_body, c->n_body, in_loop);
+                        }
+                    }
+                    instrument_stmts(x->m_default, x->n_default, in_loop);
+                    break;
+                }
+                case ASR::stmtType::BlockCall: {
+                    ASR::symbol_t *m = down_cast<ASR::BlockCall_t>(s)->m_m;
+                    if (is_a<ASR::Block_t>(*m)) {
+                        ASR::Block_t *block = down_cast<ASR::Block_t>(m);
+                        instrument_stmts(block->m_body, block->n_body, in_loop);
+                    }
+                    break;
+                }
+                default: {
+                    break;
+                }
+            }
+            body.push_back(al, s);
+        }
+        m_body = body.p;
+        n_body = body.size();
+    }
+
+    // Instruments the body of a procedure called `name`
+    void instrument_procedure(const Location &loc, SymbolTable *symtab,
+            const std::string &kind,
+            const std::string &name, ASR::stmt_t **&m_body, size_t &n_body,
+            bool time_procedure) {
+        current_scope = symtab;
+        current_name = name;
+        enter_fn = exit_fn = nullptr;
+        procedure_site = nullptr;
+        n_loops = 0;
+        std::string where;
+        if (time_procedure) {
+            uint32_t line;
+            where = location(loc, line);
+            procedure_site = create_site(loc);
+        }
+        instrument_stmts(m_body, n_body, false);
+        if (time_procedure) {
+            Vec<ASR::stmt_t*> body;
+            body.reserve(al, n_body + 2);
+            body.push_back(al, enter_call(loc, procedure_site, kind, name,
+                where));
+            for (size_t i = 0; i < n_body; i++) {
+                body.push_back(al, m_body[i]);
+            }
+            body.push_back(al, exit_call(loc, procedure_site));
+            m_body = body.p;
+            n_body = body.size();
+        }
+        current_scope = nullptr;
+    }
+
+    void visit_TranslationUnit(const ASR::TranslationUnit_t &x) {
+        for (auto &a : x.m_symtab->get_scope()) {
+            visit_symbol(*a.second);
+        }
+    }
+
+    void visit_Module(const ASR::Module_t &x) {
+        if (x.m_intrinsic) return;
+        for (auto &a : x.m_symtab->get_scope()) {
+            if (is_a<ASR::Function_t>(*a.second)) {
+                visit_symbol(*a.second);
+            }
+        }
+    }
+
+    void visit_Program(const ASR::Program_t &x) {
+        ASR::Program_t &xx = const_cast<ASR::Program_t&>(x);
+        for (auto &a : x.m_symtab->get_scope()) {
+            if (is_a<ASR::Function_t>(*a.second)) {
+                visit_symbol(*a.second);
+            }
+        }
+        instrument_procedure(x.base.base.loc, x.m_symtab, "program", x.m_name,
+            xx.m_body, xx.n_body, pass_options.instrument_functions);
+    }
+
+    void visit_Function(const ASR::Function_t &x) {
+        ASR::Function_t &xx = const_cast<ASR::Function_t&>(x);
+        ASR::FunctionType_t *ftype = ASRUtils::get_FunctionType(x);
+        if (ftype->m_deftype == ASR::deftypeType::Interface ||
+                ftype->m_abi == ASR::abiType::Intrinsic ||
+                ftype->m_is_restriction || x.n_body == 0) {
+            return;
+        }
+        for (auto &a : x.m_symtab->get_scope()) {
+            if (is_a<ASR::Function_t>(*a.second)) {
+                visit_symbol(*a.second);
+            }
+        }
+        std::string name = x.m_name;
+        ASR::symbol_t *owner = ASRUtils::get_asr_owner(&x.base);
+        if (owner && is_a<ASR::Module_t>(*owner)) {
+            name = std::string(ASRUtils::symbol_name(owner)) + "::" + name;
+        }
+        instrument_procedure(x.base.base.loc, x.m_symtab, "function", name,
+            xx.m_body, xx.n_body, pass_options.instrument_functions);
+    }
+
+};
+
+void pass_instrument(Allocator &al, ASR::TranslationUnit_t &unit,
+                     const LCompilers::PassOptions& pass_options) {
+    if (!pass_options.instrument_functions && !pass_options.instrument_loops) {
+        return;
+    }
+    InstrumentVisitor v(al, pass_options);
+    v.visit_TranslationUnit(unit);
+}
+
+
+} // namespace LCompilers
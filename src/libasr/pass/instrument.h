@@ -0,0 +1,14 @@
+#ifndef LIBASR_PASS_INSTRUMENT_H
+#define LIBASR_PASS_INSTRUMENT_H
+
+#include <libasr/asr.h>
+#include <libasr/utils.h>
+
+namespace LCompilers {
+
+    void pass_instrument(Allocator &al, ASR::TranslationUnit_t &unit,
+                         const PassOptions &pass_options);
+
+} // namespace LCompilers
+
+#endif // LIBASR_PASS_INSTRUMENT_H
@@ -94,6 +94,196 @@ typedef void (*verify_array_function)(
     const ASR::IntrinsicArrayFunction_t&,
     diag::Diagnostics&);
 
+/*
+ * Calls to the array kernels of the runtime library (`_lfortran_dgemm` and
+ * friends in lfortran_intrinsics.c). The generated functions of `matmul`,
+ * `dot_product`, `sum` and `transpose` call them when all of their arrays
+ * are contiguous and of the same real or complex kind, and fall back to
+ * their loops otherwise.
+ */
+namespace ArrayKernels {
+
+// Set by the intrinsic_function pass for backends that implement
+// `ArrayIsContiguous` and link the runtime library
+inline bool enabled = false;
+
+// The reduction kernels sum in a different order than the loops, so like
+// in GFortran they are only used with -fassociative-math (or -ffast-math)
+inline bool reassociate = false;
+
+// BLAS style prefix of the kernels for elements of type `t`, or "" if
+// there are none
+static inline std::string prefix(ASR::ttype_t* t) {
+    t = ASRUtils::type_get_past_array(ASRUtils::type_get_past_allocatable(
+        ASRUtils::type_get_past_pointer(t)));
+    int kind = ASRUtils::extract_kind_from_ttype_t(t);
+    if (ASR::is_a<ASR::Real_t>(*t)) {
+        return kind == 8 ? "d" : kind == 4 ? "s" : "";
+    } else if (ASR::is_a<ASR::Complex_t>(*t)) {
+        return kind == 8 ? "z" : kind == 4 ? "c" : "";
+    }
+    return "";
+}
+
+// Prefix shared by all of `types`, or "" if they differ or the kernels are
+// not enabled
+static inline std::string common_prefix(std::vector<ASR::ttype_t*> types) {
+    if (!enabled) return "";
+    std::string p = prefix(types[0]);
+    for (auto &t: types) {
+        if (prefix(t) != p) return "";
+    }
+    return p;
+}
+
+// `c_loc` of the first element of `arr`
+static inline ASR::expr_t* data(Allocator &al, ASRBuilder &b, ASR::expr_t* arr) {
+    const Location &loc = arr->base.loc;
+    int rank = ASRUtils::extract_n_dims_from_ttype(ASRUtils::expr_type(arr));
+    std::vector<ASR::expr_t*> idx;
+    for (int i = 1; i <= rank; i++) {
+        idx.push_back(LBound(arr, i));
+    }
+    ASR::expr_t* first = b.ArrayItem_01(arr, idx);
+    ASR::expr_t* ptr = ASRUtils::EXPR(ASR::make_GetPointer_t(al, loc, first,
+        ASRUtils::TYPE(ASR::make_Pointer_t(al, loc, ASRUtils::expr_type(first))),
+        nullptr));
+    return b.PointerToCPtr(ptr, b.CPtr());
+}
+
+// size(arr, dim) (size(arr) if `dim` is 0) as an integer(8); later passes
+// may replace the size by an integer(4) variable, hence the cast
+static inline ASR::expr_t* size(Allocator &al, ASRBuilder &b, ASR::expr_t* arr,
+        int dim = 0) {
+    const Location &loc = arr->base.loc;
+    return b.i2i_t(b.ArraySize(arr, dim ? b.i32(dim) : nullptr, int32), int64);
+}
+
+// `c_loc` of the scalar variable `x`
+static inline ASR::expr_t* address(Allocator &al, ASRBuilder &b, ASR::expr_t* x) {
+    const Location &loc = x->base.loc;
+    ASR::expr_t* ptr = ASRUtils::EXPR(ASR::make_GetPointer_t(al, loc, x,
+        ASRUtils::TYPE(ASR::make_Pointer_t(al, loc, ASRUtils::expr_type(x))),
+        nullptr));
+    return b.PointerToCPtr(ptr, b.CPtr());
+}
+
+// `.true.` if all of `arrays` are contiguous and the first two (or the only
+// one) are not empty
+static inline ASR::expr_t* applicable(Allocator &al, const Location &loc,
+        ASRBuilder &b, std::vector<ASR::expr_t*> arrays) {
+    ASR::expr_t* test = nullptr;
+    for (size_t i = 0; i < arrays.size(); i++) {
+        ASR::expr_t* contiguous = ASRUtils::EXPR(ASR::make_ArrayIsContiguous_t(
+            al, loc, arrays[i], logical, nullptr));
+        test = test ? b.And(test, contiguous) : contiguous;
+        if (i < 2) {
+            test = b.And(test, b.Gt(size(al, b, arrays[i]), b.i64(0)));
+        }
+    }
+    return test;
+}
+
+// Declares the kernel `name` in `fn_symtab`, taking its arguments by value
+// and returning `return_type` (nullptr for a subroutine)
+static inline ASR::symbol_t* declare_kernel(Allocator &al, const Location &loc,
+        SymbolTable* fn_symtab, SetChar &dep, const std::string &name,
+        std::vector<ASR::ttype_t*> arg_types, ASR::ttype_t* return_type) {
+    ASRBuilder b(al, loc);
+    SymbolTable *fn_symtab_1 = al.make_new<SymbolTable>(fn_symtab);
+    Vec<ASR::expr_t*> args_1; args_1.reserve(al, arg_types.size());
+    for (size_t i = 0; i < arg_types.size(); i++) {
+        args_1.push_back(al, b.Variable(fn_symtab_1, "x_" + std::to_string(i),
+            arg_types[i], ASR::intentType::In, ASR::abiType::BindC, true));
+    }
+    ASR::expr_t *return_var_1 = nullptr;
+    if (return_type) {
+        return_var_1 = b.Variable(fn_symtab_1, name, return_type,
+            ASRUtils::intent_return_var, ASR::abiType::BindC, false);
+    }
+    SetChar dep_1; dep_1.reserve(al, 1);
+    Vec<ASR::stmt_t*> body_1; body_1.reserve(al, 1);
+    ASR::symbol_t *s = make_ASR_Function_t(name, fn_symtab_1, dep_1, args_1,
+        body_1, return_var_1, ASR::abiType::BindC, ASR::deftypeType::Interface,
+        s2c(al, name));
+    fn_symtab->add_symbol(name, s);
+    dep.push_back(al, s2c(al, name));
+    return s;
+}
+
+static inline Vec<ASR::call_arg_t> call_args(Allocator &al,
+        std::vector<ASR::expr_t*> values) {
+    Vec<ASR::call_arg_t> args; args.reserve(al, values.size());
+    for (auto &v: values) {
+        ASR::call_arg_t arg;
+        arg.loc = v->base.loc;
+        arg.m_value = v;
+        args.push_back(al, arg);
+    }
+    return args;
+}
+
+// call `name`(values...) with arguments of type int64 or c_ptr
+static inline ASR::stmt_t* call(Allocator &al, const Location &loc,
+        SymbolTable* fn_symtab, SetChar &dep, const std::string &name,
+        std::vector<ASR::expr_t*> values) {
+    std::vector<ASR::ttype_t*> arg_types;
+    for (auto &v: values) arg_types.push_back(ASRUtils::expr_type(v));
+    ASR::symbol_t* s = declare_kernel(al, loc, fn_symtab, dep, name,
+        arg_types, nullptr);
+    Vec<ASR::call_arg_t> args = call_args(al, values);
+    ASRBuilder b(al, loc);
+    return b.SubroutineCall(s, args);
+}
+
+// `name`(values...) for a kernel returning `return_type`
+static inline ASR::expr_t* call_function(Allocator &al, const Location &loc,
+        SymbolTable* fn_symtab, SetChar &dep, const std::string &name,
+        std::vector<ASR::expr_t*> values, ASR::ttype_t* return_type) {
+    std::vector<ASR::ttype_t*> arg_types;
+    for (auto &v: values) arg_types.push_back(ASRUtils::expr_type(v));
+    ASR::symbol_t* s = declare_kernel(al, loc, fn_symtab, dep, name,
+        arg_types, return_type);
+    Vec<ASR::call_arg_t> args = call_args(al, values);
+    ASRBuilder b(al, loc);
+    return b.Call(s, args, return_type, nullptr);
+}
+
+// Reduction of the whole of `array` into the scalar `result` with the
+// kernel `_lfortran_<prefix><name>` (`sum` or `dot` with `other`), if the
+// kernels apply to it and may reassociate the sum
+static inline void reduce(Allocator &al, const Location &loc, ASRBuilder &b,
+        SymbolTable* fn_symtab, SetChar &dep, Vec<ASR::stmt_t*> &body,
+        const std::string &name, ASR::expr_t* array, ASR::expr_t* other,
+        ASR::expr_t* result) {
+    if (!reassociate) return;
+    std::vector<ASR::ttype_t*> types = {ASRUtils::expr_type(array),
+        ASRUtils::expr_type(result)};
+    if (other) types.push_back(ASRUtils::expr_type(other));
+    std::string p = common_prefix(types);
+    if (p.empty()) return;
+    std::vector<ASR::expr_t*> values = {size(al, b, array),
+        data(al, b, array)};
+    std::vector<ASR::expr_t*> arrays = {array};
+    if (other) {
+        values.push_back(data(al, b, other));
+        arrays.push_back(other);
+    }
+    std::string kernel = "_lfortran_" + p + name;
+    ASR::stmt_t* compute;
+    if (p == "z" || p == "c") {
+        values.push_back(address(al, b, result));
+        compute = call(al, loc, fn_symtab, dep, kernel, values);
+    } else {
+        compute = b.Assignment(result, call_function(al, loc, fn_symtab, dep,
+            kernel, values, ASRUtils::expr_type(result)));
+    }
+    body.push_back(al, b.If(applicable(al, loc, b, arrays),
+        {compute, b.Return()}, {}));
+}
+
+} // namespace ArrayKernels
+
 namespace ArrIntrinsic {
 
 static inline void verify_array_int_real_cmplx(ASR::expr_t* array, ASR::ttype_t* return_type,
@@ -989,6 +1179,9 @@ static inline ASR::expr_t* instantiate_ArrIntrinsic(Allocator &al,
 
     Vec<ASR::stmt_t*> body;
     body.reserve(al, 1);
+    SetChar dep;
+    dep.reserve(al, 1);
+    // TODO: fill dependencies
     ASR::expr_t* output_var = nullptr;
     if( return_var ) {
         output_var = return_var;
@@ -996,6 +1189,10 @@ static inline ASR::expr_t* instantiate_ArrIntrinsic(Allocator &al,
         output_var = args[(int) args.size() - 1];
     }
     if( overload_id == id_array ) {
+        if( intrinsic_func_id == ASRUtils::IntrinsicArrayFunctions::Sum ) {
+            ArrayKernels::reduce(al, loc, b, fn_symtab, dep, body, "sum",
+                args[0], nullptr, output_var);
+        }
         generate_body_for_array_input(al, loc, args[0], output_var,
                                       fn_symtab, body, get_initial_value, elemental_operation);
     } else if( overload_id == id_array_dim ) {
@@ -1009,10 +1206,6 @@ static inline ASR::expr_t* instantiate_ArrIntrinsic(Allocator &al,
                                            fn_symtab, body, get_initial_value, elemental_operation);
     }
 
-    Vec<char *> dep;
-    dep.reserve(al, 1);
-    // TODO: fill dependencies
-
     ASR::symbol_t *new_symbol = nullptr;
     if( return_var ) {
         new_symbol = make_ASR_Function_t(new_name, fn_symtab, dep, args,
@@ -4018,6 +4211,32 @@ namespace MatMul {
         body.push_back(al, STMT(ASR::make_Assert_t(al, loc, dim_mismatch_check,
             EXPR(ASR::make_StringConstant_t(al, loc, s2c(al, assert_msg),
             character(assert_msg.size()))))));
+        std::string kernel_prefix = ArrayKernels::common_prefix(
+            {arg_types[0], arg_types[1], return_type});
+        if (!kernel_prefix.empty()) {
+            // result(m, n) = a(m, k) * b(k, n), vectors being 1 x k or k x 1
+            ASR::expr_t *m = b.i64(1), *n = b.i64(1), *kk;
+            if ( overload_id == 1 ) {
+                kk = ArrayKernels::size(al, b, args[0], 1);
+                n = ArrayKernels::size(al, b, args[1], 2);
+            } else if ( overload_id == 2 ) {
+                m = ArrayKernels::size(al, b, args[0], 1);
+                kk = ArrayKernels::size(al, b, args[0], 2);
+            } else {
+                m = ArrayKernels::size(al, b, args[0], 1);
+                kk = ArrayKernels::size(al, b, args[0], 2);
+                n = ArrayKernels::size(al, b, args[1], 2);
+            }
+            body.push_back(al, b.If(ArrayKernels::applicable(al, loc, b,
+                    {args[0], args[1], result}), {
+                ArrayKernels::call(al, loc, fn_symtab, dep,
+                    "_lfortran_" + kernel_prefix + "gemm", {m, n, kk,
+                    ArrayKernels::data(al, b, args[0]),
+                    ArrayKernels::data(al, b, args[1]),
+                    ArrayKernels::data(al, b, result)}),
+                b.Return()
+            }, {}));
+        }
         ASR::expr_t *mul_value;
         if (is_real(*expr_type(a_ref)) && is_integer(*expr_type(b_ref))) {
             mul_value = b.Mul(a_ref, b.i2r_t(b_ref, expr_type(a_ref)));
@@ -5600,6 +5819,8 @@ namespace DotProduct {
                 b.Assignment(result, b.Or(result, b.And(b.ArrayItem_01(args[0], {i}), b.ArrayItem_01(args[1], {i}))))
             }));
         } else if (is_complex(*return_type)) {
+            ArrayKernels::reduce(al, loc, b, fn_symtab, dep, body, "dot",
+                args[0], args[1], result);
             body.push_back(al, b.Assignment(result, EXPR(ASR::make_ComplexConstant_t(al, loc, 0.0, 0.0, return_type))));
 
             Vec<ASR::call_arg_t> new_args_conjg; new_args_conjg.reserve(al, 1);
@@ -5615,6 +5836,8 @@ namespace DotProduct {
                 b.Assignment(result, b.Add(result, EXPR(ASR::make_ComplexBinOp_t(al, loc, func_call_conjg, ASR::binopType::Mul, b.ArrayItem_01(args[1], {i}), return_type, nullptr))))
             }, nullptr));
         } else if (is_real(*return_type)) {
+            ArrayKernels::reduce(al, loc, b, fn_symtab, dep, body, "dot",
+                args[0], args[1], result);
             body.push_back(al, b.Assignment(result, make_ConstantWithType(make_RealConstant_t, 0.0, return_type, loc)));
             body.push_back(al, b.DoLoop(i, LBound(args[0], 1), UBound(args[0], 1), {
                 b.Assignment(result, b.Add(result, b.Mul(b.ArrayItem_01(args[0], {i}), b.r2r_t(b.ArrayItem_01(args[1], {i}), ASRUtils::type_get_past_array(arg_types[0])))))
@@ -5725,6 +5948,24 @@ namespace Transpose {
         args.push_back(al, result);
         ASR::expr_t *i = declare("i", int32, Local);
         ASR::expr_t *j = declare("j", int32, Local);
+        std::string kernel_prefix = ArrayKernels::common_prefix(
+            {arg_types[0], return_type});
+        if (!kernel_prefix.empty()) {
+            ASR::ttype_t *elem_type = type_get_past_array(
+                type_get_past_allocatable(return_type));
+            int64_t elem_size = extract_kind_from_ttype_t(elem_type) *
+                (is_complex(*elem_type) ? 2 : 1);
+            body.push_back(al, b.If(ArrayKernels::applicable(al, loc, b,
+                    {args[0], result}), {
+                ArrayKernels::call(al, loc, fn_symtab, dep,
+                    "_lfortran_transpose", {
+                    ArrayKernels::size(al, b, args[0], 1),
+                    ArrayKernels::size(al, b, args[0], 2), b.i64(elem_size),
+                    ArrayKernels::data(al, b, args[0]),
+                    ArrayKernels::data(al, b, result)}),
+                b.Return()
+            }, {}));
+        }
         body.push_back(al, b.DoLoop(i, LBound(args[0], 1), UBound(args[0], 1), {
             b.DoLoop(j, LBound(args[0], 2), UBound(args[0], 2), {
                 b.Assignment(b.ArrayItem_01(result, {j, i}), b.ArrayItem_01(args[0], {i, j}))
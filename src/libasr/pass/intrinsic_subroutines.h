@@ -130,62 +130,60 @@ namespace RandomSeed {
             Vec<ASR::call_arg_t>& new_args, int64_t /*overload_id*/) {
 
         std::string c_func_name_1 = "_lfortran_random_seed";
-        std::string c_func_name_2 = "_lfortran_dp_rand_num";
+        std::string c_func_name_2 = "_lfortran_random_seed_put";
+        std::string c_func_name_3 = "_lfortran_random_seed_get";
         std::string new_name = "_lcompilers_random_seed_";
         declare_basic_variables(new_name);
-        int flag = 0;
+        // The seed is the state of the generator, as 8 32-bit integers
+        const int seed_size = 8;
         if (!is_real(*arg_types[0])) {
             fill_func_arg_sub("size", arg_types[0], InOut);
             ASR::symbol_t *s_1 = b.create_c_func_subroutines(c_func_name_1, fn_symtab, 1, arg_types[0]);
             fn_symtab->add_symbol(c_func_name_1, s_1);
             dep.push_back(al, s2c(al, c_func_name_1));
             Vec<ASR::expr_t*> call_args; call_args.reserve(al, 1);
-            call_args.push_back(al, b.i32(8));
+            call_args.push_back(al, b.i32(seed_size));
             body.push_back(al, b.Assignment(args[0], b.Call(s_1, call_args, arg_types[0])));
         } else {
             fill_func_arg_sub("size", real32, InOut);
             body.push_back(al, b.Assignment(args[0], b.f32(0)));
         }
         if (!is_real(*arg_types[1])) {
-            flag = 1;
             fill_func_arg_sub("put", arg_types[1], InOut);
-            body.push_back(al, b.Assignment(args[1], args[1]));
+            ASR::symbol_t *s_2 = b.create_c_func_subroutines(c_func_name_2, fn_symtab, seed_size, int32);
+            fn_symtab->add_symbol(c_func_name_2, s_2);
+            dep.push_back(al, s2c(al, c_func_name_2));
+            Vec<ASR::expr_t*> call_args; call_args.reserve(al, seed_size);
+            ASR::expr_t* lbound = b.ArrayLBound(args[1], 1);
+            for (int i = 0; i < seed_size; i++) {
+                ASR::expr_t* item = b.ArrayItem_01(args[1], {b.Add(lbound, b.i32(i))});
+                if (ASRUtils::extract_kind_from_ttype_t(ASRUtils::expr_type(item)) != 4) {
+                    item = b.i2i_t(item, int32);
+                }
+                call_args.push_back(al, item);
+            }
+            auto size = declare("seed_size", int32, Local);
+            body.push_back(al, b.Assignment(size, b.Call(s_2, call_args, int32)));
         } else {
             fill_func_arg_sub("put", real32, InOut);
             body.push_back(al, b.Assignment(args[1], b.f32(0)));
         }
         if (!is_real(*arg_types[2])) {
             fill_func_arg_sub("get", arg_types[2], InOut);
-            if (flag == 1) {
-                body.push_back(al, b.Assignment(args[2], args[1]));
-            } else {
-                std::vector<LCompilers::ASR::expr_t *> vals;
-                std::string c_func = c_func_name_2;
-                int kind = ASRUtils::extract_kind_from_ttype_t(arg_types[2]);
-                if ( is_real(*arg_types[2]) ) {
-                    if (kind == 4) {
-                        c_func = "_lfortran_sp_rand_num";
-                    } else {
-                        c_func = "_lfortran_dp_rand_num";
-                    }
-                } else if ( is_integer(*arg_types[2]) ) {
-                    if (kind == 4) {
-                        c_func = "_lfortran_int32_rand_num";
-                    } else {
-                        c_func = "_lfortran_int64_rand_num";
-                    }
-                }
-                ASR::symbol_t *s_2 = b.create_c_func_subroutines(c_func, fn_symtab, 0, arg_types[2]);
-                fn_symtab->add_symbol(c_func, s_2);
-                dep.push_back(al, s2c(al, c_func));
-                Vec<ASR::expr_t*> call_args2; call_args2.reserve(al, 0);
-                ASR::ttype_t* elem_type = extract_type(arg_types[2]);
-                for (int i = 0; i < 8; i++) {
-                    auto xx = declare("i_" + std::to_string(i), elem_type, Local);
-                    body.push_back(al, b.Assignment(xx, b.Call(s_2, call_args2, int32)));
-                    vals.push_back(xx);
+            ASR::symbol_t *s_3 = b.create_c_func_subroutines(c_func_name_3, fn_symtab, 1, int32);
+            fn_symtab->add_symbol(c_func_name_3, s_3);
+            dep.push_back(al, s2c(al, c_func_name_3));
+            ASR::ttype_t* elem_type = extract_type(arg_types[2]);
+            ASR::expr_t* lbound = b.ArrayLBound(args[2], 1);
+            for (int i = 0; i < seed_size; i++) {
+                Vec<ASR::expr_t*> call_args; call_args.reserve(al, 1);
+                call_args.push_back(al, b.i32(i + 1));
+                ASR::expr_t* value = b.Call(s_3, call_args, int32);
+                if (ASRUtils::extract_kind_from_ttype_t(elem_type) != 4) {
+                    value = b.i2i_t(value, elem_type);
                 }
-                body.push_back(al, b.Assignment(args[2], b.ArrayConstant(vals, extract_type(arg_types[2]), false)));
+                body.push_back(al, b.Assignment(b.ArrayItem_01(args[2],
+                    {b.Add(lbound, b.i32(i))}), value));
             }
         } else {
             fill_func_arg_sub("get", real32, InOut);
@@ -302,7 +300,7 @@ namespace RandomNumber {
                     To
                 real :: b(3)
                 do i=lbound(b,1),ubound(b,1)
-                    call random_number(b(i))
+                    b(i) = _lfortran_sp_rand_num()
                 end do
             */
             ASR::dimension_t* array_dims = nullptr;
@@ -311,12 +309,13 @@ namespace RandomNumber {
             for (int i = 0; i < array_rank; i++) {
                 do_loop_variables.push_back(declare("i_" + std::to_string(i), int32, Local));
             }
-            ASR::stmt_t* func_call = b.CallIntrinsicSubroutine(scope, {ASRUtils::type_get_past_array(ASRUtils::type_get_past_allocatable(arg_types[0]))},
-                                    {b.ArrayItem_01(args[0], do_loop_variables)}, 0, RandomNumber::instantiate_RandomNumber);
-            fn_name = scope->get_unique_name(fn_name, false);
+            ASR::ttype_t* elem_type = ASRUtils::type_get_past_array(
+                ASRUtils::type_get_past_allocatable(arg_types[0]));
+            Vec<ASR::expr_t*> call_args; call_args.reserve(al, 0);
+            ASR::stmt_t* assign_item = b.Assignment(b.ArrayItem_01(args[0], do_loop_variables),
+                b.Call(s, call_args, elem_type));
             body.push_back(al, PassUtils::create_do_loop_helper_random_number(al, loc, do_loop_variables, s, args[0],
-                    ASRUtils::type_get_past_array(ASRUtils::type_get_past_allocatable(arg_types[0])),
-                    b.ArrayItem_01(args[0], do_loop_variables), func_call, 1));
+                    elem_type, b.ArrayItem_01(args[0], do_loop_variables), assign_item, 1));
         } else {
             Vec<ASR::expr_t*> call_args; call_args.reserve(al, 0);
             body.push_back(al, b.Assignment(args[0], b.Call(s, call_args, arg_types[0])));
@@ -1,4 +1,5 @@
 #include <limits.h>
+#include <set>
 #include <libasr/asr.h>
 #include <libasr/containers.h>
 #include <libasr/exception.h>
@@ -448,6 +449,77 @@ class InvolvedSymbolsCollector:
         }
 };
 
+// Collects the local variables of the enclosing procedure used inside an
+// OpenMP region and the loop variables of the loops in the region
+class RegionSymbolsCollector:
+    public ASR::BaseWalkVisitor<RegionSymbolsCollector>
+{
+    public:
+        std::map<std::string, ASR::symbol_t*> symbols;
+        std::set<ASR::symbol_t*> loop_variables;
+
+        void visit_Var(const ASR::Var_t &x) {
+            if (!ASR::is_a<ASR::Variable_t>(*x.m_v)) {
+                return;
+            }
+            ASR::asr_t* owner = ASRUtils::symbol_parent_symtab(x.m_v)->asr_owner;
+            if (ASR::is_a<ASR::symbol_t>(*owner) &&
+                    (ASR::is_a<ASR::Function_t>(*ASR::down_cast<ASR::symbol_t>(owner)) ||
+                     ASR::is_a<ASR::Program_t>(*ASR::down_cast<ASR::symbol_t>(owner)))) {
+                symbols[to_lower(ASRUtils::symbol_name(x.m_v))] = x.m_v;
+            }
+        }
+
+        void visit_DoLoop(const ASR::DoLoop_t &x) {
+            if (x.m_head.m_v && ASR::is_a<ASR::Var_t>(*x.m_head.m_v)) {
+                loop_variables.insert(ASR::down_cast<ASR::Var_t>(x.m_head.m_v)->m_v);
+            }
+            BaseWalkVisitor::visit_DoLoop(x);
+        }
+};
+
+// Rebinds the variables of an outlined OpenMP region to the variables of the
+// outlined procedure
+class ReplaceRegionVariables: public ASR::BaseExprReplacer<ReplaceRegionVariables> {
+private:
+    std::map<ASR::symbol_t*, ASR::symbol_t*> &symbol_map;
+
+public:
+    ReplaceRegionVariables(std::map<ASR::symbol_t*, ASR::symbol_t*> &symbol_map) :
+        symbol_map(symbol_map) {}
+
+    void replace_Var(ASR::Var_t *x) {
+        if (symbol_map.find(x->m_v) != symbol_map.end()) {
+            x->m_v = symbol_map[x->m_v];
+        }
+    }
+
+    void replace_ArrayPhysicalCast(ASR::ArrayPhysicalCast_t* x) {
+        // Shared arrays become descriptor arrays in the outlined procedure
+        BaseExprReplacer<ReplaceRegionVariables>::replace_ArrayPhysicalCast(x);
+        x->m_old = ASRUtils::extract_physical_type(ASRUtils::expr_type(x->m_arg));
+        if (x->m_old == x->m_new) {
+            *current_expr = x->m_arg;
+        }
+    }
+};
+
+class RegionVariablesVisitor:
+    public ASR::CallReplacerOnExpressionsVisitor<RegionVariablesVisitor> {
+
+private:
+    ReplaceRegionVariables replacer;
+
+public:
+    RegionVariablesVisitor(std::map<ASR::symbol_t*, ASR::symbol_t*> &symbol_map):
+        replacer(symbol_map) { }
+
+    void call_replacer() {
+        replacer.current_expr = current_expr;
+        replacer.replace_expr(*current_expr);
+    }
+};
+
 // Replaces all the symbols used inside the DoConcurrentLoop region with the
 // same symbols passed as argument to the function
 class ReplaceSymbols: public ASR::BaseExprReplacer<ReplaceSymbols> {
@@ -527,6 +599,11 @@ class DoConcurrentVisitor :
         int current_stmt_index = -1;
         ASR::stmt_t** current_m_body; size_t current_n_body;
         std::vector<std::string> reduction_variables;
+        // Symbols of the outlined procedure being lowered that are shared
+        // with its region, the default for the tasks nested in it
+        std::set<ASR::symbol_t*> omp_shared_symbols;
+        std::set<std::string> omp_outlined_names;
+        bool omp_region_outlined = false;
     public:
         DoConcurrentVisitor(Allocator& al_, PassOptions pass_options_) :
         al(al_), remove_original_statement(false), pass_options(pass_options_) {
@@ -746,7 +823,10 @@ class DoConcurrentVisitor :
             return module_sym;
         }
 
-        std::pair<std::string, ASR::symbol_t*> create_thread_data_module(std::map<std::string, ASR::ttype_t*> &involved_symbols, const Location& loc) {
+        // `leading_members` are placed at the start of the struct, before the
+        // members for `involved_symbols`
+        std::pair<std::string, ASR::symbol_t*> create_thread_data_module(std::map<std::string, ASR::ttype_t*> &involved_symbols, const Location& loc,
+                const std::vector<std::pair<std::string, ASR::ttype_t*>> &leading_members = {}) {
             SymbolTable* current_scope_copy = current_scope;
             while (current_scope->parent != nullptr) {
                 current_scope = current_scope->parent;
@@ -775,6 +855,10 @@ class DoConcurrentVisitor :
             SymbolTable* parent_scope = current_scope;
             current_scope = al.make_new<SymbolTable>(parent_scope);
             SetChar involved_symbols_set; involved_symbols_set.reserve(al, involved_symbols.size());
+            for (auto &it: leading_members) {
+                b.VariableDeclaration(current_scope, it.first, it.second, ASR::intentType::Local);
+                involved_symbols_set.push_back(al, s2c(al, it.first));
+            }
             for (auto it: involved_symbols) {
                 ASR::ttype_t* sym_type = nullptr;
                 bool is_array = ASRUtils::is_array(it.second);
@@ -973,34 +1057,76 @@ class DoConcurrentVisitor :
             // always this shall be IntegerBinOp_t
             ASR::expr_t* loop_length = total_iterations;
             // ASR::expr_t* loop_length = b.Add(b.Sub(loop_head.m_end, loop_head.m_start), b.i32(1));
+
+            /*
+                schedule(static, chunk), schedule(dynamic), schedule(guided)
+                and schedule(runtime) hand out the iterations with libgomp:
+
+                more = GOMP_loop_dynamic_start(0, total_iterations, 1, chunk, istart, iend)
+                do while (more)
+                    do I = istart + 1, iend
+                        ! ... some computation ...
+                    end do
+                    more = GOMP_loop_dynamic_next(istart, iend)
+                end do
+                call GOMP_loop_end_nowait()
+
+                Otherwise every thread takes one block of the iterations, as
+                computed below.
+            */
+            std::string gomp_schedule;
+            switch (do_loop.m_schedule) {
+                case ASR::schedule_typeType::ScheduleStatic: {
+                    if (do_loop.m_chunk) gomp_schedule = "static";
+                    break;
+                }
+                case ASR::schedule_typeType::ScheduleDynamic: {
+                    gomp_schedule = "dynamic";
+                    break;
+                }
+                case ASR::schedule_typeType::ScheduleGuided: {
+                    gomp_schedule = "guided";
+                    break;
+                }
+                case ASR::schedule_typeType::ScheduleRuntime: {
+                    gomp_schedule = "runtime";
+                    break;
+                }
+                default: {
+                    break;
+                }
+            }
+
             // calculate chunk size
-            body.push_back(al, b.Assignment(num_threads,
-                            ASRUtils::EXPR(ASR::make_FunctionCall_t(al, loc, current_scope->get_symbol("omp_get_max_threads"),
-                            current_scope->get_symbol("omp_get_max_threads"), nullptr, 0, ASRUtils::TYPE(ASR::make_Integer_t(al, loc, 4)), nullptr, nullptr))));
-            body.push_back(al, b.Assignment(chunk,
-                            b.Div(loop_length, num_threads)));
-            Vec<ASR::expr_t*> mod_args; mod_args.reserve(al, 2);
-            mod_args.push_back(al, loop_length);
-            mod_args.push_back(al, num_threads);
-            body.push_back(al, b.Assignment(leftovers,
-                            ASRUtils::EXPR(ASRUtils::make_IntrinsicElementalFunction_t_util(al, loc,
-                            2,
-                            mod_args.p, 2, 0, ASRUtils::expr_type(loop_length), nullptr))));
-            body.push_back(al, b.Assignment(thread_num,
-                            ASRUtils::EXPR(ASR::make_FunctionCall_t(al, loc, current_scope->get_symbol("omp_get_thread_num"),
-                            current_scope->get_symbol("omp_get_thread_num"), nullptr, 0, ASRUtils::TYPE(ASR::make_Integer_t(al, loc, 4)), nullptr, nullptr))));
-            body.push_back(al, b.Assignment(start, b.Mul(chunk, thread_num)));
-            body.push_back(al, b.If(b.Lt(thread_num, leftovers), {
-                b.Assignment(start, b.Add(start, thread_num))
-            }, {
-                b.Assignment(start, b.Add(start, leftovers))
-            }));
-            body.push_back(al, b.Assignment(end, b.Add(start, chunk)));
-            body.push_back(al, b.If(b.Lt(thread_num, leftovers), {
-                b.Assignment(end, b.Add(end, b.i32(1)))
-            }, {
-                // do nothing
-            }));
+            if (gomp_schedule.empty()) {
+                body.push_back(al, b.Assignment(num_threads,
+                                ASRUtils::EXPR(ASR::make_FunctionCall_t(al, loc, current_scope->get_symbol("omp_get_max_threads"),
+                                current_scope->get_symbol("omp_get_max_threads"), nullptr, 0, ASRUtils::TYPE(ASR::make_Integer_t(al, loc, 4)), nullptr, nullptr))));
+                body.push_back(al, b.Assignment(chunk,
+                                b.Div(loop_length, num_threads)));
+                Vec<ASR::expr_t*> mod_args; mod_args.reserve(al, 2);
+                mod_args.push_back(al, loop_length);
+                mod_args.push_back(al, num_threads);
+                body.push_back(al, b.Assignment(leftovers,
+                                ASRUtils::EXPR(ASRUtils::make_IntrinsicElementalFunction_t_util(al, loc,
+                                2,
+                                mod_args.p, 2, 0, ASRUtils::expr_type(loop_length), nullptr))));
+                body.push_back(al, b.Assignment(thread_num,
+                                ASRUtils::EXPR(ASR::make_FunctionCall_t(al, loc, current_scope->get_symbol("omp_get_thread_num"),
+                                current_scope->get_symbol("omp_get_thread_num"), nullptr, 0, ASRUtils::TYPE(ASR::make_Integer_t(al, loc, 4)), nullptr, nullptr))));
+                body.push_back(al, b.Assignment(start, b.Mul(chunk, thread_num)));
+                body.push_back(al, b.If(b.Lt(thread_num, leftovers), {
+                    b.Assignment(start, b.Add(start, thread_num))
+                }, {
+                    b.Assignment(start, b.Add(start, leftovers))
+                }));
+                body.push_back(al, b.Assignment(end, b.Add(start, chunk)));
+                body.push_back(al, b.If(b.Lt(thread_num, leftovers), {
+                    b.Assignment(end, b.Add(end, b.i32(1)))
+                }, {
+                    // do nothing
+                }));
+            }
 
             // Partioning logic ends
 
@@ -1054,7 +1180,10 @@ class DoConcurrentVisitor :
             ASR::expr_t* I = b.Variable(current_scope, "I", ASRUtils::TYPE(ASR::make_Integer_t(al, loc,
             4)),ASR::intentType::Local, ASR::abiType::BindC);
 
-            ASR::expr_t* temp_I = I;
+            // I runs from 1, the loop variables are computed from I - 1 so
+            // that consecutive I are consecutive iterations (which is what
+            // schedule(static, chunk) hands out)
+            ASR::expr_t* temp_I = b.Sub(I, b.i32(1));
             for (size_t i = 0; i < do_loop.n_head; ++i) {
                 ASR::do_loop_head_t head = do_loop.m_head[i];
                 ASR::expr_t* computed_var;
@@ -1080,7 +1209,7 @@ class DoConcurrentVisitor :
                         computed_var = b.Add(ASRUtils::EXPR(ASRUtils::make_IntrinsicElementalFunction_t_util(al,
                     loc,2,mod_args.p, 2, 0, ASRUtils::expr_type(dimension_lengths[i]), nullptr)),head.m_start);
                     } else {
-                        computed_var = b.Add(b.Div(b.Add(temp_I,b.i32(-1)), product_of_next_dimensions),head.m_start);
+                        computed_var = b.Add(b.Div(temp_I, product_of_next_dimensions),head.m_start);
                     }
                 }
 
@@ -1094,7 +1223,60 @@ class DoConcurrentVisitor :
             }
             //  Collapse Ends Here
 
-            body.push_back(al, b.DoLoop(I, b.Add(start, b.i32(1)), end, flattened_body, loop_head.m_increment));
+            // do I = <loop_start>, <loop_end>, which the backend vectorizes
+            // for `parallel do simd`
+            auto create_loop = [&](ASR::expr_t* loop_start, ASR::expr_t* loop_end) {
+                if (!do_loop.m_simd) {
+                    return b.DoLoop(I, loop_start, loop_end, flattened_body, loop_head.m_increment);
+                }
+                Vec<ASR::do_loop_head_t> heads; heads.reserve(al, 1);
+                ASR::do_loop_head_t head;
+                head.loc = loc; head.m_v = I; head.m_start = loop_start;
+                head.m_end = loop_end; head.m_increment = loop_head.m_increment;
+                heads.push_back(al, head);
+                Vec<ASR::stmt_t*> loop_body; loop_body.reserve(al, flattened_body.size());
+                for (auto &stmt: flattened_body) loop_body.push_back(al, stmt);
+                return ASRUtils::STMT(ASR::make_DoConcurrentLoop_t(al, loc, heads.p, heads.n,
+                    nullptr, 0, nullptr, 0, nullptr, 0, ASR::schedule_typeType::ScheduleSequential,
+                    nullptr, true, loop_body.p, loop_body.n));
+            };
+
+            if (gomp_schedule.empty()) {
+                body.push_back(al, create_loop(b.Add(start, b.i32(1)), end));
+            } else {
+                ASR::ttype_t* long_type = ASRUtils::TYPE(ASR::make_Integer_t(al, loc, 8));
+                ASR::expr_t* istart = b.Variable(current_scope, current_scope->get_unique_name("istart"), long_type, ASR::intentType::Local, ASR::abiType::BindC);
+                ASR::expr_t* iend = b.Variable(current_scope, current_scope->get_unique_name("iend"), long_type, ASR::intentType::Local, ASR::abiType::BindC);
+                ASR::symbol_t* start_fn = current_scope->get_symbol("gomp_loop_" + gomp_schedule + "_start");
+                ASR::symbol_t* next_fn = current_scope->get_symbol("gomp_loop_" + gomp_schedule + "_next");
+                LCOMPILERS_ASSERT(start_fn != nullptr && next_fn != nullptr);
+                ASR::ttype_t* bool_type = ASRUtils::expr_type(ASR::down_cast<ASR::Function_t>(
+                    ASRUtils::symbol_get_past_external(start_fn))->m_return_var);
+                ASR::expr_t* more = b.Variable(current_scope, current_scope->get_unique_name("more"), bool_type, ASR::intentType::Local, ASR::abiType::BindC);
+
+                Vec<ASR::expr_t*> start_args; start_args.reserve(al, 6);
+                start_args.push_back(al, b.i64(0));
+                start_args.push_back(al, b.i2i_t(loop_length, long_type));
+                start_args.push_back(al, b.i64(1));
+                if (gomp_schedule != "runtime") {
+                    // The default chunk size of dynamic and guided is 1
+                    start_args.push_back(al, do_loop.m_chunk ? b.i2i_t(do_loop.m_chunk, long_type) : b.i64(1));
+                }
+                start_args.push_back(al, istart);
+                start_args.push_back(al, iend);
+                Vec<ASR::expr_t*> next_args; next_args.reserve(al, 2);
+                next_args.push_back(al, istart);
+                next_args.push_back(al, iend);
+
+                body.push_back(al, b.Assignment(more, b.Call(start_fn, start_args, bool_type)));
+                body.push_back(al, b.While(more, {
+                    b.Assignment(start, b.i2i_t(istart, int_type)),
+                    b.Assignment(end, b.i2i_t(iend, int_type)),
+                    create_loop(b.Add(start, b.i32(1)), end),
+                    b.Assignment(more, b.Call(next_fn, next_args, bool_type))
+                }));
+                body.push_back(al, ASRUtils::STMT(ASR::make_SubroutineCall_t(al, loc, current_scope->get_symbol("gomp_loop_end_nowait"), nullptr, nullptr, 0, nullptr)));
+            }
             body.push_back(al, ASRUtils::STMT(ASR::make_SubroutineCall_t(al, loc, current_scope->get_symbol("gomp_barrier"), nullptr, nullptr, 0, nullptr)));
 
             /*
@@ -1368,6 +1550,11 @@ class DoConcurrentVisitor :
         }
 
         void visit_DoConcurrentLoop(const ASR::DoConcurrentLoop_t &x) {
+            if (x.m_schedule == ASR::schedule_typeType::ScheduleSequential) {
+                // `!$omp simd` loops run on the current thread, the
+                // do_loops pass lowers them
+                return;
+            }
             std::map<std::string, ASR::ttype_t*> involved_symbols;
 
             InvolvedSymbolsCollector c(involved_symbols);
@@ -1694,6 +1881,527 @@ class DoConcurrentVisitor :
             return;
         }
 
+        ASR::stmt_t* omp_lib_call(const Location &loc, std::string name, std::vector<ASR::expr_t*> args) {
+            ASR::symbol_t* fn = current_scope->get_symbol(name);
+            LCOMPILERS_ASSERT(fn != nullptr);
+            Vec<ASR::call_arg_t> call_args; call_args.reserve(al, args.size());
+            for (auto &arg: args) {
+                ASR::call_arg_t call_arg; call_arg.loc = loc; call_arg.m_value = arg;
+                call_args.push_back(al, call_arg);
+            }
+            return ASRUtils::STMT(ASR::make_SubroutineCall_t(al, loc, fn, nullptr,
+                call_args.p, call_args.n, nullptr));
+        }
+
+        // c_loc(x)
+        ASR::expr_t* omp_c_loc(ASR::expr_t* x) {
+            Location loc = x->base.loc;
+            ASR::ttype_t* type = ASRUtils::expr_type(x);
+            ASR::ttype_t* cptr_type = ASRUtils::TYPE(ASR::make_CPtr_t(al, loc));
+            if (ASRUtils::is_array(type) || ASR::is_a<ASR::Pointer_t>(*type)) {
+                return ASRUtils::EXPR(ASR::make_PointerToCPtr_t(al, loc, x, cptr_type, nullptr));
+            }
+            return ASRUtils::EXPR(ASR::make_PointerToCPtr_t(al, loc,
+                ASRUtils::EXPR(ASR::make_GetPointer_t(al, loc, x,
+                    ASRUtils::TYPE(ASR::make_Pointer_t(al, loc, type)), nullptr)),
+                cptr_type, nullptr));
+        }
+
+        // data%<member>, through an external symbol of the member in the
+        // current scope
+        ASR::expr_t* omp_struct_member(ASR::expr_t* data, ASR::symbol_t* thread_data_sym,
+                const std::string &member) {
+            std::string sym_name = std::string(ASRUtils::symbol_name(thread_data_sym)) + "_" + member;
+            ASR::symbol_t* sym = current_scope->get_symbol(sym_name);
+            if (sym == nullptr) {
+                sym = ASR::down_cast<ASR::symbol_t>(ASR::make_ExternalSymbol_t(al, data->base.loc,
+                    current_scope, s2c(al, sym_name), ASRUtils::symbol_symtab(thread_data_sym)->get_symbol(member),
+                    ASRUtils::symbol_name(thread_data_sym), nullptr, 0, s2c(al, member), ASR::accessType::Public));
+                current_scope->add_symbol(sym_name, sym);
+            }
+            return ASRUtils::EXPR(ASR::make_StructInstanceMember_t(al, data->base.loc, data,
+                sym, ASRUtils::symbol_type(sym), nullptr));
+        }
+
+        // The outlined procedures are contained in the procedure of the
+        // region, but their (bind(C)) names must be unique in the whole
+        // translation unit
+        std::string omp_outlined_name(const std::string &name) {
+            std::string unique_name = name;
+            int counter = 1;
+            while (omp_outlined_names.find(unique_name) != omp_outlined_names.end() ||
+                    current_scope->resolve_symbol(unique_name) != nullptr) {
+                unique_name = name + std::to_string(counter);
+                counter++;
+            }
+            omp_outlined_names.insert(unique_name);
+            return unique_name;
+        }
+
+        /*
+            The body of `!$omp parallel`, `!$omp task` and `!$omp taskloop`
+            is outlined into a procedure contained in the current one. The
+            variables it uses are passed in a thread data struct, like for
+            `!$omp parallel do`:
+
+            !$omp task shared(s) firstprivate(n)
+                s = s + n
+            !$omp end task
+
+            ------To----->
+
+            data%n = n
+            data%s = c_loc(s)
+            tdata = c_loc(data)
+            call GOMP_task(c_funloc(lcompilers_task), tdata, c_null_ptr, &
+                sizeof(data), 8, .true., 0, c_null_ptr, 0, c_null_ptr)
+
+            contains
+
+            subroutine lcompilers_task(data) bind(C)
+                type(c_ptr), value :: data
+                type(thread_data), pointer :: tdata
+                integer :: n
+                integer, pointer :: s
+                call c_f_pointer(data, tdata)
+                n = tdata%n
+                call c_f_pointer(tdata%s, s)
+                s = s + n
+            end subroutine
+
+            Shared variables are passed by address (arrays together with
+            their bounds) and firstprivate ones by value. libgomp copies the
+            struct of a deferred task, so the task sees the firstprivate
+            values from the time it was created.
+
+            The taskloop loop is normalized to `0, trip count - 1`. libgomp
+            stores the iterations of each task in the first two members of
+            its copy of the struct:
+
+            do I = tdata%lcompilers_istart, tdata%lcompilers_iend - 1
+                i = start + I*increment
+                ! ... loop body ...
+            end do
+        */
+        void outline_omp_region(const ASR::OMPRegion_t &x) {
+            Location loc = x.base.base.loc;
+            ASRUtils::ASRBuilder b(al, loc);
+            ASR::ttype_t* i32_type = ASRUtils::TYPE(ASR::make_Integer_t(al, loc, 4));
+            ASR::ttype_t* i64_type = ASRUtils::TYPE(ASR::make_Integer_t(al, loc, 8));
+            ASR::ttype_t* cptr_type = ASRUtils::TYPE(ASR::make_CPtr_t(al, loc));
+            std::string region_name;
+            switch (x.m_region) {
+                case ASR::omp_region_typeType::OMPParallel: region_name = "parallel"; break;
+                case ASR::omp_region_typeType::OMPTask: region_name = "task"; break;
+                case ASR::omp_region_typeType::OMPTaskloop: region_name = "taskloop"; break;
+                default: LCOMPILERS_ASSERT(false);
+            }
+            bool is_taskloop = x.m_region == ASR::omp_region_typeType::OMPTaskloop;
+
+            RegionSymbolsCollector c;
+            for (size_t i = 0; i < x.n_body; i++) {
+                c.visit_stmt(*x.m_body[i]);
+            }
+            auto clause_symbols = [](ASR::expr_t** vars, size_t n) {
+                std::set<ASR::symbol_t*> symbols;
+                for (size_t i = 0; i < n; i++) {
+                    symbols.insert(ASR::down_cast<ASR::Var_t>(vars[i])->m_v);
+                }
+                return symbols;
+            };
+            std::set<ASR::symbol_t*> shared_clause = clause_symbols(x.m_shared, x.n_shared);
+            std::set<ASR::symbol_t*> private_clause = clause_symbols(x.m_private, x.n_private);
+            std::set<ASR::symbol_t*> firstprivate_clause = clause_symbols(x.m_firstprivate, x.n_firstprivate);
+
+            // Data sharing: the clauses, then loop variables are private and
+            // the rest is shared in a parallel region. In a task the
+            // variables shared in the enclosing context stay shared, the
+            // others are firstprivate, except arrays, pointers and derived
+            // types which are always shared by default.
+            enum class Sharing { Shared, FirstPrivate, Private, Parameter };
+            struct RegionVariable { ASR::symbol_t* sym; Sharing sharing; ASR::ttype_t* type; };
+            std::vector<RegionVariable> variables;
+            std::map<std::string, ASR::ttype_t*> members;
+            for (auto &it: c.symbols) {
+                ASR::symbol_t* sym = it.second;
+                ASR::Variable_t* var = ASR::down_cast<ASR::Variable_t>(sym);
+                if (var->m_storage == ASR::storage_typeType::Parameter) {
+                    variables.push_back({sym, Sharing::Parameter, var->m_type});
+                    continue;
+                }
+                ASR::ttype_t* type = var->m_type;
+                bool is_array = ASRUtils::is_array(type);
+                ASR::asr_t* owner = ASRUtils::symbol_parent_symtab(sym)->asr_owner;
+                bool is_program_variable = ASR::is_a<ASR::Program_t>(*ASR::down_cast<ASR::symbol_t>(owner));
+                Sharing sharing;
+                if (shared_clause.count(sym)) {
+                    sharing = Sharing::Shared;
+                } else if (private_clause.count(sym)) {
+                    sharing = Sharing::Private;
+                } else if (firstprivate_clause.count(sym)) {
+                    sharing = Sharing::FirstPrivate;
+                } else if (c.loop_variables.count(sym)) {
+                    sharing = Sharing::Private;
+                } else if (x.m_region == ASR::omp_region_typeType::OMPParallel ||
+                        omp_shared_symbols.count(sym) || is_program_variable ||
+                        var->m_storage == ASR::storage_typeType::Save || is_array ||
+                        ASR::is_a<ASR::Pointer_t>(*type) || ASR::is_a<ASR::StructType_t>(*type)) {
+                    sharing = Sharing::Shared;
+                } else {
+                    sharing = Sharing::FirstPrivate;
+                }
+                // The shared variables of an enclosing region are pointers
+                // here, the private copies are not
+                if (sharing != Sharing::Shared && omp_shared_symbols.count(sym)) {
+                    type = ASRUtils::type_get_past_pointer(type);
+                }
+                if (sharing == Sharing::FirstPrivate && (is_array ||
+                        ASR::is_a<ASR::Pointer_t>(*type) || ASR::is_a<ASR::StructType_t>(*type))) {
+                    throw LCompilersException("OpenMP: firstprivate is not supported yet for '"
+                        + std::string(var->m_name) + "'");
+                }
+                if (sharing == Sharing::Private && is_array && !ASR::is_a<ASR::Allocatable_t>(*type) &&
+                        !ASRUtils::is_fixed_size_array(type)) {
+                    throw LCompilersException("OpenMP: private arrays must be allocatable or of constant size for now: '"
+                        + std::string(var->m_name) + "'");
+                }
+                if (sharing != Sharing::Private && (ASRUtils::is_character(*type) ||
+                        (!is_array && ASR::is_a<ASR::Allocatable_t>(*type)))) {
+                    throw LCompilersException("OpenMP: character and allocatable scalar variables must be private in a region for now: '"
+                        + std::string(var->m_name) + "'");
+                }
+                variables.push_back({sym, sharing, type});
+                if (sharing == Sharing::Shared) {
+                    members[it.first] = is_array ? type : cptr_type;
+                } else if (sharing == Sharing::FirstPrivate) {
+                    members[it.first] = type;
+                }
+            }
+
+            std::vector<std::pair<std::string, ASR::ttype_t*>> leading_members;
+            if (is_taskloop) {
+                leading_members.push_back({"lcompilers_istart", i64_type});
+                leading_members.push_back({"lcompilers_iend", i64_type});
+            }
+            std::pair<std::string, ASR::symbol_t*> thread_data_module = create_thread_data_module(members, loc, leading_members);
+            ASR::symbol_t* thread_data_sym = thread_data_module.second;
+
+            // data%n = n, data%s = c_loc(s), tdata = c_loc(data)
+            ASR::symbol_t* thread_data_ext_sym = ASR::down_cast<ASR::symbol_t>(ASR::make_ExternalSymbol_t(al, loc,
+                current_scope, ASRUtils::symbol_name(thread_data_sym), thread_data_sym, s2c(al, thread_data_module.first),
+                nullptr, 0, ASRUtils::symbol_name(thread_data_sym), ASR::accessType::Public));
+            current_scope->add_symbol(ASRUtils::symbol_name(thread_data_sym), thread_data_ext_sym);
+            ASR::ttype_t* thread_data_type = ASRUtils::TYPE(ASRUtils::make_StructType_t_util(al, loc, thread_data_ext_sym));
+            ASR::expr_t* data_expr = b.Variable(current_scope, current_scope->get_unique_name("data"), thread_data_type, ASR::intentType::Local);
+            ASR::expr_t* tdata_expr = b.Variable(current_scope, current_scope->get_unique_name("tdata"), cptr_type, ASR::intentType::Local);
+            for (auto &it: variables) {
+                if (it.sharing == Sharing::Private || it.sharing == Sharing::Parameter) {
+                    continue;
+                }
+                std::string name = to_lower(ASRUtils::symbol_name(it.sym));
+                if (it.sharing == Sharing::FirstPrivate) {
+                    pass_result.push_back(al, b.Assignment(omp_struct_member(data_expr, thread_data_sym, name), b.Var(it.sym)));
+                    continue;
+                }
+                pass_result.push_back(al, b.Assignment(omp_struct_member(data_expr, thread_data_sym, name), omp_c_loc(b.Var(it.sym))));
+                ASR::ttype_t* type = ASRUtils::symbol_type(it.sym);
+                for (size_t i = 0; ASRUtils::is_array(type) && i < ASRUtils::extract_n_dims_from_ttype(type); i++) {
+                    pass_result.push_back(al, b.Assignment(
+                        omp_struct_member(data_expr, thread_data_sym, "lbound_" + name + "_" + std::to_string(i)),
+                        b.ArrayLBound(b.Var(it.sym), i+1)));
+                    pass_result.push_back(al, b.Assignment(
+                        omp_struct_member(data_expr, thread_data_sym, "ubound_" + name + "_" + std::to_string(i)),
+                        b.ArrayUBound(b.Var(it.sym), i+1)));
+                }
+            }
+            pass_result.push_back(al, b.Assignment(tdata_expr, omp_c_loc(data_expr)));
+
+            // The trip count of the taskloop loop is computed by the caller,
+            // on a copy of the loop head as the body is moved below
+            ASR::DoLoop_t* loop = is_taskloop ? ASR::down_cast<ASR::DoLoop_t>(x.m_body[0]) : nullptr;
+            ASR::expr_t* trip_count = nullptr;
+            if (loop) {
+                ASRUtils::ExprStmtDuplicator duplicator(al);
+                ASR::ttype_t* loop_type = ASRUtils::expr_type(loop->m_head.m_v);
+                ASR::expr_t* start = duplicator.duplicate_expr(loop->m_head.m_start);
+                ASR::expr_t* end = duplicator.duplicate_expr(loop->m_head.m_end);
+                ASR::expr_t* increment = loop->m_head.m_increment ?
+                    duplicator.duplicate_expr(loop->m_head.m_increment) : b.i_t(1, loop_type);
+                trip_count = b.i2i_t(b.Div(b.Add(b.Sub(end, start), increment),
+                    duplicator.duplicate_expr(increment)), i64_type);
+            }
+
+            SymbolTable* parent_scope = current_scope;
+            std::string fn_name = omp_outlined_name("lcompilers_" + region_name);
+            omp_region_outlined = true;
+            current_scope = al.make_new<SymbolTable>(parent_scope);
+            std::map<ASR::symbol_t*, ASR::symbol_t*> symbol_map;
+            std::set<ASR::symbol_t*> shared_symbols;
+            for (auto &it: variables) {
+                ASR::ttype_t* type = ASRUtils::symbol_type(it.sym);
+                ASR::ttype_t* new_type = nullptr;
+                if (it.sharing == Sharing::Parameter) {
+                    // Parameters are copied, so that the outlined procedure
+                    // does not access its host
+                    ASR::Variable_t* var = ASR::down_cast<ASR::Variable_t>(it.sym);
+                    ASR::expr_t* value = var->m_value ? var->m_value : var->m_symbolic_value;
+                    ASR::symbol_t* parameter = ASR::down_cast<ASR::symbol_t>(ASRUtils::make_Variable_t_util(al, loc,
+                        current_scope, var->m_name, nullptr, 0, ASR::intentType::Local, value, var->m_value,
+                        ASR::storage_typeType::Parameter, ASRUtils::duplicate_type(al, type), var->m_type_declaration,
+                        var->m_abi, ASR::accessType::Private, ASR::presenceType::Required, false));
+                    current_scope->add_symbol(var->m_name, parameter);
+                    symbol_map[it.sym] = parameter;
+                    continue;
+                }
+                if (it.sharing == Sharing::Shared && ASRUtils::is_array(type)) {
+                    ASR::Array_t* array_type = ASR::down_cast<ASR::Array_t>(
+                        ASRUtils::type_get_past_allocatable(ASRUtils::type_get_past_pointer(type)));
+                    Vec<ASR::dimension_t> dims; dims.reserve(al, array_type->n_dims);
+                    for (size_t i = 0; i < array_type->n_dims; i++) {
+                        ASR::dimension_t empty_dim; empty_dim.loc = loc;
+                        empty_dim.m_start = nullptr; empty_dim.m_length = nullptr;
+                        dims.push_back(al, empty_dim);
+                    }
+                    new_type = ASRUtils::TYPE(ASR::make_Pointer_t(al, loc, ASRUtils::TYPE(ASR::make_Array_t(al, loc,
+                        array_type->m_type, dims.p, dims.n, ASR::array_physical_typeType::DescriptorArray))));
+                } else if (it.sharing == Sharing::Shared) {
+                    new_type = ASRUtils::TYPE(ASR::make_Pointer_t(al, loc,
+                        ASRUtils::duplicate_type(al, ASRUtils::type_get_past_pointer(type))));
+                } else {
+                    new_type = ASRUtils::duplicate_type(al, it.type);
+                }
+                ASR::expr_t* var = b.Variable(current_scope, ASRUtils::symbol_name(it.sym), new_type, ASR::intentType::Local);
+                symbol_map[it.sym] = ASR::down_cast<ASR::Var_t>(var)->m_v;
+                if (it.sharing == Sharing::Shared) {
+                    shared_symbols.insert(symbol_map[it.sym]);
+                }
+            }
+
+            ASR::symbol_t* fn_thread_data_sym = ASR::down_cast<ASR::symbol_t>(ASR::make_ExternalSymbol_t(al, loc,
+                current_scope, ASRUtils::symbol_name(thread_data_sym), thread_data_sym, s2c(al, thread_data_module.first),
+                nullptr, 0, ASRUtils::symbol_name(thread_data_sym), ASR::accessType::Public));
+            current_scope->add_symbol(ASRUtils::symbol_name(thread_data_sym), fn_thread_data_sym);
+            ASR::expr_t* arg = b.Variable(current_scope, current_scope->get_unique_name("data"), cptr_type,
+                ASR::intentType::Unspecified, ASR::abiType::BindC, true);
+            ASR::expr_t* tdata = b.Variable(current_scope, current_scope->get_unique_name("tdata"),
+                ASRUtils::TYPE(ASR::make_Pointer_t(al, loc, ASRUtils::TYPE(ASRUtils::make_StructType_t_util(al, loc, fn_thread_data_sym)))),
+                ASR::intentType::Local, ASR::abiType::BindC);
+
+            Vec<ASR::stmt_t*> body; body.reserve(al, variables.size() + x.n_body + 1);
+            body.push_back(al, b.CPtrToPointer(arg, tdata));
+            for (auto &it: variables) {
+                std::string name = to_lower(ASRUtils::symbol_name(it.sym));
+                ASR::expr_t* var = b.Var(symbol_map[it.sym]);
+                if (it.sharing == Sharing::FirstPrivate) {
+                    body.push_back(al, b.Assignment(var, omp_struct_member(tdata, thread_data_sym, name)));
+                } else if (it.sharing == Sharing::Shared && ASRUtils::is_array(ASRUtils::symbol_type(it.sym))) {
+                    // call c_f_pointer(tdata%a, a, [ubound...], [lbound...])
+                    size_t n_dims = ASRUtils::extract_n_dims_from_ttype(ASRUtils::symbol_type(it.sym));
+                    Vec<ASR::expr_t*> ubounds; ubounds.reserve(al, n_dims);
+                    Vec<ASR::expr_t*> lbounds; lbounds.reserve(al, n_dims);
+                    for (size_t i = 0; i < n_dims; i++) {
+                        ubounds.push_back(al, omp_struct_member(tdata, thread_data_sym, "ubound_" + name + "_" + std::to_string(i)));
+                        lbounds.push_back(al, omp_struct_member(tdata, thread_data_sym, "lbound_" + name + "_" + std::to_string(i)));
+                    }
+                    ASR::ttype_t* bounds_type = b.Array({(int64_t) n_dims}, i32_type);
+                    body.push_back(al, b.CPtrToPointer(omp_struct_member(tdata, thread_data_sym, name), var,
+                        ASRUtils::EXPR(ASRUtils::make_ArrayConstructor_t_util(al, loc, ubounds.p, ubounds.n,
+                            bounds_type, ASR::arraystorageType::ColMajor)),
+                        ASRUtils::EXPR(ASRUtils::make_ArrayConstructor_t_util(al, loc, lbounds.p, lbounds.n,
+                            bounds_type, ASR::arraystorageType::ColMajor))));
+                } else if (it.sharing == Sharing::Shared) {
+                    body.push_back(al, b.CPtrToPointer(omp_struct_member(tdata, thread_data_sym, name), var));
+                }
+            }
+
+            RegionVariablesVisitor v(symbol_map);
+            for (size_t i = 0; i < x.n_body; i++) {
+                v.visit_stmt(*x.m_body[i]);
+            }
+            if (loop) {
+                ASR::ttype_t* loop_type = ASRUtils::expr_type(loop->m_head.m_v);
+                ASR::expr_t* increment = loop->m_head.m_increment ? loop->m_head.m_increment : b.i_t(1, loop_type);
+                ASR::expr_t* iteration = b.Variable(current_scope, current_scope->get_unique_name("lcompilers_i"),
+                    i64_type, ASR::intentType::Local);
+                Vec<ASR::stmt_t*> loop_body; loop_body.reserve(al, loop->n_body + 1);
+                loop_body.push_back(al, b.Assignment(loop->m_head.m_v,
+                    b.Add(loop->m_head.m_start, b.Mul(b.i2i_t(iteration, loop_type), increment))));
+                for (size_t i = 0; i < loop->n_body; i++) {
+                    loop_body.push_back(al, loop->m_body[i]);
+                }
+                ASR::do_loop_head_t head; head.loc = loop->m_head.loc;
+                head.m_v = iteration;
+                head.m_start = omp_struct_member(tdata, thread_data_sym, "lcompilers_istart");
+                head.m_end = b.Sub(omp_struct_member(tdata, thread_data_sym, "lcompilers_iend"), b.i64(1));
+                head.m_increment = nullptr;
+                body.push_back(al, ASRUtils::STMT(ASR::make_DoLoop_t(al, loop->base.base.loc, loop->m_name,
+                    head, loop_body.p, loop_body.n, loop->m_orelse, loop->n_orelse)));
+            } else {
+                for (size_t i = 0; i < x.n_body; i++) {
+                    body.push_back(al, x.m_body[i]);
+                }
+            }
+
+            Vec<ASR::expr_t*> args; args.reserve(al, 1);
+            args.push_back(al, arg);
+            ASR::symbol_t* fn = ASR::down_cast<ASR::symbol_t>(ASRUtils::make_Function_t_util(al, loc,
+                current_scope, s2c(al, fn_name), nullptr, 0, args.p, args.n, body.p, body.n,
+                nullptr, ASR::abiType::BindC, ASR::accessType::Public, ASR::deftypeType::Implementation,
+                nullptr, false, false, false, false, false, nullptr, 0, false, false, false, nullptr));
+            parent_scope->add_symbol(fn_name, fn);
+
+            // Lower the regions nested in the outlined procedure, this reuses
+            // pass_result
+            ASR::Function_t* outlined_fn = ASR::down_cast<ASR::Function_t>(fn);
+            Vec<ASR::stmt_t*> caller_stmts;
+            caller_stmts.from_pointer_n_copy(al, pass_result.p, pass_result.size());
+            std::set<ASR::symbol_t*> omp_shared_symbols_copy = omp_shared_symbols;
+            omp_shared_symbols = shared_symbols;
+            transform_stmts(outlined_fn->m_body, outlined_fn->n_body);
+            omp_shared_symbols = omp_shared_symbols_copy;
+            pass_result.n = 0;
+            for (size_t i = 0; i < caller_stmts.size(); i++) {
+                pass_result.push_back(al, caller_stmts[i]);
+            }
+            PassUtils::UpdateDependenciesVisitor dependencies(al);
+            dependencies.visit_Function(*outlined_fn);
+            current_scope = parent_scope;
+
+            // c_funloc(lcompilers_task)
+            ASR::expr_t* fn_ptr = ASRUtils::EXPR(ASR::make_PointerToCPtr_t(al, loc,
+                ASRUtils::EXPR(ASR::make_GetPointer_t(al, loc, b.Var(fn),
+                    ASRUtils::TYPE(ASR::make_Pointer_t(al, loc, outlined_fn->m_function_signature)), nullptr)),
+                cptr_type, nullptr));
+            ASR::expr_t* arg_size = ASRUtils::EXPR(ASR::make_SizeOfType_t(al, loc, thread_data_type, i64_type, nullptr));
+            switch (x.m_region) {
+                case ASR::omp_region_typeType::OMPParallel: {
+                    ASR::expr_t* num_threads = x.m_num_threads ? b.i2i_t(x.m_num_threads, i32_type) : b.i32(0);
+                    pass_result.push_back(al, omp_lib_call(loc, "gomp_parallel", {fn_ptr, tdata_expr, num_threads, b.i32(0)}));
+                    break;
+                }
+                case ASR::omp_region_typeType::OMPTask: {
+                    ASR::expr_t* depend = ASRUtils::EXPR(ASR::make_PointerNullConstant_t(al, loc, cptr_type));
+                    int flags = 0;
+                    if (x.n_depend > 0) {
+                        // The dependences as expected by libgomp: their
+                        // number, the number of out (and inout) ones and
+                        // then the addresses, out ones first
+                        flags |= 8; // GOMP_TASK_FLAG_DEPEND
+                        std::vector<ASR::expr_t*> addresses;
+                        for (size_t i = 0; i < x.n_depend; i++) {
+                            if (x.m_depend[i].m_kind != ASR::omp_depend_typeType::DependIn) {
+                                addresses.push_back(omp_c_loc(x.m_depend[i].m_arg));
+                            }
+                        }
+                        size_t n_out = addresses.size();
+                        for (size_t i = 0; i < x.n_depend; i++) {
+                            if (x.m_depend[i].m_kind == ASR::omp_depend_typeType::DependIn) {
+                                addresses.push_back(omp_c_loc(x.m_depend[i].m_arg));
+                            }
+                        }
+                        ASR::expr_t* deps = b.Variable(current_scope, current_scope->get_unique_name("depend"),
+                            b.Array({(int64_t) addresses.size() + 2}, cptr_type), ASR::intentType::Local);
+                        ASR::ttype_t* u64_type = ASRUtils::TYPE(ASR::make_UnsignedInteger_t(al, loc, 8));
+                        auto deps_item = [&](int64_t i) {
+                            Vec<ASR::array_index_t> args; args.reserve(al, 1);
+                            ASR::array_index_t index; index.loc = loc;
+                            index.m_left = nullptr; index.m_right = b.i32(i); index.m_step = nullptr;
+                            args.push_back(al, index);
+                            return ASRUtils::EXPR(ASR::make_ArrayItem_t(al, loc, deps, args.p, args.n,
+                                cptr_type, ASR::arraystorageType::ColMajor, nullptr));
+                        };
+                        size_t counts[2] = {addresses.size(), n_out};
+                        for (size_t i = 0; i < 2; i++) {
+                            pass_result.push_back(al, b.Assignment(deps_item(i + 1),
+                                ASRUtils::EXPR(ASR::make_Cast_t(al, loc,
+                                    ASRUtils::EXPR(ASR::make_UnsignedIntegerConstant_t(al, loc, counts[i], u64_type)),
+                                    ASR::cast_kindType::UnsignedIntegerToCPtr, cptr_type, nullptr))));
+                        }
+                        for (size_t i = 0; i < addresses.size(); i++) {
+                            pass_result.push_back(al, b.Assignment(deps_item(i + 3), addresses[i]));
+                        }
+                        depend = omp_c_loc(deps);
+                    }
+                    ASR::Function_t* gomp_task = ASR::down_cast<ASR::Function_t>(
+                        ASRUtils::symbol_get_past_external(current_scope->get_symbol("gomp_task")));
+                    ASR::expr_t* if_clause = ASRUtils::EXPR(ASR::make_LogicalConstant_t(al, loc, true,
+                        ASRUtils::expr_type(gomp_task->m_args[5])));
+                    pass_result.push_back(al, omp_lib_call(loc, "gomp_task", {fn_ptr, tdata_expr,
+                        ASRUtils::EXPR(ASR::make_PointerNullConstant_t(al, loc, cptr_type)), arg_size, b.i64(8),
+                        if_clause, b.i32(flags), depend, b.i32(0),
+                        ASRUtils::EXPR(ASR::make_PointerNullConstant_t(al, loc, cptr_type))}));
+                    break;
+                }
+                case ASR::omp_region_typeType::OMPTaskloop: {
+                    // GOMP_TASK_FLAG_UP | GOMP_TASK_FLAG_IF, with
+                    // GOMP_TASK_FLAG_GRAINSIZE the num_tasks argument is
+                    // the grainsize
+                    int flags = 256 | 1024;
+                    ASR::expr_t* num_tasks = b.i64(0);
+                    if (x.m_grainsize) {
+                        flags |= 512;
+                        num_tasks = b.i2i_t(x.m_grainsize, i64_type);
+                    } else if (x.m_num_tasks) {
+                        num_tasks = b.i2i_t(x.m_num_tasks, i64_type);
+                    }
+                    pass_result.push_back(al, omp_lib_call(loc, "gomp_taskloop", {fn_ptr, tdata_expr,
+                        ASRUtils::EXPR(ASR::make_PointerNullConstant_t(al, loc, cptr_type)), arg_size, b.i64(8),
+                        b.i32(flags), num_tasks, b.i32(0), b.i64(0), trip_count, b.i64(1)}));
+                    break;
+                }
+                default: LCOMPILERS_ASSERT(false);
+            }
+        }
+
+        void visit_OMPRegion(const ASR::OMPRegion_t &x) {
+            Location loc = x.base.base.loc;
+            ASRUtils::ASRBuilder b(al, loc);
+            ASR::symbol_t* mod_sym = create_module(loc, "omp_lib");
+            LCOMPILERS_ASSERT(mod_sym != nullptr && ASR::is_a<ASR::Module_t>(*mod_sym));
+            std::string unsupported_sym_name = import_all(ASR::down_cast<ASR::Module_t>(mod_sym));
+            LCOMPILERS_ASSERT(unsupported_sym_name == "");
+
+            switch (x.m_region) {
+                case ASR::omp_region_typeType::OMPTaskwait: {
+                    pass_result.push_back(al, omp_lib_call(loc, "gomp_taskwait", {}));
+                    break;
+                }
+                case ASR::omp_region_typeType::OMPSingle:
+                case ASR::omp_region_typeType::OMPMaster: {
+                    /*
+                        if (GOMP_single_start()) then      if (omp_get_thread_num() == 0) then
+                            ! ... body ...                     ! ... body ...
+                        end if                             end if
+                        call GOMP_barrier()
+                    */
+                    ASR::OMPRegion_t& xx = const_cast<ASR::OMPRegion_t&>(x);
+                    transform_stmts_do_loop(xx.m_body, xx.n_body);
+                    std::vector<ASR::stmt_t*> body(xx.m_body, xx.m_body + xx.n_body);
+                    ASR::expr_t* cond = nullptr;
+                    if (x.m_region == ASR::omp_region_typeType::OMPSingle) {
+                        ASR::symbol_t* single_start = current_scope->get_symbol("gomp_single_start");
+                        ASR::ttype_t* bool_type = ASRUtils::expr_type(ASR::down_cast<ASR::Function_t>(
+                            ASRUtils::symbol_get_past_external(single_start))->m_return_var);
+                        Vec<ASR::expr_t*> args; args.reserve(al, 1);
+                        cond = b.Call(single_start, args, bool_type);
+                    } else {
+                        ASR::symbol_t* thread_num = current_scope->get_symbol("omp_get_thread_num");
+                        Vec<ASR::expr_t*> args; args.reserve(al, 1);
+                        cond = b.Eq(b.Call(thread_num, args, ASRUtils::TYPE(ASR::make_Integer_t(al, loc, 4))), b.i32(0));
+                    }
+                    pass_result.push_back(al, b.If(cond, body, {}));
+                    if (x.m_region == ASR::omp_region_typeType::OMPSingle) {
+                        pass_result.push_back(al, omp_lib_call(loc, "gomp_barrier", {}));
+                    }
+                    break;
+                }
+                default: {
+                    outline_omp_region(x);
+                }
+            }
+            remove_original_statement = true;
+        }
+
         void visit_Function(const ASR::Function_t &x) {
             // FIXME: this is a hack, we need to pass in a non-const `x`,
             // which requires to generate a TransformVisitor.
@@ -1705,7 +2413,16 @@ class DoConcurrentVisitor :
                 this->visit_symbol(*item.second);
             }
 
+            bool omp_region_outlined_copy = omp_region_outlined;
+            omp_region_outlined = false;
             transform_stmts(xx.m_body, xx.n_body);
+            if (omp_region_outlined) {
+                // The calls in the outlined regions are now made by the
+                // outlined procedures
+                PassUtils::UpdateDependenciesVisitor dependencies(al);
+                dependencies.visit_Function(xx);
+            }
+            omp_region_outlined = omp_region_outlined_copy;
             current_scope = current_scope_copy;
         }
 
@@ -1751,6 +2468,24 @@ class DoConcurrentVisitor :
             transform_stmts_do_loop(xx.m_orelse, xx.n_orelse);
         }
 
+        void visit_If(const ASR::If_t &x) {
+            ASR::If_t& xx = const_cast<ASR::If_t&>(x);
+
+            visit_expr(*xx.m_test);
+
+            transform_stmts_do_loop(xx.m_body, xx.n_body);
+            transform_stmts_do_loop(xx.m_orelse, xx.n_orelse);
+        }
+
+        void visit_WhileLoop(const ASR::WhileLoop_t &x) {
+            ASR::WhileLoop_t& xx = const_cast<ASR::WhileLoop_t&>(x);
+
+            visit_expr(*xx.m_test);
+
+            transform_stmts_do_loop(xx.m_body, xx.n_body);
+            transform_stmts_do_loop(xx.m_orelse, xx.n_orelse);
+        }
+
 };
 
 void pass_replace_openmp(Allocator &al, ASR::TranslationUnit_t &unit,
@@ -89,7 +89,7 @@ public:
         loop_body.push_back(al, loop_stmt);
 
         loop_stmt = ASRUtils::STMT(ASR::make_WhileLoop_t(
-            al, loc, nullptr, loop_test, loop_body.p, loop_body.n, nullptr, 0));
+            al, loc, nullptr, loop_test, loop_body.p, loop_body.n, nullptr, 0, false));
         body.push_back(al, loop_stmt);
     }
 
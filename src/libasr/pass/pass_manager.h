@@ -55,24 +55,25 @@
 #include <libasr/pass/array_struct_temporary.h>
 #include <libasr/pass/replace_print_struct_type.h>
 #include <libasr/pass/promote_allocatable_to_nonallocatable.h>
+#include <libasr/pass/hoist_array_temporaries.h>
 #include <libasr/pass/replace_function_call_in_declaration.h>
 #include <libasr/pass/replace_array_passed_in_function_call.h>
 #include <libasr/pass/replace_openmp.h>
+#include <libasr/pass/instrument.h>
 #include <libasr/pass/replace_with_compile_time_values.h>
+#include <libasr/pass/function_local_passes.h>
 #include <libasr/codegen/asr_to_fortran.h>
 #include <libasr/asr_verify.h>
 #include <libasr/pickle.h>
 
 #include <map>
+#include <set>
 #include <vector>
 #include <algorithm>
 #include <fstream>
 
 namespace LCompilers {
 
-    typedef void (*pass_function)(Allocator&, ASR::TranslationUnit_t&,
-                                  const LCompilers::PassOptions&);
-
     class PassManager {
         private:
 
@@ -115,16 +116,43 @@ namespace LCompilers {
             {"function_call_in_declaration", &pass_replace_function_call_in_declaration},
             {"array_passed_in_function_call", &pass_replace_array_passed_in_function_call},
             {"openmp", &pass_replace_openmp},
+            {"instrument", &pass_instrument},
             {"print_struct_type", &pass_replace_print_struct_type},
             {"unique_symbols", &pass_unique_symbols},
             {"insert_deallocate", &pass_insert_deallocate},
             {"promote_allocatable_to_nonallocatable", &pass_promote_allocatable_to_nonallocatable},
+            {"hoist_array_temporaries", &pass_hoist_array_temporaries},
             {"array_struct_temporary", &pass_array_struct_temporary}
         };
+        // Passes that only rewrite the body of the procedure they visit and
+        // only add symbols to its own scope. With `pass_threads > 1` these
+        // are applied to all procedures in parallel, all other passes act
+        // as barriers and run over the whole translation unit.
+        std::set<std::string> _function_local_passes = {
+            "do_loops",
+            "while_else",
+            "select_case",
+            "where",
+            "print_arr",
+            "array_dim_intrinsics_update",
+            "dead_code_removal",
+            "hoist_array_temporaries"
+        };
 
         bool apply_default_passes;
         bool c_skip_pass; // This will contain the passes that are to be skipped in C
 
+        void apply_pass(Allocator& al, ASR::TranslationUnit_t* asr,
+                        const std::string& pass, PassOptions& pass_options) {
+            if (pass_options.pass_threads > 1 &&
+                    _function_local_passes.find(pass) != _function_local_passes.end()) {
+                apply_function_local_pass(al, *asr, _passes_db[pass],
+                    pass_options, pass_options.pass_threads);
+            } else {
+                _passes_db[pass](al, *asr, pass_options);
+            }
+        }
+
         public:
         // This should be removed after a refactor to `pass_manager.h` (This action should be done using more flexible function)
         std::vector<std::string> passes_to_skip_with_llvm;
@@ -186,7 +214,7 @@ namespace LCompilers {
                     std::cerr << "ASR Pass starts: '" << passes[i] << "'\n";
                 }
                 auto t1 = std::chrono::high_resolution_clock::now();
-                _passes_db[passes[i]](al, *asr, pass_options);
+                apply_pass(al, asr, passes[i], pass_options);
 #if defined(WITH_LFORTRAN_ASSERT)
                 if (!asr_verify(*asr, true, diagnostics)) {
                     std::cerr << diagnostics.render2();
@@ -244,6 +272,7 @@ namespace LCompilers {
                 "global_stmts",
                 "init_expr",
                 "function_call_in_declaration",
+                "instrument",
                 "openmp",
                 "implied_do_loops",
                 "array_struct_temporary",
@@ -281,8 +310,9 @@ namespace LCompilers {
                 "sign_from_value",
                 "div_to_mul",
                 "fma",
-                // "inline_function_calls",
-                "promote_allocatable_to_nonallocatable"
+                "inline_function_calls",
+                "promote_allocatable_to_nonallocatable",
+                "hoist_array_temporaries"
             };
 
             // These are re-write passes which are already handled
@@ -360,7 +390,7 @@ namespace LCompilers {
                 if (pass_options.verbose) {
                     std::cerr << "ASR Pass starts: '" << passes[i] << "'\n";
                 }
-                _passes_db[passes[i]](al, *asr, pass_options);
+                apply_pass(al, asr, passes[i], pass_options);
                 if (pass_options.dump_all_passes) {
                     std::string str_i = std::to_string(pass_cnt_asr_dump+1);
                     if ( pass_cnt_asr_dump < 9 )  str_i = "0" + str_i;
@@ -1275,7 +1275,8 @@ namespace LCompilers {
         }
 
         Vec<ASR::stmt_t*> replace_doloop(Allocator &al, const ASR::DoLoop_t &loop,
-                                         int comp, bool use_loop_variable_after_loop) {
+                                         int comp, bool use_loop_variable_after_loop,
+                                         bool vectorize) {
             Location loc = loop.base.base.loc;
             ASR::expr_t *a=loop.m_head.m_start;
             ASR::expr_t *b=loop.m_head.m_end;
@@ -1422,7 +1423,7 @@ namespace LCompilers {
             }
 
             ASR::stmt_t *while_loop_stmt = ASRUtils::STMT(ASR::make_WhileLoop_t(al, loc,
-                loop.m_name, cond, body.p, body.size(), loop.m_orelse, loop.n_orelse));
+                loop.m_name, cond, body.p, body.size(), loop.m_orelse, loop.n_orelse, vectorize));
             Vec<ASR::stmt_t*> result;
             result.reserve(al, 2);
             if( loop_init_stmt ) {
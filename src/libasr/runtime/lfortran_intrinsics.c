@@ -94,6 +94,40 @@ struct Stacktrace {
     #define INT64 "%ld"
 #endif
 
+/*
+ * A spin lock for the short critical sections around the global state of the
+ * runtime (open units, the random number seed), so that OpenMP threads can
+ * call into the runtime at the same time.
+ */
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define LFORTRAN_THREAD_LOCAL __declspec(thread)
+typedef volatile long lfortran_lock_t;
+
+static inline void lfortran_lock(lfortran_lock_t* flag) {
+    while (_InterlockedExchange(flag, 1)) {
+        while (*flag) {}
+    }
+}
+
+static inline void lfortran_unlock(lfortran_lock_t* flag) {
+    _InterlockedExchange(flag, 0);
+}
+#else
+#define LFORTRAN_THREAD_LOCAL __thread
+typedef volatile char lfortran_lock_t;
+
+static inline void lfortran_lock(lfortran_lock_t* flag) {
+    while (__atomic_test_and_set(flag, __ATOMIC_ACQUIRE)) {
+        while (__atomic_load_n(flag, __ATOMIC_RELAXED)) {}
+    }
+}
+
+static inline void lfortran_unlock(lfortran_lock_t* flag) {
+    __atomic_clear(flag, __ATOMIC_RELEASE);
+}
+#endif
+
 // This function performs case insensitive string comparison
 bool streql(const char *s1, const char* s2) {
 #if defined(_MSC_VER)
@@ -113,17 +147,689 @@ LFORTRAN_API double _lfortran_sum(int n, double *v)
     return r;
 }
 
+/*
+ * Kernels for the array intrinsics matmul, dot_product, sum and transpose.
+ *
+ * The intrinsic_function pass calls these when every array operand is
+ * contiguous and of real or complex type; strided arrays keep the generic
+ * loops generated in ASR. All arrays are column major.
+ *
+ * matmul follows the usual GotoBLAS/BLIS structure: B is packed into a
+ * KC x NC panel and A into an MC x KC block, both laid out in the order the
+ * micro-kernel reads them, and the micro-kernel keeps an MR x NR tile of C in
+ * vector registers while it walks the KC dimension. The micro-kernels are
+ * written with GCC vector extensions, and are compiled once per instruction
+ * set; the widest one the CPU supports is picked on the first call. Complex
+ * products are carried out as four real products on split real and imaginary
+ * parts.
+ *
+ * If the program is linked with a BLAS library (`lfortran --blas=openblas`),
+ * its ?gemm_ routine is used instead.
+ */
+
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(_MSC_VER)
+#  define LFORTRAN_VECTOR_KERNELS
+#endif
+
+#if defined(LFORTRAN_VECTOR_KERNELS) && defined(__x86_64__) \
+        && !defined(COMPILE_TO_WASM)
+#  define LFORTRAN_X86_KERNELS
+#endif
+
+#if defined(LFORTRAN_VECTOR_KERNELS) && defined(__ELF__) \
+        && !defined(COMPILE_TO_WASM)
+#  define LFORTRAN_BLAS_HOOK
+/* Resolved only when the program is linked with a BLAS library */
+extern void dgemm_(const char *, const char *, const int *, const int *,
+    const int *, const double *, const double *, const int *, const double *,
+    const int *, const double *, double *, const int *) __attribute__((weak));
+extern void sgemm_(const char *, const char *, const int *, const int *,
+    const int *, const float *, const float *, const int *, const float *,
+    const int *, const float *, float *, const int *) __attribute__((weak));
+extern void zgemm_(const char *, const char *, const int *, const int *,
+    const int *, const void *, const void *, const int *, const void *,
+    const int *, const void *, void *, const int *) __attribute__((weak));
+extern void cgemm_(const char *, const char *, const int *, const int *,
+    const int *, const void *, const void *, const int *, const void *,
+    const int *, const void *, void *, const int *) __attribute__((weak));
+#endif
+
+/* Returns `size` bytes aligned to 64 bytes, to be released by
+ * _lfortran_kernel_free */
+static void *_lfortran_kernel_alloc(size_t size)
+{
+    char *p = (char *) malloc(size + 64);
+    char *aligned;
+    if (p == NULL) {
+        fprintf(stderr, "Out of memory in an array intrinsic\n");
+        exit(1);
+    }
+    aligned = (char *) (((uintptr_t) p + 64) & ~(uintptr_t) 63);
+    aligned[-1] = (char) (aligned - p);
+    return aligned;
+}
+
+static void _lfortran_kernel_free(void *p)
+{
+    if (p != NULL) {
+        free((char *) p - ((char *) p)[-1]);
+    }
+}
+
+/* Shape of a gemm micro-kernel and the cache blocking that goes with it */
+#define LF_GEMM_PARAMS_STRUCT(T, S)                                            \
+typedef void (*_lfortran_##S##gemm_ukernel_t)(int64_t kc, const T *a,          \
+    const T *b, T *c, int64_t ldc, int64_t mr, int64_t nr);                    \
+struct _lfortran_##S##gemm_params {                                            \
+    int64_t mr, nr, mc, kc, nc;                                                \
+    _lfortran_##S##gemm_ukernel_t ukernel;                                     \
+};
+
+LF_GEMM_PARAMS_STRUCT(double, d)
+LF_GEMM_PARAMS_STRUCT(float, s)
+
+/* 2 if the CPU has AVX-512, 1 if it has AVX2 and FMA, 0 otherwise */
+static int _lfortran_simd_level()
+{
+#ifdef LFORTRAN_X86_KERNELS
+    static int level = -1;
+    if (level < 0) {
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx512f")) {
+            level = 2;
+        } else if (__builtin_cpu_supports("avx2")
+                && __builtin_cpu_supports("fma")) {
+            level = 1;
+        } else {
+            level = 0;
+        }
+    }
+    return level;
+#else
+    return 0;
+#endif
+}
+
+#ifdef LFORTRAN_VECTOR_KERNELS
+
+/*
+ * Defines a micro-kernel computing C(0:mr-1, 0:nr-1) += A * B for an MR x NR
+ * tile, where MR is two vectors of VT. `a` holds kc columns of MR elements
+ * and `b` kc rows of NR elements, as packed by _lfortran_?gemm_pack_[ab].
+ * Edge tiles (mr < MR or nr < NR) are computed in full on zero padded panels
+ * and only their valid part is added to C.
+ */
+#define LF_GEMM_UKERNEL(NAME, T, VT, NR, ATTR)                                 \
+ATTR static void NAME(int64_t kc, const T *a, const T *b, T *c,                \
+        int64_t ldc, int64_t mr, int64_t nr)                                   \
+{                                                                              \
+    enum { VL = sizeof(VT) / sizeof(T), MR = 2 * VL };                         \
+    VT c0[NR], c1[NR];                                                         \
+    int64_t p, i, j;                                                           \
+    _Pragma("GCC unroll 16")                                                   \
+    for (j = 0; j < NR; j++) {                                                 \
+        c0[j] = (VT) {0};                                                      \
+        c1[j] = (VT) {0};                                                      \
+    }                                                                          \
+    for (p = 0; p < kc; p++) {                                                 \
+        VT a0 = *(const VT *) (a + p * MR);                                    \
+        VT a1 = *(const VT *) (a + p * MR + VL);                               \
+        _Pragma("GCC unroll 16")                                               \
+        for (j = 0; j < NR; j++) {                                             \
+            T bj = b[p * NR + j];                                              \
+            c0[j] += a0 * bj;                                                  \
+            c1[j] += a1 * bj;                                                  \
+        }                                                                      \
+    }                                                                          \
+    if (mr == MR && nr == NR) {                                                \
+        _Pragma("GCC unroll 16")                                               \
+        for (j = 0; j < NR; j++) {                                             \
+            VT t0, t1;                                                         \
+            memcpy(&t0, c + j * ldc, sizeof(VT));                              \
+            memcpy(&t1, c + j * ldc + VL, sizeof(VT));                         \
+            t0 += c0[j];                                                       \
+            t1 += c1[j];                                                       \
+            memcpy(c + j * ldc, &t0, sizeof(VT));                              \
+            memcpy(c + j * ldc + VL, &t1, sizeof(VT));                         \
+        }                                                                      \
+    } else {                                                                   \
+        T tile[NR][MR];                                                        \
+        for (j = 0; j < NR; j++) {                                             \
+            memcpy(&tile[j][0], &c0[j], sizeof(VT));                           \
+            memcpy(&tile[j][VL], &c1[j], sizeof(VT));                          \
+        }                                                                      \
+        for (j = 0; j < nr; j++) {                                             \
+            for (i = 0; i < mr; i++) {                                         \
+                c[j * ldc + i] += tile[j][i];                                  \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+}
+
+typedef double _lfortran_v2d __attribute__((vector_size(16)));
+typedef float _lfortran_v4s __attribute__((vector_size(16)));
+LF_GEMM_UKERNEL(_lfortran_dgemm_ukernel, double, _lfortran_v2d, 4, )
+LF_GEMM_UKERNEL(_lfortran_sgemm_ukernel, float, _lfortran_v4s, 4, )
+
+#ifdef LFORTRAN_X86_KERNELS
+typedef double _lfortran_v4d __attribute__((vector_size(32)));
+typedef double _lfortran_v8d __attribute__((vector_size(64)));
+typedef float _lfortran_v8s __attribute__((vector_size(32)));
+typedef float _lfortran_v16s __attribute__((vector_size(64)));
+LF_GEMM_UKERNEL(_lfortran_dgemm_ukernel_avx2, double, _lfortran_v4d, 6,
+    __attribute__((target("avx2,fma"))))
+LF_GEMM_UKERNEL(_lfortran_sgemm_ukernel_avx2, float, _lfortran_v8s, 6,
+    __attribute__((target("avx2,fma"))))
+LF_GEMM_UKERNEL(_lfortran_dgemm_ukernel_avx512, double, _lfortran_v8d, 12,
+    __attribute__((target("avx512f,fma"))))
+LF_GEMM_UKERNEL(_lfortran_sgemm_ukernel_avx512, float, _lfortran_v16s, 12,
+    __attribute__((target("avx512f,fma"))))
+#endif
+
+#else
+
+/* Portable fallback: a 4 x 4 tile of C in scalars */
+#define LF_GEMM_UKERNEL_SCALAR(NAME, T)                                        \
+static void NAME(int64_t kc, const T *a, const T *b, T *c,                     \
+        int64_t ldc, int64_t mr, int64_t nr)                                   \
+{                                                                              \
+    T tile[4][4] = {{0}};                                                      \
+    int64_t p, i, j;                                                           \
+    for (p = 0; p < kc; p++) {                                                 \
+        for (j = 0; j < 4; j++) {                                              \
+            for (i = 0; i < 4; i++) {                                          \
+                tile[j][i] += a[p * 4 + i] * b[p * 4 + j];                     \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+    for (j = 0; j < nr; j++) {                                                 \
+        for (i = 0; i < mr; i++) {                                             \
+            c[j * ldc + i] += tile[j][i];                                      \
+        }                                                                      \
+    }                                                                          \
+}
+
+LF_GEMM_UKERNEL_SCALAR(_lfortran_dgemm_ukernel, double)
+LF_GEMM_UKERNEL_SCALAR(_lfortran_sgemm_ukernel, float)
+
+#endif
+
+/*
+ * Defines the packing routines and the blocked driver computing
+ * C(m, n) += A(m, k) * B(k, n) with leading dimensions lda, ldb and ldc.
+ */
+#define LF_GEMM_DRIVER(T, S)                                                   \
+static void _lfortran_##S##gemm_pack_a(int64_t mc, int64_t kc, const T *a,     \
+        int64_t lda, int64_t mr, T *buf)                                       \
+{                                                                              \
+    int64_t ir, p, i;                                                          \
+    for (ir = 0; ir < mc; ir += mr) {                                          \
+        int64_t rows = mc - ir < mr ? mc - ir : mr;                            \
+        for (p = 0; p < kc; p++) {                                             \
+            const T *col = a + p * lda + ir;                                   \
+            for (i = 0; i < rows; i++) buf[i] = col[i];                        \
+            for (; i < mr; i++) buf[i] = 0;                                    \
+            buf += mr;                                                         \
+        }                                                                      \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static void _lfortran_##S##gemm_pack_b(int64_t kc, int64_t nc, const T *b,     \
+        int64_t ldb, int64_t nr, T *buf)                                       \
+{                                                                              \
+    int64_t jr, p, j;                                                          \
+    for (jr = 0; jr < nc; jr += nr) {                                          \
+        int64_t cols = nc - jr < nr ? nc - jr : nr;                            \
+        for (p = 0; p < kc; p++) {                                             \
+            for (j = 0; j < cols; j++) buf[j] = b[(jr + j) * ldb + p];         \
+            for (; j < nr; j++) buf[j] = 0;                                    \
+            buf += nr;                                                         \
+        }                                                                      \
+    }                                                                          \
+}                                                                              \
+                                                                               \
+static void _lfortran_##S##gemm_acc(const struct _lfortran_##S##gemm_params *q,\
+        int64_t m, int64_t n, int64_t k, const T *a, int64_t lda,              \
+        const T *b, int64_t ldb, T *c, int64_t ldc)                            \
+{                                                                              \
+    int64_t mc_max = m < q->mc ? m : q->mc;                                    \
+    int64_t kc_max = k < q->kc ? k : q->kc;                                    \
+    int64_t nc_max = n < q->nc ? n : q->nc;                                    \
+    int64_t jc, pc, ic, jr, ir;                                                \
+    T *abuf, *bbuf;                                                            \
+    if (m == 0 || n == 0 || k == 0) return;                                    \
+    abuf = (T *) _lfortran_kernel_alloc(sizeof(T) *                            \
+        ((mc_max + q->mr - 1) / q->mr * q->mr) * kc_max);                      \
+    bbuf = (T *) _lfortran_kernel_alloc(sizeof(T) *                            \
+        ((nc_max + q->nr - 1) / q->nr * q->nr) * kc_max);                      \
+    for (jc = 0; jc < n; jc += q->nc) {                                        \
+        int64_t nc = n - jc < q->nc ? n - jc : q->nc;                          \
+        for (pc = 0; pc < k; pc += q->kc) {                                    \
+            int64_t kc = k - pc < q->kc ? k - pc : q->kc;                      \
+            _lfortran_##S##gemm_pack_b(kc, nc, b + jc * ldb + pc, ldb,         \
+                q->nr, bbuf);                                                  \
+            for (ic = 0; ic < m; ic += q->mc) {                                \
+                int64_t mc = m - ic < q->mc ? m - ic : q->mc;                  \
+                _lfortran_##S##gemm_pack_a(mc, kc, a + pc * lda + ic, lda,     \
+                    q->mr, abuf);                                              \
+                for (jr = 0; jr < nc; jr += q->nr) {                           \
+                    int64_t nr = nc - jr < q->nr ? nc - jr : q->nr;            \
+                    for (ir = 0; ir < mc; ir += q->mr) {                       \
+                        int64_t mr = mc - ir < q->mr ? mc - ir : q->mr;        \
+                        q->ukernel(kc, abuf + ir * kc, bbuf + jr * kc,         \
+                            c + (jc + jr) * ldc + ic + ir, ldc, mr, nr);       \
+                    }                                                          \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+    }                                                                          \
+    _lfortran_kernel_free(abuf);                                               \
+    _lfortran_kernel_free(bbuf);                                               \
+}
+
+LF_GEMM_DRIVER(double, d)
+LF_GEMM_DRIVER(float, s)
+
+/*
+ * Defines DOT(n, x, y) returning the dot product of x and y, and
+ * SUM(n, x, sums) which sums the even and the odd elements of x
+ * separately, i.e. the real and imaginary parts of a complex array.
+ */
+#ifdef LFORTRAN_VECTOR_KERNELS
+#define LF_REDUCE_KERNELS(DOT, SUM, T, VT, ATTR)                               \
+ATTR static T DOT(int64_t n, const T *x, const T *y)                          \
+{                                                                              \
+    enum { VL = sizeof(VT) / sizeof(T) };                                      \
+    VT s0 = {0}, s1 = {0}, s2 = {0}, s3 = {0}, x0, x1, x2, x3, y0, y1, y2, y3; \
+    int64_t i = 0, j;                                                          \
+    T r = 0;                                                                   \
+    for (; i + 4 * VL <= n; i += 4 * VL) {                                     \
+        memcpy(&x0, x + i, sizeof(VT)); memcpy(&y0, y + i, sizeof(VT));       \
+        memcpy(&x1, x + i + VL, sizeof(VT));                                   \
+        memcpy(&y1, y + i + VL, sizeof(VT));                                   \
+        memcpy(&x2, x + i + 2 * VL, sizeof(VT));                               \
+        memcpy(&y2, y + i + 2 * VL, sizeof(VT));                               \
+        memcpy(&x3, x + i + 3 * VL, sizeof(VT));                               \
+        memcpy(&y3, y + i + 3 * VL, sizeof(VT));                               \
+        s0 += x0 * y0; s1 += x1 * y1; s2 += x2 * y2; s3 += x3 * y3;            \
+    }                                                                          \
+    s0 = (s0 + s1) + (s2 + s3);                                                \
+    for (j = 0; j < VL; j++) r += s0[j];                                       \
+    for (; i < n; i++) r += x[i] * y[i];                                       \
+    return r;                                                                  \
+}                                                                              \
+                                                                               \
+ATTR static void SUM(int64_t n, const T *x, T *sums)                  \
+{                                                                              \
+    enum { VL = sizeof(VT) / sizeof(T) };                                      \
+    VT s0 = {0}, s1 = {0}, s2 = {0}, s3 = {0}, x0, x1, x2, x3;                 \
+    int64_t i = 0, j;                                                          \
+    sums[0] = sums[1] = 0;                                                     \
+    for (; i + 4 * VL <= n; i += 4 * VL) {                                     \
+        memcpy(&x0, x + i, sizeof(VT));                                        \
+        memcpy(&x1, x + i + VL, sizeof(VT));                                   \
+        memcpy(&x2, x + i + 2 * VL, sizeof(VT));                               \
+        memcpy(&x3, x + i + 3 * VL, sizeof(VT));                               \
+        s0 += x0; s1 += x1; s2 += x2; s3 += x3;                                \
+    }                                                                          \
+    s0 = (s0 + s1) + (s2 + s3);                                                \
+    for (j = 0; j < VL; j++) sums[j % 2] += s0[j];                             \
+    for (; i < n; i++) sums[i % 2] += x[i];                                    \
+}
+
+LF_REDUCE_KERNELS(_lfortran_ddot_kernel, _lfortran_dsum_kernel,
+    double, _lfortran_v2d, )
+LF_REDUCE_KERNELS(_lfortran_sdot_kernel, _lfortran_ssum_kernel,
+    float, _lfortran_v4s, )
+#ifdef LFORTRAN_X86_KERNELS
+LF_REDUCE_KERNELS(_lfortran_ddot_kernel_avx2, _lfortran_dsum_kernel_avx2,
+    double, _lfortran_v4d,
+    __attribute__((target("avx2,fma"))))
+LF_REDUCE_KERNELS(_lfortran_sdot_kernel_avx2, _lfortran_ssum_kernel_avx2,
+    float, _lfortran_v8s,
+    __attribute__((target("avx2,fma"))))
+LF_REDUCE_KERNELS(_lfortran_ddot_kernel_avx512, _lfortran_dsum_kernel_avx512,
+    double, _lfortran_v8d,
+    __attribute__((target("avx512f,fma"))))
+LF_REDUCE_KERNELS(_lfortran_sdot_kernel_avx512, _lfortran_ssum_kernel_avx512,
+    float, _lfortran_v16s,
+    __attribute__((target("avx512f,fma"))))
+#endif
+
+#else
+
+#define LF_REDUCE_KERNELS(DOT, SUM, T)                                         \
+static T DOT(int64_t n, const T *x, const T *y)                               \
+{                                                                              \
+    T r = 0;                                                                   \
+    int64_t i;                                                                 \
+    for (i = 0; i < n; i++) r += x[i] * y[i];                                  \
+    return r;                                                                  \
+}                                                                              \
+                                                                               \
+static void SUM(int64_t n, const T *x, T *sums)                       \
+{                                                                              \
+    int64_t i;                                                                 \
+    sums[0] = sums[1] = 0;                                                     \
+    for (i = 0; i < n; i++) sums[i % 2] += x[i];                               \
+}
+
+LF_REDUCE_KERNELS(_lfortran_ddot_kernel, _lfortran_dsum_kernel,
+    double)
+LF_REDUCE_KERNELS(_lfortran_sdot_kernel, _lfortran_ssum_kernel,
+    float)
+
+#endif
+
+#ifdef LFORTRAN_X86_KERNELS
+#define LF_SIMD_DISPATCH(NAME)                                                 \
+    (_lfortran_simd_level() == 2 ? NAME##_avx512                               \
+        : _lfortran_simd_level() == 1 ? NAME##_avx2 : NAME)
+#else
+#define LF_SIMD_DISPATCH(NAME) NAME
+#endif
+
+#ifdef LFORTRAN_BLAS_HOOK
+#define LF_BLAS_CALL(S, T, m, n, k, a, b, c)                                   \
+    if (S##gemm_ != NULL && m <= INT_MAX && n <= INT_MAX && k <= INT_MAX) {    \
+        static const T one[2] = {1, 0}, zero[2] = {0, 0};                      \
+        int im = (int) m, in = (int) n, ik = (int) k, ldb = k > 0 ? ik : 1;    \
+        S##gemm_("N", "N", &im, &in, &ik, one, a, &im, b, &ldb, zero, c, &im); \
+        return;                                                                \
+    }
+#else
+#define LF_BLAS_CALL(S, T, m, n, k, a, b, c)
+#endif
+
+/* Micro-kernel shapes and cache blocking: mr, nr, mc, kc, nc */
+#ifdef LFORTRAN_VECTOR_KERNELS
+#define _lfortran_dgemm_generic_params {4, 4, 128, 256, 4096, _lfortran_dgemm_ukernel}
+#define _lfortran_sgemm_generic_params {8, 4, 128, 256, 4096, _lfortran_sgemm_ukernel}
+#else
+#define _lfortran_dgemm_generic_params {4, 4, 128, 256, 4096, _lfortran_dgemm_ukernel}
+#define _lfortran_sgemm_generic_params {4, 4, 128, 256, 4096, _lfortran_sgemm_ukernel}
+#endif
+#ifdef LFORTRAN_X86_KERNELS
+#define _lfortran_dgemm_avx2_params {8, 6, 96, 256, 4092, _lfortran_dgemm_ukernel_avx2}
+#define _lfortran_sgemm_avx2_params {16, 6, 144, 512, 4092, _lfortran_sgemm_ukernel_avx2}
+#define _lfortran_dgemm_avx512_params {16, 12, 192, 384, 4092, _lfortran_dgemm_ukernel_avx512}
+#define _lfortran_sgemm_avx512_params {32, 12, 192, 512, 4092, _lfortran_sgemm_ukernel_avx512}
+#else
+#define _lfortran_dgemm_avx2_params _lfortran_dgemm_generic_params
+#define _lfortran_sgemm_avx2_params _lfortran_sgemm_generic_params
+#define _lfortran_dgemm_avx512_params _lfortran_dgemm_generic_params
+#define _lfortran_sgemm_avx512_params _lfortran_sgemm_generic_params
+#endif
+
+/*
+ * Defines the entry points for one real kind, with T the real type, S the
+ * BLAS prefix of the real type and Z the one of the matching complex type.
+ */
+#define LF_ARRAY_KERNELS(T, S, Z)                                              \
+static const struct _lfortran_##S##gemm_params *_lfortran_##S##gemm_select()   \
+{                                                                              \
+    static const struct _lfortran_##S##gemm_params params[] = {                \
+        _lfortran_##S##gemm_generic_params,                                    \
+        _lfortran_##S##gemm_avx2_params,                                       \
+        _lfortran_##S##gemm_avx512_params,                                     \
+    };                                                                         \
+    return &params[_lfortran_simd_level()];                                    \
+}                                                                              \
+                                                                               \
+LFORTRAN_API void _lfortran_##S##gemm(int64_t m, int64_t n, int64_t k,         \
+        const T *a, const T *b, T *c)                                          \
+{                                                                              \
+    if (m == 0 || n == 0) return;                                              \
+    LF_BLAS_CALL(S, T, m, n, k, a, b, c)                                       \
+    memset(c, 0, sizeof(T) * m * n);                                           \
+    _lfortran_##S##gemm_acc(_lfortran_##S##gemm_select(), m, n, k,             \
+        a, m, b, k, c, m);                                                     \
+}                                                                              \
+                                                                               \
+LFORTRAN_API void _lfortran_##Z##gemm(int64_t m, int64_t n, int64_t k,         \
+        const T *a, const T *b, T *c)                                          \
+{                                                                              \
+    const struct _lfortran_##S##gemm_params *q;                                \
+    T *ar, *ai, *nai, *br, *bi, *cr, *ci;                                      \
+    int64_t i;                                                                 \
+    if (m == 0 || n == 0) return;                                              \
+    LF_BLAS_CALL(Z, T, m, n, k, a, b, c)                                    \
+    ar = (T *) _lfortran_kernel_alloc(sizeof(T) * (3*m*k + 2*k*n + 2*m*n));    \
+    ai = ar + m * k; nai = ai + m * k;                                         \
+    br = nai + m * k; bi = br + k * n;                                         \
+    cr = bi + k * n; ci = cr + m * n;                                          \
+    for (i = 0; i < m * k; i++) {                                              \
+        ar[i] = a[2 * i]; ai[i] = a[2 * i + 1]; nai[i] = -a[2 * i + 1];        \
+    }                                                                          \
+    for (i = 0; i < k * n; i++) {                                              \
+        br[i] = b[2 * i]; bi[i] = b[2 * i + 1];                                \
+    }                                                                          \
+    memset(cr, 0, sizeof(T) * 2 * m * n);                                      \
+    q = _lfortran_##S##gemm_select();                                          \
+    _lfortran_##S##gemm_acc(q, m, n, k, ar, m, br, k, cr, m);                  \
+    _lfortran_##S##gemm_acc(q, m, n, k, nai, m, bi, k, cr, m);                 \
+    _lfortran_##S##gemm_acc(q, m, n, k, ar, m, bi, k, ci, m);                  \
+    _lfortran_##S##gemm_acc(q, m, n, k, ai, m, br, k, ci, m);                  \
+    for (i = 0; i < m * n; i++) {                                              \
+        c[2 * i] = cr[i]; c[2 * i + 1] = ci[i];                                \
+    }                                                                          \
+    _lfortran_kernel_free(ar);                                                 \
+}                                                                              \
+                                                                               \
+LFORTRAN_API T _lfortran_##S##dot(int64_t n, const T *x, const T *y)           \
+{                                                                              \
+    return LF_SIMD_DISPATCH(_lfortran_##S##dot_kernel)(n, x, y);               \
+}                                                                              \
+                                                                               \
+/* dot_product of complex arrays conjugates its first argument */             \
+LFORTRAN_API void _lfortran_##Z##dot(int64_t n, const T *x, const T *y,        \
+        T *result)                                                             \
+{                                                                              \
+    T im = 0;                                                                  \
+    int64_t i;                                                                 \
+    result[0] = LF_SIMD_DISPATCH(_lfortran_##S##dot_kernel)(2 * n, x, y);      \
+    for (i = 0; i < n; i++) {                                                  \
+        im += x[2 * i] * y[2 * i + 1] - x[2 * i + 1] * y[2 * i];               \
+    }                                                                          \
+    result[1] = im;                                                            \
+}                                                                              \
+                                                                               \
+LFORTRAN_API T _lfortran_##S##sum(int64_t n, const T *x)                       \
+{                                                                              \
+    T sums[2];                                                                 \
+    LF_SIMD_DISPATCH(_lfortran_##S##sum_kernel)(n, x, sums);             \
+    return sums[0] + sums[1];                                                  \
+}                                                                              \
+                                                                               \
+LFORTRAN_API void _lfortran_##Z##sum(int64_t n, const T *x, T *result)         \
+{                                                                              \
+    LF_SIMD_DISPATCH(_lfortran_##S##sum_kernel)(2 * n, x, result);       \
+}
+
+
+LF_ARRAY_KERNELS(double, d, z)
+LF_ARRAY_KERNELS(float, s, c)
+
+/* b(j, i) = a(i, j) for an m x n array a of elements of `size` bytes */
+#define LF_TRANSPOSE_BLOCKED(COPY)                                             \
+    for (jj = 0; jj < n; jj += 32) {                                           \
+        int64_t je = jj + 32 < n ? jj + 32 : n;                                \
+        for (ii = 0; ii < m; ii += 32) {                                       \
+            int64_t ie = ii + 32 < m ? ii + 32 : m;                            \
+            for (i = ii; i < ie; i++) {                                        \
+                for (j = jj; j < je; j++) {                                    \
+                    COPY;                                                      \
+                }                                                              \
+            }                                                                  \
+        }                                                                      \
+    }
+
+LFORTRAN_API void _lfortran_transpose(int64_t m, int64_t n, int64_t size,
+        const void *a, void *b)
+{
+    /* Going through 32 x 32 blocks keeps both sides in cache */
+    int64_t ii, jj, i, j;
+    if (size == 4) {
+        const int32_t *src = (const int32_t *) a;
+        int32_t *dst = (int32_t *) b;
+        LF_TRANSPOSE_BLOCKED(dst[i * n + j] = src[j * m + i])
+    } else if (size == 8) {
+        const int64_t *src = (const int64_t *) a;
+        int64_t *dst = (int64_t *) b;
+        LF_TRANSPOSE_BLOCKED(dst[i * n + j] = src[j * m + i])
+    } else {
+        const char *src = (const char *) a;
+        char *dst = (char *) b;
+        LF_TRANSPOSE_BLOCKED(
+            memcpy(dst + (i * n + j) * size, src + (j * m + i) * size, size))
+    }
+}
+
+/*
+ * Random numbers are generated by xoshiro256** (https://prng.di.unimi.it/),
+ * a fast generator with 256 bits of state and a period of 2^256 - 1.
+ *
+ * Every thread draws from its own state, so OpenMP threads neither contend on
+ * a lock nor repeat each other's numbers. The seed set by random_seed,
+ * random_init or srand is copied into a thread's state the next time the
+ * thread draws a number, advanced by 2^128 numbers (one `rng_jump`) for every
+ * thread that picked it up before, which gives each thread a separate stream.
+ * The thread that sets the seed continues with exactly the seeded state, so a
+ * serial program is reproducible with random_seed(put=...).
+ */
+static uint64_t rng_seed[4] = {
+    // The state seeded with 0 (see `rng_seed_from_u64`)
+    0xe220a8397b1dcdafULL, 0x6e789e6aa1b965f4ULL,
+    0x06c45d188009454fULL, 0xf88bb8a8724c81ecULL
+};
+// Incremented whenever `rng_seed` changes; threads compare it to the
+// generation their state was seeded from. 0 means "not seeded yet".
+static volatile uint32_t rng_seed_generation = 1;
+static uint32_t rng_next_stream = 0;
+static lfortran_lock_t rng_seed_lock_flag = 0;
+
+static LFORTRAN_THREAD_LOCAL uint64_t rng_state[4];
+static LFORTRAN_THREAD_LOCAL uint32_t rng_state_generation = 0;
+
+static inline uint64_t rng_rotl(const uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t rng_next_state(uint64_t s[4]) {
+    const uint64_t result = rng_rotl(s[1] * 5, 7) * 9;
+    const uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rng_rotl(s[3], 45);
+    return result;
+}
+
+// Advances `s` by 2^128 numbers
+static void rng_jump(uint64_t s[4]) {
+    static const uint64_t jump[] = { 0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL,
+        0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL };
+    uint64_t s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+    for (int i = 0; i < 4; i++) {
+        for (int b = 0; b < 64; b++) {
+            if (jump[i] & ((uint64_t)1 << b)) {
+                s0 ^= s[0];
+                s1 ^= s[1];
+                s2 ^= s[2];
+                s3 ^= s[3];
+            }
+            rng_next_state(s);
+        }
+    }
+    s[0] = s0;
+    s[1] = s1;
+    s[2] = s2;
+    s[3] = s3;
+}
+
+static void rng_sync_thread_state() {
+    lfortran_lock(&rng_seed_lock_flag);
+    memcpy(rng_state, rng_seed, sizeof(rng_state));
+    uint32_t stream = rng_next_stream++;
+    uint32_t generation = rng_seed_generation;
+    lfortran_unlock(&rng_seed_lock_flag);
+    for (uint32_t i = 0; i < stream; i++) {
+        rng_jump(rng_state);
+    }
+    rng_state_generation = generation;
+}
+
+// The state of the calling thread, (re)seeded if the seed has changed
+static inline uint64_t* rng_thread_state() {
+    if (rng_state_generation != rng_seed_generation) {
+        rng_sync_thread_state();
+    }
+    return rng_state;
+}
+
+static inline uint64_t rng_next() {
+    return rng_next_state(rng_thread_state());
+}
+
+// A uniformly distributed double in [0, 1)
+static inline double rng_next_double() {
+    return (rng_next() >> 11) * 0x1.0p-53;
+}
+
+// A uniformly distributed float in [0, 1)
+static inline float rng_next_float() {
+    return (rng_next() >> 40) * 0x1.0p-24f;
+}
+
+static void rng_set_seed(const uint64_t seed[4]) {
+    uint64_t state[4];
+    memcpy(state, seed, sizeof(state));
+    if ((state[0] | state[1] | state[2] | state[3]) == 0) {
+        // The all zero state is a fixed point of the generator
+        state[0] = 1;
+    }
+    lfortran_lock(&rng_seed_lock_flag);
+    memcpy(rng_seed, state, sizeof(rng_seed));
+    uint32_t generation = rng_seed_generation + 1;
+    if (generation == 0) generation = 1;
+    rng_seed_generation = generation;
+    // The calling thread takes the first stream
+    rng_next_stream = 1;
+    lfortran_unlock(&rng_seed_lock_flag);
+    memcpy(rng_state, state, sizeof(rng_state));
+    rng_state_generation = generation;
+}
+
+// Expands `seed` into a full state with splitmix64, as recommended for
+// xoshiro
+static void rng_seed_from_u64(uint64_t seed) {
+    uint64_t state[4];
+    for (int i = 0; i < 4; i++) {
+        uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        state[i] = z ^ (z >> 31);
+    }
+    rng_set_seed(state);
+}
+
 LFORTRAN_API void _lfortran_random_number(int n, double *v)
 {
-    int i;
-    for (i=0; i < n; i++) {
-        v[i] = rand() / (double) RAND_MAX;
+    // Draw from a local copy of the state, which the compiler can keep in
+    // registers for the whole loop
+    uint64_t s[4];
+    memcpy(s, rng_thread_state(), sizeof(s));
+    for (int i = 0; i < n; i++) {
+        v[i] = (rng_next_state(s) >> 11) * 0x1.0p-53;
     }
+    memcpy(rng_state, s, sizeof(s));
 }
 
 LFORTRAN_API int _lfortran_init_random_seed(unsigned seed)
 {
-    srand(seed);
+    rng_seed_from_u64(seed);
     return seed;
 }
 
@@ -140,23 +846,25 @@ LFORTRAN_API void _lfortran_init_random_clock()
         count = (unsigned int)clock();
     }
 #endif
+    rng_seed_from_u64(count);
+    // Also used for the names of generated files (see `get_unique_ID`)
     srand(count);
 }
 
 LFORTRAN_API double _lfortran_random()
 {
-    return (rand() / (double) RAND_MAX);
+    return rng_next_double();
 }
 
 LFORTRAN_API int _lfortran_randrange(int lower, int upper)
 {
-    int rr = lower + (rand() % (upper - lower));
+    int rr = lower + (int)(rng_next() % (uint64_t)(upper - lower));
     return rr;
 }
 
 LFORTRAN_API int _lfortran_random_int(int lower, int upper)
 {
-    int randint = lower + (rand() % (upper - lower + 1));
+    int randint = lower + (int)(rng_next() % (uint64_t)(upper - lower + 1));
     return randint;
 }
 
@@ -188,27 +896,119 @@ char* substring(const char* str, int start, int end) {
     return substr;
 }
 
-char* append_to_string(char* str, const char* append) {
-    int len1 = strlen(str);
-    int len2 = strlen(append);
-    str = (char*)realloc(str, (len1 + len2 + 1) * sizeof(char));
-    strcat(str, append);
-    return str;
+/*
+A growable, null-terminated character buffer that the formatting routines
+append to. The length is tracked and the capacity grows geometrically, so
+appending a piece costs time proportional to the piece only. `data` may start
+out as a caller provided (e.g. stack) buffer, which is left alone and copied
+once the builder outgrows it.
+*/
+typedef struct string_builder {
+    char* data;
+    int64_t len;
+    int64_t cap;
+    bool owns_data;
+} String_Builder;
+
+// Starts an empty string in `buffer` (of `cap` bytes), or in a heap buffer
+// if `buffer` is NULL
+static void string_builder_init(String_Builder* sb, char* buffer, int64_t cap) {
+    sb->owns_data = (buffer == NULL);
+    if (buffer == NULL) {
+        buffer = (char*)malloc(cap * sizeof(char));
+        if (buffer == NULL) {
+            perror("Memory allocation failed.\n");
+            exit(1);
+        }
+    }
+    sb->data = buffer;
+    sb->data[0] = '\0';
+    sb->len = 0;
+    sb->cap = cap;
+}
+
+// Makes room for `n` more characters (and the null terminator)
+static void string_builder_reserve(String_Builder* sb, int64_t n) {
+    if (sb->len + n + 1 <= sb->cap) return;
+    int64_t new_cap = 2 * sb->cap;
+    if (new_cap < sb->len + n + 1) new_cap = sb->len + n + 1;
+    char* data;
+    if (sb->owns_data) {
+        data = (char*)realloc(sb->data, new_cap * sizeof(char));
+    } else {
+        data = (char*)malloc(new_cap * sizeof(char));
+        if (data != NULL) memcpy(data, sb->data, sb->len + 1);
+    }
+    if (data == NULL) {
+        perror("Memory allocation failed.\n");
+        exit(1);
+    }
+    sb->data = data;
+    sb->cap = new_cap;
+    sb->owns_data = true;
 }
 
-void handle_integer(char* format, int64_t val, char** result, bool is_signed_plus) {
+static inline void string_builder_append_n(String_Builder* sb, const char* str, int64_t n) {
+    string_builder_reserve(sb, n);
+    memcpy(sb->data + sb->len, str, n);
+    sb->len += n;
+    sb->data[sb->len] = '\0';
+}
+
+static inline void string_builder_append(String_Builder* sb, const char* str) {
+    string_builder_append_n(sb, str, strlen(str));
+}
+
+// Appends `c` `n` times
+static inline void string_builder_append_repeat(String_Builder* sb, char c, int64_t n) {
+    if (n <= 0) return;
+    string_builder_reserve(sb, n);
+    memset(sb->data + sb->len, c, n);
+    sb->len += n;
+    sb->data[sb->len] = '\0';
+}
+
+static inline void string_builder_truncate(String_Builder* sb, int64_t len) {
+    if (len < sb->len) {
+        sb->len = len;
+        sb->data[len] = '\0';
+    }
+}
+
+// Returns the string as a heap allocated buffer, owned by the caller
+static char* string_builder_release(String_Builder* sb) {
+    if (!sb->owns_data) {
+        char* data = (char*)malloc((sb->len + 1) * sizeof(char));
+        memcpy(data, sb->data, sb->len + 1);
+        sb->data = data;
+        sb->owns_data = true;
+    }
+    return sb->data;
+}
+
+// Writes the decimal digits of `val` (at least `min_digits` of them, padded
+// with leading zeros) and a null terminator to `str`, which must have room
+// for 21 characters. Returns the number of digits.
+static int uint64_to_decimal(uint64_t val, int min_digits, char* str) {
+    char digits[20];
+    int len = 0;
+    do {
+        digits[sizeof(digits) - 1 - len++] = '0' + (char)(val % 10);
+        val /= 10;
+    } while (val != 0 || len < min_digits);
+    memcpy(str, digits + sizeof(digits) - len, len);
+    str[len] = '\0';
+    return len;
+}
+
+void handle_integer(char* format, int64_t val, String_Builder* result, bool is_signed_plus) {
     int width = 0, min_width = 0;
     char* dot_pos = strchr(format, '.');
-    int len;
     int sign_width = (val < 0) ? 1 : 0;
     bool sign_plus_exist = (is_signed_plus && val >= 0);
-    if (val == 0) {
-        len = 1;
-    } else if (val == INT64_MIN) {
-        len = 19;
-    } else {
-        len = (int)log10(llabs(val)) + 1;
-    }
+    char digits[21];
+    int len = uint64_to_decimal((val < 0) ? (uint64_t)0 - (uint64_t)val : (uint64_t)val,
+        1, digits);
     if (dot_pos != NULL) {
         dot_pos++;
         width = atoi(format + 1);
@@ -224,67 +1024,47 @@ void handle_integer(char* format, int64_t val, char** result, bool is_signed_plu
     }
     if (width >= len + sign_width + sign_plus_exist || width == 0) {
         if (min_width > len) {
-            for (int i = 0; i < (width - min_width - sign_width - sign_plus_exist); i++) {
-                *result = append_to_string(*result, " ");
-            }
-            
+            string_builder_append_repeat(result, ' ', width - min_width - sign_width - sign_plus_exist);
             if (val < 0) {
-                *result = append_to_string(*result, "-");
+                string_builder_append(result, "-");
             } else if(sign_plus_exist){
-                *result = append_to_string(*result, "+");
-            }
-
-            for (int i = 0; i < (min_width - len); i++) {
-                *result = append_to_string(*result, "0");
+                string_builder_append(result, "+");
             }
+            string_builder_append_repeat(result, '0', min_width - len);
         } else {
-            for (int i = 0; i < (width - len - sign_width - sign_plus_exist); i++) {
-                *result = append_to_string(*result, " ");
-            }
+            string_builder_append_repeat(result, ' ', width - len - sign_width - sign_plus_exist);
             if (val < 0) {
-                *result = append_to_string(*result, "-");
+                string_builder_append(result, "-");
             } else if (sign_plus_exist){
-                *result = append_to_string(*result, "+");
+                string_builder_append(result, "+");
             }
         }
-        char str[20];
-        if (val == INT64_MIN) {
-            sprintf(str, "9223372036854775808");
-        } else {
-            sprintf(str, "%lld", llabs(val));
-        }
-        *result = append_to_string(*result, str);
+        string_builder_append_n(result, digits, len);
     } else {
-        for (int i = 0; i < width; i++) {
-            *result = append_to_string(*result, "*");
-        }
+        string_builder_append_repeat(result, '*', width);
     }
 }
 
-void handle_logical(char* format, bool val, char** result) {
+void handle_logical(char* format, bool val, String_Builder* result) {
     int width = atoi(format + 1);
-    for (int i = 0; i < width - 1; i++) {
-        *result = append_to_string(*result, " ");
-    }
+    string_builder_append_repeat(result, ' ', width - 1);
     if (val) {
-        *result = append_to_string(*result, "T");
+        string_builder_append(result, "T");
     } else {
-        *result = append_to_string(*result, "F");
+        string_builder_append(result, "F");
     }
 }
 
-void handle_float(char* format, double val, char** result, bool use_sign_plus) {
+void handle_float(char* format, double val, String_Builder* result, bool use_sign_plus) {
     if (strcmp(format,"f-64") == 0) { //use c formatting.
-        char* float_str = (char*)malloc(50 * sizeof(char));
-        sprintf(float_str,"%23.17e",val);
-        *result = append_to_string(*result,float_str);
-        free(float_str);
+        char float_str[50];
+        int n = snprintf(float_str, sizeof(float_str), "%23.17e", val);
+        string_builder_append_n(result, float_str, n);
         return;
     } else if(strcmp(format,"f-32") == 0){ //use c formatting.
-        char* float_str = (char*)malloc(40 * sizeof(char));
-        sprintf(float_str,"%13.8e",val);
-        *result = append_to_string(*result,float_str);
-        free(float_str);
+        char float_str[40];
+        int n = snprintf(float_str, sizeof(float_str), "%13.8e", val);
+        string_builder_append_n(result, float_str, n);
         return;
     }
     int width = 0, decimal_digits = 0;
@@ -311,14 +1091,25 @@ void handle_float(char* format, double val, char** result, bool use_sign_plus) {
     }
 
     char int_str[64];
-    sprintf(int_str, "%ld", integer_part);
+    if (fabs(val) < (double)LONG_MAX) {
+        uint64_to_decimal((uint64_t)integer_part, 1, int_str);
+    } else {
+        sprintf(int_str, "%ld", integer_part);
+    }
 
     // TODO: This will work for up to `F65.60` but will fail for:
     // print "(F67.62)", 1.23456789101112e-62_8
     char dec_str[64];
-    sprintf(dec_str, "%.*f", decimal_digits, decimal_part);
-    // removing the leading "0." from the formatted decimal part
-    memmove(dec_str, dec_str + 2, strlen(dec_str));
+    // `decimal_part` is a multiple of `rounding_factor` (up to rounding
+    // errors far below it), so its digits are the ones of that multiple
+    double decimal_units = round(decimal_part / rounding_factor);
+    if (decimal_digits <= 15 && decimal_units < pow(10, decimal_digits)) {
+        uint64_to_decimal((uint64_t)decimal_units, decimal_digits, dec_str);
+    } else {
+        sprintf(dec_str, "%.*f", decimal_digits, decimal_part);
+        // removing the leading "0." from the formatted decimal part
+        memmove(dec_str, dec_str + 2, strlen(dec_str));
+    }
 
     // Determine total length needed
     int total_length =  sign_width      + 
@@ -355,22 +1146,18 @@ void handle_float(char* format, double val, char** result, bool use_sign_plus) {
 
     // checking for overflow
     if (strlen(formatted_value) > width) {
-        for (int i = 0; i < width; i++) {
-            *result = append_to_string(*result, "*");
-        }
+        string_builder_append_repeat(result, '*', width);
     } else {
-        *result = append_to_string(*result, formatted_value);
+        string_builder_append(result, formatted_value);
     }
 }
 
 /*
 `handle_en` - Formats a floating-point number using a Fortran-style "EN" format.
 
-NOTE: The function allocates memory for the formatted result, which is returned via
-the `result` parameter. It is the responsibility of the caller to free this memory
-using `free(*result)` after it is no longer needed.
+The formatted value is appended to `result`.
 */
-void handle_en(char* format, double val, int scale, char** result, char* c, bool is_signed_plus) {
+void handle_en(char* format, double val, int scale, String_Builder* result, char* c, bool is_signed_plus) {
     int width, decimal_digits;
     char *num_pos = format, *dot_pos = strchr(format, '.');
     decimal_digits = atoi(++dot_pos);
@@ -423,7 +1210,8 @@ void handle_en(char* format, double val, int scale, char** result, char* c, bool
     }
 
     // Assign the result to the output parameter
-    *result = append_to_string(*result, final_result);
+    string_builder_append(result, final_result);
+    free(final_result);
 }
 
 void parse_decimal_format(char* format, int* width_digits, int* decimal_digits, int* exp_digits) {
@@ -448,7 +1236,7 @@ void parse_decimal_format(char* format, int* width_digits, int* decimal_digits,
 }
 
 
-void handle_decimal(char* format, double val, int scale, char** result, char* c, bool is_signed_plus) {
+void handle_decimal(char* format, double val, int scale, String_Builder* result, char* c, bool is_signed_plus) {
     // Consider an example: write(*, "(es10.2)") 1.123e+10
     // format = "es10.2", val = 11230000128.00, scale = 0, c = "E"
 
@@ -613,17 +1401,14 @@ void handle_decimal(char* format, double val, int scale, char** result, char* c,
     }
 
     if (strlen(formatted_value) > width) {
-        for(int i=0; i<width; i++){
-            *result = append_to_string(*result,"*");
-        }
+        string_builder_append_repeat(result, '*', width);
     } else {
-        *result = append_to_string(*result, formatted_value);
+        string_builder_append(result, formatted_value);
         // result = "  1.12E+10"
     }
 }
-void handle_SP_specifier(char** result, bool is_positive_value){
-    char positive_sign_string[] = "+";
-    if(is_positive_value) append_to_string(*result, positive_sign_string);
+void handle_SP_specifier(String_Builder* result, bool is_positive_value){
+    if(is_positive_value) string_builder_append(result, "+");
 }
 /*
 Ignore blank space characters within format specification, except
@@ -666,7 +1451,11 @@ char* remove_spaces_except_quotes(const char* format) {
     return cleaned_format;
 }
 
-int find_matching_parentheses(const char* format, int index){
+/*
+Returns the index just past the parenthesis matching the one at `index`. If
+they are unbalanced, exits when `fatal`, otherwise returns -1.
+*/
+int find_matching_parentheses(const char* format, int index, bool fatal){
     int parenCount = 0;
     while (format[index] != '\0') {
         if (format[index] == '(') {
@@ -679,6 +1468,7 @@ int find_matching_parentheses(const char* format, int index){
             break;
     }
     if (parenCount != 0) {
+        if (!fatal) return -1;
         fprintf(stderr, "Error: Unbalanced paranthesis in format string\n");
         exit(1);
     }
@@ -692,11 +1482,13 @@ int find_matching_parentheses(const char* format, int index){
  * `char* format`: the string we need to split into format specifiers
  * `int* count`  : store count of format specifiers (passed by reference from caller)
  * `item_start`  :
+ * `fatal`       : whether an invalid format string is reported and exits the
+ *                 program, or just makes this function return NULL
  *
  * e.g. "(I5, F5.2, T10)" is split separately into "I5", "F5.2", "T10" as
  * format specifiers
 */
-char** parse_fortran_format(char* format, int64_t *count, int64_t *item_start) {
+char** parse_fortran_format(char* format, int64_t *count, int64_t *item_start, bool fatal) {
     char** format_values_2 = (char**)malloc((*count + 1) * sizeof(char*));
     int format_values_count = *count;
     int index = 0 , start = 0;
@@ -721,6 +1513,11 @@ char** parse_fortran_format(char* format, int64_t *count, int64_t *item_start) {
             case '"' :
                 start = index++;
                 while (format[index] != '"') {
+                    if (format[index] == '\0') {
+                        if (!fatal) goto invalid_format;
+                        fprintf(stderr, "Error: Unterminated character string in format string\n");
+                        exit(1);
+                    }
                     index++;
                 }
                 format_values_2[format_values_count++] = substring(format, start, index+1);
@@ -729,6 +1526,11 @@ char** parse_fortran_format(char* format, int64_t *count, int64_t *item_start) {
             case '\'' :
                 start = index++;
                 while (format[index] != '\'') {
+                    if (format[index] == '\0') {
+                        if (!fatal) goto invalid_format;
+                        fprintf(stderr, "Error: Unterminated character string in format string\n");
+                        exit(1);
+                    }
                     index++;
                 }
                 format_values_2[format_values_count++] = substring(format, start, index+1);
@@ -755,6 +1557,7 @@ char** parse_fortran_format(char* format, int64_t *count, int64_t *item_start) {
                     edot = true;
                     index++;
                 } else {
+                    if (!fatal) goto invalid_format;
                     printf("Error: Period required in format specifier\n");
                     exit(1);
                 }
@@ -797,13 +1600,15 @@ char** parse_fortran_format(char* format, int64_t *count, int64_t *item_start) {
                     if(format[index] == ',') --index; // Don't consume
                     format_values_2[format_values_count++] = substring(format, start, index+1);
                 } else {
+                    if (!fatal) goto invalid_format;
                     fprintf(stderr, "Error: Invalid format specifier. After 's' specifier\n");
                     exit(1);
                 }
                 break;
             case '(' :
                 start = index;
-                index = find_matching_parentheses(format, index);
+                index = find_matching_parentheses(format, index, fatal);
+                if (index < 0) goto invalid_format;
                 format_values_2[format_values_count++] = substring(format, start, index);
                 *item_start = format_values_count;
                 break;
@@ -816,6 +1621,7 @@ char** parse_fortran_format(char* format, int64_t *count, int64_t *item_start) {
                 // raise error when "T/TL/TR" is specified itself or with
                 // non-positive width
                 if (!isdigit(format[index])) {
+                    if (!fatal) goto invalid_format;
                     // TODO: if just 'T' is specified the error message will print 'T,', fix it
                     printf("Error: Positive width required with '%c%c' descriptor in format string\n",
                         format[start], format[start + 1]);
@@ -843,7 +1649,8 @@ char** parse_fortran_format(char* format, int64_t *count, int64_t *item_start) {
                     format_values_2 = (char**)realloc(format_values_2, (format_values_count + repeat + 1) * sizeof(char*));
                     if (format[index] == '(') {
                         start = index;
-                        index = find_matching_parentheses(format, index);
+                        index = find_matching_parentheses(format, index, fatal);
+                        if (index < 0) goto invalid_format;
                         *item_start = format_values_count+1;
                         for (int i = 0; i < repeat; i++) {
                             format_values_2[format_values_count++] = substring(format, start, index);
@@ -861,6 +1668,7 @@ char** parse_fortran_format(char* format, int64_t *count, int64_t *item_start) {
                         index--;
                     }
                 } else if (format[index] != ' ') {
+                    if (!fatal) goto invalid_format;
                     fprintf(stderr, "Unsupported or unrecognized `%c` in format string\n", format[index]);
                     exit(1);
                 }
@@ -869,6 +1677,13 @@ char** parse_fortran_format(char* format, int64_t *count, int64_t *item_start) {
     }
     *count = format_values_count;
     return format_values_2;
+
+invalid_format:
+    for (int i = *count; i < format_values_count; i++) {
+        free(format_values_2[i]);
+    }
+    free(format_values_2);
+    return NULL;
 }
 
 #define primitive_types_cnt  10
@@ -1223,13 +2038,10 @@ void print_into_string(Serialization_Info* s_info,  char* result){
 
 }
 
-void default_formatting(char** result, struct serialization_info* s_info){
-    int64_t result_capacity = 100;
-    int64_t result_size = 0;
+void default_formatting(String_Builder* result, struct serialization_info* s_info){
     const int default_spacing_len = 4;
     const char* default_spacing = "    ";
     ASSERT(default_spacing_len == strlen(default_spacing));
-    *result = realloc(*result, result_capacity + 1 /*Null Character*/ );
 
     while(move_to_next_element(s_info, false)){
         int size_to_allocate;
@@ -1240,22 +2052,13 @@ void default_formatting(char** result, struct serialization_info* s_info){
         } else {
             size_to_allocate = (60 + default_spacing_len) * sizeof(char);
         }
-        int64_t old_capacity = result_capacity;
-        while(result_capacity <= size_to_allocate + result_size){ // Check if string extension is needed.
-            if(result_size + size_to_allocate > result_capacity*2){
-                result_capacity = size_to_allocate + result_size ;
-            } else {
-                result_capacity *=2;
-            }
+        string_builder_reserve(result, size_to_allocate);
+        if(result->len > 0){
+            string_builder_append_n(result, default_spacing, default_spacing_len);
         }
-        if(result_capacity != old_capacity){*result = (char*)realloc(*result, result_capacity + 1);}
-        if(result_size > 0){
-            strcpy((*result)+result_size, default_spacing);
-            result_size+=default_spacing_len;
-        }
-        print_into_string(s_info,  (*result) + result_size);
-        int64_t printed_arg_size = strlen((*result) + result_size);
-        result_size += printed_arg_size;
+        print_into_string(s_info, result->data + result->len);
+        int64_t printed_arg_size = strlen(result->data + result->len);
+        result->len += printed_arg_size;
     }
 }
 void free_serialization_info(Serialization_Info* s_info){
@@ -1265,63 +2068,41 @@ void free_serialization_info(Serialization_Info* s_info){
     va_end(*s_info->current_arg_info.args);
 }
 
-LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const char* serialization_string, 
-    int32_t array_sizes_cnt, ...)
+static void init_serialization_info(struct serialization_info* s_info,
+    const char* serialization_string, int32_t array_sizes_cnt, va_list* args)
 {
-    va_list args;
-    va_start(args, array_sizes_cnt);
-    char* result = (char*)malloc(sizeof(char)); //TODO : the consumer of this string needs to free it.
-    result[0] = '\0';
-
-    // Setup s_info
-    struct serialization_info s_info;
-    s_info.serialization_string = serialization_string;
-    s_info.array_serialiation_start_index = create_stack();
-    s_info.array_sizes_stack = create_stack();
-    s_info.current_stop = 0;
-    s_info.current_arg_info.args = &args;
-    s_info.current_element_type = NONE_TYPE;
-    s_info.current_arg_info.is_complex = false;
-    s_info.array_sizes.current_index = 0;
-    s_info.just_peeked = false;
+    s_info->serialization_string = serialization_string;
+    s_info->array_serialiation_start_index = create_stack();
+    s_info->array_sizes_stack = create_stack();
+    s_info->current_stop = 0;
+    s_info->current_arg_info.args = args;
+    s_info->current_element_type = NONE_TYPE;
+    s_info->current_arg_info.is_complex = false;
+    s_info->array_sizes.current_index = 0;
+    s_info->just_peeked = false;
     int64_t* array_sizes = (int64_t*) malloc(array_sizes_cnt * sizeof(int64_t));
     for(int i=0; i<array_sizes_cnt; i++){
-        array_sizes[i] = va_arg(args, int64_t);
+        array_sizes[i] = va_arg(*args, int64_t);
     }
-    s_info.array_sizes.ptr = array_sizes;
-    s_info.current_arg_info.current_arg = va_arg(args, void*);
+    s_info->array_sizes.ptr = array_sizes;
+    s_info->current_arg_info.current_arg = va_arg(*args, void*);
 
-    if(!s_info.current_arg_info.current_arg && 
-        s_info.serialization_string[s_info.current_stop] !='\0')
+    if(!s_info->current_arg_info.current_arg && 
+        s_info->serialization_string[s_info->current_stop] !='\0')
     {fprintf(stderr,"Internal Error : default formatting error\n");exit(1);}
+}
 
-    if(format == NULL){
-        default_formatting(&result, &s_info);
-        free_serialization_info(&s_info);
-        return result;
-    }
-
-    int64_t format_values_count = 0,item_start_idx=0;
-    char** format_values;
-    char* modified_input_string;
-    char* cleaned_format = remove_spaces_except_quotes(format);
-    if (!cleaned_format) {
-        free_serialization_info(&s_info);
-        return NULL;
-    }
-    int len = strlen(cleaned_format);
-    modified_input_string = (char*)malloc((len+1) * sizeof(char));
-    strncpy(modified_input_string, cleaned_format, len);
-    modified_input_string[len] = '\0';
-    if (cleaned_format[0] == '(' && cleaned_format[len-1] == ')') {
-        memmove(modified_input_string, modified_input_string + 1, strlen(modified_input_string));
-        modified_input_string[len-2] = '\0';
-    }
-    format_values = parse_fortran_format(modified_input_string, &format_values_count, &item_start_idx);
-    /*
-    is_SP_specifier = false  --> 'S' OR 'SS'
-    is_SP_specifier = true  --> 'SP'
-    */
+/*
+Runs the format specifiers `format_values` (as split by
+`parse_fortran_format`) on the arguments described by `s_info` and appends
+the formatted record to `result`. Parenthesized groups are expanded when they are first
+reached. If `owns_values` is false, `format_values` must not contain any
+groups (see `_lcompilers_precompile_format`) and stays owned by the caller.
+*/
+static void format_fortran_values(char** format_values, int64_t format_values_count,
+    int64_t item_start_idx, bool owns_values, struct serialization_info* s_info,
+    String_Builder* result)
+{
     bool is_SP_specifier = false;
     int item_start = 0;
     bool array = false;
@@ -1337,7 +2118,7 @@ LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const c
             if (value[0] == '(' && value[strlen(value)-1] == ')') {
                 value[strlen(value)-1] = '\0';
                 int64_t new_fmt_val_count = 0;
-                char** new_fmt_val = parse_fortran_format(++value,&new_fmt_val_count,&item_start_idx);
+                char** new_fmt_val = parse_fortran_format(++value,&new_fmt_val_count,&item_start_idx,true);
 
                 char** ptr = (char**)realloc(format_values, (format_values_count + new_fmt_val_count + 1) * sizeof(char*));
                 if (ptr == NULL) {
@@ -1360,10 +2141,10 @@ LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const c
             }
 
             if (value[0] == ':') {
-                if (!move_to_next_element(&s_info, true)) break;
+                if (!move_to_next_element(s_info, true)) break;
                 continue;
             } else if (value[0] == '/') {
-                result = append_to_string(result, "\n");
+                string_builder_append(result, "\n");
             } else if (value[0] == '*') {
                 array = true;
             } else if (isdigit(value[0]) && tolower(value[1]) == 'p') {
@@ -1375,11 +2156,9 @@ LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const c
             } else if ((value[0] == '\"' && value[strlen(value) - 1] == '\"') ||
                 (value[0] == '\'' && value[strlen(value) - 1] == '\'')) {
                 // String
-                value = substring(value, 1, strlen(value) - 1);
-                result = append_to_string(result, value);
-                free(value);
+                string_builder_append_n(result, value + 1, strlen(value) - 2);
             } else if (tolower(value[strlen(value) - 1]) == 'x') {
-                result = append_to_string(result, " ");
+                string_builder_append(result, " ");
             } else if (tolower(value[0]) == 's') {
                 is_SP_specifier = ( strlen(value) == 2 /*case 'S' speicifer*/ &&
                                     tolower(value[1]) == 'p'); 
@@ -1387,50 +2166,39 @@ LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const c
                 if (tolower(value[1]) == 'l') {
                     // handle "TL" format specifier
                     int tab_left_pos = atoi(value + 2);
-                    int current_length = strlen(result);
+                    int current_length = result->len;
                     if (tab_left_pos > current_length) {
-                        result[0] = '\0';
+                        string_builder_truncate(result, 0);
                     } else {
-                        result[current_length - tab_left_pos] = '\0';
+                        string_builder_truncate(result, current_length - tab_left_pos);
                     }
                 } else if (tolower(value[1]) == 'r') {
                     // handle "TR" format specifier
                     int tab_right_pos = atoi(value + 2);
-                    int current_length = strlen(result);
                     int spaces_needed = tab_right_pos;
-                    if (spaces_needed > 0) {
-                        char* spaces = (char*)malloc((spaces_needed + 1) * sizeof(char));
-                        memset(spaces, ' ', spaces_needed);
-                        spaces[spaces_needed] = '\0';
-                        result = append_to_string(result, spaces);
-                        free(spaces);
-                    }
+                    string_builder_append_repeat(result, ' ', spaces_needed);
                 } else {
-                    if (!move_to_next_element(&s_info, true)) break;
+                    if (!move_to_next_element(s_info, true)) break;
                     int tab_position = atoi(value + 1);
-                    int current_length = strlen(result);
+                    int current_length = result->len;
                     int spaces_needed = tab_position - current_length - 1;
                     if (spaces_needed > 0) {
-                        char* spaces = (char*)malloc((spaces_needed + 1) * sizeof(char));
-                        memset(spaces, ' ', spaces_needed);
-                        spaces[spaces_needed] = '\0';
-                        result = append_to_string(result, spaces);
-                        free(spaces);
+                        string_builder_append_repeat(result, ' ', spaces_needed);
                     } else if (spaces_needed < 0) {
                         // Truncate the string to the length specified by Tn
                         // if the current position exceeds it
                         if (tab_position < current_length) {
                             // Truncate the string at the position specified by Tn
-                            result[tab_position] = '\0';
+                            string_builder_truncate(result, tab_position);
                         }
                     }
                 }
             } else {
-                if (!move_to_next_element(&s_info, false)) break;
+                if (!move_to_next_element(s_info, false)) break;
                 if (!is_format_match(
-                        tolower(value[0]), s_info.current_element_type)){
+                        tolower(value[0]), s_info->current_element_type)){
                     char* type; // For better error message.
-                    switch (primitive_enum_to_format_specifier(s_info.current_element_type))
+                    switch (primitive_enum_to_format_specifier(s_info->current_element_type))
                     {
                         case 'i':
                             type = "INTEGER";
@@ -1445,11 +2213,12 @@ LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const c
                             type = "CHARACTER";
                             break;
                     }
-                    free(result);
-                    result = (char*)malloc(150 * sizeof(char));
-                    sprintf(result, " Runtime Error : Got argument of type (%s), while the format specifier is (%c)\n", type, value[0]);
+                    char error_message[150];
+                    snprintf(error_message, sizeof(error_message), " Runtime Error : Got argument of type (%s), while the format specifier is (%c)\n", type, value[0]);
                     // Special indication for error --> "\b" to be handled by `lfortran_print` or `lfortran_file_write`
-                    result[0] = '\b';
+                    error_message[0] = '\b';
+                    string_builder_truncate(result, 0);
+                    string_builder_append(result, error_message);
                     BreakWhileLoop = true;
                     break;
                 }
@@ -1460,44 +2229,44 @@ LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const c
                 double double_val = 0;
                 char* char_val = NULL;
                 bool bool_val = false;
-                switch(s_info.current_element_type ){
+                switch(s_info->current_element_type ){
                     case  INTEGER_64_TYPE:
-                        integer_val = *(int64_t*)s_info.current_arg_info.current_arg; 
+                        integer_val = *(int64_t*)s_info->current_arg_info.current_arg; 
                         break;
                     case  INTEGER_32_TYPE:
-                        integer_val = (int64_t)*(int32_t*)s_info.current_arg_info.current_arg; 
+                        integer_val = (int64_t)*(int32_t*)s_info->current_arg_info.current_arg; 
                         break;
                     case  INTEGER_16_TYPE:
-                        integer_val = (int64_t)*(int16_t*)s_info.current_arg_info.current_arg; 
+                        integer_val = (int64_t)*(int16_t*)s_info->current_arg_info.current_arg; 
                         break;
                     case  INTEGER_8_TYPE:
-                        integer_val = (int64_t)*(int8_t*)s_info.current_arg_info.current_arg; 
+                        integer_val = (int64_t)*(int8_t*)s_info->current_arg_info.current_arg; 
                         break;
                     case  FLOAT_64_TYPE:
-                        double_val = *(double*)s_info.current_arg_info.current_arg; 
+                        double_val = *(double*)s_info->current_arg_info.current_arg; 
                         break;
                     case  FLOAT_32_TYPE:
-                        double_val = (double)*(float*)s_info.current_arg_info.current_arg; 
+                        double_val = (double)*(float*)s_info->current_arg_info.current_arg; 
                         break;
                     case CHARACTER_TYPE:
-                        char_val = *(char**)s_info.current_arg_info.current_arg;
+                        char_val = *(char**)s_info->current_arg_info.current_arg;
                         break;
                     case LOGICAL_TYPE:
-                        bool_val = *(bool*)s_info.current_arg_info.current_arg;
+                        bool_val = *(bool*)s_info->current_arg_info.current_arg;
                         break;
                     default:
                         break;
                 }
                 if (tolower(value[0]) == 'a') {
                     // Handle if argument is actually logical (allowed in Fortran).
-                    if(s_info.current_element_type==LOGICAL_TYPE){
-                        handle_logical("l",*(bool*)s_info.current_arg_info.current_arg, &result);
+                    if(s_info->current_element_type==LOGICAL_TYPE){
+                        handle_logical("l",*(bool*)s_info->current_arg_info.current_arg, result);
                         continue;
                     }
-                    char* arg = *(char**)s_info.current_arg_info.current_arg;
+                    char* arg = *(char**)s_info->current_arg_info.current_arg;
                     if (arg == NULL) continue;
                     if (strlen(value) == 1) {
-                        result = append_to_string(result, arg);
+                        string_builder_append(result, arg);
                     } else {
                         char* str = (char*)malloc((strlen(value)) * sizeof(char));
                         memmove(str, value+1, strlen(value));
@@ -1506,14 +2275,14 @@ LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const c
                         snprintf(s, buffer_size, "%%%s.%ss", str, str);
                         char* string = (char*)malloc((atoi(str) + 1) * sizeof(char));
                         sprintf(string,s, arg);
-                        result = append_to_string(result, string);
+                        string_builder_append(result, string);
                         free(str);
                         free(s);
                         free(string);
                     }
                 } else if (tolower(value[0]) == 'i') {
                     // Integer Editing ( I[w[.m]] )
-                    handle_integer(value, integer_val, &result, is_SP_specifier);
+                    handle_integer(value, integer_val, result, is_SP_specifier);
                 } else if (tolower(value[0]) == 'b') {
                     int width = 0;
                     if (strlen(value) > 1) {
@@ -1522,33 +2291,33 @@ LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const c
 
                     int bit_size = 0;
                     uint64_t uval = 0;
-                    char fmt_type = primitive_enum_to_format_specifier(s_info.current_element_type);
+                    char fmt_type = primitive_enum_to_format_specifier(s_info->current_element_type);
                     if (fmt_type == 'i') {
-                        if (s_info.current_element_type == INTEGER_8_TYPE) {
+                        if (s_info->current_element_type == INTEGER_8_TYPE) {
                             bit_size = 8;
-                        } else if (s_info.current_element_type == INTEGER_16_TYPE) {
+                        } else if (s_info->current_element_type == INTEGER_16_TYPE) {
                             bit_size = 16;
-                        } else if (s_info.current_element_type == INTEGER_32_TYPE) {
+                        } else if (s_info->current_element_type == INTEGER_32_TYPE) {
                             bit_size = 32;
-                        } else if (s_info.current_element_type == INTEGER_64_TYPE) {
+                        } else if (s_info->current_element_type == INTEGER_64_TYPE) {
                             bit_size = 64;
                         }
                         uint64_t mask = (bit_size == 64) ? UINT64_MAX : ((1ULL << bit_size) - 1);
                         uval = ((uint64_t)integer_val) & mask;
                     } else if (fmt_type == 'f') {
-                        if (s_info.current_element_type == FLOAT_32_TYPE) {
+                        if (s_info->current_element_type == FLOAT_32_TYPE) {
                             float f = (float)double_val;
                             uint32_t bits;
                             memcpy(&bits, &f, sizeof(float));
                             uval = (uint64_t)bits;
                             bit_size = 32;
-                        } else if (s_info.current_element_type == FLOAT_64_TYPE) {
+                        } else if (s_info->current_element_type == FLOAT_64_TYPE) {
                             double d = double_val;
                             memcpy(&uval, &d, sizeof(double));
                             bit_size = 64;
                         }
                     } else {
-                        result = append_to_string(result, "<unsupported>");
+                        string_builder_append(result, "<unsupported>");
                         break;
                     }
 
@@ -1573,22 +2342,14 @@ LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const c
                     int bin_len = strlen(binary_str);
 
                     if (width == 0) {
-                        result = append_to_string(result, binary_str);
+                        string_builder_append(result, binary_str);
                     } else if (bin_len > width) {
-                        for (int i = 0; i < width; i++) {
-                            result = append_to_string(result, "*");
-                        }
+                        string_builder_append_repeat(result, '*', width);
                     } else {
                         int padding_needed = width - bin_len;
                         char pad_char = ' ';
-                        if (padding_needed > 0) {
-                            char* pad = (char*)malloc((padding_needed + 1) * sizeof(char));
-                            memset(pad, pad_char, padding_needed);
-                            pad[padding_needed] = '\0';
-                            result = append_to_string(result, pad);
-                            free(pad);
-                        }
-                        result = append_to_string(result, binary_str);
+                        string_builder_append_repeat(result, pad_char, padding_needed);
+                        string_builder_append(result, binary_str);
                     }
                 } else if (tolower(value[0]) == 'g') {
                     int width = 0;
@@ -1600,40 +2361,41 @@ LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const c
                         precision = atoi(value + 3); // Get precision after 'g.'
                     }
                     char buffer[100];
-                    if (s_info.current_element_type == FLOAT_32_TYPE || s_info.current_element_type == FLOAT_64_TYPE) {
+                    if (s_info->current_element_type == FLOAT_32_TYPE || s_info->current_element_type == FLOAT_64_TYPE) {
                         char format_spec[20];
                         snprintf(format_spec, sizeof(format_spec), "%%#.%dG", precision);
                         snprintf(buffer, sizeof(buffer), format_spec, double_val);
-                        result = append_to_string(result, buffer);
-                    } else if (s_info.current_element_type == INTEGER_8_TYPE ||
-                               s_info.current_element_type == INTEGER_16_TYPE ||
-                               s_info.current_element_type == INTEGER_32_TYPE ||
-                               s_info.current_element_type == INTEGER_64_TYPE) {
-                        snprintf(result, sizeof(buffer), "%"PRId64, integer_val);
-                    } else if (s_info.current_element_type == CHARACTER_TYPE) {
-                        result = append_to_string(result, char_val);
-                    } else if (s_info.current_element_type == LOGICAL_TYPE) {
-                        result = append_to_string(result, bool_val ? "T" : "F");
+                        string_builder_append(result, buffer);
+                    } else if (s_info->current_element_type == INTEGER_8_TYPE ||
+                               s_info->current_element_type == INTEGER_16_TYPE ||
+                               s_info->current_element_type == INTEGER_32_TYPE ||
+                               s_info->current_element_type == INTEGER_64_TYPE) {
+                        snprintf(buffer, sizeof(buffer), "%"PRId64, integer_val);
+                        string_builder_append(result, buffer);
+                    } else if (s_info->current_element_type == CHARACTER_TYPE) {
+                        string_builder_append(result, char_val);
+                    } else if (s_info->current_element_type == LOGICAL_TYPE) {
+                        string_builder_append(result, bool_val ? "T" : "F");
                     } else {
-                        result = append_to_string(result, "<unsupported>");
+                        string_builder_append(result, "<unsupported>");
                     }
                 } else if (tolower(value[0]) == 'd') {
                     // D Editing (D[w[.d]])
-                    double val = *(double*)s_info.current_arg_info.current_arg;
-                    handle_decimal(value, double_val, scale, &result, "D", is_SP_specifier);
+                    double val = *(double*)s_info->current_arg_info.current_arg;
+                    handle_decimal(value, double_val, scale, result, "D", is_SP_specifier);
                 } else if (tolower(value[0]) == 'e') {
                     // Check if the next character is 'N' for EN format
                     char format_type = tolower(value[1]);
                     if (format_type == 'n') {
-                        handle_en(value, double_val, scale, &result, "E", is_SP_specifier);
+                        handle_en(value, double_val, scale, result, "E", is_SP_specifier);
                     } else {
-                        handle_decimal(value, double_val, scale, &result, "E", is_SP_specifier);
+                        handle_decimal(value, double_val, scale, result, "E", is_SP_specifier);
                     }
                 } else if (tolower(value[0]) == 'f') {
-                    handle_float(value, double_val, &result, is_SP_specifier);
+                    handle_float(value, double_val, result, is_SP_specifier);
                 } else if (tolower(value[0]) == 'l') {
-                    bool val = *(bool*)s_info.current_arg_info.current_arg;
-                    handle_logical(value, val, &result);
+                    bool val = *(bool*)s_info->current_arg_info.current_arg;
+                    handle_logical(value, val, result);
                 } else if (strlen(value) != 0) {
                     printf("Printing support is not available for %s format.\n",value);
                 }
@@ -1641,23 +2403,201 @@ LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const c
             }
         }
         if(BreakWhileLoop) break;
-        if (move_to_next_element(&s_info, true)) {
+        if (move_to_next_element(s_info, true)) {
             if (!array) {
-                result = append_to_string(result, "\n");
+                string_builder_append(result, "\n");
             }
             item_start = item_start_idx;
         } else {
             break;
         }
     }
+    if (owns_values) {
+        for (int i = 0;(i<format_values_count);i++) {
+                free(format_values[i]);
+        }
+        free(format_values);
+    }
+}
+
+/*
+Formats one record into `result`, with the format specifiers in `format_table`
+if it is not NULL (see `_lcompilers_precompile_format`), otherwise with the
+`format` string, or list-directed if that is NULL as well.
+*/
+static void format_record(String_Builder* result, const char* format,
+    const char* format_table, int64_t n_values, int64_t item_start,
+    struct serialization_info* s_info)
+{
+    if (format_table != NULL) {
+        char* values_buffer[32];
+        char** format_values = n_values <= 32 ? values_buffer
+            : (char**)malloc(n_values * sizeof(char*));
+        const char* value = format_table;
+        for (int64_t i = 0; i < n_values; i++) {
+            format_values[i] = (char*)value;
+            value += strlen(value) + 1;
+        }
+        format_fortran_values(format_values, n_values, item_start, false,
+            s_info, result);
+        if (format_values != values_buffer) free(format_values);
+        return;
+    }
+
+    if(format == NULL){
+        default_formatting(result, s_info);
+        return;
+    }
+
+    int64_t format_values_count = 0,item_start_idx=0;
+    char** format_values;
+    char* modified_input_string;
+    char* cleaned_format = remove_spaces_except_quotes(format);
+    if (!cleaned_format) {
+        return;
+    }
+    int len = strlen(cleaned_format);
+    modified_input_string = (char*)malloc((len+1) * sizeof(char));
+    strncpy(modified_input_string, cleaned_format, len);
+    modified_input_string[len] = '\0';
+    if (cleaned_format[0] == '(' && cleaned_format[len-1] == ')') {
+        memmove(modified_input_string, modified_input_string + 1, strlen(modified_input_string));
+        modified_input_string[len-2] = '\0';
+    }
+    free(cleaned_format);
+    format_values = parse_fortran_format(modified_input_string, &format_values_count, &item_start_idx, true);
+    format_fortran_values(format_values, format_values_count,
+        item_start_idx, true, s_info, result);
     free(modified_input_string);
-    for (int i = 0;(i<format_values_count);i++) {
-            free(format_values[i]);
+}
+
+LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format, const char* serialization_string, 
+    int32_t array_sizes_cnt, ...)
+{
+    va_list args;
+    va_start(args, array_sizes_cnt);
+
+    // Setup s_info
+    struct serialization_info s_info;
+    init_serialization_info(&s_info, serialization_string, array_sizes_cnt, &args);
+
+    String_Builder result;
+    string_builder_init(&result, NULL, 64);
+    format_record(&result, format, NULL, 0, 0, &s_info);
+    free_serialization_info(&s_info);
+    return string_builder_release(&result);
+}
+
+/*
+Parses a constant format string once, at compile time, into the format
+specifiers that `_lcompilers_string_format_fortran_compiled` runs: the same
+ones `_lcompilers_string_format_fortran` gets from `parse_fortran_format`,
+but with all parenthesized groups already expanded (in the order the
+formatting loop expands them, so that the item to restart from when the
+format is reverted is the same).
+
+Returns a buffer (to be freed by the caller) of `*n_values` consecutive
+null-terminated specifiers, `*size` bytes in total, and the index of the
+specifier to restart from in `*item_start`. Returns NULL if the format string
+is invalid; it is then left to the runtime to report the error.
+*/
+LFORTRAN_API char* _lcompilers_precompile_format(const char* format,
+    int64_t* n_values, int64_t* item_start, int64_t* size)
+{
+    char* cleaned_format = remove_spaces_except_quotes(format);
+    if (!cleaned_format) return NULL;
+    int len = strlen(cleaned_format);
+    char* modified_input_string = (char*)malloc((len+1) * sizeof(char));
+    strncpy(modified_input_string, cleaned_format, len);
+    modified_input_string[len] = '\0';
+    if (cleaned_format[0] == '(' && cleaned_format[len-1] == ')') {
+        memmove(modified_input_string, modified_input_string + 1, strlen(modified_input_string));
+        modified_input_string[len-2] = '\0';
+    }
+    free(cleaned_format);
+
+    int64_t format_values_count = 0, item_start_idx = 0;
+    char** format_values = parse_fortran_format(modified_input_string,
+        &format_values_count, &item_start_idx, false);
+    free(modified_input_string);
+    if (format_values == NULL) return NULL;
+
+    bool valid = true;
+    for (int64_t i = 0; i < format_values_count; i++) {
+        char* value = format_values[i];
+        if (value == NULL) continue;
+        size_t value_len = strlen(value);
+        if (!(value[0] == '(' && value[value_len-1] == ')')) continue;
+        value[value_len-1] = '\0';
+        int64_t new_fmt_val_count = 0;
+        char** new_fmt_val = parse_fortran_format(value + 1, &new_fmt_val_count,
+            &item_start_idx, false);
+        if (new_fmt_val == NULL) {
+            valid = false;
+            break;
+        }
+        format_values = (char**)realloc(format_values,
+            (format_values_count + new_fmt_val_count + 1) * sizeof(char*));
+        for (int64_t k = format_values_count - 1; k >= i+1; k--) {
+            format_values[k + new_fmt_val_count] = format_values[k];
+        }
+        for (int64_t k = 0; k < new_fmt_val_count; k++) {
+            format_values[i + 1 + k] = new_fmt_val[k];
+        }
+        format_values_count += new_fmt_val_count;
+        free(format_values[i]);
+        format_values[i] = NULL;
+        free(new_fmt_val);
+    }
+
+    char* table = NULL;
+    if (valid) {
+        // Drop the expanded groups, which the formatting loop skips
+        int64_t count = 0, start = 0, table_size = 0;
+        for (int64_t i = 0; i < format_values_count; i++) {
+            if (format_values[i] == NULL) continue;
+            if (i < item_start_idx) start++;
+            count++;
+            table_size += strlen(format_values[i]) + 1;
+        }
+        table = (char*)malloc(table_size + 1);
+        char* p = table;
+        for (int64_t i = 0; i < format_values_count; i++) {
+            if (format_values[i] == NULL) continue;
+            size_t value_size = strlen(format_values[i]) + 1;
+            memcpy(p, format_values[i], value_size);
+            p += value_size;
+        }
+        *n_values = count;
+        *item_start = start;
+        *size = table_size;
+    }
+    for (int64_t i = 0; i < format_values_count; i++) {
+        free(format_values[i]);
     }
-    va_end(args);
     free(format_values);
+    return table;
+}
+
+/*
+Like `_lcompilers_string_format_fortran`, but runs a format string that was
+parsed at compile time by `_lcompilers_precompile_format`.
+*/
+LFORTRAN_API char* _lcompilers_string_format_fortran_compiled(const char* format_table,
+    int64_t n_values, int64_t item_start, const char* serialization_string,
+    int32_t array_sizes_cnt, ...)
+{
+    va_list args;
+    va_start(args, array_sizes_cnt);
+
+    struct serialization_info s_info;
+    init_serialization_info(&s_info, serialization_string, array_sizes_cnt, &args);
+
+    String_Builder result;
+    string_builder_init(&result, NULL, 64);
+    format_record(&result, NULL, format_table, n_values, item_start, &s_info);
     free_serialization_info(&s_info);
-    return result;
+    return string_builder_release(&result);
 }
 
 LFORTRAN_API void _lcompilers_print_error(const char* format, ...)
@@ -2888,24 +3828,156 @@ LFORTRAN_API char* _lfortran_str_chr(int val)
     return dest_char;
 }
 
-LFORTRAN_API void _lfortran_memset(void* s, int32_t c, int32_t size) {
-    memset(s, c, size);
+LFORTRAN_API void _lfortran_memset(void* s, int32_t c, int32_t size) {
+    memset(s, c, size);
+}
+
+LFORTRAN_API void* _lfortran_malloc(int64_t size) {
+    return malloc(size);
+}
+
+LFORTRAN_API int8_t* _lfortran_realloc(int8_t* ptr, int64_t size) {
+    return (int8_t*) realloc(ptr, size);
+}
+
+LFORTRAN_API int8_t* _lfortran_calloc(int64_t count, int64_t size) {
+    return (int8_t*) calloc(count, size);
+}
+
+LFORTRAN_API void _lfortran_free(char* ptr) {
+    free((void*)ptr);
+}
+
+/*
+ * Pool allocator for array data (allocatable arrays, automatic arrays and
+ * the temporaries created by the array passes).
+ *
+ * Requests up to LFORTRAN_POOL_MAX_SHIFT bytes are rounded up to a power of
+ * two size class. Freed blocks are kept in a small per-thread cache for each
+ * class, so the allocate/deallocate pairs of temporaries in loops are served
+ * without calling malloc. Larger requests are passed through to
+ * malloc/realloc/free directly. Every block carries a header recording its
+ * class, so a block may be freed or reallocated by any thread.
+ *
+ * Memory returned by _lfortran_pool_malloc must only be released with
+ * _lfortran_pool_free (or resized with _lfortran_pool_realloc).
+ *
+ * The compiler may also serve small requests from a buffer on the stack of
+ * the allocating procedure. It then writes a header with the class
+ * LFORTRAN_POOL_STACK and the capacity of the buffer in front of the data:
+ * freeing such a block does nothing and growing it past its capacity moves
+ * the data to the heap.
+ */
+#define LFORTRAN_POOL_MIN_SHIFT 5
+#define LFORTRAN_POOL_MAX_SHIFT 20
+#define LFORTRAN_POOL_NCLASSES (LFORTRAN_POOL_MAX_SHIFT - LFORTRAN_POOL_MIN_SHIFT + 1)
+// Bytes a thread may keep cached per size class (at least 4 blocks).
+#define LFORTRAN_POOL_CACHE_BYTES (1 << 22)
+#define LFORTRAN_POOL_LARGE -1
+#define LFORTRAN_POOL_STACK -2
+
+// 16 bytes to keep the alignment guaranteed by malloc for the user data
+typedef union lfortran_pool_header {
+    struct {
+        int64_t size_class;
+        union {
+            union lfortran_pool_header* next;
+            // Size of the buffer (LFORTRAN_POOL_STACK blocks only)
+            int64_t capacity;
+        } u;
+    } h;
+    char pad[16];
+} lfortran_pool_header;
+
+struct lfortran_pool_cache {
+    lfortran_pool_header* head;
+    int32_t count;
+};
+
+static LFORTRAN_THREAD_LOCAL struct lfortran_pool_cache
+    lfortran_pool_caches[LFORTRAN_POOL_NCLASSES];
+
+static inline int64_t lfortran_pool_class(int64_t size) {
+    int64_t c = 0;
+    while (((int64_t)1 << (c + LFORTRAN_POOL_MIN_SHIFT)) < size) {
+        c++;
+    }
+    return c;
 }
 
-LFORTRAN_API void* _lfortran_malloc(int32_t size) {
-    return malloc(size);
+static inline int32_t lfortran_pool_cache_limit(int64_t size_class) {
+    int32_t limit = LFORTRAN_POOL_CACHE_BYTES >> (size_class + LFORTRAN_POOL_MIN_SHIFT);
+    return limit < 4 ? 4 : limit;
 }
 
-LFORTRAN_API int8_t* _lfortran_realloc(int8_t* ptr, int32_t size) {
-    return (int8_t*) realloc(ptr, size);
+LFORTRAN_API void* _lfortran_pool_malloc(int64_t size) {
+    lfortran_pool_header* block;
+    if (size > ((int64_t)1 << LFORTRAN_POOL_MAX_SHIFT)) {
+        block = (lfortran_pool_header*) malloc(sizeof(lfortran_pool_header) + size);
+        if (block == NULL) return NULL;
+        block->h.size_class = LFORTRAN_POOL_LARGE;
+        return block + 1;
+    }
+    int64_t size_class = lfortran_pool_class(size);
+    struct lfortran_pool_cache* cache = &lfortran_pool_caches[size_class];
+    if (cache->head != NULL) {
+        block = cache->head;
+        cache->head = block->h.u.next;
+        cache->count--;
+    } else {
+        block = (lfortran_pool_header*) malloc(sizeof(lfortran_pool_header)
+            + ((size_t)1 << (size_class + LFORTRAN_POOL_MIN_SHIFT)));
+        if (block == NULL) return NULL;
+    }
+    block->h.size_class = size_class;
+    return block + 1;
 }
 
-LFORTRAN_API int8_t* _lfortran_calloc(int32_t count, int32_t size) {
-    return (int8_t*) calloc(count, size);
+LFORTRAN_API void _lfortran_pool_free(void* ptr) {
+    if (ptr == NULL) return;
+    lfortran_pool_header* block = (lfortran_pool_header*) ptr - 1;
+    int64_t size_class = block->h.size_class;
+    if (size_class == LFORTRAN_POOL_STACK) {
+        return;
+    }
+    if (size_class == LFORTRAN_POOL_LARGE) {
+        free(block);
+        return;
+    }
+    struct lfortran_pool_cache* cache = &lfortran_pool_caches[size_class];
+    if (cache->count >= lfortran_pool_cache_limit(size_class)) {
+        free(block);
+        return;
+    }
+    block->h.u.next = cache->head;
+    cache->head = block;
+    cache->count++;
 }
 
-LFORTRAN_API void _lfortran_free(char* ptr) {
-    free((void*)ptr);
+LFORTRAN_API void* _lfortran_pool_realloc(void* ptr, int64_t size) {
+    if (ptr == NULL) return _lfortran_pool_malloc(size);
+    lfortran_pool_header* block = (lfortran_pool_header*) ptr - 1;
+    int64_t size_class = block->h.size_class;
+    int64_t capacity;
+    if (size_class == LFORTRAN_POOL_LARGE) {
+        if (size > ((int64_t)1 << LFORTRAN_POOL_MAX_SHIFT)) {
+            block = (lfortran_pool_header*) realloc(block, sizeof(lfortran_pool_header) + size);
+            return block == NULL ? NULL : block + 1;
+        }
+        // Shrinking a large block into a size class: copy what fits
+        capacity = size;
+    } else if (size_class == LFORTRAN_POOL_STACK) {
+        capacity = block->h.u.capacity;
+        if (size <= capacity) return ptr;
+    } else {
+        capacity = (int64_t)1 << (size_class + LFORTRAN_POOL_MIN_SHIFT);
+        if (size <= capacity) return ptr;
+    }
+    void* new_ptr = _lfortran_pool_malloc(size);
+    if (new_ptr == NULL) return NULL;
+    memcpy(new_ptr, ptr, capacity < size ? capacity : size);
+    _lfortran_pool_free(ptr);
+    return new_ptr;
 }
 
 
@@ -3223,37 +4295,420 @@ LFORTRAN_API int32_t _lfortran_values(int32_t n)
     return result;
 }
 
+// profiling (--instrument) ----------------------------------------------------
+
+/*
+ * The instrument pass encloses the procedures and loop nests of a program in
+ * `_lfortran_profile_enter(&site, desc)` and `_lfortran_profile_exit(&site)`.
+ * `site` is a saved variable of the region, numbered by the first enter;
+ * `desc` is "kind<TAB>frame<TAB>file:line".
+ *
+ * Each thread keeps its own calling context tree: one node per path of
+ * regions from the root, with the number of calls, the total time and the
+ * time not spent in nested regions. Nothing is shared on the fast path. At
+ * exit the trees of all threads are written as
+ *
+ *   <prefix>.txt     the flat profile, one line per region
+ *   <prefix>.folded  the collapsed stacks (`a;b;c <self time in us>`), the
+ *                    input of flamegraph.pl, speedscope and similar tools
+ *
+ * where <prefix> is $LFORTRAN_PROFILE_OUTPUT, or "lfortran_profile".
+ *
+ * The time stamp counter is read on x86 and calibrated against the monotonic
+ * clock at exit, the monotonic clock is read elsewhere.
+ */
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#if !defined(_MSC_VER)
+#include <x86intrin.h>
+#endif
+#define LFORTRAN_PROFILE_TSC
+#endif
+
+struct lfortran_profile_site {
+    char *kind;
+    char *frame;
+    char *location;
+};
+
+struct lfortran_profile_node {
+    int32_t site;
+    int32_t parent;
+    int32_t first_child;
+    int32_t next_sibling;
+    uint64_t calls;
+    uint64_t total;
+    uint64_t self;
+};
+
+struct lfortran_profile_frame {
+    int32_t node;
+    uint64_t start;
+    uint64_t children;
+};
+
+struct lfortran_profile_thread {
+    struct lfortran_profile_node *nodes;
+    int32_t n_nodes, nodes_capacity;
+    struct lfortran_profile_frame *stack;
+    int32_t depth, stack_capacity;
+    struct lfortran_profile_thread *next;
+};
+
+static struct lfortran_profile_site *profile_sites = NULL;
+static int32_t profile_n_sites = 0, profile_sites_capacity = 0;
+static struct lfortran_profile_thread *profile_threads = NULL;
+static lfortran_lock_t profile_lock_flag = 0;
+static uint64_t profile_start_ticks, profile_start_ns;
+static LFORTRAN_THREAD_LOCAL struct lfortran_profile_thread *profile_thread = NULL;
+
+static uint64_t profile_ns() {
+    struct timespec ts;
+#if defined(_WIN32)
+    timespec_get(&ts, TIME_UTC);
+#else
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static inline uint64_t profile_ticks() {
+#ifdef LFORTRAN_PROFILE_TSC
+    return __rdtsc();
+#else
+    return profile_ns();
+#endif
+}
+
+static char *profile_strndup(const char *s, size_t n) {
+    char *r = (char*)malloc(n + 1);
+    memcpy(r, s, n);
+    r[n] = '\0';
+    return r;
+}
+
+static void profile_write_report();
+
+static int32_t profile_register_site(int32_t *site, const char *desc) {
+    lfortran_lock(&profile_lock_flag);
+    int32_t id = *site;
+    if (id == 0) {
+        if (profile_n_sites == 0) {
+            profile_start_ns = profile_ns();
+            profile_start_ticks = profile_ticks();
+            atexit(profile_write_report);
+        }
+        if (profile_n_sites == profile_sites_capacity) {
+            profile_sites_capacity = profile_sites_capacity ? 2 * profile_sites_capacity : 64;
+            profile_sites = (struct lfortran_profile_site*)realloc(profile_sites,
+                profile_sites_capacity * sizeof(struct lfortran_profile_site));
+        }
+        struct lfortran_profile_site *s = &profile_sites[profile_n_sites];
+        const char *frame = strchr(desc, '\t');
+        const char *location = frame ? strchr(frame + 1, '\t') : NULL;
+        if (location) {
+            s->kind = profile_strndup(desc, frame - desc);
+            s->frame = profile_strndup(frame + 1, location - frame - 1);
+            s->location = profile_strndup(location + 1, strlen(location + 1));
+        } else {
+            s->kind = profile_strndup("region", 6);
+            s->frame = profile_strndup(desc, strlen(desc));
+            s->location = profile_strndup("", 0);
+        }
+        id = ++profile_n_sites;
+#if defined(_MSC_VER)
+        *(volatile int32_t*)site = id;
+#else
+        __atomic_store_n(site, id, __ATOMIC_RELEASE);
+#endif
+    }
+    lfortran_unlock(&profile_lock_flag);
+    return id;
+}
+
+static struct lfortran_profile_thread *profile_new_thread() {
+    struct lfortran_profile_thread *t = (struct lfortran_profile_thread*)
+        calloc(1, sizeof(struct lfortran_profile_thread));
+    t->nodes_capacity = 64;
+    t->nodes = (struct lfortran_profile_node*)malloc(
+        t->nodes_capacity * sizeof(struct lfortran_profile_node));
+    // Node 0 is the root of the tree
+    memset(&t->nodes[0], 0, sizeof(struct lfortran_profile_node));
+    t->nodes[0].first_child = -1;
+    t->nodes[0].next_sibling = -1;
+    t->n_nodes = 1;
+    t->stack_capacity = 64;
+    t->stack = (struct lfortran_profile_frame*)malloc(
+        t->stack_capacity * sizeof(struct lfortran_profile_frame));
+    lfortran_lock(&profile_lock_flag);
+    t->next = profile_threads;
+    profile_threads = t;
+    lfortran_unlock(&profile_lock_flag);
+    profile_thread = t;
+    return t;
+}
+
+// The child of `parent` for `site`, added if it is not there yet
+static int32_t profile_child(struct lfortran_profile_thread *t, int32_t parent,
+        int32_t site) {
+    int32_t n = t->nodes[parent].first_child;
+    while (n != -1 && t->nodes[n].site != site) {
+        n = t->nodes[n].next_sibling;
+    }
+    if (n != -1) return n;
+    if (t->n_nodes == t->nodes_capacity) {
+        t->nodes_capacity *= 2;
+        t->nodes = (struct lfortran_profile_node*)realloc(t->nodes,
+            t->nodes_capacity * sizeof(struct lfortran_profile_node));
+    }
+    n = t->n_nodes++;
+    struct lfortran_profile_node *node = &t->nodes[n];
+    memset(node, 0, sizeof(struct lfortran_profile_node));
+    node->site = site;
+    node->parent = parent;
+    node->first_child = -1;
+    node->next_sibling = t->nodes[parent].first_child;
+    t->nodes[parent].first_child = n;
+    return n;
+}
+
+LFORTRAN_API void _lfortran_profile_enter(int32_t *site, const char *desc) {
+#if defined(_MSC_VER)
+    int32_t id = *(volatile int32_t*)site;
+#else
+    int32_t id = __atomic_load_n(site, __ATOMIC_ACQUIRE);
+#endif
+    if (id == 0) id = profile_register_site(site, desc);
+    struct lfortran_profile_thread *t = profile_thread;
+    if (t == NULL) t = profile_new_thread();
+    int32_t parent = t->depth ? t->stack[t->depth - 1].node : 0;
+    int32_t node = profile_child(t, parent, id);
+    if (t->depth == t->stack_capacity) {
+        t->stack_capacity *= 2;
+        t->stack = (struct lfortran_profile_frame*)realloc(t->stack,
+            t->stack_capacity * sizeof(struct lfortran_profile_frame));
+    }
+    struct lfortran_profile_frame *f = &t->stack[t->depth++];
+    f->node = node;
+    f->children = 0;
+    f->start = profile_ticks();
+}
+
+// Closes the innermost `depth - to` regions of `t` at `now`
+static void profile_pop(struct lfortran_profile_thread *t, int32_t to,
+        uint64_t now) {
+    while (t->depth > to) {
+        struct lfortran_profile_frame *f = &t->stack[--t->depth];
+        struct lfortran_profile_node *node = &t->nodes[f->node];
+        uint64_t elapsed = now - f->start;
+        node->calls++;
+        node->total += elapsed;
+        node->self += elapsed - f->children;
+        if (t->depth > 0) {
+            t->stack[t->depth - 1].children += elapsed;
+        }
+    }
+}
+
+LFORTRAN_API void _lfortran_profile_exit(int32_t *site) {
+    uint64_t now = profile_ticks();
+    struct lfortran_profile_thread *t = profile_thread;
+    if (t == NULL) return;
+    int32_t id = *site;
+    // The regions inside this one that were left by `return` or `go to`
+    // are closed with it
+    int32_t d = t->depth;
+    while (d > 0 && t->nodes[t->stack[d - 1].node].site != id) d--;
+    if (d > 0) profile_pop(t, d - 1, now);
+}
+
+struct lfortran_profile_stack {
+    char *path;
+    uint64_t self;
+};
+
+static int profile_compare_stacks(const void *a, const void *b) {
+    return strcmp(((const struct lfortran_profile_stack*)a)->path,
+        ((const struct lfortran_profile_stack*)b)->path);
+}
+
+struct lfortran_profile_flat {
+    int32_t site;
+    uint64_t calls, total, self;
+};
+
+static int profile_compare_flat(const void *a, const void *b) {
+    uint64_t x = ((const struct lfortran_profile_flat*)a)->self;
+    uint64_t y = ((const struct lfortran_profile_flat*)b)->self;
+    return x < y ? 1 : x > y ? -1 : 0;
+}
+
+static void profile_write_report() {
+    uint64_t now = profile_ticks();
+    uint64_t now_ns = profile_ns();
+    double seconds_per_tick = 1e-9;
+#ifdef LFORTRAN_PROFILE_TSC
+    if (now > profile_start_ticks && now_ns > profile_start_ns) {
+        seconds_per_tick = (now_ns - profile_start_ns) * 1e-9
+            / (now - profile_start_ticks);
+    }
+#endif
+    // The regions of the exiting thread that are still open (`stop`)
+    if (profile_thread) profile_pop(profile_thread, 0, now);
+
+    lfortran_lock(&profile_lock_flag);
+    int32_t n_sites = profile_n_sites;
+    struct lfortran_profile_flat *flat = (struct lfortran_profile_flat*)
+        calloc(n_sites + 1, sizeof(struct lfortran_profile_flat));
+    size_t n_stacks = 0, n_threads = 0;
+    for (struct lfortran_profile_thread *t = profile_threads; t; t = t->next) {
+        n_stacks += t->n_nodes;
+        n_threads++;
+    }
+    struct lfortran_profile_stack *stacks = (struct lfortran_profile_stack*)
+        malloc((n_stacks + 1) * sizeof(struct lfortran_profile_stack));
+    n_stacks = 0;
+    for (struct lfortran_profile_thread *t = profile_threads; t; t = t->next) {
+        for (int32_t i = 1; i < t->n_nodes; i++) {
+            struct lfortran_profile_node *node = &t->nodes[i];
+            struct lfortran_profile_flat *f = &flat[node->site];
+            f->calls += node->calls;
+            f->self += node->self;
+            // Recursive calls are already in the total of the outer call
+            size_t path_size = 0;
+            bool recursive = false;
+            for (int32_t p = i; p != 0; p = t->nodes[p].parent) {
+                if (p != i && t->nodes[p].site == node->site) recursive = true;
+                path_size += strlen(profile_sites[t->nodes[p].site - 1].frame) + 1;
+            }
+            if (!recursive) f->total += node->total;
+            if (node->self == 0) continue;
+            char *path = (char*)malloc(path_size);
+            size_t pos = path_size - 1;
+            path[pos] = '\0';
+            for (int32_t p = i; p != 0; p = t->nodes[p].parent) {
+                const char *frame = profile_sites[t->nodes[p].site - 1].frame;
+                size_t n = strlen(frame);
+                if (p != i) path[--pos] = ';';
+                pos -= n;
+                memcpy(path + pos, frame, n);
+            }
+            stacks[n_stacks].path = path;
+            stacks[n_stacks].self = node->self;
+            n_stacks++;
+        }
+    }
+    lfortran_unlock(&profile_lock_flag);
+
+    const char *prefix = getenv("LFORTRAN_PROFILE_OUTPUT");
+    if (prefix == NULL || prefix[0] == '\0') prefix = "lfortran_profile";
+    size_t prefix_size = strlen(prefix);
+    char *filename = (char*)malloc(prefix_size + 8);
+
+    memcpy(filename, prefix, prefix_size);
+    strcpy(filename + prefix_size, ".txt");
+    FILE *fp = fopen(filename, "w");
+    if (fp) {
+        // Site ids start at 1
+        for (int32_t i = 0; i < n_sites; i++) {
+            flat[i] = flat[i + 1];
+            flat[i].site = i + 1;
+        }
+        qsort(flat, n_sites, sizeof(struct lfortran_profile_flat), profile_compare_flat);
+        fprintf(fp, "Flat profile (seconds, %zu thread%s)\n\n", n_threads,
+            n_threads == 1 ? "" : "s");
+        fprintf(fp, "%12s %12s %12s  %s\n", "self", "total", "calls", "region");
+        for (int32_t i = 0; i < n_sites; i++) {
+            struct lfortran_profile_site *s = &profile_sites[flat[i].site - 1];
+            if (flat[i].calls == 0) continue;
+            fprintf(fp, "%12.6f %12.6f %12" PRIu64 "  %s %s%s%s%s\n",
+                flat[i].self * seconds_per_tick, flat[i].total * seconds_per_tick,
+                flat[i].calls, s->kind, s->frame, s->location[0] ? " (" : "",
+                s->location, s->location[0] ? ")" : "");
+        }
+        fclose(fp);
+    }
+
+    strcpy(filename + prefix_size, ".folded");
+    fp = fopen(filename, "w");
+    if (fp) {
+        // The same stack of several threads is written once
+        qsort(stacks, n_stacks, sizeof(struct lfortran_profile_stack),
+            profile_compare_stacks);
+        for (size_t i = 0; i < n_stacks;) {
+            uint64_t self = 0;
+            size_t j = i;
+            for (; j < n_stacks && strcmp(stacks[j].path, stacks[i].path) == 0; j++) {
+                self += stacks[j].self;
+            }
+            uint64_t us = (uint64_t)(self * seconds_per_tick * 1e6 + 0.5);
+            if (us > 0) fprintf(fp, "%s %" PRIu64 "\n", stacks[i].path, us);
+            i = j;
+        }
+        fclose(fp);
+    }
+    for (size_t i = 0; i < n_stacks; i++) free(stacks[i].path);
+    free(stacks);
+    free(flat);
+    free(filename);
+}
+
 LFORTRAN_API float _lfortran_sp_rand_num() {
-    return rand() / (float) RAND_MAX;
+    return rng_next_float();
 }
 
 LFORTRAN_API double _lfortran_dp_rand_num() {
-    return rand() / (double) RAND_MAX;
+    return rng_next_double();
 }
 
 LFORTRAN_API int32_t _lfortran_int32_rand_num() {
-    return rand();
+    return (int32_t)(rng_next() >> 33);
 }
 
 LFORTRAN_API int64_t _lfortran_int64_rand_num() {
-    return rand();
+    return (int64_t)(rng_next() >> 1);
 }
 
 LFORTRAN_API bool _lfortran_random_init(bool repeatable, bool image_distinct) {
     if (repeatable) {
-            srand(0);
+        rng_seed_from_u64(0);
     } else {
-        srand(time(NULL));
+        rng_seed_from_u64((uint64_t)time(NULL));
     }
     return false;
 }
 
 LFORTRAN_API int64_t _lfortran_random_seed(unsigned seed)
 {
-    srand(seed);
-    // The seed array size is typically 8 elements because Fortran's RNG often uses a seed with a fixed length of 8 integers to ensure sufficient randomness and repeatability in generating sequences of random numbers.
+    // The seed array holds the 256 bit generator state as 8 32-bit integers
     return 8;
+}
+
+/*
+Sets the seed from the 8 integers of random_seed(put=...) and returns the
+size of the seed.
+*/
+LFORTRAN_API int32_t _lfortran_random_seed_put(int32_t s1, int32_t s2, int32_t s3,
+    int32_t s4, int32_t s5, int32_t s6, int32_t s7, int32_t s8)
+{
+    uint32_t s[8] = {(uint32_t)s1, (uint32_t)s2, (uint32_t)s3, (uint32_t)s4,
+        (uint32_t)s5, (uint32_t)s6, (uint32_t)s7, (uint32_t)s8};
+    uint64_t seed[4];
+    for (int i = 0; i < 4; i++) {
+        seed[i] = (uint64_t)s[2*i] | ((uint64_t)s[2*i + 1] << 32);
+    }
+    rng_set_seed(seed);
+    return 8;
+}
 
+/*
+Returns the `i`-th (1 based) of the 8 integers of random_seed(get=...): the
+current state of the calling thread, which random_seed(put=...) restores.
+*/
+LFORTRAN_API int32_t _lfortran_random_seed_get(int32_t i)
+{
+    const uint64_t* s = rng_thread_state();
+    return (int32_t)(uint32_t)(s[(i - 1) / 2] >> (32 * ((i - 1) % 2)));
 }
 
 LFORTRAN_API int64_t _lpython_open(char *path, char *flags)
@@ -3269,82 +4724,187 @@ LFORTRAN_API int64_t _lpython_open(char *path, char *flags)
     return (int64_t)fd;
 }
 
-#define MAXUNITS 1000
-
 struct UNIT_FILE {
     int32_t unit;
     char* filename;
     FILE* filep;
     bool unit_file_bin;
     int access_id;
+    bool in_use;
+    // The file position is known to be at the end of the file, so a
+    // sequential write does not have to truncate the file after it
+    bool at_end;
 };
 
-int32_t last_index_used = -1;
+/*
+ * Open units are kept in an open-addressing hash table keyed by the unit
+ * number (linear probing, backward-shift deletion), so lookups on every
+ * read/write/flush are O(1) and the number of open units is only bounded by
+ * memory. The table is guarded by a spin lock: the critical sections are a
+ * few probes long and the actual I/O happens outside of it, so OpenMP
+ * threads writing to distinct units do not serialize on each other.
+ */
+#define UNIT_TABLE_INITIAL_CAPACITY 64
+#define LFORTRAN_UNIT_BUFFER_SIZE (64 * 1024)
 
-struct UNIT_FILE unit_to_file[MAXUNITS];
+static struct UNIT_FILE* unit_table = NULL;
+static uint32_t unit_table_capacity = 0;
+static uint32_t unit_table_count = 0;
 
-void store_unit_file(int32_t unit_num, char* filename, FILE* filep, bool unit_file_bin, int access_id) {
-    for( int i = 0; i <= last_index_used; i++ ) {
-        if( unit_to_file[i].unit == unit_num ) {
-            unit_to_file[i].unit = unit_num;
-            unit_to_file[i].filep = filep;
-            unit_to_file[i].unit_file_bin = unit_file_bin;
-            unit_to_file[i].access_id = access_id;
-        }
+static lfortran_lock_t unit_table_lock_flag = 0;
+
+static inline void unit_table_lock() {
+    lfortran_lock(&unit_table_lock_flag);
+}
+
+static inline void unit_table_unlock() {
+    lfortran_unlock(&unit_table_lock_flag);
+}
+
+static inline uint32_t unit_table_hash(int32_t unit_num) {
+    uint32_t h = (uint32_t)unit_num * 2654435769u;
+    return h ^ (h >> 16);
+}
+
+// Returns the slot holding `unit_num`, or the empty slot where it would be
+// inserted. Requires the lock to be held and the table to be allocated.
+static inline uint32_t unit_table_find_slot(int32_t unit_num) {
+    uint32_t mask = unit_table_capacity - 1;
+    uint32_t i = unit_table_hash(unit_num) & mask;
+    while (unit_table[i].in_use && unit_table[i].unit != unit_num) {
+        i = (i + 1) & mask;
     }
-    last_index_used += 1;
-    if( last_index_used >= MAXUNITS ) {
-        printf("Only %d units can be opened for now\n.", MAXUNITS);
+    return i;
+}
+
+static void unit_table_grow() {
+    uint32_t old_capacity = unit_table_capacity;
+    struct UNIT_FILE* old_table = unit_table;
+    unit_table_capacity = old_capacity ? 2 * old_capacity : UNIT_TABLE_INITIAL_CAPACITY;
+    unit_table = (struct UNIT_FILE*)calloc(unit_table_capacity, sizeof(struct UNIT_FILE));
+    if (unit_table == NULL) {
+        printf("Failed to allocate the unit table for %u units\n", unit_table_capacity);
         exit(1);
     }
-    unit_to_file[last_index_used].unit = unit_num;
-    unit_to_file[last_index_used].filename = filename;
-    unit_to_file[last_index_used].filep = filep;
-    unit_to_file[last_index_used].unit_file_bin = unit_file_bin;
-    unit_to_file[last_index_used].access_id = access_id;
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        if (old_table[i].in_use) {
+            unit_table[unit_table_find_slot(old_table[i].unit)] = old_table[i];
+        }
+    }
+    free(old_table);
+}
+
+void store_unit_file(int32_t unit_num, char* filename, FILE* filep, bool unit_file_bin, int access_id) {
+    unit_table_lock();
+    // Keep the load factor at or below 1/2 so that probe sequences stay short
+    if (2 * (unit_table_count + 1) > unit_table_capacity) {
+        unit_table_grow();
+    }
+    uint32_t i = unit_table_find_slot(unit_num);
+    if (!unit_table[i].in_use) {
+        unit_table_count++;
+    }
+    unit_table[i].unit = unit_num;
+    unit_table[i].filename = filename;
+    unit_table[i].filep = filep;
+    unit_table[i].unit_file_bin = unit_file_bin;
+    unit_table[i].access_id = access_id;
+    unit_table[i].in_use = true;
+    unit_table[i].at_end = false;
+    unit_table_unlock();
 }
 
 FILE* get_file_pointer_from_unit(int32_t unit_num, bool *unit_file_bin, int *access_id) {
     if (unit_file_bin) *unit_file_bin = false;
-    for( int i = 0; i <= last_index_used; i++ ) {
-        if( unit_to_file[i].unit == unit_num ) {
-            if (unit_file_bin) *unit_file_bin = unit_to_file[i].unit_file_bin;
-            if (access_id) *access_id = unit_to_file[i].access_id;
-            return unit_to_file[i].filep;
+    FILE* filep = NULL;
+    unit_table_lock();
+    if (unit_table_count > 0) {
+        uint32_t i = unit_table_find_slot(unit_num);
+        if (unit_table[i].in_use) {
+            if (unit_file_bin) *unit_file_bin = unit_table[i].unit_file_bin;
+            if (access_id) *access_id = unit_table[i].access_id;
+            filep = unit_table[i].filep;
+            // The caller may read, rewind, backspace, ...
+            unit_table[i].at_end = false;
         }
     }
-    return NULL;
+    unit_table_unlock();
+    return filep;
+}
+
+/*
+Like `get_file_pointer_from_unit`, for a sequential write. Sets `*truncate`
+if the file has to be truncated after the write (the written record becomes
+the last one of the file), which is only the case if the position may have
+moved away from the end of the file since the previous write.
+*/
+static FILE* get_file_pointer_for_write(int32_t unit_num, bool *unit_file_bin,
+    int *access_id, bool *truncate) {
+    *unit_file_bin = false;
+    *truncate = false;
+    FILE* filep = NULL;
+    unit_table_lock();
+    if (unit_table_count > 0) {
+        uint32_t i = unit_table_find_slot(unit_num);
+        if (unit_table[i].in_use) {
+            *unit_file_bin = unit_table[i].unit_file_bin;
+            *access_id = unit_table[i].access_id;
+            filep = unit_table[i].filep;
+            *truncate = !unit_table[i].at_end;
+            unit_table[i].at_end = true;
+        }
+    }
+    unit_table_unlock();
+    return filep;
 }
 
 char* get_file_name_from_unit(int32_t unit_num, bool *unit_file_bin) {
     *unit_file_bin = false;
-    for (int i = 0; i <= last_index_used; i++) {
-        if (unit_to_file[i].unit == unit_num) {
-            *unit_file_bin = unit_to_file[i].unit_file_bin;
-            return unit_to_file[i].filename;
+    char* filename = NULL;
+    unit_table_lock();
+    if (unit_table_count > 0) {
+        uint32_t i = unit_table_find_slot(unit_num);
+        if (unit_table[i].in_use) {
+            *unit_file_bin = unit_table[i].unit_file_bin;
+            filename = unit_table[i].filename;
         }
     }
-    return NULL;
+    unit_table_unlock();
+    return filename;
 }
 
 void remove_from_unit_to_file(int32_t unit_num) {
-    int index = -1;
-    for( int i = 0; i <= last_index_used; i++ ) {
-        if( unit_to_file[i].unit == unit_num ) {
-            index = i;
-            break;
-        }
+    unit_table_lock();
+    if (unit_table_count == 0) {
+        unit_table_unlock();
+        return ;
     }
-    if( index == -1 ) {
+    uint32_t mask = unit_table_capacity - 1;
+    uint32_t i = unit_table_find_slot(unit_num);
+    if (!unit_table[i].in_use) {
+        unit_table_unlock();
         return ;
     }
-    for( int i = index; i < last_index_used; i++ ) {
-        unit_to_file[i].unit = unit_to_file[i + 1].unit;
-        unit_to_file[i].filename = unit_to_file[i + 1].filename;
-        unit_to_file[i].filep = unit_to_file[i + 1].filep;
-        unit_to_file[i].unit_file_bin = unit_to_file[i + 1].unit_file_bin;
+    // Backward-shift deletion: pull every following entry of the cluster
+    // that may live in slot `i` into it, so no tombstones are left behind
+    // and the freed slot is immediately reusable.
+    uint32_t j = i;
+    while (true) {
+        j = (j + 1) & mask;
+        if (!unit_table[j].in_use) {
+            break;
+        }
+        uint32_t home = unit_table_hash(unit_table[j].unit) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            unit_table[i] = unit_table[j];
+            i = j;
+        }
     }
-    last_index_used -= 1;
+    unit_table[i].in_use = false;
+    unit_table[i].filename = NULL;
+    unit_table[i].filep = NULL;
+    unit_table_count--;
+    unit_table_unlock();
 }
 
 // Note: The length 25 was chosen to be at least as good as UUID
@@ -3555,6 +5115,11 @@ LFORTRAN_API int64_t _lfortran_open(int32_t unit_num, char *f_name, char *status
             perror(f_name);
             exit(1);
         }
+        if (fd) {
+            // Records are written into the stdio buffer and reach the file
+            // in blocks of this size
+            setvbuf(fd, NULL, _IOFBF, LFORTRAN_UNIT_BUFFER_SIZE);
+        }
         store_unit_file(unit_num, f_name, fd, unit_file_bin, access_id);
         return (int64_t)fd;
     }
@@ -3565,11 +5130,13 @@ LFORTRAN_API void _lfortran_flush(int32_t unit_num)
 {
     // special case: flush all open units
     if (unit_num == -1) {
-        for (int i = 0; i <= last_index_used; i++) {
-            if (unit_to_file[i].filep != NULL) {
-                fflush(unit_to_file[i].filep);
+        unit_table_lock();
+        for (uint32_t i = 0; i < unit_table_capacity; i++) {
+            if (unit_table[i].in_use && unit_table[i].filep != NULL) {
+                fflush(unit_table[i].filep);
             }
         }
+        unit_table_unlock();
     } else {
         bool unit_file_bin;
         FILE* filep = get_file_pointer_from_unit(unit_num, &unit_file_bin, NULL);
@@ -3865,6 +5432,298 @@ LFORTRAN_API void _lfortran_read_logical(bool *p, int32_t unit_num)
 }
 
 
+/*
+ * Buffered reading of list-directed numeric arrays from formatted files.
+ *
+ * Reading one element per `fscanf` call is dominated by the per call
+ * overhead of the stdio machinery, so arrays are instead read in large
+ * blocks and split into tokens by hand. Once the array is read, the file is
+ * positioned right after the last consumed token, so that other reads from
+ * the same unit are not affected. Files that cannot be positioned (pipes,
+ * terminals) and Windows text streams (whose offsets do not match the bytes
+ * read) use the `fscanf` path.
+ */
+
+#define LFORTRAN_READ_BLOCK_SIZE (1 << 20)
+
+enum lfortran_array_element {
+    LFORTRAN_ARRAY_INT32,
+    LFORTRAN_ARRAY_INT64,
+    LFORTRAN_ARRAY_FLOAT,
+    LFORTRAN_ARRAY_DOUBLE
+};
+
+struct lfortran_number_reader {
+    FILE *filep;
+    long start;     // File position of buf[0]
+    char *buf;
+    size_t capacity;
+    size_t size;    // Number of valid bytes in `buf`
+    size_t pos;     // Next byte of `buf` to be consumed
+    bool eof;
+};
+
+// Value separators of list-directed input
+static const bool lfortran_number_separator[256] = {
+    [' '] = true, ['\t'] = true, ['\n'] = true, ['\r'] = true,
+    ['\v'] = true, ['\f'] = true, [','] = true
+};
+
+static bool number_reader_refill(struct lfortran_number_reader *r, size_t keep_from) {
+    // Drop the consumed bytes and append the next block after the rest
+    size_t kept = r->size - keep_from;
+    memmove(r->buf, r->buf + keep_from, kept);
+    r->start += (long)keep_from;
+    r->pos -= keep_from;
+    r->size = kept;
+    if (r->capacity - r->size < LFORTRAN_READ_BLOCK_SIZE / 2) {
+        // A single token fills the whole buffer
+        r->capacity *= 2;
+        r->buf = (char*)realloc(r->buf, r->capacity);
+        if (r->buf == NULL) {
+            fprintf(stderr, "Error: Out of memory while reading from file.\n");
+            exit(1);
+        }
+    }
+    size_t n = fread(r->buf + r->size, 1, r->capacity - r->size, r->filep);
+    r->size += n;
+    if (n == 0) r->eof = true;
+    return n > 0;
+}
+
+// Returns the next token (not NUL terminated) and its length in `len`, or
+// NULL at the end of the file
+static const char *number_reader_token(struct lfortran_number_reader *r, size_t *len) {
+    for (;;) {
+        while (r->pos < r->size
+                && lfortran_number_separator[(unsigned char)r->buf[r->pos]]) {
+            r->pos++;
+        }
+        if (r->pos < r->size) break;
+        if (r->eof || !number_reader_refill(r, r->pos)) return NULL;
+    }
+    size_t begin = r->pos;
+    for (;;) {
+        while (r->pos < r->size
+                && !lfortran_number_separator[(unsigned char)r->buf[r->pos]]) {
+            r->pos++;
+        }
+        if (r->pos < r->size || r->eof) break;
+        // The token may continue in the next block
+        size_t offset = r->pos - begin;
+        if (!number_reader_refill(r, begin)) {
+            r->pos = offset;
+            begin = 0;
+            break;
+        }
+        r->pos = offset;
+        begin = 0;
+    }
+    *len = r->pos - begin;
+    return r->buf + begin;
+}
+
+static bool parse_int64_token(const char *s, size_t n, int64_t min, int64_t max,
+        int64_t *value) {
+    size_t i = 0;
+    bool negative = false;
+    if (i < n && (s[i] == '+' || s[i] == '-')) {
+        negative = (s[i] == '-');
+        i++;
+    }
+    if (i == n) return false;
+    uint64_t limit = negative ? (uint64_t)(-(min + 1)) + 1 : (uint64_t)max;
+    uint64_t u = 0;
+    for (; i < n; i++) {
+        unsigned d = (unsigned char)s[i] - '0';
+        if (d > 9) return false;
+        if (u > (limit - d) / 10) return false;
+        u = u * 10 + d;
+    }
+    *value = negative ? (int64_t)(0 - u) : (int64_t)u;
+    return true;
+}
+
+// Splits a decimal real `[sign] digits [. digits] [(e|d) [sign] digits]` into
+// a mantissa of at most 19 significant digits and a power of ten. Returns
+// false for anything else (more digits, `inf`, `nan`, malformed input).
+static bool decompose_real_token(const char *s, size_t n, bool *negative,
+        uint64_t *mantissa, int *exp10) {
+    size_t i = 0;
+    *negative = false;
+    if (i < n && (s[i] == '+' || s[i] == '-')) {
+        *negative = (s[i] == '-');
+        i++;
+    }
+    uint64_t m = 0;
+    int n_significant = 0, e = 0, n_digits = 0;
+    bool after_point = false;
+    for (; i < n; i++) {
+        char c = s[i];
+        if (c == '.' && !after_point) {
+            after_point = true;
+            continue;
+        }
+        unsigned d = (unsigned char)c - '0';
+        if (d > 9) break;
+        n_digits++;
+        if (m == 0 && d == 0) {
+            if (after_point) e--;
+            continue;
+        }
+        if (n_significant == 19) return false;
+        m = m * 10 + d;
+        n_significant++;
+        if (after_point) e--;
+    }
+    if (n_digits == 0) return false;
+    if (i < n) {
+        if (s[i] != 'e' && s[i] != 'E' && s[i] != 'd' && s[i] != 'D') return false;
+        i++;
+        bool exp_negative = false;
+        if (i < n && (s[i] == '+' || s[i] == '-')) {
+            exp_negative = (s[i] == '-');
+            i++;
+        }
+        if (i == n) return false;
+        int x = 0;
+        for (; i < n; i++) {
+            unsigned d = (unsigned char)s[i] - '0';
+            if (d > 9 || x > 100000) return false;
+            x = x * 10 + d;
+        }
+        e += exp_negative ? -x : x;
+    }
+    *mantissa = m;
+    *exp10 = e;
+    return true;
+}
+
+// Correctly rounded parsing of a real, using `strtod` for the cases where
+// the exact fast path does not apply
+static bool parse_real_token(const char *s, size_t n, bool single, double *value) {
+    static const double pow10_double[] = {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+    static const float pow10_float[] = {
+        1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f
+    };
+    bool negative;
+    uint64_t m;
+    int e;
+    if (decompose_real_token(s, n, &negative, &m, &e)) {
+        // Both the mantissa and the power of ten are exact, so a single
+        // multiplication or division rounds correctly (Clinger's fast path)
+#if FLT_EVAL_METHOD == 0
+        if (single) {
+            if (m <= (UINT64_C(1) << 24) && e >= -10 && e <= 10) {
+                float f = (float)m;
+                f = e < 0 ? f / pow10_float[-e] : f * pow10_float[e];
+                *value = negative ? -f : f;
+                return true;
+            }
+        } else if (m <= (UINT64_C(1) << 53) && e >= -22 && e <= 22) {
+            double d = (double)m;
+            d = e < 0 ? d / pow10_double[-e] : d * pow10_double[e];
+            *value = negative ? -d : d;
+            return true;
+        }
+#endif
+        if (m == 0) {
+            *value = negative ? -0.0 : 0.0;
+            return true;
+        }
+    }
+    char tmp[128];
+    if (n >= sizeof(tmp)) return false;
+    for (size_t i = 0; i < n; i++) {
+        // Fortran allows `d` as the exponent letter
+        tmp[i] = (s[i] == 'd' || s[i] == 'D') ? 'e' : s[i];
+    }
+    tmp[n] = '\0';
+    char *end;
+    if (single) {
+        *value = strtof(tmp, &end);
+    } else {
+        *value = strtod(tmp, &end);
+    }
+    return end == tmp + n;
+}
+
+// Reads `array_size` elements of `type` into `p`. Returns false (without
+// reading anything) if `filep` cannot be read this way.
+static bool read_formatted_array(FILE *filep, void *p, int array_size,
+        enum lfortran_array_element type) {
+#if defined(_WIN32)
+    (void)filep; (void)p; (void)array_size; (void)type;
+    return false;
+#else
+    struct lfortran_number_reader r;
+    r.filep = filep;
+    r.start = ftell(filep);
+    if (r.start < 0 || fseek(filep, r.start, SEEK_SET) != 0) return false;
+    r.capacity = LFORTRAN_READ_BLOCK_SIZE;
+    r.buf = (char*)malloc(r.capacity);
+    if (r.buf == NULL) return false;
+    r.size = r.pos = 0;
+    r.eof = false;
+
+    for (int i = 0; i < array_size; i++) {
+        size_t len;
+        const char *tok = number_reader_token(&r, &len);
+        if (tok == NULL) {
+            fprintf(stderr, "Error: End of file while reading an array of "
+                "%d elements (read %d).\n", array_size, i);
+            exit(1);
+        }
+        bool ok;
+        switch (type) {
+            case LFORTRAN_ARRAY_INT32: {
+                int64_t v;
+                ok = parse_int64_token(tok, len, INT32_MIN, INT32_MAX, &v);
+                if (ok) ((int32_t*)p)[i] = (int32_t)v;
+                break;
+            }
+            case LFORTRAN_ARRAY_INT64: {
+                int64_t v;
+                ok = parse_int64_token(tok, len, INT64_MIN, INT64_MAX, &v);
+                if (ok) ((int64_t*)p)[i] = v;
+                break;
+            }
+            case LFORTRAN_ARRAY_FLOAT: {
+                double v;
+                ok = parse_real_token(tok, len, true, &v);
+                if (ok) ((float*)p)[i] = (float)v;
+                break;
+            }
+            default: {
+                double v;
+                ok = parse_real_token(tok, len, false, &v);
+                if (ok) ((double*)p)[i] = v;
+                break;
+            }
+        }
+        if (!ok) {
+            fprintf(stderr, "Error: Invalid input '%.*s' for %s array element "
+                "from file.\n", (int)(len < 64 ? len : 64), tok,
+                type == LFORTRAN_ARRAY_INT32 ? "integer(4)" :
+                type == LFORTRAN_ARRAY_INT64 ? "integer(8)" :
+                type == LFORTRAN_ARRAY_FLOAT ? "real(4)" : "real(8)");
+            exit(1);
+        }
+    }
+
+    // Give the bytes read ahead back to the file
+    if (fseek(filep, r.start + (long)r.pos, SEEK_SET) != 0) {
+        fprintf(stderr, "Error: Failed to reposition the file after reading an array.\n");
+        exit(1);
+    }
+    free(r.buf);
+    return true;
+#endif
+}
+
 LFORTRAN_API void _lfortran_read_array_int8(int8_t *p, int array_size, int32_t unit_num)
 {
     if (unit_num == -1) {
@@ -3922,7 +5781,7 @@ LFORTRAN_API void _lfortran_read_array_int32(int32_t *p, int array_size, int32_t
             (void)!fread(&record_marker_start, sizeof(int32_t), 1, filep);
         }
         (void)!fread(p, sizeof(int32_t), array_size, filep);
-    } else {
+    } else if (!read_formatted_array(filep, p, array_size, LFORTRAN_ARRAY_INT32)) {
         for (int i = 0; i < array_size; i++) {
             (void)!fscanf(filep, "%d", &p[i]);
         }
@@ -3953,7 +5812,7 @@ LFORTRAN_API void _lfortran_read_array_int64(int64_t *p, int array_size, int32_t
             (void)!fread(&record_marker_start, sizeof(int32_t), 1, filep);
         }
         (void)!fread(p, sizeof(int64_t), array_size, filep);
-    } else {
+    } else if (!read_formatted_array(filep, p, array_size, LFORTRAN_ARRAY_INT64)) {
         for (int i = 0; i < array_size; i++) {
             (void)!fscanf(filep, "%" SCNd64, &p[i]);
         }
@@ -4114,7 +5973,7 @@ LFORTRAN_API void _lfortran_read_array_float(float *p, int array_size, int32_t u
 
     if (unit_file_bin) {
         (void)!fread(p, sizeof(float), array_size, filep);
-    } else {
+    } else if (!read_formatted_array(filep, p, array_size, LFORTRAN_ARRAY_FLOAT)) {
         for (int i = 0; i < array_size; i++) {
             (void)!fscanf(filep, "%f", &p[i]);
         }
@@ -4140,7 +5999,7 @@ LFORTRAN_API void _lfortran_read_array_double(double *p, int array_size, int32_t
 
     if (unit_file_bin) {
         (void)!fread(p, sizeof(double), array_size, filep);
-    } else {
+    } else if (!read_formatted_array(filep, p, array_size, LFORTRAN_ARRAY_DOUBLE)) {
         for (int i = 0; i < array_size; i++) {
             (void)!fscanf(filep, "%lf", &p[i]);
         }
@@ -4349,7 +6208,8 @@ LFORTRAN_API void _lfortran_file_write(int32_t unit_num, int32_t* iostat, const
 {
     bool unit_file_bin;
     int access_id;
-    FILE* filep = get_file_pointer_from_unit(unit_num, &unit_file_bin, &access_id);
+    bool truncate;
+    FILE* filep = get_file_pointer_for_write(unit_num, &unit_file_bin, &access_id, &truncate);
     if (!filep) {
         filep = stdout;
     }
@@ -4425,7 +6285,62 @@ LFORTRAN_API void _lfortran_file_write(int32_t unit_num, int32_t* iostat, const
         if(iostat != NULL) *iostat = 0;
         va_end(args);
     }
-    (void)!ftruncate(fileno(filep), ftell(filep));
+    if (truncate) {
+        (void)!ftruncate(fileno(filep), ftell(filep));
+    }
+}
+
+/*
+A formatted sequential write of one record: formats the values straight into
+a buffer on the stack (which only spills to the heap for very long records)
+and hands it to the unit's stdio buffer in one piece. `end` is appended to
+the record. The format arguments are the ones of
+`_lcompilers_string_format_fortran_compiled` if `format_table` is not NULL,
+otherwise `format` is run as in `_lcompilers_string_format_fortran` (NULL for
+list-directed output).
+*/
+LFORTRAN_API void _lfortran_file_write_formatted(int32_t unit_num, int32_t* iostat,
+    const char* end, const char* format, const char* format_table,
+    int64_t n_values, int64_t item_start, const char* serialization_string,
+    int32_t array_sizes_cnt, ...)
+{
+    va_list args;
+    va_start(args, array_sizes_cnt);
+    struct serialization_info s_info;
+    init_serialization_info(&s_info, serialization_string, array_sizes_cnt, &args);
+
+    char buffer[1024];
+    String_Builder record;
+    string_builder_init(&record, buffer, sizeof(buffer));
+    format_record(&record, format, format_table, n_values, item_start, &s_info);
+    free_serialization_info(&s_info);
+
+    // Detect "\b" to raise error
+    if (record.data[0] == '\b') {
+        if (iostat == NULL) {
+            fprintf(stderr, "%s", record.data + 1);
+            exit(1);
+        } else { // Delegate error handling to the user.
+            *iostat = 11;
+            if (record.owns_data) free(record.data);
+            return;
+        }
+    }
+    string_builder_append(&record, end);
+
+    bool unit_file_bin;
+    int access_id;
+    bool truncate;
+    FILE* filep = get_file_pointer_for_write(unit_num, &unit_file_bin, &access_id, &truncate);
+    if (!filep) {
+        filep = stdout;
+    }
+    fwrite(record.data, 1, record.len, filep);
+    if (truncate) {
+        (void)!ftruncate(fileno(filep), ftell(filep));
+    }
+    if (iostat != NULL) *iostat = 0;
+    if (record.owns_data) free(record.data);
 }
 
 LFORTRAN_API void _lfortran_string_write(char **str_holder, int64_t* size, int64_t* capacity, int32_t* iostat, const char *format, ...) {
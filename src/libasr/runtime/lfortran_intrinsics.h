@@ -66,6 +66,26 @@ typedef double _Complex double_complex_t;
 #endif
 
 LFORTRAN_API double _lfortran_sum(int n, double *v);
+LFORTRAN_API void _lfortran_dgemm(int64_t m, int64_t n, int64_t k,
+        const double *a, const double *b, double *c);
+LFORTRAN_API void _lfortran_sgemm(int64_t m, int64_t n, int64_t k,
+        const float *a, const float *b, float *c);
+LFORTRAN_API void _lfortran_zgemm(int64_t m, int64_t n, int64_t k,
+        const double *a, const double *b, double *c);
+LFORTRAN_API void _lfortran_cgemm(int64_t m, int64_t n, int64_t k,
+        const float *a, const float *b, float *c);
+LFORTRAN_API double _lfortran_ddot(int64_t n, const double *x, const double *y);
+LFORTRAN_API float _lfortran_sdot(int64_t n, const float *x, const float *y);
+LFORTRAN_API void _lfortran_zdot(int64_t n, const double *x, const double *y,
+        double *result);
+LFORTRAN_API void _lfortran_cdot(int64_t n, const float *x, const float *y,
+        float *result);
+LFORTRAN_API double _lfortran_dsum(int64_t n, const double *x);
+LFORTRAN_API float _lfortran_ssum(int64_t n, const float *x);
+LFORTRAN_API void _lfortran_zsum(int64_t n, const double *x, double *result);
+LFORTRAN_API void _lfortran_csum(int64_t n, const float *x, float *result);
+LFORTRAN_API void _lfortran_transpose(int64_t m, int64_t n, int64_t size,
+        const void *a, void *b);
 LFORTRAN_API void _lfortran_random_number(int n, double *v);
 LFORTRAN_API void _lfortran_init_random_clock();
 LFORTRAN_API int _lfortran_init_random_seed(unsigned seed);
@@ -202,11 +222,14 @@ LFORTRAN_API int _lfortran_str_ord(char** s);
 LFORTRAN_API int _lfortran_str_ord_c(char* s);
 LFORTRAN_API char* _lfortran_str_chr(int c);
 LFORTRAN_API int _lfortran_str_to_int(char** s);
-LFORTRAN_API void* _lfortran_malloc(int32_t size);
+LFORTRAN_API void* _lfortran_malloc(int64_t size);
 LFORTRAN_API void _lfortran_memset(void* s, int32_t c, int32_t size);
-LFORTRAN_API int8_t* _lfortran_realloc(int8_t* ptr, int32_t size);
-LFORTRAN_API int8_t* _lfortran_calloc(int32_t count, int32_t size);
+LFORTRAN_API int8_t* _lfortran_realloc(int8_t* ptr, int64_t size);
+LFORTRAN_API int8_t* _lfortran_calloc(int64_t count, int64_t size);
 LFORTRAN_API void _lfortran_free(char* ptr);
+LFORTRAN_API void* _lfortran_pool_malloc(int64_t size);
+LFORTRAN_API void* _lfortran_pool_realloc(void* ptr, int64_t size);
+LFORTRAN_API void _lfortran_pool_free(void* ptr);
 LFORTRAN_API void _lfortran_allocate_string(char** ptr, int64_t len, int64_t* size, int64_t* capacity);
 LFORTRAN_API void _lfortran_string_init(int64_t size_plus_one, char *s);
 LFORTRAN_API char* _lfortran_str_item(char* s, int64_t idx);
@@ -233,8 +256,13 @@ LFORTRAN_API char* _lfortran_date();
 LFORTRAN_API char* _lfortran_time();
 LFORTRAN_API char* _lfortran_zone();
 LFORTRAN_API int32_t _lfortran_values(int32_t n);
+LFORTRAN_API void _lfortran_profile_enter(int32_t *site, const char *desc);
+LFORTRAN_API void _lfortran_profile_exit(int32_t *site);
 LFORTRAN_API float _lfortran_sp_rand_num();
 LFORTRAN_API double _lfortran_dp_rand_num();
+LFORTRAN_API int32_t _lfortran_random_seed_put(int32_t s1, int32_t s2, int32_t s3,
+        int32_t s4, int32_t s5, int32_t s6, int32_t s7, int32_t s8);
+LFORTRAN_API int32_t _lfortran_random_seed_get(int32_t i);
 LFORTRAN_API int64_t _lpython_open(char *path, char *flags);
 LFORTRAN_API int64_t _lfortran_open(int32_t unit_num, char *f_name, char *status, char* form, char* access, int32_t *iostat, char **iomsg);
 LFORTRAN_API void _lfortran_flush(int32_t unit_num);
@@ -253,6 +281,7 @@ LFORTRAN_API void _lfortran_read_array_double(double *p, int array_size, int32_t
 LFORTRAN_API void _lfortran_read_char(char **p, int32_t unit_num, ...);
 LFORTRAN_API void _lfortran_string_write(char **str, int64_t* size, int64_t* capacity, int32_t* iostat, const char *format, ...);
 LFORTRAN_API void _lfortran_file_write(int32_t unit_num, int32_t* iostat, const char *format, ...);
+LFORTRAN_API void _lfortran_file_write_formatted(int32_t unit_num, int32_t* iostat, const char* end, const char* format, const char* format_table, int64_t n_values, int64_t item_start, const char* serialization_string, int32_t array_sizes_cnt, ...);
 LFORTRAN_API void _lfortran_string_read_i32(char *str, char *format, int32_t *i);
 LFORTRAN_API void _lfortran_string_read_i32_array(char *str, char *format, int32_t *arr);
 LFORTRAN_API void _lfortran_string_read_i64(char *str, char *format, int64_t *i);
@@ -280,6 +309,8 @@ LFORTRAN_API char *_lfortran_get_environment_variable(char *name);
 LFORTRAN_API int _lfortran_exec_command(char *cmd);
 
 LFORTRAN_API char* _lcompilers_string_format_fortran(const char* format,const char* serialization_string, int32_t array_sizes_cnt, ...);
+LFORTRAN_API char* _lcompilers_precompile_format(const char* format, int64_t* n_values, int64_t* item_start, int64_t* size);
+LFORTRAN_API char* _lcompilers_string_format_fortran_compiled(const char* format_table, int64_t n_values, int64_t item_start, const char* serialization_string, int32_t array_sizes_cnt, ...);
 
 #ifdef __cplusplus
 }
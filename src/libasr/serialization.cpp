@@ -1,3 +1,4 @@
+#include <set>
 #include <string>
 
 #include <libasr/config.h>
@@ -25,6 +26,12 @@ class ASRSerializationVisitor :
         public ASR::SerializationBaseVisitor<ASRSerializationVisitor>
 {
 public:
+    // If set, the names of the symbols of this scope that the serialized
+    // nodes refer to are collected into `dependencies`
+    const SymbolTable *dependency_scope = nullptr;
+    std::string module_name;
+    std::set<std::string> dependencies;
+
     void write_bool(bool b) {
         if (b) {
             write_int8(1);
@@ -34,10 +41,51 @@ public:
     }
 
     void write_symbol(const ASR::symbol_t &x) {
+        if (dependency_scope && symbol_parent_symtab(&x) == dependency_scope) {
+            dependencies.insert(symbol_name(&x));
+        }
         write_int64(symbol_parent_symtab(&x)->counter);
         write_int8(x.type);
         write_string(symbol_name(&x));
     }
+
+    // The references below are by name, they are resolved when loading
+
+    void add_dependency(const std::string &name) {
+        if (dependency_scope && dependency_scope->get_symbol(name)) {
+            dependencies.insert(name);
+        }
+    }
+
+    void add_dependencies(char **names, size_t n) {
+        for (size_t i = 0; i < n; i++) {
+            add_dependency(names[i]);
+        }
+    }
+
+    void visit_ExternalSymbol(const ASR::ExternalSymbol_t &x) {
+        add_dependency(x.m_module_name);
+        if (module_name == x.m_module_name) {
+            add_dependency(x.n_scope_names > 0 ? x.m_scope_names[0]
+                : x.m_original_name);
+        }
+        ASR::SerializationBaseVisitor<ASRSerializationVisitor>::visit_ExternalSymbol(x);
+    }
+
+    void visit_Function(const ASR::Function_t &x) {
+        add_dependencies(x.m_dependencies, x.n_dependencies);
+        ASR::SerializationBaseVisitor<ASRSerializationVisitor>::visit_Function(x);
+    }
+
+    void visit_Struct(const ASR::Struct_t &x) {
+        add_dependencies(x.m_dependencies, x.n_dependencies);
+        ASR::SerializationBaseVisitor<ASRSerializationVisitor>::visit_Struct(x);
+    }
+
+    void visit_Variable(const ASR::Variable_t &x) {
+        add_dependencies(x.m_dependencies, x.n_dependencies);
+        ASR::SerializationBaseVisitor<ASRSerializationVisitor>::visit_Variable(x);
+    }
 };
 
 std::string serialize(const ASR::asr_t &asr) {
@@ -51,6 +99,52 @@ std::string serialize(const ASR::TranslationUnit_t &unit) {
     return serialize((ASR::asr_t&)(unit));
 }
 
+std::string serialize_module(const ASR::TranslationUnit_t &unit,
+        std::vector<SerializedSymbol> &symbols) {
+    ASR::Module_t *m = ASRUtils::extract_module(unit);
+
+    // The module and its TranslationUnit with the same symbol table ids, but
+    // without the symbols of the module
+    SymbolTable module_symtab(nullptr);
+    module_symtab.counter = m->m_symtab->counter;
+    ASR::Module_t module = *m;
+    module.m_symtab = &module_symtab;
+    SymbolTable unit_symtab(nullptr);
+    unit_symtab.counter = unit.m_symtab->counter;
+    for (auto &a : unit.m_symtab->get_scope()) {
+        unit_symtab.add_symbol(a.first, (ASR::symbol_t*)&module);
+    }
+    ASR::TranslationUnit_t shell = unit;
+    shell.m_symtab = &unit_symtab;
+
+    // Same order as in the serialization of a symbol table
+    std::vector<std::pair<std::string, ASR::symbol_t*>> scope;
+    for (auto &a : m->m_symtab->get_scope()) {
+        if (!ASR::is_a<ASR::Function_t>(*a.second)) {
+            scope.push_back(a);
+        }
+    }
+    for (auto &a : m->m_symtab->get_scope()) {
+        if (ASR::is_a<ASR::Function_t>(*a.second)) {
+            scope.push_back(a);
+        }
+    }
+    for (auto &a : scope) {
+        ASRSerializationVisitor v;
+        v.dependency_scope = m->m_symtab;
+        v.module_name = m->m_name;
+        v.write_string(a.first);
+        v.visit_symbol(*a.second);
+        v.dependencies.erase(a.first);
+        SerializedSymbol s;
+        s.name = a.first;
+        s.asr = v.get_str();
+        s.dependencies.assign(v.dependencies.begin(), v.dependencies.end());
+        symbols.push_back(s);
+    }
+    return serialize(shell);
+}
+
 class ASRDeserializationVisitor :
 #ifdef WITH_LFORTRAN_BINARY_MODFILES
         public BinaryReader,
@@ -60,12 +154,15 @@ class ASRDeserializationVisitor :
         public ASR::DeserializationBaseVisitor<ASRDeserializationVisitor>
 {
 public:
-    ASRDeserializationVisitor(Allocator &al, const std::string &s,
+    // The placeholders created by read_symbol() that are not filled in yet
+    std::set<std::pair<SymbolTable*, std::string>> placeholders;
+
+    ASRDeserializationVisitor(Allocator &al, const char *data, size_t size,
         bool load_symtab_id, uint32_t offset) :
 #ifdef WITH_LFORTRAN_BINARY_MODFILES
-            BinaryReader(s),
+            BinaryReader(data, size),
 #else
-            TextReader(s),
+            TextReader(data, size),
 #endif
             DeserializationBaseVisitor(al, load_symtab_id, offset) {}
 
@@ -104,7 +201,10 @@ public:
         // it in write_symbol() above
         uint64_t symbol_type = read_int8();
         std::string symbol_name  = read_string();
-        LCOMPILERS_ASSERT(id_symtab_map.find(symtab_id) != id_symtab_map.end());
+        if (id_symtab_map.find(symtab_id) == id_symtab_map.end()) {
+            throw LCompilersException("The symbol '" + symbol_name
+                + "' refers to a symbol table that is not loaded");
+        }
         SymbolTable *symtab = id_symtab_map[symtab_id];
         if (symtab->get_symbol(symbol_name) == nullptr) {
             // Symbol is not in the symbol table yet. We construct an empty
@@ -125,6 +225,7 @@ public:
                 default : throw LCompilersException("Symbol type not supported");
             }
             symtab->add_symbol(symbol_name, s);
+            placeholders.insert({symtab, symbol_name});
         }
         ASR::symbol_t *sym = symtab->get_symbol(symbol_name);
         return sym;
@@ -138,6 +239,7 @@ public:
             // We have to copy the contents of `sym` into `sym2` without
             // changing the `sym2` pointer already in the table
             ASR::symbol_t *sym2 = symtab.get_symbol(name);
+            placeholders.erase({&symtab, name});
             switch (sym->type) {
                 INSERT_SYMBOL_CASE(Program)
                 INSERT_SYMBOL_CASE(Module)
@@ -160,6 +262,12 @@ class FixParentSymtabVisitor : public BaseWalkVisitor<FixParentSymtabVisitor>
 private:
     SymbolTable *current_symtab;
 public:
+    // Fixes the symbol `x` of the symbol table `symtab`
+    void visit_symbol_of(SymbolTable *symtab, const symbol_t &x) {
+        current_symtab = symtab;
+        this->visit_symbol(x);
+    }
+
     void visit_TranslationUnit(const TranslationUnit_t &x) {
         current_symtab = x.m_symtab;
         x.m_symtab->asr_owner = (asr_t*)&x;
@@ -418,7 +526,12 @@ ASR::asr_t* deserialize_asr(Allocator &al, const std::string &s,
 
 ASR::asr_t* deserialize_asr(Allocator &al, const std::string &s,
         bool load_symtab_id, uint32_t offset) {
-    ASRDeserializationVisitor v(al, s, load_symtab_id, offset);
+    return deserialize_asr(al, s.data(), s.size(), load_symtab_id, offset);
+}
+
+ASR::asr_t* deserialize_asr(Allocator &al, const char *data, size_t size,
+        bool load_symtab_id, uint32_t offset) {
+    ASRDeserializationVisitor v(al, data, size, load_symtab_id, offset);
     ASR::asr_t *node = v.deserialize_node();
     ASR::TranslationUnit_t *tu = ASR::down_cast2<ASR::TranslationUnit_t>(node);
 
@@ -438,4 +551,30 @@ ASR::asr_t* deserialize_asr(Allocator &al, const std::string &s,
     return node;
 }
 
+void deserialize_symbols(Allocator &al, const char *data, size_t size,
+        const std::vector<size_t> &symbols, uint64_t symtab_id,
+        ASR::Module_t &m, bool load_symtab_id, uint32_t offset) {
+    ASRDeserializationVisitor v(al, data, size, load_symtab_id, offset);
+    v.id_symtab_map[symtab_id] = m.m_symtab;
+    std::vector<std::string> names;
+    for (size_t pos : symbols) {
+        // Every symbol was serialized by its own writer
+        v.set_pos(pos);
+        v.reset_strings();
+        std::string name = v.read_string();
+        ASR::symbol_t *sym = ASR::down_cast<ASR::symbol_t>(v.deserialize_symbol());
+        v.symtab_insert_symbol(*m.m_symtab, name, sym);
+        names.push_back(name);
+    }
+    if (!v.placeholders.empty()) {
+        throw LCompilersException("The symbol '" + v.placeholders.begin()->second
+            + "' of the module '" + m.m_name + "' is referred to, but not loaded");
+    }
+
+    ASR::FixParentSymtabVisitor p;
+    for (auto &name : names) {
+        p.visit_symbol_of(m.m_symtab, *m.m_symtab->get_symbol(name));
+    }
+}
+
 } // namespace LCompilers
@@ -11,6 +11,30 @@ namespace LCompilers {
             bool load_symtab_id, SymbolTable &symtab, uint32_t offset);
     ASR::asr_t* deserialize_asr(Allocator &al, const std::string &s,
             bool load_symtab_id, uint32_t offset);
+    // Deserializes the `size` bytes at `data` in place
+    ASR::asr_t* deserialize_asr(Allocator &al, const char *data, size_t size,
+            bool load_symtab_id, uint32_t offset);
+
+    // A symbol of a module that was serialized on its own
+    struct SerializedSymbol {
+        std::string name;
+        std::string asr;
+        // The other symbols of the module that it refers to
+        std::vector<std::string> dependencies;
+    };
+
+    // Serializes a TranslationUnit that holds a single module. The module is
+    // serialized with an empty symbol table, and its symbols are serialized
+    // one by one into `symbols`, in the order they must be deserialized in.
+    std::string serialize_module(const ASR::TranslationUnit_t &unit,
+            std::vector<SerializedSymbol> &symbols);
+
+    // Deserializes the symbols at the positions `symbols` of `data` into the
+    // module `m`, whose symbol table was serialized with the id `symtab_id`.
+    // Throws if they refer to symbols of the module that are not loaded.
+    void deserialize_symbols(Allocator &al, const char *data, size_t size,
+            const std::vector<size_t> &symbols, uint64_t symtab_id,
+            ASR::Module_t &m, bool load_symtab_id, uint32_t offset);
 
     void fix_external_symbols(ASR::TranslationUnit_t &unit,
             SymbolTable &external_symtab);
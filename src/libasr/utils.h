@@ -24,6 +24,8 @@ std::string get_unique_ID();
 int visualize_json(std::string &astr_data_json, LCompilers::Platform os);
 std::string generate_visualize_html(std::string &astr_data_json);
 
+struct LocationManager;
+
 struct PassOptions {
     std::filesystem::path mod_files_dir;
     std::vector<std::filesystem::path> include_dirs;
@@ -44,6 +46,12 @@ struct PassOptions {
     bool disable_main = false;
     bool use_loop_variable_after_loop = false;
     bool realloc_lhs = false;
+    // Only load the symbols of a modfile that `use, only` imports
+    bool lazy_modfiles = false;
+    // Compress the modfiles that are written
+    bool compress_modfiles = false;
+    // Number of threads used to apply function-local passes
+    size_t pass_threads = 1;
     std::vector<int64_t> skip_optimization_func_instantiation;
     bool module_name_mangling = false;
     bool intrinsic_module_name_mangling = false;
@@ -62,6 +70,12 @@ struct PassOptions {
     bool enable_cpython = false;
     bool c_skip_bindpy_pass = false;
     bool openmp = false;
+    bool array_kernels = false; // Call the runtime's array kernels
+    bool associative_math = false; // -fassociative-math: sums may be reordered
+    bool instrument_functions = false; // --instrument=functions
+    bool instrument_loops = false; // --instrument=loops
+    // Source locations of the regions timed by the instrument pass
+    const LocationManager *location_manager = nullptr;
     bool enable_gpu_offloading = false;
     bool time_report = false;
     bool skip_removal_of_unused_procedures_in_pass_array_by_data = false;
@@ -88,8 +102,16 @@ struct CompilerOptions {
     bool tree = false;
     bool visualize = false;
     bool fast = false;
+    // LLVM optimization level ("0", "1", "2", "3", "s" or "z"). If empty,
+    // "3" is used with --fast and "0" otherwise.
+    std::string opt_level = "";
+    // Custom LLVM pass pipeline, overrides `opt_level` if not empty
+    std::string llvm_passes = "";
+    // Number of threads (and module partitions) used to emit object code
+    size_t codegen_threads = 1;
     bool openmp = false;
     std::string openmp_lib_dir = "";
+    std::string blas_lib = "";
     bool lookup_name = false;
     bool rename_symbol = false;
     std::string line = "";
@@ -134,6 +156,11 @@ struct CompilerOptions {
     bool legacy_array_sections = false;
     bool ignore_pragma = false;
     bool stack_arrays = false;
+    // Largest array data (in bytes) placed on the stack for local arrays that
+    // do not outlive their procedure, larger ones go to the heap at runtime.
+    // -1 selects the default: 1024 with --fast, 0 (disabled) otherwise.
+    int64_t max_stack_array_size = -1;
+    bool no_alias_metadata = false;
     bool wasm_html = false;
     bool time_report = false;
     std::string emcc_embed;
@@ -16,8 +16,8 @@
 namespace LCompilers {
 
 std::string get_unique_ID() {
-    static std::random_device dev;
-    static std::mt19937 rng(dev());
+    thread_local std::random_device dev;
+    thread_local std::mt19937 rng(dev());
     std::uniform_int_distribution<int> dist(0, 61);
     const std::string v =
         "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789";
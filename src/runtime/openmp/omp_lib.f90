@@ -41,6 +41,89 @@ end subroutine
 subroutine GOMP_atomic_end() bind(C, name="GOMP_atomic_end")
 end subroutine
 
+logical(c_bool) function GOMP_loop_static_start(lb, ub, incr, chunk_size, istart, iend) &
+        bind(C, name="GOMP_loop_static_start")
+import :: c_long, c_bool
+integer(c_long), value :: lb, ub, incr, chunk_size
+integer(c_long) :: istart, iend
+end function
+
+logical(c_bool) function GOMP_loop_dynamic_start(lb, ub, incr, chunk_size, istart, iend) &
+        bind(C, name="GOMP_loop_dynamic_start")
+import :: c_long, c_bool
+integer(c_long), value :: lb, ub, incr, chunk_size
+integer(c_long) :: istart, iend
+end function
+
+logical(c_bool) function GOMP_loop_guided_start(lb, ub, incr, chunk_size, istart, iend) &
+        bind(C, name="GOMP_loop_guided_start")
+import :: c_long, c_bool
+integer(c_long), value :: lb, ub, incr, chunk_size
+integer(c_long) :: istart, iend
+end function
+
+logical(c_bool) function GOMP_loop_runtime_start(lb, ub, incr, istart, iend) &
+        bind(C, name="GOMP_loop_runtime_start")
+import :: c_long, c_bool
+integer(c_long), value :: lb, ub, incr
+integer(c_long) :: istart, iend
+end function
+
+logical(c_bool) function GOMP_loop_static_next(istart, iend) bind(C, name="GOMP_loop_static_next")
+import :: c_long, c_bool
+integer(c_long) :: istart, iend
+end function
+
+logical(c_bool) function GOMP_loop_dynamic_next(istart, iend) bind(C, name="GOMP_loop_dynamic_next")
+import :: c_long, c_bool
+integer(c_long) :: istart, iend
+end function
+
+logical(c_bool) function GOMP_loop_guided_next(istart, iend) bind(C, name="GOMP_loop_guided_next")
+import :: c_long, c_bool
+integer(c_long) :: istart, iend
+end function
+
+logical(c_bool) function GOMP_loop_runtime_next(istart, iend) bind(C, name="GOMP_loop_runtime_next")
+import :: c_long, c_bool
+integer(c_long) :: istart, iend
+end function
+
+subroutine GOMP_loop_end_nowait() bind(C, name="GOMP_loop_end_nowait")
+end subroutine
+
+logical(c_bool) function GOMP_single_start() bind(C, name="GOMP_single_start")
+import :: c_bool
+end function
+
+subroutine GOMP_task(fn, data, cpyfn, arg_size, arg_align, if_clause, flags, &
+        depend, priority, detach) bind(C, name="GOMP_task")
+import :: c_funptr, c_ptr, c_long, c_bool, c_int
+type(c_funptr), value :: fn
+type(c_ptr), value :: data, cpyfn
+integer(c_long), value :: arg_size, arg_align
+logical(c_bool), value :: if_clause
+integer(c_int), value :: flags
+type(c_ptr), value :: depend
+integer(c_int), value :: priority
+type(c_ptr), value :: detach
+end subroutine
+
+subroutine GOMP_taskwait() bind(C, name="GOMP_taskwait")
+end subroutine
+
+subroutine GOMP_taskloop(fn, data, cpyfn, arg_size, arg_align, flags, num_tasks, &
+        priority, lb, ub, incr) bind(C, name="GOMP_taskloop")
+import :: c_funptr, c_ptr, c_long, c_int
+type(c_funptr), value :: fn
+type(c_ptr), value :: data, cpyfn
+integer(c_long), value :: arg_size, arg_align
+integer(c_int), value :: flags
+integer(c_long), value :: num_tasks
+integer(c_int), value :: priority
+integer(c_long), value :: lb, ub, incr
+end subroutine
+
 double precision function omp_get_wtime() bind(c, name="omp_get_wtime")
 end function omp_get_wtime
 
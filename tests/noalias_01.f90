@@ -0,0 +1,49 @@
+module noalias_01_mod
+implicit none
+contains
+
+    subroutine add(a, b, c)
+    real(8), intent(out) :: a(:)
+    real(8), intent(in) :: b(:), c(:)
+    integer :: i
+    do i = 1, size(a)
+        a(i) = b(i) + c(i)
+    end do
+    end subroutine
+
+    subroutine axpy(n, alpha, x, y)
+    integer, intent(in) :: n
+    real(8), intent(in) :: alpha, x(n)
+    real(8), intent(inout) :: y(n)
+    integer :: i
+    do i = 1, n
+        y(i) = y(i) + alpha*x(i)
+    end do
+    end subroutine
+
+    ! `x` is a target and `y` a pointer, they may alias
+    subroutine shift(x, y)
+    real(8), target, intent(inout) :: x(10)
+    real(8), pointer, intent(inout) :: y(:)
+    integer :: i
+    do i = 1, 10
+        x(i) = y(i) + 1
+    end do
+    end subroutine
+
+end module
+
+program noalias_01
+use noalias_01_mod
+implicit none
+real(8), target :: x(10)
+real(8) :: y(10), z(20)
+real(8), pointer :: p(:)
+y = 1
+z = 2
+call add(x, y, z(1:20:2))
+call axpy(10, 2.0_8, y, x)
+p => x
+call shift(x, p)
+print *, x
+end program